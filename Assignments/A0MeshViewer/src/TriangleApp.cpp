@@ -1,9 +1,11 @@
 #include "TriangleApp.h"
+#include <cstddef>
 #include <d3dx12/d3dx12.h>
 #include <gimslib/contrib/stb/stb_image.h>
 #include <gimslib/d3d/DX12Util.hpp>
 #include <gimslib/d3d/UploadHelper.hpp>
 #include <gimslib/dbg/HrException.hpp>
+#include <gimslib/geometry/AABB.hpp>
 #include <gimslib/sys/Event.hpp>
 #include <imgui.h>
 #include <iostream>
@@ -18,16 +20,13 @@ f32m4 getNormalizationTransformation(f32v3 const* const positions, ui32 nPositio
   if (nPositions == 0)
     return f32m4(1.0f);
 
-  f32v3 minPos = positions[0];
-  f32v3 maxPos = positions[0];
+  const AABB aabb(positions, nPositions);
 
   // We need to translate the vertices to the center of the cuboid
   // Therefore we first need to calculate the center of mass of the vertices
   f32v3 centerOfMass(0.0f, 0.0f, 0.0f);
   for (ui32 i = 0; i < nPositions; i++)
   {
-    minPos = glm::min(minPos, positions[i]);
-    maxPos = glm::max(maxPos, positions[i]);
     centerOfMass += positions[i];
   }
 
@@ -36,7 +35,7 @@ f32m4 getNormalizationTransformation(f32v3 const* const positions, ui32 nPositio
   f32m4 translation = glm::translate(glm::mat4(1.0f), -centerOfMass);
 
   // find largest dimension and scale accordingly
-  const f32v3 distance         = maxPos - minPos;
+  const f32v3 distance         = aabb.getUpperRightTop() - aabb.getLowerLeftBottom();
   const f32   largestDimension = glm::max(distance.x, glm::max(distance.y, distance.z));
   const f32   scalingFactor    = (largestDimension != 0) ? (1.0f / largestDimension) : 1.0f;
   f32m4       scale_matrix     = glm::scale(glm::mat4(1.0f), f32v3(scalingFactor));
@@ -85,8 +84,8 @@ MeshViewer::MeshViewer(const DX12AppConfig config)
   createConstantBufferForEachSwapchainFrame();
   m_examinerController.setTranslationVector(f32v3(0, 0, 3));
 
-  // Load the model data from file
-  CograBinaryMeshFile cbm("../../../data/bunny.cbm");
+  // Map the model data from file
+  const auto cbm = CograBinaryMeshFile::map("../../../data/bunny.cbm");
 
   // Test print some stats
   cbm.printAttributes(std::cout);
@@ -345,25 +344,21 @@ void MeshViewer::createPipeline(bool enableBackFaceCulling, bool enableWireFrame
 
 void MeshViewer::initializeVertexBuffer(const CograBinaryMeshFile* cbm)
 {
-  const auto numVertices         = cbm->getNumVertices();
-  const auto vertexPointer       = cbm->getPositionsPtr();
-  const auto normalPointer       = reinterpret_cast<f32v3*>(cbm->getAttributePtr(0));
-  const auto texture_coordinates = reinterpret_cast<f32v2*>(cbm->getAttributePtr(1));
+  const auto numVertices = cbm->getNumVertices();
 
   if (numVertices % 3 != 0)
   {
     std::cerr << "The loaded vertex data is invalid. Please check for errors..." << std::endl;
     exit(1);
   }
-  // convert simple float vector to vertex vector
-  for (size_t i = 0; i < numVertices; i++)
-  {
-    Vertex v;
-    v.position = {vertexPointer[i * 3], vertexPointer[i * 3 + 1], vertexPointer[i * 3 + 2]};
-    v.normal   = normalPointer[i];
-    v.texcoord = texture_coordinates[i];
-    m_VertexBufferCPU.push_back(v);
-  }
+  // interleave the planar streams of the file into vertices: position, normal (attribute 0), texcoord (attribute 1)
+  VertexLayout layout;
+  layout.stride   = sizeof(Vertex);
+  layout.elements = {{VertexElement::POSITIONS, offsetof(Vertex, position), sizeof(f32v3)},
+                     {0, offsetof(Vertex, normal), sizeof(f32v3)},
+                     {1, offsetof(Vertex, texcoord), sizeof(f32v2)}};
+  m_VertexBufferCPU.resize(numVertices);
+  cbm->getInterleavedVertices(layout, m_VertexBufferCPU.data());
 
   m_vertexBufferSize = m_VertexBufferCPU.size() * sizeof(Vertex);
 }
@@ -1,6 +1,6 @@
 #pragma once
-#include "AABB.hpp"
 #include <d3d12.h>
+#include <gimslib/geometry/AABB.hpp>
 #include <gimslib/types.hpp>
 #include <vector>
 #include <wrl.h>
@@ -2,9 +2,9 @@
 #include "TriangleMeshD3D12.hpp"
 #include <ConstantBufferD3D12.hpp>
 #include <Texture2DD3D12.hpp>
-#include <assimp/scene.h>
 #include <d3d12.h>
 #include <d3dx12/d3dx12.h>
+#include <gimslib/scene/SceneGraph.hpp>
 #include <gimslib/types.hpp>
 #include <iostream>
 #include <vector>
@@ -12,11 +12,6 @@
 namespace gims
 {
 
-static inline glm::mat4 aiMatrix4x4ToGlm(const aiMatrix4x4& from)
-{
-  return glm::transpose(glm::make_mat4(&from.a1));
-}
-
 class SceneGraphFactory;
 
 /// <summary>
@@ -30,13 +25,7 @@ public:
   /// <summary>
   /// Node of the scene graph.
   /// </summary>
-  struct Node
-  {
-    f32m4             transformation;           //! Transformation to parent node.
-    f32m4             worldSpaceTransformation; //! Transformation into world space
-    std::vector<ui32> meshIndices;              //! Index in the array of meshIndices, i.e., Scene::m_meshes[].
-    std::vector<ui32> childIndices;             //! Index in the array of nodes, i.e.,Scene::m_nodes[].
-  };
+  using Node = SceneGraph::Node;
 
   /// <summary>
   /// Material information per mesh that will be uploaded to the GPU.
@@ -1,7 +1,8 @@
 #pragma once
-#include "AABB.hpp"
 #include <d3d12.h>
 #include <d3dx12/d3dx12.h>
+#include <gimslib/geometry/AABB.hpp>
+#include <gimslib/geometry/TriangleMeshView.hpp>
 #include <gimslib/types.hpp>
 #include <vector>
 #include <wrl.h>
@@ -60,6 +61,13 @@ public:
   /// <returns><The material index of the mesh./returns>
   const ui32 getMaterialIndex() const;
 
+  /// <summary>
+  /// Returns a view of m_vertices and m_indices, e.g., for building a CPU-side BVH. Valid while the mesh lives and
+  /// m_startVertex is the offset that was added to the indices.
+  /// </summary>
+  /// <returns>The triangle mesh view.</returns>
+  TriangleMeshView getTriangleMeshView() const;
+
   const ComPtr<ID3D12Resource>& getVertexBuffer() const;
   const ComPtr<ID3D12Resource>& getIndexBuffer() const;
 
@@ -1,133 +1,48 @@
 #include "SceneFactory.hpp"
-#include <assimp/Importer.hpp>
-#include <assimp/postprocess.h>
-#include <assimp/scene.h>
 #include <d3dx12/d3dx12.h>
 #include <gimslib/d3d/UploadHelper.hpp>
 #include <gimslib/dbg/HrException.hpp>
+#include <gimslib/scene/SceneGraphImporter.hpp>
 #include <iostream>
 using namespace gims;
 
 namespace
 {
-/// <summary>
-/// Converts the index buffer required for D3D12 rendering from an aiMesh.
-/// </summary>
-/// <param name="mesh">The ai mesh containing an index buffer.</param>
-/// <returns></returns>
-std::vector<ui32v3> getTriangleIndicesFromAiMesh(aiMesh const* const mesh, ui32 baseVertexForMesh)
-{
-  std::vector<ui32v3> result;
-  if (!mesh->HasFaces())
-    return result;
-
-  result.reserve(mesh->mNumFaces);
-  for (ui32 i = 0; i < mesh->mNumFaces; i++)
-  {
-    const aiFace& currentFace = mesh->mFaces[i];
-    if (currentFace.mNumIndices == 3)
-    {
-      result.emplace_back(currentFace.mIndices[0] + baseVertexForMesh, currentFace.mIndices[1] + baseVertexForMesh,
-                          currentFace.mIndices[2] + baseVertexForMesh);
-    }
-    else
-    {
-      std::cout << "Not 3 indices" << std::endl;
-    }
-  }
-
-  return result;
-}
+//! Index of the first texture of the scene in Scene::m_textures. The default textures come first.
+const ui32 firstSceneTextureIndex = 3;
 
-ui8 getDefaultTextureIndexForTextureType(aiTextureType aiTextureTypeValue)
+ui8 getDefaultTextureIndexForTextureType(ui32 textureType)
 {
-  if (aiTextureTypeValue == aiTextureType_AMBIENT)
+  if (textureType == SceneGraph::AMBIENT)
     return 1;
-  if (aiTextureTypeValue == aiTextureType_DIFFUSE)
+  if (textureType == SceneGraph::DIFFUSE)
     return 0;
-  if (aiTextureTypeValue == aiTextureType_SPECULAR)
+  if (textureType == SceneGraph::SPECULAR)
     return 0;
-  if (aiTextureTypeValue == aiTextureType_EMISSIVE)
+  if (textureType == SceneGraph::EMISSIVE)
     return 1;
-  if (aiTextureTypeValue == aiTextureType_HEIGHT)
+  if (textureType == SceneGraph::HEIGHT)
     return 2;
   return 0;
 }
 
-void addTextureToDescriptorHeap(const ComPtr<ID3D12Device>& device, aiTextureType aiTextureTypeValue,
-                                i32 offsetInDescriptors, aiMaterial const* const inputMaterial,
-                                std::vector<Texture2DD3D12>& m_textures, ComPtr<ID3D12DescriptorHeap> descriptorHeap,
-                                std::unordered_map<std::filesystem::path, ui32> textureFileNameToTextureIndex)
+void addTextureToDescriptorHeap(const ComPtr<ID3D12Device>& device, ui32 textureType, i32 offsetInDescriptors,
+                                const SceneGraph::Material& inputMaterial, std::vector<Texture2DD3D12>& m_textures,
+                                ComPtr<ID3D12DescriptorHeap> descriptorHeap)
 {
-  // default texture
-  if (inputMaterial->GetTextureCount(aiTextureTypeValue) == 0)
+  const ui32 textureIndex = inputMaterial.textures[textureType];
+  if (textureIndex == SceneGraph::NO_TEXTURE) // default texture
   {
-
-    m_textures[getDefaultTextureIndexForTextureType(aiTextureTypeValue)].addToDescriptorHeap(device, descriptorHeap,
-                                                                                             offsetInDescriptors);
-    std::cout << "Added texture: " << aiTextureTypeValue << " at index: " << offsetInDescriptors << std::endl;
+    m_textures[getDefaultTextureIndexForTextureType(textureType)].addToDescriptorHeap(device, descriptorHeap,
+                                                                                      offsetInDescriptors);
   }
   else // custom texture
   {
-    aiString path;
-    inputMaterial->GetTexture(aiTextureTypeValue, 0, &path);
-    m_textures[textureFileNameToTextureIndex[path.C_Str()]].addToDescriptorHeap(device, descriptorHeap,
-                                                                                offsetInDescriptors);
-    std::cout << "Added texture: " << aiTextureTypeValue << " at index: " << offsetInDescriptors << std::endl;
+    m_textures[firstSceneTextureIndex + textureIndex].addToDescriptorHeap(device, descriptorHeap,
+                                                                          offsetInDescriptors);
   }
+  std::cout << "Added texture: " << textureType << " at index: " << offsetInDescriptors << std::endl;
 }
-
-std::unordered_map<std::filesystem::path, ui32> textureFilenameToIndex(aiScene const* const inputScene)
-{
-  std::unordered_map<std::filesystem::path, ui32> textureFileNameToTextureIndex;
-
-  ui32 textureIdx = 3;
-  for (ui32 mIdx = 0; mIdx < inputScene->mNumMaterials; mIdx++)
-  {
-    for (ui32 textureType = aiTextureType_NONE; textureType < aiTextureType_UNKNOWN; textureType++)
-    {
-      for (ui32 i = 0; i < inputScene->mMaterials[mIdx]->GetTextureCount((aiTextureType)textureType); i++)
-      {
-        aiString path;
-        inputScene->mMaterials[mIdx]->GetTexture((aiTextureType)textureType, i, &path);
-
-        const auto texturePathCstr = path.C_Str();
-        const auto textureIter     = textureFileNameToTextureIndex.find(texturePathCstr);
-        if (textureIter == textureFileNameToTextureIndex.end())
-        {
-          textureFileNameToTextureIndex.emplace(texturePathCstr, static_cast<ui32>(textureIdx));
-          textureIdx++;
-        }
-      }
-    }
-  }
-  return textureFileNameToTextureIndex;
-}
-/// <summary>
-/// Reads the color from the Asset Importer specific (pKey, type, idx) triple.
-/// Use the Asset Importer Macros AI_MATKEY_COLOR_AMBIENT, AI_MATKEY_COLOR_DIFFUSE, etc. which map to these arguments
-/// correctly.
-///
-/// If that key does not exist a null vector is returned.
-/// </summary>
-/// <param name="pKey">Asset importer specific parameter</param>
-/// <param name="type"></param>
-/// <param name="idx"></param>
-/// <param name="material">The material from which we wish to extract the color.</param>
-/// <returns>Color or 0 vector if no color exists.</returns>
-f32v4 getColor(char const* const pKey, unsigned int type, unsigned int idx, aiMaterial const* const material)
-{
-  aiColor3D color;
-  if (material->Get(pKey, type, idx, color) == aiReturn_SUCCESS)
-  {
-    return f32v4(color.r, color.g, color.b, 0.0f);
-  }
-  else
-  {
-    return f32v4(0.0f);
-  }
-}
-
 } // namespace
 
 namespace gims
@@ -136,30 +51,11 @@ Scene SceneGraphFactory::createFromAssImpScene(const std::filesystem::path
                                                const ComPtr<ID3D12Device>&       device,
                                                const ComPtr<ID3D12CommandQueue>& commandQueue)
 {
-  Scene outputScene;
-
-  const auto absolutePath = std::filesystem::weakly_canonical(pathToScene);
-  if (!std::filesystem::exists(absolutePath))
-  {
-    throw std::exception((absolutePath.string() + std::string(" does not exist.")).c_str());
-  }
-
-  const auto arguments = aiPostProcessSteps::aiProcess_Triangulate | aiProcess_GenSmoothNormals |
-                         aiProcess_GenUVCoords | aiProcess_ConvertToLeftHanded | aiProcess_OptimizeMeshes |
-                         aiProcess_RemoveRedundantMaterials | aiProcess_ImproveCacheLocality |
-                         aiProcess_FindInvalidData | aiProcess_FindDegenerates | aiProcess_CalcTangentSpace;
-
-  Assimp::Importer imp;
-  imp.SetPropertyBool(AI_CONFIG_PP_FD_REMOVE, true);
-  auto inputScene = imp.ReadFile(absolutePath.string(), arguments);
-  if (!inputScene)
-  {
-    throw std::exception((absolutePath.string() + std::string(" can't be loaded. with Assimp.")).c_str());
-  }
-  const auto textureFileNameToTextureIndex = textureFilenameToIndex(inputScene);
+  Scene            outputScene;
+  const SceneGraph inputScene = SceneGraphImporter::load(pathToScene);
 
   ui32 numOfDescriptors =
-      (ui32)(inputScene->mNumMaterials * 5 + 2); // 5 for material textures + 2 (vertex and index buffer)
+      (ui32)(inputScene.materials.size() * 5 + 2); // 5 for material textures + 2 (vertex and index buffer)
 
   outputScene.m_totalDescriptorCount = numOfDescriptors;
 
@@ -177,14 +73,13 @@ Scene SceneGraphFactory::createFromAssImpScene(const std::filesystem::path
 
   createMeshes(inputScene, device, commandQueue, outputScene);
 
-  f32m4 identity = glm::identity<f32m4>();
-  createNodes(inputScene, outputScene, inputScene->mRootNode, identity);
+  outputScene.m_nodes = inputScene.nodes;
 
   std::cout << outputScene.m_nodes.size() << std::endl;
 
-  computeSceneAABB(outputScene, outputScene.m_aabb, 0, glm::identity<f32m4>());
-  createTextures(textureFileNameToTextureIndex, absolutePath.parent_path(), device, commandQueue, outputScene);
-  createMaterials(inputScene, textureFileNameToTextureIndex, device, outputScene);
+  outputScene.m_aabb = inputScene.aabb;
+  createTextures(inputScene, device, commandQueue, outputScene);
+  createMaterials(inputScene, device, outputScene);
 
   return outputScene;
 }
@@ -196,72 +91,31 @@ Scene SceneGraphFactory::createFromAssImpScene(const std::filesystem::path
 /// <param name="device"></param>
 /// <param name="commandQueue"></param>
 /// <param name="outputScene"></param>
-void SceneGraphFactory::createMeshes(aiScene const* const inputScene, const ComPtr<ID3D12Device>& device,
+void SceneGraphFactory::createMeshes(const SceneGraph& inputScene, const ComPtr<ID3D12Device>& device,
                                      const ComPtr<ID3D12CommandQueue>& commandQueue, Scene& outputScene)
 {
   ui32                descriptorIndex = 0;
   std::vector<Vertex> globalVertices;
   std::vector<ui32>   globalIndices;
 
-  for (ui32 i = 0; i < inputScene->mNumMeshes; i++)
+  for (ui32 i = 0; i < (ui32)inputScene.meshes.size(); i++)
   {
-    const aiMesh* currentMesh = inputScene->mMeshes[i];
-
-    // get positions and normals
-    const ui32         numVertices = currentMesh->mNumVertices;
-    std::vector<f32v3> positions;
-    positions.reserve(numVertices);
-    std::vector<f32v3> normals;
-    normals.reserve(numVertices);
-    std::vector<f32v3> textureCoords;
-    textureCoords.reserve(numVertices);
-    std::vector<f32v3> tangents;
-    tangents.reserve(numVertices);
-    for (ui32 n = 0; n < numVertices; n++)
+    const SceneGraph::Mesh& currentMesh = inputScene.meshes[i];
+    const ui32              numVertices = (ui32)currentMesh.positions.size();
+
+    // get triangle indices, offset into the global vertex buffer
+    std::vector<ui32v3> indexBuffer;
+    indexBuffer.reserve(currentMesh.triangles.size());
+    for (const auto& triangle : currentMesh.triangles)
     {
-      const aiVector3D& currentPos = currentMesh->mVertices[n];
-      positions.emplace_back(currentPos.x, currentPos.y, currentPos.z);
-
-      if (currentMesh->HasNormals())
-      {
-        const aiVector3D& currentNormal = currentMesh->mNormals[n];
-        normals.emplace_back(currentNormal.x, currentNormal.y, currentNormal.z);
-      }
-      else
-      {
-        normals.emplace_back(0.0f, 0.0f, 0.0f); // default normal if missing
-      }
-
-      if (currentMesh->HasTextureCoords(0))
-      {
-        const aiVector3D& currentTexCoord = currentMesh->mTextureCoords[0][n];
-        textureCoords.emplace_back(currentTexCoord.x, currentTexCoord.y, 0.0f);
-      }
-      else
-      {
-        textureCoords.emplace_back(0.0f, 0.0f, 0.0f); // default UV if missing
-      }
-
-      if (currentMesh->HasTangentsAndBitangents())
-      {
-        const aiVector3D& currentTangent = currentMesh->mTangents[i];
-        tangents.emplace_back(currentTangent.x, currentTangent.y, currentTangent.z);
-      }
-      else
-      {
-        tangents.emplace_back(0.0f, 0.0f, 0.0f);
-      }
+      indexBuffer.emplace_back(triangle + static_cast<ui32>(globalVertices.size()));
     }
-
-    // get triangle indices
-    const std::vector<ui32v3> indexBuffer =
-        getTriangleIndicesFromAiMesh(currentMesh, static_cast<ui32>(globalVertices.size()));
     const ui32 numIndices = 3 * static_cast<ui32>(indexBuffer.size()); // mul by 3, because of vec3
 
     // create internal mesh
     TriangleMeshD3D12 createdMesh = TriangleMeshD3D12::TriangleMeshD3D12(
-        positions.data(), normals.data(), textureCoords.data(), numVertices, indexBuffer.data(), numIndices,
-        tangents.data(), currentMesh->mMaterialIndex);
+        currentMesh.positions.data(), currentMesh.normals.data(), currentMesh.textureCoordinates.data(), numVertices,
+        indexBuffer.data(), numIndices, currentMesh.tangents.data(), currentMesh.materialIndex);
 
     if (/*i == 0 || */i == 2/* || i == 4*/)
     {
@@ -338,66 +192,10 @@ void SceneGraphFactory::createMeshes(aiScene const* const inputScene, const ComP
   std::cout << "Total Global Indices: " << globalIndices.size() << std::endl;
 }
 
-ui32 SceneGraphFactory::createNodes(aiScene const* const inputScene, Scene& outputScene, aiNode const* const assimpNode,
-                                    f32m4 worldSpaceTransformation)
-{
-  (void)inputScene;
-
-  // create node and add to list
-  outputScene.m_nodes.emplace_back();
-  const auto   currentNodeIndex = static_cast<ui32>(outputScene.m_nodes.size() - 1);
-  Scene::Node& currentNode      = outputScene.m_nodes.back();
-
-  // set transformation to parent
-  const aiMatrix4x4 parentRelativeTransformation = assimpNode->mTransformation;
-  glm::mat4         convertedAssimpTrafo         = aiMatrix4x4ToGlm(parentRelativeTransformation);
-  currentNode.transformation                     = convertedAssimpTrafo;
-  worldSpaceTransformation                       = worldSpaceTransformation * convertedAssimpTrafo;
-  currentNode.worldSpaceTransformation           = worldSpaceTransformation;
-
-  // set mesh indices
-  for (ui32 i = 0; i < assimpNode->mNumMeshes; i++)
-  {
-    currentNode.meshIndices.push_back(assimpNode->mMeshes[i]);
-  }
-
-  // traverse children
-  aiNode** childrenOfInputNode = assimpNode->mChildren;
-  for (ui32 i = 0; i < assimpNode->mNumChildren; i++)
-  {
-    const ui32 childNodeIndex = createNodes(inputScene, outputScene, childrenOfInputNode[i], worldSpaceTransformation);
-    outputScene.m_nodes.at(currentNodeIndex).childIndices.emplace_back(childNodeIndex);
-  }
-
-  return currentNodeIndex;
-}
-
-void SceneGraphFactory::computeSceneAABB(Scene& scene, AABB& accuAABB, ui32 nodeIdx, f32m4 accuTransformation)
+void SceneGraphFactory::createTextures(const SceneGraph& inputScene, const ComPtr<ID3D12Device>& device,
+                                       const ComPtr<ID3D12CommandQueue>& commandQueue, Scene& outputScene)
 {
-  // get current node
-  const auto& currentNode = scene.getNode(nodeIdx);
-
-  // update transformation
-  accuTransformation = accuTransformation * currentNode.transformation;
-
-  // merge aabb for each mesh
-  for (const auto& meshIndex : currentNode.meshIndices)
-  {
-    const auto transformedMeshAABB = scene.m_meshes[meshIndex].getAABB().getTransformed(accuTransformation);
-    accuAABB                       = accuAABB.getUnion(transformedMeshAABB);
-  }
-  for (ui32 i = 0; i < (ui32)currentNode.childIndices.size(); i++)
-  {
-    computeSceneAABB(scene, accuAABB, currentNode.childIndices[i], accuTransformation);
-  }
-}
-
-void SceneGraphFactory::createTextures(
-    const std::unordered_map<std::filesystem::path, ui32>& textureFileNameToTextureIndex,
-    std::filesystem::path parentPath, const ComPtr<ID3D12Device>& device,
-    const ComPtr<ID3D12CommandQueue>& commandQueue, Scene& outputScene)
-{
-  outputScene.m_textures.resize(ui32(textureFileNameToTextureIndex.size() + 3));
+  outputScene.m_textures.resize(ui32(inputScene.textureFileNames.size() + firstSceneTextureIndex));
   // create default textures
   const auto white             = gims::ui8v4(255, 255, 255, 255);
   const auto black             = gims::ui8v4(0, 0, 0, 255);
@@ -406,38 +204,30 @@ void SceneGraphFactory::createTextures(
   outputScene.m_textures.at(1) = Texture2DD3D12(&black, 1, 1, device, commandQueue); // black
   outputScene.m_textures.at(2) = Texture2DD3D12(&blue, 1, 1, device, commandQueue);  // blue
 
-  // create every texture in "textureFileNameToTextureIndex"
-  for (const auto& entry : textureFileNameToTextureIndex)
+  // create every texture referenced by the scene
+  for (ui32 i = 0; i < (ui32)inputScene.textureFileNames.size(); i++)
   {
-    const std::filesystem::path pathToFilename = parentPath / entry.first;
+    const std::filesystem::path pathToFilename = inputScene.directory / inputScene.textureFileNames[i];
     const Texture2DD3D12        createdTexture(pathToFilename, device, commandQueue);
-    outputScene.m_textures.at(entry.second) = createdTexture;
+    outputScene.m_textures.at(firstSceneTextureIndex + i) = createdTexture;
   }
 }
 
-void SceneGraphFactory::createMaterials(aiScene const* const                            inputScene,
-                                        std::unordered_map<std::filesystem::path, ui32> textureFileNameToTextureIndex,
-                                        const ComPtr<ID3D12Device>& device, Scene& outputScene)
+void SceneGraphFactory::createMaterials(const SceneGraph& inputScene, const ComPtr<ID3D12Device>& device,
+                                        Scene& outputScene)
 {
   ui32 descriptorIndex = 2; // vertex and index buffer already added
 
   // iterate over materials in the scene
-  for (ui32 i = 0; i < inputScene->mNumMaterials; i++)
+  for (ui32 i = 0; i < (ui32)inputScene.materials.size(); i++)
   {
-    aiMaterial*                   currentMaterial = inputScene->mMaterials[i];
+    const SceneGraph::Material&   currentMaterial = inputScene.materials[i];
     Scene::MaterialConstantBuffer mcb;
 
-    // fill mcb by extracting data from assimp
-    f32v4 emissiveFactors = getColor(AI_MATKEY_COLOR_EMISSIVE, currentMaterial);
-    mcb.ambientColor      = getColor(AI_MATKEY_COLOR_AMBIENT, currentMaterial) + emissiveFactors;
-    mcb.diffuseColor      = getColor(AI_MATKEY_COLOR_DIFFUSE, currentMaterial);
-    ai_real specularExponent;
-    aiGetMaterialFloat(currentMaterial, AI_MATKEY_SHININESS, &specularExponent);
-    ai_real reflectivity;
-    aiGetMaterialFloat(currentMaterial, AI_MATKEY_REFLECTIVITY, &reflectivity);
-    mcb.reflectivity             = reflectivity;
-    f32v4 specularColor          = getColor(AI_MATKEY_COLOR_SPECULAR, currentMaterial);
-    mcb.specularColorAndExponent = f32v4(specularColor.r, specularColor.g, specularColor.b, specularExponent);
+    mcb.ambientColor             = f32v4(currentMaterial.ambientColor + currentMaterial.emissiveColor, 0.0f);
+    mcb.diffuseColor             = f32v4(currentMaterial.diffuseColor, 0.0f);
+    mcb.specularColorAndExponent = f32v4(currentMaterial.specularColor, currentMaterial.specularExponent);
+    mcb.reflectivity             = currentMaterial.reflectivity;
 
     // create constant buffer
     ConstantBufferD3D12 materialConstantBuffer(mcb, device);
@@ -445,32 +235,19 @@ void SceneGraphFactory::createMaterials(aiScene const* const
     // create material and add to scene
     outputScene.m_materials.emplace_back(materialConstantBuffer, outputScene.m_globalDescriptorHeap, descriptorIndex);
 
-    addTextureToDescriptorHeap(device, aiTextureType_AMBIENT, descriptorIndex++, currentMaterial,
-                               outputScene.m_textures, outputScene.m_globalDescriptorHeap,
-                               textureFileNameToTextureIndex);
-    addTextureToDescriptorHeap(device, aiTextureType_DIFFUSE, descriptorIndex++, currentMaterial,
-                               outputScene.m_textures, outputScene.m_globalDescriptorHeap,
-                               textureFileNameToTextureIndex);
-    addTextureToDescriptorHeap(device, aiTextureType_SPECULAR, descriptorIndex++, currentMaterial,
-                               outputScene.m_textures, outputScene.m_globalDescriptorHeap,
-                               textureFileNameToTextureIndex);
-    addTextureToDescriptorHeap(device, aiTextureType_EMISSIVE, descriptorIndex++, currentMaterial,
-                               outputScene.m_textures, outputScene.m_globalDescriptorHeap,
-                               textureFileNameToTextureIndex);
-    addTextureToDescriptorHeap(device, aiTextureType_HEIGHT, descriptorIndex++, currentMaterial, outputScene.m_textures,
-                               outputScene.m_globalDescriptorHeap, textureFileNameToTextureIndex);
+    for (ui32 textureType = 0; textureType < SceneGraph::NUM_TEXTURE_TYPES; textureType++)
+    {
+      addTextureToDescriptorHeap(device, textureType, descriptorIndex++, currentMaterial, outputScene.m_textures,
+                                 outputScene.m_globalDescriptorHeap);
+    }
 
     // log for debug
-    std::cout << "Created material: " << currentMaterial->GetName().C_Str() << std::endl;
+    std::cout << "Created material: " << currentMaterial.name << std::endl;
     std::cout << "Ambient Color: " << glm::to_string(mcb.ambientColor) << std::endl;
     std::cout << "Diffuse Color: " << glm::to_string(mcb.diffuseColor) << std::endl;
     std::cout << "Specular Color with exponent: " << glm::to_string(mcb.specularColorAndExponent) << std::endl;
     // std::cout << "Reflectivity: " << glm::to_string(mcb.reflectivity) << std::endl;
   }
-
-  // Assignment 9
-  (void)textureFileNameToTextureIndex;
-  // Assignment 10
 }
 
 } // namespace gims
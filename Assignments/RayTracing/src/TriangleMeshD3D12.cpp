@@ -46,6 +46,18 @@ void TriangleMeshD3D12::addToCommandList(const ComPtr<ID3D12GraphicsCommandList>
   commandList->DrawIndexedInstanced(m_nIndices, 1, m_startIndex, 0, 0);
 }
 
+TriangleMeshView TriangleMeshD3D12::getTriangleMeshView() const
+{
+  // The position is the first member of a Vertex.
+  TriangleMeshView result;
+  result.positions      = m_vertices.data();
+  result.positionStride = sizeof(Vertex);
+  result.triangles      = reinterpret_cast<const ui32v3*>(m_indices.data());
+  result.nTriangles     = static_cast<ui32>(m_indices.size() / 3);
+  result.baseVertex     = m_startVertex;
+  return result;
+}
+
 const ComPtr<ID3D12Resource>& TriangleMeshD3D12::getVertexBuffer() const
 {
   return m_vertexBuffer;
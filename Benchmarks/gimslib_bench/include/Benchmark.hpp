@@ -0,0 +1,63 @@
+#pragma once
+#include <functional>
+#include <gimslib/types.hpp>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace gims
+{
+//! \brief Timing of one operation on one mesh.
+struct BenchmarkResult
+{
+  std::string mesh;
+  ui64        nVertices;
+  ui64        nTriangles;
+  std::string operation;
+  ui64        bytes;    //! Bytes processed by one run of the operation, e.g., the size of the file.
+  f64         minMs;    //! Fastest run.
+  f64         medianMs; //! Median run.
+  f64         megabytesPerSecond; //! bytes / minMs in MB/s, with 1 MB = 10^6 bytes.
+  ui64        nRays             = 0;   //! Rays traced by one run of a ray tracing operation, otherwise 0.
+  f64         megaraysPerSecond = 0.0; //! nRays / minMs in Mrays/s.
+};
+
+//! \brief Runs operations repeatedly, keeps their timings and writes them as JSON.
+class Benchmark
+{
+public:
+  //! \param[in]  nRepetitions Number of timed runs per operation.
+  explicit Benchmark(ui32 nRepetitions);
+
+  //! \brief Times an operation.
+  //! \param[in]  mesh Name of the mesh the operation works on.
+  //! \param[in]  nVertices Number of vertices of the mesh.
+  //! \param[in]  nTriangles Number of triangles of the mesh.
+  //! \param[in]  operation Name of the operation, e.g., "load_v1".
+  //! \param[in]  bytes Bytes processed by one run.
+  //! \param[in]  run The timed operation.
+  //! \param[in]  setup Called before every run and not timed. May be empty.
+  void measure(const std::string& mesh, ui64 nVertices, ui64 nTriangles, const std::string& operation, ui64 bytes,
+               const std::function<void()>& run, const std::function<void()>& setup = {});
+
+  //! \brief Times an operation that traces rays and reports its throughput in Mrays/s.
+  //! \param[in]  nRays Rays traced by one run.
+  //! \param[in]  run The timed operation. Run it on one thread to obtain the throughput per core.
+  //! See measure() for the other parameters.
+  void measureRays(const std::string& mesh, ui64 nVertices, ui64 nTriangles, const std::string& operation, ui64 nRays,
+                   const std::function<void()>& run);
+
+  //! \brief Writes all results as a JSON document.
+  void writeJson(std::ostream& stream) const;
+
+  const std::vector<BenchmarkResult>& getResults() const;
+
+private:
+  //! \brief Returns the minimum and the median time of the runs in milliseconds.
+  std::pair<f64, f64> time(const std::function<void()>& run, const std::function<void()>& setup) const;
+
+  ui32                         m_nRepetitions;
+  std::vector<BenchmarkResult> m_results;
+};
+} // namespace gims
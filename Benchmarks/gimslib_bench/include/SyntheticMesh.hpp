@@ -0,0 +1,11 @@
+#pragma once
+#include <gimslib/io/CograBinaryMeshFile.hpp>
+
+namespace gims
+{
+//! \brief Creates a tessellated, wavy height field with normals and texture coordinates.
+//!
+//! The attributes are "Normals" (3 x f32) and "TexCoords" (2 x f32), in the same order as in data/bunny.cbm.
+//! \param[in]  nTriangles Minimum number of triangles. The grid is square, so the result has slightly more.
+CograBinaryMeshFile createGridMesh(ui64 nTriangles);
+} // namespace gims
@@ -0,0 +1,113 @@
+#include <Benchmark.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <tuple>
+
+namespace
+{
+std::string escapeJson(const std::string& text)
+{
+  std::string result;
+  for (const char c : text)
+  {
+    if (c == '"' || c == '\\')
+    {
+      result += '\\';
+    }
+    result += c;
+  }
+  return result;
+}
+} // namespace
+
+namespace gims
+{
+Benchmark::Benchmark(ui32 nRepetitions)
+    : m_nRepetitions(std::max(1u, nRepetitions))
+{
+}
+
+void Benchmark::measure(const std::string& mesh, ui64 nVertices, ui64 nTriangles, const std::string& operation,
+                        ui64 bytes, const std::function<void()>& run, const std::function<void()>& setup)
+{
+  BenchmarkResult result;
+  result.mesh                             = mesh;
+  result.nVertices                        = nVertices;
+  result.nTriangles                       = nTriangles;
+  result.operation                        = operation;
+  result.bytes                            = bytes;
+  std::tie(result.minMs, result.medianMs) = time(run, setup);
+  result.megabytesPerSecond               = result.minMs > 0.0 ? f64(bytes) / (result.minMs * 1000.0) : 0.0;
+  m_results.push_back(result);
+
+  std::cerr << std::left << std::setw(24) << mesh << std::setw(20) << operation << std::right << std::fixed
+            << std::setprecision(3) << std::setw(12) << result.minMs << " ms" << std::setprecision(1) << std::setw(12)
+            << result.megabytesPerSecond << " MB/s\n";
+}
+
+void Benchmark::measureRays(const std::string& mesh, ui64 nVertices, ui64 nTriangles, const std::string& operation,
+                            ui64 nRays, const std::function<void()>& run)
+{
+  BenchmarkResult result;
+  result.mesh                             = mesh;
+  result.nVertices                        = nVertices;
+  result.nTriangles                       = nTriangles;
+  result.operation                        = operation;
+  result.bytes                            = 0;
+  std::tie(result.minMs, result.medianMs) = time(run, {});
+  result.megabytesPerSecond               = 0.0;
+  result.nRays                            = nRays;
+  result.megaraysPerSecond                = result.minMs > 0.0 ? f64(nRays) / (result.minMs * 1000.0) : 0.0;
+  m_results.push_back(result);
+
+  std::cerr << std::left << std::setw(24) << mesh << std::setw(20) << operation << std::right << std::fixed
+            << std::setprecision(3) << std::setw(12) << result.minMs << " ms" << std::setprecision(2) << std::setw(12)
+            << result.megaraysPerSecond << " Mrays/s\n";
+}
+
+void Benchmark::writeJson(std::ostream& stream) const
+{
+  stream << "{\n  \"benchmark\": \"gimslib_bench\",\n  \"repetitions\": " << m_nRepetitions
+         << ",\n  \"results\": [";
+  for (size_t i = 0; i < m_results.size(); i++)
+  {
+    const auto& r = m_results[i];
+    stream << (i == 0 ? "\n" : ",\n") << "    {\"mesh\": \"" << escapeJson(r.mesh) << "\", \"vertices\": " << r.nVertices
+           << ", \"triangles\": " << r.nTriangles << ", \"operation\": \"" << escapeJson(r.operation)
+           << "\", \"bytes\": " << r.bytes << std::fixed << std::setprecision(4) << ", \"minMs\": " << r.minMs
+           << ", \"medianMs\": " << r.medianMs << ", \"megabytesPerSecond\": " << std::setprecision(2)
+           << r.megabytesPerSecond;
+    if (r.nRays > 0)
+    {
+      stream << ", \"rays\": " << r.nRays << ", \"megaraysPerSecond\": " << r.megaraysPerSecond;
+    }
+    stream << "}";
+  }
+  stream << "\n  ]\n}\n";
+}
+
+const std::vector<BenchmarkResult>& Benchmark::getResults() const
+{
+  return m_results;
+}
+
+std::pair<f64, f64> Benchmark::time(const std::function<void()>& run, const std::function<void()>& setup) const
+{
+  std::vector<f64> timings;
+  for (ui32 i = 0; i < m_nRepetitions; i++)
+  {
+    if (setup)
+    {
+      setup();
+    }
+    const auto start = std::chrono::steady_clock::now();
+    run();
+    const auto end = std::chrono::steady_clock::now();
+    timings.push_back(std::chrono::duration<f64, std::milli>(end - start).count());
+  }
+  std::sort(timings.begin(), timings.end());
+  return {timings.front(), timings[timings.size() / 2]};
+}
+} // namespace gims
@@ -0,0 +1,62 @@
+#include <SyntheticMesh.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace gims
+{
+CograBinaryMeshFile createGridMesh(ui64 nTriangles)
+{
+  // n x n quads with two triangles each
+  const ui64 n         = std::max<ui64>(1, static_cast<ui64>(std::ceil(std::sqrt(f64(nTriangles) / 2.0))));
+  const ui64 nVertices = (n + 1) * (n + 1);
+
+  std::vector<f32> positions(nVertices * 3);
+  std::vector<f32> normals(nVertices * 3);
+  std::vector<f32> texCoords(nVertices * 2);
+  for (ui64 y = 0; y <= n; y++)
+  {
+    for (ui64 x = 0; x <= n; x++)
+    {
+      const ui64 vIdx = y * (n + 1) + x;
+      const f32  u    = f32(x) / f32(n);
+      const f32  v    = f32(y) / f32(n);
+      // height h(u, v) = a * sin(f * u) * cos(f * v)
+      const f32   a      = 0.05f;
+      const f32   f      = 12.0f;
+      const f32v3 normal = glm::normalize(f32v3(-a * f * std::cos(f * u) * std::cos(f * v),
+                                                a * f * std::sin(f * u) * std::sin(f * v), 1.0f));
+
+      positions[vIdx * 3 + 0] = u - 0.5f;
+      positions[vIdx * 3 + 1] = v - 0.5f;
+      positions[vIdx * 3 + 2] = a * std::sin(f * u) * std::cos(f * v);
+      normals[vIdx * 3 + 0]   = normal.x;
+      normals[vIdx * 3 + 1]   = normal.y;
+      normals[vIdx * 3 + 2]   = normal.z;
+      texCoords[vIdx * 2 + 0] = u;
+      texCoords[vIdx * 2 + 1] = v;
+    }
+  }
+
+  std::vector<ui32> indices;
+  indices.reserve(n * n * 6);
+  for (ui64 y = 0; y < n; y++)
+  {
+    for (ui64 x = 0; x < n; x++)
+    {
+      const ui32 v00 = static_cast<ui32>(y * (n + 1) + x);
+      const ui32 v10 = v00 + 1;
+      const ui32 v01 = v00 + static_cast<ui32>(n + 1);
+      const ui32 v11 = v01 + 1;
+      indices.insert(indices.end(), {v00, v10, v11, v00, v11, v01});
+    }
+  }
+
+  CograBinaryMeshFile result;
+  result.setPositions(positions.data(), static_cast<ui32>(nVertices));
+  result.setTriangleIndices(indices.data(), static_cast<ui32>(indices.size() / 3));
+  result.addAttribute(normals.data(), 3, sizeof(f32), "Normals");
+  result.addAttribute(texCoords.data(), 2, sizeof(f32), "TexCoords");
+  return result;
+}
+} // namespace gims
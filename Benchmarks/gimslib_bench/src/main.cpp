@@ -0,0 +1,439 @@
+#include <Benchmark.hpp>
+#include <SyntheticMesh.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <gimslib/accel/BVH.hpp>
+#include <gimslib/accel/BVHCache.hpp>
+#include <gimslib/accel/BVHReport.hpp>
+#include <gimslib/accel/TLAS.hpp>
+#include <gimslib/accel/WideBVH.hpp>
+#include <gimslib/geometry/AABB.hpp>
+#include <gimslib/io/CograBinaryMeshFile.hpp>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace gims;
+
+namespace
+{
+struct Options
+{
+  std::filesystem::path dataDirectory = GIMS_BENCH_DATA_DIR;
+  std::filesystem::path outputFile;
+  std::filesystem::path tempDirectory = std::filesystem::temp_directory_path();
+  std::filesystem::path bvhReportDirectory;
+  ui64                  minTriangles  = 10'000;
+  ui64                  maxTriangles  = 50'000'000;
+  ui32                  nRepetitions  = 5;
+};
+
+void printUsage()
+{
+  std::cerr << "Usage: gimslib_bench [options]\n"
+               "  --data <dir>            Directory that contains bunny.cbm.\n"
+               "  --output <file>         Writes the JSON results to a file instead of stdout.\n"
+               "  --temp <dir>            Directory for the files written by the save benchmarks.\n"
+               "  --bvh-reports <dir>     Writes the quality figures of the BVHs of each mesh as JSON files.\n"
+               "  --min-triangles <n>     Smallest synthetic mesh (default 10000).\n"
+               "  --max-triangles <n>     Largest synthetic mesh (default 50000000).\n"
+               "  --repetitions <n>       Timed runs per operation (default 5).\n";
+}
+
+Options parseOptions(int argc, char** argv)
+{
+  Options result;
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string argument = argv[i];
+    if (i + 1 >= argc)
+    {
+      throw std::runtime_error("Missing value for " + argument + ".");
+    }
+    const std::string value = argv[++i];
+    if (argument == "--data")
+    {
+      result.dataDirectory = value;
+    }
+    else if (argument == "--output")
+    {
+      result.outputFile = value;
+    }
+    else if (argument == "--temp")
+    {
+      result.tempDirectory = value;
+    }
+    else if (argument == "--bvh-reports")
+    {
+      result.bvhReportDirectory = value;
+    }
+    else if (argument == "--min-triangles")
+    {
+      result.minTriangles = std::stoull(value);
+    }
+    else if (argument == "--max-triangles")
+    {
+      result.maxTriangles = std::stoull(value);
+    }
+    else if (argument == "--repetitions")
+    {
+      result.nRepetitions = static_cast<ui32>(std::stoul(value));
+    }
+    else
+    {
+      throw std::runtime_error("Unknown option " + argument + ".");
+    }
+  }
+  return result;
+}
+
+//! Bytes of the positions, indices and attributes of a mesh.
+ui64 getPayloadSize(const CograBinaryMeshFile& mesh)
+{
+  return ui64(mesh.getNumVertices()) * (3 * sizeof(f32) + mesh.getTotalAttributeSize()) +
+         ui64(mesh.getNumTriangles()) * 3 * sizeof(ui32);
+}
+
+//! Rays through the pixels of a square image, from a camera in front of the box towards its center along -z. The rays
+//! are ordered by tiles of 4 x 4 pixels, so that consecutive rays are coherent.
+std::vector<Ray> createPrimaryRays(const AABB& aabb, ui32 resolution)
+{
+  const f32v3 center = (aabb.getLowerLeftBottom() + aabb.getUpperRightTop()) * 0.5f;
+  const f32   extent = glm::length(aabb.getUpperRightTop() - aabb.getLowerLeftBottom());
+  const f32v3 origin = center + f32v3(0.0f, 0.0f, 2.0f * extent);
+
+  std::vector<Ray> result;
+  result.reserve(size_t(resolution) * resolution);
+  for (ui32 tileY = 0; tileY < resolution; tileY += 4)
+  {
+    for (ui32 tileX = 0; tileX < resolution; tileX += 4)
+    {
+      for (ui32 y = tileY; y < std::min(tileY + 4, resolution); y++)
+      {
+        for (ui32 x = tileX; x < std::min(tileX + 4, resolution); x++)
+        {
+          const f32v2 pixel = (f32v2(f32(x), f32(y)) + 0.5f) / f32(resolution) - 0.5f;
+          Ray         ray;
+          ray.origin    = origin;
+          ray.direction = f32v3(pixel * 0.6f, -1.0f);
+          result.push_back(ray);
+        }
+      }
+    }
+  }
+  return result;
+}
+
+//! Traces primary rays and shadow rays from their hits towards a point light. Single-threaded, i.e., per core.
+void benchmarkRayTracing(Benchmark& benchmark, const std::string& name, ui64 nV, ui64 nT, const TriangleMeshView& mesh,
+                         ThreadPool& threadPool)
+{
+  TLAS         tlas;
+  TLASInstance instance;
+  instance.bottomLevelIdx = tlas.addBottomLevel(mesh, BVHBuildOptions(), &threadPool);
+  tlas.addInstance(instance);
+  tlas.build();
+
+  const auto          primaryRays = createPrimaryRays(tlas.getAABB(), 512);
+  const auto          nPrimary    = static_cast<ui32>(primaryRays.size());
+  std::vector<RayHit> hits(primaryRays.size());
+  benchmark.measureRays(name, nV, nT, "trace_closest", nPrimary,
+                        [&]()
+                        {
+                          for (ui32 rIdx = 0; rIdx < nPrimary; rIdx++)
+                          {
+                            hits[rIdx] = tlas.traceRay(primaryRays[rIdx]);
+                          }
+                        });
+  benchmark.measureRays(name, nV, nT, "trace_closest_packet", nPrimary,
+                        [&]() { tlas.traceRays(primaryRays.data(), nPrimary, hits.data()); });
+
+  const AABB&      aabb  = tlas.getAABB();
+  const f32v3      light = aabb.getUpperRightTop() + (aabb.getUpperRightTop() - aabb.getLowerLeftBottom());
+  std::vector<Ray> shadowRays;
+  for (ui32 rIdx = 0; rIdx < nPrimary; rIdx++)
+  {
+    if (hits[rIdx].isHit())
+    {
+      Ray ray;
+      ray.origin    = primaryRays[rIdx].origin + hits[rIdx].t * primaryRays[rIdx].direction;
+      ray.direction = light - ray.origin;
+      ray.tMin      = 1e-4f;
+      ray.tMax      = 1.0f;
+      shadowRays.push_back(ray);
+    }
+  }
+  const auto nShadow = static_cast<ui32>(shadowRays.size());
+  benchmark.measureRays(name, nV, nT, "trace_shadow", nShadow,
+                        [&]()
+                        {
+                          for (ui32 rIdx = 0; rIdx < nShadow; rIdx++)
+                          {
+                            hits[rIdx] = tlas.traceRay(shadowRays[rIdx], 0xff, true);
+                          }
+                        });
+  benchmark.measureRays(name, nV, nT, "trace_shadow_packet", nShadow,
+                        [&]() { tlas.traceRays(shadowRays.data(), nShadow, hits.data(), 0xff, true); });
+}
+
+//! Compares the binary BVH with the wide BVHs collapsed from it, in size and in single-ray closest-hit traversal.
+void benchmarkWideBVH(Benchmark& benchmark, const std::string& name, ui64 nV, ui64 nT, const TriangleMeshView& mesh,
+                      const BVH& bvh)
+{
+  BVH4 bvh4;
+  BVH8 bvh8;
+  benchmark.measure(name, nV, nT, "bvh4_collapse", bvh.getMemorySize(), [&]() { bvh4 = BVH4(bvh); });
+  benchmark.measure(name, nV, nT, "bvh8_collapse", bvh.getMemorySize(), [&]() { bvh8 = BVH8(bvh); });
+  std::cerr << std::left << std::setw(24) << name << "memory: bvh " << bvh.getMemorySize() << " bytes, bvh4 "
+            << bvh4.getMemorySize() << " bytes, bvh8 " << bvh8.getMemorySize() << " bytes\n";
+
+  const auto          rays  = createPrimaryRays(bvh.getAABB(), 512);
+  const auto          nRays = static_cast<ui32>(rays.size());
+  std::vector<RayHit> hits(rays.size());
+  const auto          trace = [&](const auto& accelerationStructure)
+  {
+    for (ui32 rIdx = 0; rIdx < nRays; rIdx++)
+    {
+      hits[rIdx] = RayHit();
+      accelerationStructure.intersect(mesh, rays[rIdx], hits[rIdx]);
+    }
+  };
+  benchmark.measureRays(name, nV, nT, "trace_closest_bvh", nRays, [&]() { trace(bvh); });
+  benchmark.measureRays(name, nV, nT, "trace_closest_bvh4", nRays, [&]() { trace(bvh4); });
+  benchmark.measureRays(name, nV, nT, "trace_closest_bvh8", nRays, [&]() { trace(bvh8); });
+}
+
+//! Compares linear BVHs with the SAH BVH in build time, SAH cost, and single-ray closest-hit traversal.
+void benchmarkLBVH(Benchmark& benchmark, ThreadPool& threadPool, const std::string& name, ui64 nV, ui64 nT,
+                   const TriangleMeshView& mesh, const BVH& bvh)
+{
+  const ui64      bytes = nV * 3 * sizeof(f32) + nT * 3 * sizeof(ui32);
+  BVHBuildOptions options;
+  options.algorithm = BVHBuildAlgorithm::LBVH;
+  BVHBuildOptions treeletOptions = options;
+  treeletOptions.nTreeletRounds  = 3;
+  BVH lbvh, lbvhParallel, lbvhTreelets;
+  benchmark.measure(name, nV, nT, "bvh_lbvh", bytes, [&]() { lbvh = BVH(mesh, options); });
+  benchmark.measure(name, nV, nT, "bvh_lbvh_parallel", bytes,
+                    [&]() { lbvhParallel = BVH(mesh, options, &threadPool); });
+  benchmark.measure(name, nV, nT, "bvh_lbvh_treelets_parallel", bytes,
+                    [&]() { lbvhTreelets = BVH(mesh, treeletOptions, &threadPool); });
+  if (lbvh.getNodes().size() != lbvhParallel.getNodes().size() ||
+      lbvh.getPrimitiveIndices() != lbvhParallel.getPrimitiveIndices())
+  {
+    throw std::runtime_error("The linear BVHs of " + name + " differ.");
+  }
+  std::cerr << std::left << std::setw(24) << name << "sah cost: bvh " << bvh.getStatistics().sahCost << ", lbvh "
+            << lbvh.getStatistics().sahCost << ", lbvh with treelets " << lbvhTreelets.getStatistics().sahCost << "\n";
+
+  const auto          rays  = createPrimaryRays(bvh.getAABB(), 512);
+  const auto          nRays = static_cast<ui32>(rays.size());
+  std::vector<RayHit> hits(rays.size());
+  const auto          trace = [&](const BVH& accelerationStructure)
+  {
+    for (ui32 rIdx = 0; rIdx < nRays; rIdx++)
+    {
+      hits[rIdx] = RayHit();
+      accelerationStructure.intersect(mesh, rays[rIdx], hits[rIdx]);
+    }
+  };
+  benchmark.measureRays(name, nV, nT, "trace_closest_lbvh", nRays, [&]() { trace(lbvh); });
+  benchmark.measureRays(name, nV, nT, "trace_closest_lbvh_treelets", nRays, [&]() { trace(lbvhTreelets); });
+}
+
+//! Writes the quality figures of the SAH BVH and of linear BVHs of a mesh, traced with the rays of a camera in front of
+//! the mesh, to <directory>/<name>_<builder>.json.
+void writeBVHReports(const std::filesystem::path& directory, ThreadPool& threadPool, const std::string& name,
+                     const TriangleMeshView& mesh, const BVH& bvh)
+{
+  const f32v3 center = (bvh.getAABB().getLowerLeftBottom() + bvh.getAABB().getUpperRightTop()) * 0.5f;
+  const f32   extent = glm::length(bvh.getAABB().getUpperRightTop() - bvh.getAABB().getLowerLeftBottom());
+  const f32m4 viewMatrix = glm::lookAtLH(center + f32v3(0.0f, 0.0f, 2.0f * extent), center, f32v3(0.0f, 1.0f, 0.0f));
+  const f32m4 projectionMatrix = glm::perspectiveFovLH_ZO(glm::radians(35.0f), 512.0f, 512.0f, 0.01f, 4.0f * extent);
+  const auto  rays             = createCameraRays(viewMatrix, projectionMatrix, 512, 512);
+
+  BVHBuildOptions lbvhOptions;
+  lbvhOptions.algorithm = BVHBuildAlgorithm::LBVH;
+  BVHBuildOptions treeletOptions = lbvhOptions;
+  treeletOptions.nTreeletRounds  = 3;
+  const BVH                                lbvh(mesh, lbvhOptions, &threadPool);
+  const BVH                                lbvhTreelets(mesh, treeletOptions, &threadPool);
+  const std::pair<std::string, const BVH*> bvhs[] = {
+      {"sah", &bvh}, {"lbvh", &lbvh}, {"lbvh_treelets", &lbvhTreelets}};
+  std::filesystem::create_directories(directory);
+  for (const auto& [builder, builtBVH] : bvhs)
+  {
+    std::ofstream file(directory / (name + "_" + builder + ".json"));
+    BVHReport(*builtBVH, mesh, rays, &threadPool).writeJson(file);
+  }
+}
+
+//! Runs all benchmarks on a mesh. part is merged 16 times for the merge benchmark.
+void benchmarkMesh(Benchmark& benchmark, ThreadPool& threadPool, const Options& options, const std::string& name,
+                   CograBinaryMeshFile& mesh, const CograBinaryMeshFile& part)
+{
+  const ui64 nV      = mesh.getNumVertices();
+  const ui64 nT      = mesh.getNumTriangles();
+  const auto measure = [&](const std::string& operation, ui64 bytes, const std::function<void()>& run,
+                           const std::function<void()>& setup = {})
+  { benchmark.measure(name, nV, nT, operation, bytes, run, setup); };
+
+  // file I/O. The files are read right after they were written, so they are usually in the page cache.
+  const auto v1File    = (options.tempDirectory / "gimslib_bench_v1.cbm").string();
+  const auto v2File    = (options.tempDirectory / "gimslib_bench_v2.cbm").string();
+  const auto v2zFile   = (options.tempDirectory / "gimslib_bench_v2z.cbm").string();
+  const auto fileBytes = [](const std::string& fileName) { return ui64(std::filesystem::file_size(fileName)); };
+
+  mesh.save(v1File);
+  measure("save_v1", fileBytes(v1File), [&]() { mesh.save(v1File); });
+  mesh.save(v2File, CograBinaryMeshFile::FileVersion::V2);
+  measure("save_v2", fileBytes(v2File), [&]() { mesh.save(v2File, CograBinaryMeshFile::FileVersion::V2); });
+  mesh.save(v2zFile, CograBinaryMeshFile::FileVersion::V2, CograBinaryMeshFile::COMPRESS_ALL);
+  measure("save_v2_compressed", fileBytes(v2zFile),
+          [&]() { mesh.save(v2zFile, CograBinaryMeshFile::FileVersion::V2, CograBinaryMeshFile::COMPRESS_ALL); });
+
+  CograBinaryMeshFile loaded;
+  const auto          reset = [&]() { loaded = CograBinaryMeshFile(); };
+  measure("load_v1", fileBytes(v1File), [&]() { loaded.load(v1File); }, reset);
+  measure("load_v2", fileBytes(v2File), [&]() { loaded.load(v2File); }, reset);
+  measure("load_v2_compressed", fileBytes(v2zFile), [&]() { loaded.load(v2zFile); }, reset);
+  measure("map_v2_verified", fileBytes(v2File), [&]() { loaded = CograBinaryMeshFile::map(v2File, true); }, reset);
+  reset();
+
+  // in-memory processing
+  const auto       layout = mesh.getPackedVertexLayout();
+  std::vector<ui8> staging(nV * layout.stride);
+  measure("interleave", staging.size(), [&]() { mesh.getInterleavedVertices(layout, staging.data()); });
+  std::vector<std::vector<ui8>> planeStorage(layout.elements.size());
+  std::vector<void*>            planes;
+  for (size_t eIdx = 0; eIdx < layout.elements.size(); eIdx++)
+  {
+    planeStorage[eIdx].resize(nV * layout.elements[eIdx].size);
+    planes.push_back(planeStorage[eIdx].data());
+  }
+  measure("deinterleave", staging.size(), [&]() { deinterleaveVertices(layout, staging.data(), nV, planes.data()); });
+
+  // The scalar loop is the baseline for the vectorized and the multithreaded reduction.
+  const auto* positions = reinterpret_cast<const f32v3*>(mesh.getPositionsPtr());
+  f32v3       aabbMin, aabbMax;
+  measure("aabb_scalar", nV * 3 * sizeof(f32),
+          [&]()
+          {
+            aabbMin = f32v3(std::numeric_limits<f32>::max());
+            aabbMax = f32v3(-std::numeric_limits<f32>::max());
+            for (ui64 vIdx = 0; vIdx < nV; vIdx++)
+            {
+              aabbMin = glm::min(aabbMin, positions[vIdx]);
+              aabbMax = glm::max(aabbMax, positions[vIdx]);
+            }
+          });
+  AABB aabb, aabbParallel;
+  measure("aabb", nV * 3 * sizeof(f32), [&]() { aabb = AABB(positions, nV); });
+  measure("aabb_parallel", nV * 3 * sizeof(f32), [&]() { aabbParallel = AABB(positions, nV, &threadPool); });
+  if (aabb.getLowerLeftBottom() != aabbMin || aabb.getUpperRightTop() != aabbMax ||
+      aabbParallel.getLowerLeftBottom() != aabbMin || aabbParallel.getUpperRightTop() != aabbMax)
+  {
+    throw std::runtime_error("The bounding boxes of " + name + " differ.");
+  }
+
+  TriangleMeshView meshView;
+  meshView.positions  = positions;
+  meshView.triangles  = reinterpret_cast<const ui32v3*>(mesh.getTriangleIndices());
+  meshView.nTriangles = static_cast<ui32>(nT);
+  BVH bvh, bvhParallel;
+  measure("bvh_sah", nV * 3 * sizeof(f32) + nT * 3 * sizeof(ui32), [&]() { bvh = BVH(meshView); });
+  measure("bvh_sah_parallel", nV * 3 * sizeof(f32) + nT * 3 * sizeof(ui32),
+          [&]() { bvhParallel = BVH(meshView, BVHBuildOptions(), &threadPool); });
+  if (bvh.getNodes().size() != bvhParallel.getNodes().size() ||
+      bvh.getPrimitiveIndices() != bvhParallel.getPrimitiveIndices())
+  {
+    throw std::runtime_error("The BVHs of " + name + " differ.");
+  }
+
+  // A warm start hashes the mesh and loads the BVH from the cache instead of building it.
+  const auto bvhFile = (options.tempDirectory / "gimslib_bench.bvh").string();
+  ui64       key     = 0;
+  measure("bvh_cache_key", nV * 3 * sizeof(f32) + nT * 3 * sizeof(ui32),
+          [&]() { key = BVHCache::computeKey(meshView, BVHBuildOptions()); });
+  bvh.save(bvhFile, key);
+  BVH loadedBVH;
+  measure("bvh_cache_load", fileBytes(bvhFile), [&]() { loadedBVH = BVH::load(bvhFile, key); },
+          [&]() { loadedBVH = BVH(); });
+  if (loadedBVH.getNodes().size() != bvh.getNodes().size() ||
+      loadedBVH.getPrimitiveIndices() != bvh.getPrimitiveIndices())
+  {
+    throw std::runtime_error("The loaded BVH of " + name + " differs.");
+  }
+  std::filesystem::remove(bvhFile);
+  benchmarkRayTracing(benchmark, name, nV, nT, meshView, threadPool);
+  benchmarkWideBVH(benchmark, name, nV, nT, meshView, bvh);
+  benchmarkLBVH(benchmark, threadPool, name, nV, nT, meshView, bvh);
+  if (!options.bvhReportDirectory.empty())
+  {
+    writeBVHReports(options.bvhReportDirectory, threadPool, name, meshView, bvh);
+  }
+
+  const std::vector<const CograBinaryMeshFile*> parts(16, &part);
+  CograBinaryMeshFile                           merged;
+  measure("merge_16", 16 * getPayloadSize(part), [&]() { merged = CograBinaryMeshFile::merge(parts, &threadPool); },
+          [&]() { merged = CograBinaryMeshFile(); });
+
+  std::filesystem::remove(v1File);
+  std::filesystem::remove(v2File);
+  std::filesystem::remove(v2zFile);
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+  try
+  {
+    const Options options = parseOptions(argc, argv);
+    Benchmark     benchmark(options.nRepetitions);
+    ThreadPool    threadPool;
+
+    const auto bunnyFile = (options.dataDirectory / "bunny.cbm").string();
+    if (std::filesystem::exists(bunnyFile))
+    {
+      CograBinaryMeshFile bunny(bunnyFile);
+      benchmarkMesh(benchmark, threadPool, options, "bunny.cbm", bunny, bunny);
+    }
+    else
+    {
+      std::cerr << bunnyFile << " not found, skipping it.\n";
+    }
+
+    for (const ui64 nTriangles : {10'000ull, 100'000ull, 1'000'000ull, 10'000'000ull, 50'000'000ull})
+    {
+      if (nTriangles < options.minTriangles || nTriangles > options.maxTriangles)
+      {
+        continue;
+      }
+      auto       mesh = createGridMesh(nTriangles);
+      const auto part = createGridMesh(nTriangles / 16);
+      benchmarkMesh(benchmark, threadPool, options, "grid_" + std::to_string(nTriangles), mesh, part);
+    }
+
+    if (options.outputFile.empty())
+    {
+      benchmark.writeJson(std::cout);
+    }
+    else
+    {
+      std::ofstream outFile(options.outputFile);
+      benchmark.writeJson(outFile);
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Error: " << e.what() << "\n";
+    printUsage();
+    return 1;
+  }
+  return 0;
+}
@@ -9,3 +9,9 @@ option(FEATURE_DOCS "Enable the docs" OFF)
 
 # fuzz tests
 option(FEATURE_FUZZ_TESTS "Enable the fuzz tests" OFF)
+
+# benchmarks, e.g., gimslib_bench. They only depend on gimslib_core and build on every platform.
+option(FEATURE_BENCHMARKS "Enable the benchmarks" ON)
+
+# tools, e.g., the CPU reference renderer of the RayTracing assignment. They only depend on gimslib_core.
+option(FEATURE_TOOLS "Enable the tools" ON)
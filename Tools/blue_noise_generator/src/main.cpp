@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <gimslib/io/ImageWriter.hpp>
+#include <gimslib/sampling/BlueNoiseGenerator.hpp>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace gims;
+
+namespace
+{
+struct Options
+{
+  BlueNoiseOptions      blueNoise;
+  std::filesystem::path output   = "blue_noise.png";
+  ui32                  nThreads = 0;
+};
+
+void printUsage()
+{
+  std::cerr << "Usage: blue_noise_generator [options]\n"
+               "  --type <name>                2d (independent slices, default), 3d, or spatiotemporal.\n"
+               "  --width <n>                  Width of the texture (default 64).\n"
+               "  --height <n>                 Height of the texture (default 64).\n"
+               "  --depth <n>                  Number of slices (default 1).\n"
+               "  --channels <n>               Independent values per texel (default 1).\n"
+               "  --sigma <f>                  Standard deviation of the energy within a slice (default 1.9).\n"
+               "  --depth-sigma <f>            Standard deviation of the energy across slices (default 1.9).\n"
+               "  --density <f>                Fraction of the texels in the initial pattern (default 0.1).\n"
+               "  --seed <n>                   Seed of the initial patterns (default 0).\n"
+               "  --threads <n>                Threads, 0 uses one per hardware thread (default 0).\n"
+               "  --output <file>              Writes a PNG with 8 bits per channel per slice, named <file>_<z>.png\n"
+               "                               if there are several, or, if the file ends with .raw, all values as\n"
+               "                               32-bit floats at [((z * height + y) * width + x) * channels + c].\n";
+}
+
+Options parseOptions(int argc, char** argv)
+{
+  Options result;
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string argument = argv[i];
+    if (i + 1 >= argc)
+    {
+      throw std::runtime_error("Missing value for " + argument + ".");
+    }
+    const std::string value = argv[++i];
+    if (argument == "--type")
+    {
+      if (value == "2d")
+      {
+        result.blueNoise.type = BlueNoiseType::TEXTURE_2D;
+      }
+      else if (value == "3d")
+      {
+        result.blueNoise.type = BlueNoiseType::TEXTURE_3D;
+      }
+      else if (value == "spatiotemporal")
+      {
+        result.blueNoise.type = BlueNoiseType::SPATIOTEMPORAL;
+      }
+      else
+      {
+        throw std::runtime_error("Unknown type " + value + ".");
+      }
+    }
+    else if (argument == "--width")
+    {
+      result.blueNoise.width = static_cast<ui32>(std::stoul(value));
+    }
+    else if (argument == "--height")
+    {
+      result.blueNoise.height = static_cast<ui32>(std::stoul(value));
+    }
+    else if (argument == "--depth")
+    {
+      result.blueNoise.depth = static_cast<ui32>(std::stoul(value));
+    }
+    else if (argument == "--channels")
+    {
+      result.blueNoise.nChannels = static_cast<ui32>(std::stoul(value));
+    }
+    else if (argument == "--sigma")
+    {
+      result.blueNoise.sigma = std::stof(value);
+    }
+    else if (argument == "--depth-sigma")
+    {
+      result.blueNoise.depthSigma = std::stof(value);
+    }
+    else if (argument == "--density")
+    {
+      result.blueNoise.initialDensity = std::stof(value);
+    }
+    else if (argument == "--seed")
+    {
+      result.blueNoise.seed = static_cast<ui32>(std::stoul(value));
+    }
+    else if (argument == "--threads")
+    {
+      result.nThreads = static_cast<ui32>(std::stoul(value));
+    }
+    else if (argument == "--output")
+    {
+      result.output = value;
+    }
+    else
+    {
+      throw std::runtime_error("Unknown option " + argument + ".");
+    }
+  }
+  return result;
+}
+
+void writeRaw(const std::filesystem::path& fileName, const BlueNoiseTexture& texture)
+{
+  std::ofstream file(fileName, std::ios::binary);
+  file.write(reinterpret_cast<const char*>(texture.values.data()),
+             static_cast<std::streamsize>(texture.values.size() * sizeof(f32)));
+  if (!file)
+  {
+    throw std::runtime_error("Error writing " + fileName.string() + ".");
+  }
+}
+
+//! One PNG per slice, which Texture2DD3D12 loads. Value v becomes floor(v * 256), so every byte is equally frequent.
+void writePNGs(const std::filesystem::path& fileName, const BlueNoiseTexture& texture)
+{
+  if (texture.nChannels > 4)
+  {
+    throw std::runtime_error("PNGs hold at most four channels.");
+  }
+  for (ui32 z = 0; z < texture.depth; z++)
+  {
+    std::filesystem::path sliceFileName = fileName;
+    if (texture.depth > 1)
+    {
+      char suffix[16];
+      std::snprintf(suffix, sizeof(suffix), "_%03u", z);
+      sliceFileName.replace_filename(fileName.stem().string() + suffix + fileName.extension().string());
+    }
+    const size_t     nValuesPerSlice = size_t(texture.width) * texture.height * texture.nChannels;
+    std::vector<ui8> pixels(nValuesPerSlice);
+    for (size_t i = 0; i < nValuesPerSlice; i++)
+    {
+      pixels[i] = static_cast<ui8>(std::min(texture.values[z * nValuesPerSlice + i] * 256.0f, 255.0f));
+    }
+    writePNG(sliceFileName, pixels.data(), texture.width, texture.height, texture.nChannels);
+  }
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+  try
+  {
+    const Options options = parseOptions(argc, argv);
+    ThreadPool    threadPool(options.nThreads);
+
+    const auto             start   = std::chrono::steady_clock::now();
+    const BlueNoiseTexture texture = generateBlueNoise(options.blueNoise, &threadPool);
+    const f64              seconds = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+
+    if (options.output.extension() == ".raw")
+    {
+      writeRaw(options.output, texture);
+    }
+    else
+    {
+      writePNGs(options.output, texture);
+    }
+    std::cout << "texels: " << texture.width << "x" << texture.height << "x" << texture.depth << " with "
+              << texture.nChannels << " channels\nthreads: " << threadPool.getNumThreads()
+              << "\ntime: " << seconds * 1000.0 << " ms\n";
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Error: " << e.what() << "\n";
+    printUsage();
+    return 1;
+  }
+  return 0;
+}
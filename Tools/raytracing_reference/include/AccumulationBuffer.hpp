@@ -0,0 +1,68 @@
+#pragma once
+#include <gimslib/types.hpp>
+#include <vector>
+
+namespace gims
+{
+//! \brief Running mean and variance of the color samples of every pixel, for progressive rendering.
+//!
+//! The statistics are updated with Welford's algorithm, which does not lose precision to the cancellation of a sum
+//! of squares when many samples are added. Besides the color, the luminance is tracked, whose variance decides when a
+//! pixel has converged.
+class AccumulationBuffer
+{
+public:
+  //! \brief Creates a buffer without samples.
+  AccumulationBuffer(ui32 width, ui32 height);
+
+  //! \brief Adds a sample to a pixel.
+  //! \param[in]  pixelIdx Index of the pixel, row by row from the top left pixel.
+  void addSample(ui32 pixelIdx, const f32v3& color);
+
+  //! \brief Marks a pixel as done. Progressive rendering skips it in later passes.
+  void setDone(ui32 pixelIdx);
+
+  bool isDone(ui32 pixelIdx) const;
+
+  ui32 getNumSamples(ui32 pixelIdx) const;
+
+  //! \brief Returns the mean of the samples of a pixel, zero without samples.
+  f32v3 getMean(ui32 pixelIdx) const;
+
+  //! \brief Returns the unbiased variance of the samples of a pixel, zero with fewer than two samples.
+  f32v3 getVariance(ui32 pixelIdx) const;
+
+  f32 getLuminanceMean(ui32 pixelIdx) const;
+
+  //! \brief Returns the unbiased variance of the luminance of the samples, zero with fewer than two samples.
+  f32 getLuminanceVariance(ui32 pixelIdx) const;
+
+  //! \brief Returns the means, row by row from the top left pixel, with an alpha of one.
+  std::vector<f32v4> getImage() const;
+
+  //! \brief Returns the variances of the means, i.e., the variances divided by the number of samples, with an alpha
+  //! of one. Their square roots are the standard errors of the image.
+  std::vector<f32v4> getVarianceImage() const;
+
+  ui32 getWidth() const;
+  ui32 getHeight() const;
+
+  //! \brief Returns the number of pixels that are done.
+  ui32 getNumDonePixels() const;
+
+private:
+  struct Pixel
+  {
+    f32v3 mean          = f32v3(0.0f);
+    f32v3 m2            = f32v3(0.0f); //! Sum of the squared deviations from the mean.
+    f32   luminanceMean = 0.0f;
+    f32   luminanceM2   = 0.0f;
+    ui32  nSamples      = 0;
+    bool  isDone        = false;
+  };
+
+  ui32               m_width;
+  ui32               m_height;
+  std::vector<Pixel> m_pixels;
+};
+} // namespace gims
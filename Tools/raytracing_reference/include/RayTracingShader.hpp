@@ -0,0 +1,174 @@
+#pragma once
+#include <ReferenceScene.hpp>
+#include <ShadowRaySampler.hpp>
+#include <gimslib/accel/Ray.hpp>
+#include <gimslib/accel/RayQuery.hpp>
+#include <gimslib/accel/TLAS.hpp>
+#include <gimslib/types.hpp>
+#include <vector>
+
+namespace gims
+{
+//! Same layout as PointLight in RayTracing.hlsl.
+struct PointLight
+{
+  f32v3 position;
+  f32   intensity;
+
+  f32v3 color;
+  f32   padding;
+};
+
+//! Same layout as AreaLight in RayTracing.hlsl.
+struct AreaLight
+{
+  f32v3 position;
+  f32   intensity;
+
+  f32v3 color;
+  f32   width;
+
+  f32v3 normal;
+  f32   height;
+};
+
+//! Same layout as the cbuffer PerFrameConstants in RayTracing.hlsl.
+struct PerFrameConstants
+{
+  f32m4 projectionMatrix;
+  f32m4 inverseViewMatrix; //! Inverse of the camera transformation, which excludes the normalization of the scene.
+  f32   shadowBias;
+  f32v3 environmentColor;
+  i32   numRays;
+  f32   samplingOffset;
+  f32   minT;
+  f32   reflectionFactor;
+  f32   shadowFactor;
+  i32   flags; //! Bit 0 selects the area lights. Bit 1 is set by the reflection checkbox, but PS_main ignores it.
+};
+
+//! Same layout as the cbuffer PerMeshConstants in RayTracing.hlsl.
+struct PerMeshConstants
+{
+  f32m4 modelViewMatrix;
+  f32m4 modelMatrix;
+  i32   isReflectiveFlag;
+  i32   meshDescriptorIndex;
+};
+
+//! The cbuffers PointLightBuffer and AreaLightBuffer in RayTracing.hlsl. The shader holds at most eight lights each.
+struct LightConstants
+{
+  std::vector<PointLight> pointLights;
+  std::vector<AreaLight>  areaLights;
+};
+
+//! Same as VertexShaderOutput in RayTracing.hlsl, except for SV_POSITION, which only the rasterizer reads.
+struct VertexShaderOutput
+{
+  f32v3 viewSpacePosition;
+  f32v3 objectSpacePosition;
+  f32v3 worldSpacePosition;
+  f32v3 viewSpaceNormal;
+  f32v3 worldSpaceNormal;
+  f32v3 viewSpaceTangent;
+  f32v3 viewSpaceBitangent;
+  f32v2 texCoord;
+
+  //! \brief Interpolates the outputs of the corners of a triangle like the rasterizer does.
+  //! \param[in]  barycentrics Weights of the second and the third corner, as in RayHit.
+  static VertexShaderOutput interpolate(const VertexShaderOutput& v0, const VertexShaderOutput& v1,
+                                        const VertexShaderOutput& v2, const f32v2& barycentrics);
+};
+
+//! \brief Port of VS_main and PS_main of Assignments/RayTracing/shaders/RayTracing.hlsl to the CPU.
+//!
+//! The port keeps the control flow, the constants, and the quirks of the shader, e.g., that the point-light shadow
+//! factor carries over from one light to the next and that the flag of the reflection checkbox is ignored, so that
+//! its images are a reference for the GPU. Inline ray queries run on the ReferenceScene TLAS through RayQuery, whose
+//! work the shader counts. Hence, a shader must not be used by several threads at once.
+//! Images agree with the GPU up to the precision of sin(), which seeds the random offsets, and of the rasterizer.
+//! A ShadowRaySampler replaces the sin() hash with stratified random numbers, see setShadowRaySampler().
+class RayTracingShader
+{
+public:
+  //! \param[in]  scene Provides the vertex and index buffers, the textures, and the TLAS.
+  //! \param[in]  perFrame The per-frame constants.
+  //! \param[in]  lights The point and the area lights.
+  RayTracingShader(const ReferenceScene& scene, const PerFrameConstants& perFrame, const LightConstants& lights);
+
+  //! \brief VS_main for the vertex vertexID of the global vertex buffer.
+  VertexShaderOutput vsMain(ui32 vertexID, const PerMeshConstants& perMesh) const;
+
+  //! \brief PS_main for a fragment of a draw call with the given constants.
+  f32v4 psMain(const VertexShaderOutput& input, const PerMeshConstants& perMesh,
+               const ReferenceScene::Material& material);
+
+  //! \brief Returns the work of the ray queries of psMain() since the construction or the last reset.
+  const TLASTraversalCounters& getRayQueryCounters() const;
+
+  //! \brief Sets the counters of getRayQueryCounters() to zero.
+  void resetRayQueryCounters();
+
+  //! \brief Sets the index that the jittered shadow rays of a fragment start counting at.
+  //!
+  //! The index seeds the random offsets of the shadow rays. PS_main starts at 0, the default. Progressive rendering
+  //! continues the sequence of a fragment in its later samples, so that they add new shadow rays.
+  void setFirstShadowRayIndex(i32 firstShadowRayIdx);
+
+  //! \brief Sets the sampler of the random offsets of the shadow rays.
+  //! \param[in]  sampler If nullptr, the default, the offsets are those of GetRandomOffset() in the shader. Must
+  //!             outlive its use.
+  void setShadowRaySampler(const ShadowRaySampler* sampler);
+
+  //! \brief Sets the pixel of the next fragments, which selects their sequence of the shadow-ray sampler.
+  void setPixel(ui32 x, ui32 y);
+
+private:
+  //! Texture slots of a material, as in RayTracing.hlsl.
+  enum TextureSlot : ui32
+  {
+    AMBIENT_TEXTURE_INDEX  = 0,
+    DIFFUSE_TEXTURE_INDEX  = 1,
+    SPECULAR_TEXTURE_INDEX = 2,
+    EMMISIVE_TEXTURE_INDEX = 3,
+    NORMAL_TEXTURE_INDEX   = 4
+  };
+
+  //! Corresponds to HitInformation in RayTracing.hlsl.
+  struct HitInformation
+  {
+    f32v3 hitPosition;
+    f32v3 hitNormal;
+    f32v2 hitUV;
+  };
+
+  //! The query type of every ray of RayTracing.hlsl.
+  using ShaderRayQuery = RayQuery<RAY_FLAG_FORCE_OPAQUE | RAY_FLAG_SKIP_PROCEDURAL_PRIMITIVES>;
+
+  //! \brief q.Proceed(), which also adds the work of the query to the counters of the shader. Call once per query.
+  bool proceed(ShaderRayQuery& q);
+
+  f32v4 sampleTexture(ui32 textureIdx, const f32v2& texCoord) const;
+
+  //! \brief Returns the random offset of a shadow ray of the sampler, or seeded like the shader without a sampler.
+  //! \param[in]  seedScale Scales the ray index in the seeds of GetRandomOffset(), (0.123, 0.321) for point lights.
+  f32v2 getShadowRayOffset(const VertexShaderOutput& psInput, ui32 lightIdx, i32 rayIdx, const f32v2& seedScale) const;
+
+  f32v3 getPixelColorForPointLighting(i32 numShadowRays, f32 shadowFactor, const VertexShaderOutput& psInput,
+                                      const PerMeshConstants& perMesh, const ReferenceScene::Material& material);
+  f32v3 getPixelColorForAreaLighting(i32 numShadowRays, f32 shadowFactor, const VertexShaderOutput& psInput,
+                                     const PerMeshConstants& perMesh, const ReferenceScene::Material& material);
+  f32v3 getLightingColorForReflections(const HitInformation& hitInfo, ui32 baseMaterialIndex,
+                                       const ReferenceScene::Material& material);
+  f32v3 getPixelColorForReflections(const VertexShaderOutput& psInput, const ReferenceScene::Material& material);
+
+  const ReferenceScene&   m_scene;
+  PerFrameConstants       m_perFrame;
+  LightConstants          m_lights;
+  TLASTraversalCounters   m_rayQueryCounters;
+  i32                     m_firstShadowRayIdx = 0;
+  const ShadowRaySampler* m_shadowRaySampler  = nullptr;
+  ui32v2                  m_pixel             = ui32v2(0);
+};
+} // namespace gims
@@ -0,0 +1,126 @@
+#pragma once
+#include <AccumulationBuffer.hpp>
+#include <RayTracingShader.hpp>
+#include <ReferenceScene.hpp>
+#include <gimslib/accel/TLAS.hpp>
+#include <gimslib/sys/TileScheduler.hpp>
+#include <gimslib/types.hpp>
+#include <vector>
+
+namespace gims
+{
+class ThreadPool;
+
+//! \brief Timing and work of a frame.
+struct FrameStatistics
+{
+  TileSchedulerStatistics tiles;
+  //! Work of the ray queries of the shader, i.e., of the shadow and reflection rays. The primary rays that replace
+  //! the rasterizer are not counted.
+  TLASTraversalCounters   rayQueries;
+};
+
+//! \brief Parameters of ReferenceRenderer::renderProgressive().
+struct ProgressiveOptions
+{
+  //! numRays of the shader per sample. The image converges to the mean of PS_main with this numRays over the random
+  //! offsets. With one ray, the running shadow factor of a light cannot weight its own later rays.
+  i32  numRaysPerSample  = 1;
+  //! Samples a pixel takes in its first pass, before its variance is trusted.
+  ui32 minSamples        = 8;
+  //! Samples after which a pixel stops, even if it has not converged.
+  ui32 maxSamples        = 1024;
+  //! Upper bound of the samples a pixel takes in one pass after its first.
+  ui32 maxSamplesPerPass = 64;
+  //! A pixel has converged when the standard error of its luminance is below this fraction of its luminance.
+  f32  noiseThreshold    = 0.02f;
+  //! Luminance below which noiseThreshold is relative to noiseFloor instead, so that dark pixels stop, too.
+  f32  noiseFloor        = 0.05f;
+};
+
+//! \brief Timing and work of ReferenceRenderer::renderProgressive().
+struct ProgressiveStatistics
+{
+  ui32                  nPasses            = 0;
+  ui64                  nSamples           = 0; //! PS_main evaluations of all passes.
+  ui32                  nConvergedPixels   = 0; //! Pixels that met the noise threshold, including those without hit.
+  ui32                  maxSamplesPerPixel = 0;
+  f64                   seconds            = 0.0;
+  TLASTraversalCounters rayQueries;
+};
+
+//! \brief Renders frames of the RayTracing assignment on the CPU, tile by tile with work stealing.
+//!
+//! The rasterizer is replaced by a closest-hit ray through the center of every pixel. The hit is shaded by
+//! RayTracingShader::psMain() with the VS_main outputs of its triangle, interpolated like the rasterizer does. Pixels
+//! without a hit keep the clear color of the viewer, which is the environment color.
+class ReferenceRenderer
+{
+public:
+  //! \param[in]  scene The scene. Must outlive the renderer.
+  explicit ReferenceRenderer(const ReferenceScene& scene);
+
+  //! \brief Sets the sampler of the random offsets of the shadow rays, see RayTracingShader::setShadowRaySampler().
+  void setShadowRaySampler(const ShadowRaySampler* sampler);
+
+  //! \brief Renders a frame like SceneGraphViewerApp::onDraw().
+  //!
+  //! The draw calls get the constants of Scene::addToCommandList(), i.e., the view matrix is the camera transformation
+  //! followed by the normalization of the scene to the unit cube.
+  //! \param[in]  perFrame The per-frame constants. The projection and the inverse view matrix define the camera.
+  //! \param[in]  lights The lights.
+  //! \param[in]  width Number of pixels per row.
+  //! \param[in]  height Number of rows.
+  //! \param[in]  tileSize Width and height of the tiles that are scheduled.
+  //! \param[in]  threadPool If not nullptr, the tiles are rendered in parallel.
+  //! \param[out] image width * height colors, row by row from the top left pixel.
+  //! \return Timing and load balance of the tiles and the work of the ray queries.
+  FrameStatistics render(const PerFrameConstants& perFrame, const LightConstants& lights, ui32 width, ui32 height,
+                         ui32 tileSize, ThreadPool* threadPool, std::vector<f32v4>& image) const;
+
+  //! \brief Accumulates samples of the shader in passes until the noise of every pixel is below a threshold.
+  //!
+  //! A sample is a PS_main evaluation with options.numRaysPerSample shadow rays per light. Each sample of a pixel
+  //! continues the shadow-ray sequence of the samples before it, see RayTracingShader::setFirstShadowRayIndex(), so
+  //! the mean converges instead of repeating one frame. A pixel takes options.minSamples samples in its first pass.
+  //! Later passes only visit the pixels that have not converged, and each takes about half of the samples that its
+  //! variance says it still needs, so that rays go where the variance is high. A pixel stops when it converges or
+  //! reaches options.maxSamples. Pixels without a hit are constant and stop after one sample.
+  //! \param[in]  perFrame See render(). numRays is replaced by options.numRaysPerSample.
+  //! \param[in]  lights The lights.
+  //! \param[in]  options Sampling and stopping parameters.
+  //! \param[in]  tileSize Width and height of the tiles that are scheduled.
+  //! \param[in]  threadPool If not nullptr, the tiles are rendered in parallel.
+  //! \param[in,out] buffer The samples, which also define the size of the image. Pixels that are done are skipped.
+  //! \return Timing and work of all passes.
+  ProgressiveStatistics renderProgressive(const PerFrameConstants& perFrame, const LightConstants& lights,
+                                          const ProgressiveOptions& options, ui32 tileSize, ThreadPool* threadPool,
+                                          AccumulationBuffer& buffer) const;
+
+private:
+  //! The constants of the draw calls of a frame.
+  struct DrawConstants
+  {
+    f32m4                         clipToWorld;
+    std::vector<PerMeshConstants> perMeshConstants; //! One per instance.
+  };
+
+  //! The input of PS_main for the fragment of a pixel.
+  struct Fragment
+  {
+    VertexShaderOutput              input;
+    const PerMeshConstants*         perMesh;
+    const ReferenceScene::Material* material;
+  };
+
+  DrawConstants createDrawConstants(const PerFrameConstants& perFrame) const;
+
+  //! \brief Finds the fragment of the primary ray through the center of a pixel.
+  //! \return False if the ray hits nothing.
+  bool getFragment(const DrawConstants& drawConstants, const RayTracingShader& shader, ui32 x, ui32 y, ui32 width,
+                   ui32 height, Fragment& fragment) const;
+
+  const ReferenceScene&   m_scene;
+  const ShadowRaySampler* m_shadowRaySampler = nullptr;
+};
+} // namespace gims
@@ -0,0 +1,120 @@
+#pragma once
+#include <gimslib/accel/TLAS.hpp>
+#include <gimslib/geometry/AABB.hpp>
+#include <gimslib/scene/SceneGraph.hpp>
+#include <gimslib/types.hpp>
+#include <vector>
+
+namespace gims
+{
+class ThreadPool;
+class BVHCache;
+
+//! \brief CPU counterpart of the Scene that SceneGraphFactory creates for the RayTracing assignment.
+//!
+//! Holds the same global vertex and index buffers, the same material constants, the same texture bindings, and the
+//! same acceleration structure as the GPU scene, so that a port of RayTracing.hlsl reads identical data. Meshes are
+//! instanced once per node that references them, in the order of RayTracingUtils::createAccelerationStructures().
+class ReferenceScene
+{
+public:
+  //! Same layout as Vertex in RayTracing.hlsl.
+  struct Vertex
+  {
+    f32v3 position;
+    f32v3 normal;
+    f32v2 texCoord;
+    f32v3 tangent;
+    ui32  materialIndex;
+  };
+
+  //! Same layout as the cbuffer Material in RayTracing.hlsl.
+  struct Material
+  {
+    f32v4 ambientColor; //! Ambient plus emissive color, as in SceneGraphFactory::createMaterials().
+    f32v4 diffuseColor;
+    f32v4 specularColorAndExponent;
+    f32   reflectivity;
+  };
+
+  //! A mesh within the global buffers.
+  struct Mesh
+  {
+    ui32 startVertex;   //! First vertex in the global vertex buffer.
+    ui32 startIndex;    //! First index in the global index buffer, the instance ID of the mesh.
+    ui32 nIndices;      //! Three times the number of triangles.
+    ui32 materialIndex; //! Index into the materials.
+    bool isReflective;  //! isReflectiveFlag of the draw call.
+  };
+
+  //! A mesh drawn with the world-space transformation of a node. Instance i is instance i of the TLAS.
+  struct Instance
+  {
+    ui32  meshIdx;
+    f32m4 modelMatrix;
+  };
+
+  //! A texture with 8-bit RGBA texels, sampled like a Texture2D with DXGI_FORMAT_R8G8B8A8_UNORM.
+  struct Texture
+  {
+    ui32               width  = 0;
+    ui32               height = 0;
+    std::vector<ui8v4> texels; //! Row by row from the top left texel.
+
+    //! \brief Samples the texture like SamplerState g_sampler, i.e., nearest texel and wrapped coordinates.
+    f32v4 sample(const f32v2& texCoord) const;
+  };
+
+  //! Number of textures bound per material, the NUM_MATERIALS of RayTracing.hlsl.
+  static constexpr ui32 NUM_TEXTURES_PER_MATERIAL = SceneGraph::NUM_TEXTURE_TYPES;
+
+  //! \brief Creates the scene from a scene graph and loads the textures it references.
+  //! \param[in]  sceneGraph The scene graph, e.g., from SceneGraphImporter::load().
+  //! \param[in]  reflectiveMeshIndices Meshes that are drawn with isReflectiveFlag set. SceneGraphFactory hard-codes
+  //!             mesh 2.
+  //! \param[in]  threadPool If not nullptr, the bottom-level BVHs are built in parallel.
+  //! \param[in]  bvhCache If not nullptr, the bottom-level BVHs are loaded from it, and only those of new or edited
+  //!             meshes are built.
+  ReferenceScene(const SceneGraph& sceneGraph, const std::vector<ui32>& reflectiveMeshIndices,
+                 ThreadPool* threadPool = nullptr, BVHCache* bvhCache = nullptr);
+
+  // The TLAS refers to the vertex and index buffers, whose data moves along with them, but is not copied.
+  ReferenceScene(const ReferenceScene& other)            = delete;
+  ReferenceScene& operator=(const ReferenceScene& other) = delete;
+  ReferenceScene(ReferenceScene&& other)                 = default;
+  ReferenceScene& operator=(ReferenceScene&& other)      = default;
+
+  //! \brief Returns vertexBuffer of RayTracing.hlsl.
+  const std::vector<Vertex>& getVertices() const;
+
+  //! \brief Returns indexBuffer of RayTracing.hlsl. The indices address the global vertex buffer.
+  const std::vector<ui32>& getIndices() const;
+
+  ui32            getNumMeshes() const;
+  const Mesh&     getMesh(ui32 meshIdx) const;
+  const Material& getMaterial(ui32 materialIdx) const;
+  ui32            getNumInstances() const;
+  const Instance& getInstance(ui32 instanceIdx) const;
+
+  //! \brief Returns g_textures[textureIdx] of RayTracing.hlsl. Texture slot s of material m is at
+  //! m * NUM_TEXTURES_PER_MATERIAL + s. Empty slots hold the default textures of SceneGraphFactory.
+  const Texture& getBoundTexture(ui32 textureIdx) const;
+
+  //! \brief Returns the acceleration structure. Occurrences of a mesh share one bottom-level BVH.
+  const TLAS& getTLAS() const;
+
+  //! \brief Returns the bounding box of the scene graph, which the viewer normalizes the scene by.
+  const AABB& getAABB() const;
+
+private:
+  std::vector<Vertex>   m_vertices;
+  std::vector<ui32>     m_indices;
+  std::vector<Mesh>     m_meshes;
+  std::vector<Material> m_materials;
+  std::vector<Instance> m_instances;
+  std::vector<Texture>  m_textures;      //! The default textures, followed by those of the scene graph.
+  std::vector<ui32>     m_boundTextures; //! Index into m_textures per texture slot of each material.
+  TLAS                  m_tlas;
+  AABB                  m_aabb;
+};
+} // namespace gims
@@ -0,0 +1,45 @@
+#pragma once
+#include <gimslib/sampling/BlueNoiseTile.hpp>
+#include <gimslib/sampling/SobolSequence.hpp>
+#include <gimslib/types.hpp>
+
+namespace gims
+{
+//! The low-discrepancy sequences of ShadowRaySampler.
+enum class ShadowRaySequence
+{
+  SOBOL,      //! Sobol points, rotated per pixel.
+  OWEN_SOBOL, //! The first two Sobol dimensions, Owen-scrambled with a seed per pixel and light.
+  R2          //! The R2 sequence, rotated per pixel.
+};
+
+//! \brief Stratified random numbers for the jittered shadow rays of RayTracingShader.
+//!
+//! Replaces the sin() hash of GetRandomOffset() in RayTracing.hlsl, which is seeded by the world-space position and
+//! correlates the rays of a pixel. Each pixel and light gets its own sequence. The rays of a light take consecutive
+//! points, so any prefix, e.g., the rays of the first progressive samples, is well stratified over the light.
+//! SOBOL and R2 decorrelate the pixels by a rotation, which is taken from a blue-noise tile, if there is one, or
+//! from a hash of the pixel otherwise.
+class ShadowRaySampler
+{
+public:
+  //! \param[in]  sequence The sequence.
+  //! \param[in]  blueNoise If not nullptr, the tile that rotates SOBOL and R2. Must outlive the sampler.
+  explicit ShadowRaySampler(ShadowRaySequence sequence, const BlueNoiseTile* blueNoise = nullptr);
+
+  //! \brief Returns the random numbers in [0, 1)^2 of a shadow ray.
+  //! \param[in]  x Column of the pixel.
+  //! \param[in]  y Row of the pixel.
+  //! \param[in]  lightIdx Index of the light in its buffer.
+  //! \param[in]  rayIdx Index of the shadow ray of the light.
+  f32v2 get(ui32 x, ui32 y, ui32 lightIdx, ui32 rayIdx) const;
+
+private:
+  //! \brief Returns the toroidal shift of the sequence of a pixel and light.
+  f32v2 getRotation(ui32 x, ui32 y, ui32 lightIdx) const;
+
+  ShadowRaySequence    m_sequence;
+  SobolSequence        m_sobol;
+  const BlueNoiseTile* m_blueNoise;
+};
+} // namespace gims
@@ -0,0 +1,108 @@
+#include <AccumulationBuffer.hpp>
+#include <algorithm>
+
+namespace
+{
+using namespace gims;
+
+//! Rec. 709 luminance of linear RGB.
+f32 getLuminance(const f32v3& color)
+{
+  return glm::dot(color, f32v3(0.2126f, 0.7152f, 0.0722f));
+}
+} // namespace
+
+namespace gims
+{
+AccumulationBuffer::AccumulationBuffer(ui32 width, ui32 height)
+    : m_width(width)
+    , m_height(height)
+    , m_pixels(size_t(width) * height)
+{
+}
+
+void AccumulationBuffer::addSample(ui32 pixelIdx, const f32v3& color)
+{
+  Pixel&      pixel     = m_pixels[pixelIdx];
+  const f32   luminance = getLuminance(color);
+  const f32v3 delta     = color - pixel.mean;
+  const f32   lumDelta  = luminance - pixel.luminanceMean;
+  pixel.nSamples++;
+  pixel.mean += delta / f32(pixel.nSamples);
+  pixel.m2 += delta * (color - pixel.mean);
+  pixel.luminanceMean += lumDelta / f32(pixel.nSamples);
+  pixel.luminanceM2 += lumDelta * (luminance - pixel.luminanceMean);
+}
+
+void AccumulationBuffer::setDone(ui32 pixelIdx)
+{
+  m_pixels[pixelIdx].isDone = true;
+}
+
+bool AccumulationBuffer::isDone(ui32 pixelIdx) const
+{
+  return m_pixels[pixelIdx].isDone;
+}
+
+ui32 AccumulationBuffer::getNumSamples(ui32 pixelIdx) const
+{
+  return m_pixels[pixelIdx].nSamples;
+}
+
+f32v3 AccumulationBuffer::getMean(ui32 pixelIdx) const
+{
+  return m_pixels[pixelIdx].mean;
+}
+
+f32v3 AccumulationBuffer::getVariance(ui32 pixelIdx) const
+{
+  const Pixel& pixel = m_pixels[pixelIdx];
+  return pixel.nSamples < 2 ? f32v3(0.0f) : pixel.m2 / f32(pixel.nSamples - 1);
+}
+
+f32 AccumulationBuffer::getLuminanceMean(ui32 pixelIdx) const
+{
+  return m_pixels[pixelIdx].luminanceMean;
+}
+
+f32 AccumulationBuffer::getLuminanceVariance(ui32 pixelIdx) const
+{
+  const Pixel& pixel = m_pixels[pixelIdx];
+  return pixel.nSamples < 2 ? 0.0f : pixel.luminanceM2 / f32(pixel.nSamples - 1);
+}
+
+std::vector<f32v4> AccumulationBuffer::getImage() const
+{
+  std::vector<f32v4> result(m_pixels.size());
+  for (size_t i = 0; i < m_pixels.size(); i++)
+  {
+    result[i] = f32v4(m_pixels[i].mean, 1.0f);
+  }
+  return result;
+}
+
+std::vector<f32v4> AccumulationBuffer::getVarianceImage() const
+{
+  std::vector<f32v4> result(m_pixels.size());
+  for (ui32 i = 0; i < static_cast<ui32>(m_pixels.size()); i++)
+  {
+    result[i] = f32v4(getVariance(i) / f32(std::max(m_pixels[i].nSamples, 1u)), 1.0f);
+  }
+  return result;
+}
+
+ui32 AccumulationBuffer::getWidth() const
+{
+  return m_width;
+}
+
+ui32 AccumulationBuffer::getHeight() const
+{
+  return m_height;
+}
+
+ui32 AccumulationBuffer::getNumDonePixels() const
+{
+  return static_cast<ui32>(std::count_if(m_pixels.begin(), m_pixels.end(), [](const Pixel& p) { return p.isDone; }));
+}
+} // namespace gims
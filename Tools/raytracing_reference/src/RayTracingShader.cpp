@@ -0,0 +1,353 @@
+#include <RayTracingShader.hpp>
+#include <cmath>
+
+using namespace gims;
+
+namespace
+{
+//! Number of textures per material, NUM_MATERIALS in RayTracing.hlsl.
+constexpr ui32 NUM_MATERIALS = ReferenceScene::NUM_TEXTURES_PER_MATERIAL;
+
+f32 frac(f32 x)
+{
+  return x - std::floor(x);
+}
+
+//! Same as GetRandomOffset() in RayTracing.hlsl.
+f32 getRandomOffset(const f32v2& p)
+{
+  return frac(std::sin(glm::dot(p, f32v2(12.9898f, 78.233f))) * 43758.5453f);
+}
+
+//! Same as GetRandomPointOnAreaLight() in RayTracing.hlsl, which offsets every coordinate by the same scalars.
+f32v3 getRandomPointOnAreaLight(const AreaLight& light, const f32v2& randomSample)
+{
+  return light.position + light.width * (randomSample.x - 0.5f) + light.height * (randomSample.y - 0.5f);
+}
+} // namespace
+
+namespace gims
+{
+VertexShaderOutput VertexShaderOutput::interpolate(const VertexShaderOutput& v0, const VertexShaderOutput& v1,
+                                                   const VertexShaderOutput& v2, const f32v2& barycentrics)
+{
+  const f32          w0 = 1.0f - barycentrics.x - barycentrics.y;
+  const f32          w1 = barycentrics.x;
+  const f32          w2 = barycentrics.y;
+  VertexShaderOutput result;
+  result.viewSpacePosition   = w0 * v0.viewSpacePosition + w1 * v1.viewSpacePosition + w2 * v2.viewSpacePosition;
+  result.objectSpacePosition = w0 * v0.objectSpacePosition + w1 * v1.objectSpacePosition + w2 * v2.objectSpacePosition;
+  result.worldSpacePosition  = w0 * v0.worldSpacePosition + w1 * v1.worldSpacePosition + w2 * v2.worldSpacePosition;
+  result.viewSpaceNormal     = w0 * v0.viewSpaceNormal + w1 * v1.viewSpaceNormal + w2 * v2.viewSpaceNormal;
+  result.worldSpaceNormal    = w0 * v0.worldSpaceNormal + w1 * v1.worldSpaceNormal + w2 * v2.worldSpaceNormal;
+  result.viewSpaceTangent    = w0 * v0.viewSpaceTangent + w1 * v1.viewSpaceTangent + w2 * v2.viewSpaceTangent;
+  result.viewSpaceBitangent  = w0 * v0.viewSpaceBitangent + w1 * v1.viewSpaceBitangent + w2 * v2.viewSpaceBitangent;
+  result.texCoord            = w0 * v0.texCoord + w1 * v1.texCoord + w2 * v2.texCoord;
+  return result;
+}
+
+RayTracingShader::RayTracingShader(const ReferenceScene& scene, const PerFrameConstants& perFrame,
+                                   const LightConstants& lights)
+    : m_scene(scene)
+    , m_perFrame(perFrame)
+    , m_lights(lights)
+{
+}
+
+VertexShaderOutput RayTracingShader::vsMain(ui32 vertexID, const PerMeshConstants& perMesh) const
+{
+  const ReferenceScene::Vertex& vertex = m_scene.getVertices()[vertexID];
+  const f32m3                   modelView3x3(perMesh.modelViewMatrix);
+
+  VertexShaderOutput output;
+  const f32v4        p4      = perMesh.modelViewMatrix * f32v4(vertex.position, 1.0f);
+  output.objectSpacePosition = vertex.position;
+  output.worldSpacePosition  = f32v3(perMesh.modelMatrix * f32v4(vertex.position, 1.0f));
+  output.viewSpacePosition   = f32v3(p4);
+  output.viewSpaceNormal     = glm::normalize(modelView3x3 * vertex.normal);
+  output.worldSpaceNormal    = f32v3(m_perFrame.inverseViewMatrix * f32v4(output.viewSpaceNormal, 0.0f));
+  output.texCoord            = vertex.texCoord;
+  output.viewSpaceTangent    = modelView3x3 * vertex.tangent;
+  output.viewSpaceBitangent  = glm::cross(output.viewSpaceNormal, output.viewSpaceTangent);
+  return output;
+}
+
+f32v4 RayTracingShader::psMain(const VertexShaderOutput& input, const PerMeshConstants& perMesh,
+                               const ReferenceScene::Material& material)
+{
+  const bool useAreaLights = m_perFrame.flags & 0x1;
+  f32v3      pixelColor    = f32v3(0.0f);
+  f32v3      lightingColor = f32v3(0.0f);
+
+  if (useAreaLights)
+  {
+    lightingColor =
+        getPixelColorForAreaLighting(m_perFrame.numRays, m_perFrame.shadowFactor, input, perMesh, material);
+  }
+  else
+  {
+    lightingColor =
+        getPixelColorForPointLighting(m_perFrame.numRays, m_perFrame.shadowFactor, input, perMesh, material);
+  }
+
+  const bool doReflection = perMesh.isReflectiveFlag & 0x1;
+  if (doReflection)
+  {
+    const f32v3 reflectionColor = getPixelColorForReflections(input, material);
+    pixelColor                  = glm::mix(lightingColor, reflectionColor, m_perFrame.reflectionFactor);
+  }
+  else
+  {
+    pixelColor = lightingColor;
+  }
+
+  return f32v4(pixelColor, 1.0f);
+}
+
+const TLASTraversalCounters& RayTracingShader::getRayQueryCounters() const
+{
+  return m_rayQueryCounters;
+}
+
+void RayTracingShader::resetRayQueryCounters()
+{
+  m_rayQueryCounters = TLASTraversalCounters();
+}
+
+void RayTracingShader::setFirstShadowRayIndex(i32 firstShadowRayIdx)
+{
+  m_firstShadowRayIdx = firstShadowRayIdx;
+}
+
+void RayTracingShader::setShadowRaySampler(const ShadowRaySampler* sampler)
+{
+  m_shadowRaySampler = sampler;
+}
+
+void RayTracingShader::setPixel(ui32 x, ui32 y)
+{
+  m_pixel = ui32v2(x, y);
+}
+
+bool RayTracingShader::proceed(ShaderRayQuery& q)
+{
+  const bool result = q.Proceed();
+  m_rayQueryCounters += q.getTraversalCounters();
+  return result;
+}
+
+f32v4 RayTracingShader::sampleTexture(ui32 textureIdx, const f32v2& texCoord) const
+{
+  return m_scene.getBoundTexture(textureIdx).sample(texCoord);
+}
+
+f32v2 RayTracingShader::getShadowRayOffset(const VertexShaderOutput& psInput, ui32 lightIdx, i32 rayIdx,
+                                           const f32v2& seedScale) const
+{
+  if (m_shadowRaySampler != nullptr)
+  {
+    return m_shadowRaySampler->get(m_pixel.x, m_pixel.y, lightIdx, static_cast<ui32>(rayIdx));
+  }
+  return f32v2(getRandomOffset(f32v2(psInput.worldSpacePosition) + f32(rayIdx) * seedScale.x),
+               getRandomOffset(f32v2(psInput.worldSpacePosition.y, psInput.worldSpacePosition.x) +
+                               f32(rayIdx) * seedScale.y));
+}
+
+f32v3 RayTracingShader::getPixelColorForPointLighting(i32 numShadowRays, f32 shadowFactor,
+                                                      const VertexShaderOutput& psInput,
+                                                      const PerMeshConstants&   perMesh,
+                                                      const ReferenceScene::Material& material)
+{
+  f32v3 accumulatedLightContribution = f32v3(0.0f);
+
+  // Sample textures
+  const ui32  textureIdx = static_cast<ui32>(perMesh.meshDescriptorIndex);
+  const f32v4 ambient    = sampleTexture(textureIdx + AMBIENT_TEXTURE_INDEX, psInput.texCoord) * material.ambientColor;
+  const f32v4 diffuse    = sampleTexture(textureIdx + DIFFUSE_TEXTURE_INDEX, psInput.texCoord) * material.diffuseColor;
+  const f32v4 emissive   = sampleTexture(textureIdx + EMMISIVE_TEXTURE_INDEX, psInput.texCoord);
+
+  const f32v4 pixelColorFromSampling = ambient + diffuse + emissive;
+
+  for (ui32 lightIdx = 0; lightIdx < m_lights.pointLights.size(); lightIdx++)
+  {
+    const PointLight& l        = m_lights.pointLights[lightIdx];
+    const f32v3       lightDir = glm::normalize(l.position - psInput.worldSpacePosition);
+    const f32         distance = glm::length(l.position - psInput.worldSpacePosition);
+
+    f32v4 pixelColorWithCurrentLight = pixelColorFromSampling * f32v4(l.color, 1.0f) * l.intensity;
+
+    // As in the shader, shadowFactor is not reset per light, so occlusion of one light darkens the following ones.
+    for (i32 r = 0; r < numShadowRays; r++)
+    {
+      const f32v2 randomOffset =
+          getShadowRayOffset(psInput, lightIdx, m_firstShadowRayIdx + r, f32v2(0.123f, 0.321f)) *
+          m_perFrame.samplingOffset;
+
+      const f32v3 jitteredLightDir = glm::normalize(lightDir + randomOffset.x + randomOffset.y);
+
+      Ray ray;
+      ray.origin    = psInput.worldSpacePosition + m_perFrame.shadowBias * glm::normalize(psInput.worldSpaceNormal);
+      ray.direction = jitteredLightDir;
+      ray.tMin      = m_perFrame.minT;
+      ray.tMax      = distance;
+      ShaderRayQuery q;
+      q.TraceRayInline(m_scene.getTLAS(), 0, 0xFF, ray);
+      proceed(q);
+      if (q.CommittedStatus() == COMMITTED_TRIANGLE_HIT)
+      {
+        shadowFactor -= 1.0f / f32(numShadowRays);
+      }
+    }
+
+    pixelColorWithCurrentLight *= shadowFactor;
+    const f32 attenuation = 1.0f / (1.0f + 0.1f * distance + 0.01f * distance * distance);
+    accumulatedLightContribution += f32v3(pixelColorWithCurrentLight * attenuation);
+  }
+  return accumulatedLightContribution;
+}
+
+f32v3 RayTracingShader::getPixelColorForAreaLighting(i32 numShadowRays, f32 /* shadowFactor */,
+                                                     const VertexShaderOutput&       psInput,
+                                                     const PerMeshConstants&         perMesh,
+                                                     const ReferenceScene::Material& material)
+{
+  f32v3 accumulatedLightContribution = f32v3(0.0f);
+  // As in the shader, the contribution is not reset per light, so every light adds those of the previous lights again.
+  f32v3 lightContribution = f32v3(0.0f);
+
+  const ui32  textureIdx = static_cast<ui32>(perMesh.meshDescriptorIndex);
+  const f32v4 ambient    = sampleTexture(textureIdx + AMBIENT_TEXTURE_INDEX, psInput.texCoord) * material.ambientColor;
+  const f32v4 diffuse    = sampleTexture(textureIdx + DIFFUSE_TEXTURE_INDEX, psInput.texCoord) * material.diffuseColor;
+  const f32v4 emissive   = sampleTexture(textureIdx + EMMISIVE_TEXTURE_INDEX, psInput.texCoord);
+
+  for (ui32 lightIdx = 0; lightIdx < m_lights.areaLights.size(); lightIdx++)
+  {
+    const AreaLight& light = m_lights.areaLights[lightIdx];
+    // Shadows the parameter, as in the shader. Every sample is weighted with the factor of the samples before it.
+    f32 shadowFactor = 1.0f;
+
+    for (i32 s = 0; s < numShadowRays; s++)
+    {
+      const f32v2 randomSample = getShadowRayOffset(psInput, lightIdx, m_firstShadowRayIdx + s, f32v2(1.0f));
+      const f32v3 samplePoint  = getRandomPointOnAreaLight(light, randomSample);
+
+      const f32v3 lightDir    = glm::normalize(samplePoint - psInput.worldSpacePosition);
+      const f32   distance    = glm::length(samplePoint - psInput.worldSpacePosition);
+      const f32   attenuation = 1.0f / distance;
+      const f32   cosTheta    = std::max(0.0f, glm::dot(lightDir, light.normal));
+
+      Ray ray;
+      ray.origin    = psInput.worldSpacePosition + m_perFrame.shadowBias * psInput.worldSpaceNormal;
+      ray.direction = lightDir;
+      ray.tMin      = m_perFrame.minT;
+      ray.tMax      = distance;
+      ShaderRayQuery q;
+      q.TraceRayInline(m_scene.getTLAS(), 0, 0xFF, ray);
+      proceed(q);
+      if (q.CommittedStatus() == COMMITTED_TRIANGLE_HIT)
+      {
+        shadowFactor -= 1.0f / f32(numShadowRays);
+      }
+      const f32v4 textureColor = ambient + diffuse + emissive;
+      lightContribution +=
+          f32v3(textureColor) * light.color * light.intensity * cosTheta * attenuation * shadowFactor;
+    }
+
+    lightContribution /= f32(numShadowRays);
+    accumulatedLightContribution += lightContribution;
+  }
+
+  return accumulatedLightContribution;
+}
+
+f32v3 RayTracingShader::getLightingColorForReflections(const HitInformation& hitInfo, ui32 baseMaterialIndex,
+                                                       const ReferenceScene::Material& material)
+{
+  f32v3 accumulatedLightContribution = f32v3(0.0f);
+
+  // The textures are those of the hit material, the colors those of the material of the reflecting mesh.
+  const ui32  textureIdx = baseMaterialIndex;
+  const f32v4 ambient    = sampleTexture(textureIdx + AMBIENT_TEXTURE_INDEX, hitInfo.hitUV) * material.ambientColor;
+  const f32v4 diffuse    = sampleTexture(textureIdx + DIFFUSE_TEXTURE_INDEX, hitInfo.hitUV) * material.diffuseColor;
+  const f32v4 emissive   = sampleTexture(textureIdx + EMMISIVE_TEXTURE_INDEX, hitInfo.hitUV);
+
+  for (const PointLight& l : m_lights.pointLights)
+  {
+    const f32v3 lightDir    = glm::normalize(l.position - hitInfo.hitPosition);
+    const f32   distance    = glm::length(l.position - hitInfo.hitPosition);
+    const f32   attenuation = 1.0f / (1.0f + 0.1f * distance + 0.01f * distance * distance);
+
+    f32v4 lightedWithoutEmissive = ambient + diffuse;
+    lightedWithoutEmissive *= l.intensity;
+    lightedWithoutEmissive *= f32v4(l.color, 1.0f);
+
+    // Ten identical shadow rays, as in the shader.
+    f32 shadowFactor = 1.0f;
+    for (i32 r = 0; r < 10; r++)
+    {
+      Ray ray;
+      ray.origin    = hitInfo.hitPosition;
+      ray.direction = lightDir;
+      ray.tMin      = 0.1f;
+      ray.tMax      = distance;
+      ShaderRayQuery q;
+      q.TraceRayInline(m_scene.getTLAS(), 0, 0xFF, ray);
+      proceed(q);
+      if (q.CommittedStatus() == COMMITTED_TRIANGLE_HIT)
+      {
+        shadowFactor -= 1.0f / 10;
+      }
+    }
+
+    lightedWithoutEmissive *= shadowFactor;
+    const f32v3 currentLightContribution = f32v3(lightedWithoutEmissive + emissive);
+    accumulatedLightContribution += currentLightContribution * attenuation;
+  }
+  return accumulatedLightContribution;
+}
+
+f32v3 RayTracingShader::getPixelColorForReflections(const VertexShaderOutput&       psInput,
+                                                    const ReferenceScene::Material& material)
+{
+  const f32v3 viewDir = glm::normalize(f32m3(m_perFrame.inverseViewMatrix) * f32v3(0.0f, 0.0f, -1.0f));
+
+  f32v3 reflectionDir = glm::normalize(glm::reflect(-viewDir, psInput.worldSpaceNormal));
+  if (material.reflectivity > 0.0f)
+  {
+    reflectionDir *= material.reflectivity;
+  }
+
+  Ray reflectionRay;
+  reflectionRay.origin    = psInput.worldSpacePosition + m_perFrame.shadowBias * psInput.worldSpaceNormal;
+  reflectionRay.direction = reflectionDir;
+  reflectionRay.tMin      = m_perFrame.minT;
+  reflectionRay.tMax      = 1e5f;
+
+  ShaderRayQuery q;
+  q.TraceRayInline(m_scene.getTLAS(), 0, 0xFF, reflectionRay);
+  proceed(q);
+  if (q.CommittedStatus() != COMMITTED_TRIANGLE_HIT)
+  {
+    return m_perFrame.environmentColor;
+  }
+
+  const f32v2 barycentrics  = q.CommittedTriangleBarycentrics();
+  const ui32  startIndex    = q.CommittedInstanceID();
+  const ui32  triangleIndex = q.CommittedPrimitiveIndex();
+
+  const auto&                   indexBuffer  = m_scene.getIndices();
+  const auto&                   vertexBuffer = m_scene.getVertices();
+  const ReferenceScene::Vertex& v0           = vertexBuffer[indexBuffer[startIndex + triangleIndex * 3 + 0]];
+  const ReferenceScene::Vertex& v1           = vertexBuffer[indexBuffer[startIndex + triangleIndex * 3 + 1]];
+  const ReferenceScene::Vertex& v2           = vertexBuffer[indexBuffer[startIndex + triangleIndex * 3 + 2]];
+
+  const f32 w0 = 1.0f - barycentrics.x - barycentrics.y;
+
+  HitInformation hitInfo;
+  hitInfo.hitUV       = v0.texCoord * w0 + v1.texCoord * barycentrics.x + v2.texCoord * barycentrics.y;
+  hitInfo.hitNormal   = v0.normal * w0 + v1.normal * barycentrics.x + v2.normal * barycentrics.y;
+  hitInfo.hitPosition = q.CommittedRayT() * reflectionDir + reflectionRay.origin;
+
+  return getLightingColorForReflections(hitInfo, v1.materialIndex * NUM_MATERIALS, material);
+}
+} // namespace gims
@@ -0,0 +1,226 @@
+#include <ReferenceRenderer.hpp>
+#include <algorithm>
+#include <cmath>
+#include <gimslib/accel/Ray.hpp>
+
+namespace
+{
+using namespace gims;
+
+//! A shader per worker, on cache lines of its own, as the shaders count the work of their ray queries.
+struct alignas(64) WorkerShader
+{
+  RayTracingShader shader;
+  ui64             nSamples = 0;
+};
+
+//! Squared standard error of the luminance below which a pixel has converged.
+f32 getSquaredTolerance(const AccumulationBuffer& buffer, ui32 pixelIdx, const ProgressiveOptions& options)
+{
+  const f32 tolerance = options.noiseThreshold * std::max(buffer.getLuminanceMean(pixelIdx), options.noiseFloor);
+  return tolerance * tolerance;
+}
+
+bool isConverged(const AccumulationBuffer& buffer, ui32 pixelIdx, const ProgressiveOptions& options)
+{
+  const ui32 nSamples = buffer.getNumSamples(pixelIdx);
+  return nSamples >= options.minSamples &&
+         buffer.getLuminanceVariance(pixelIdx) <= getSquaredTolerance(buffer, pixelIdx, options) * f32(nSamples);
+}
+
+//! Samples that a pixel takes in the next pass.
+ui32 getNumNewSamples(const AccumulationBuffer& buffer, ui32 pixelIdx, const ProgressiveOptions& options)
+{
+  const ui32 nSamples = buffer.getNumSamples(pixelIdx);
+  if (nSamples >= options.maxSamples)
+  {
+    return 0;
+  }
+  if (nSamples == 0)
+  {
+    return std::min(std::max(options.minSamples, 1u), options.maxSamples);
+  }
+  // The standard error sqrt(variance / n) meets the tolerance after variance / tolerance^2 samples. Taking half of
+  // the missing samples keeps a noisy variance estimate from overshooting.
+  const f64  variance = f64(buffer.getLuminanceVariance(pixelIdx));
+  const f64  nNeeded  = variance / f64(getSquaredTolerance(buffer, pixelIdx, options));
+  const f64  nMissing = std::ceil(0.5 * (nNeeded - f64(nSamples)));
+  const ui32 nNew     = static_cast<ui32>(std::clamp(nMissing, 1.0, f64(std::max(options.maxSamplesPerPass, 1u))));
+  return std::min(nNew, options.maxSamples - nSamples);
+}
+} // namespace
+
+namespace gims
+{
+ReferenceRenderer::ReferenceRenderer(const ReferenceScene& scene)
+    : m_scene(scene)
+{
+}
+
+void ReferenceRenderer::setShadowRaySampler(const ShadowRaySampler* sampler)
+{
+  m_shadowRaySampler = sampler;
+}
+
+FrameStatistics ReferenceRenderer::render(const PerFrameConstants& perFrame, const LightConstants& lights, ui32 width,
+                                          ui32 height, ui32 tileSize, ThreadPool* threadPool,
+                                          std::vector<f32v4>& image) const
+{
+  const DrawConstants drawConstants = createDrawConstants(perFrame);
+  RayTracingShader    prototype(m_scene, perFrame, lights);
+  prototype.setShadowRaySampler(m_shadowRaySampler);
+  std::vector<WorkerShader> shaders(TileScheduler::getNumWorkers(threadPool), WorkerShader{prototype});
+
+  image.assign(size_t(width) * height, f32v4(perFrame.environmentColor, 1.0f));
+  const auto renderTile = [&](const Tile& tile, ui32 workerIdx)
+  {
+    auto& shader = shaders[workerIdx].shader;
+    for (ui32 y = tile.y; y < tile.y + tile.height; y++)
+    {
+      for (ui32 x = tile.x; x < tile.x + tile.width; x++)
+      {
+        Fragment fragment;
+        if (getFragment(drawConstants, shader, x, y, width, height, fragment))
+        {
+          shader.setPixel(x, y);
+          image[size_t(y) * width + x] = shader.psMain(fragment.input, *fragment.perMesh, *fragment.material);
+        }
+      }
+    }
+  };
+
+  FrameStatistics result;
+  result.tiles = TileScheduler(width, height, tileSize).run(renderTile, threadPool);
+  for (const auto& workerShader : shaders)
+  {
+    result.rayQueries += workerShader.shader.getRayQueryCounters();
+  }
+  return result;
+}
+
+ProgressiveStatistics ReferenceRenderer::renderProgressive(const PerFrameConstants& perFrame,
+                                                           const LightConstants& lights,
+                                                           const ProgressiveOptions& options, ui32 tileSize,
+                                                           ThreadPool* threadPool, AccumulationBuffer& buffer) const
+{
+  const ui32 width  = buffer.getWidth();
+  const ui32 height = buffer.getHeight();
+
+  PerFrameConstants samplePerFrame = perFrame;
+  samplePerFrame.numRays           = std::max(options.numRaysPerSample, 1);
+
+  const DrawConstants drawConstants = createDrawConstants(samplePerFrame);
+  RayTracingShader    prototype(m_scene, samplePerFrame, lights);
+  prototype.setShadowRaySampler(m_shadowRaySampler);
+
+  ProgressiveStatistics result;
+  while (buffer.getNumDonePixels() < width * height)
+  {
+    std::vector<WorkerShader> shaders(TileScheduler::getNumWorkers(threadPool), WorkerShader{prototype});
+    const auto                renderTile = [&](const Tile& tile, ui32 workerIdx)
+    {
+      auto& workerShader = shaders[workerIdx];
+      for (ui32 y = tile.y; y < tile.y + tile.height; y++)
+      {
+        for (ui32 x = tile.x; x < tile.x + tile.width; x++)
+        {
+          const ui32 pixelIdx = y * width + x;
+          if (buffer.isDone(pixelIdx))
+          {
+            continue;
+          }
+          Fragment fragment;
+          if (!getFragment(drawConstants, workerShader.shader, x, y, width, height, fragment))
+          {
+            buffer.addSample(pixelIdx, perFrame.environmentColor);
+            buffer.setDone(pixelIdx);
+            workerShader.nSamples++;
+            continue;
+          }
+          const ui32 nSamples = buffer.getNumSamples(pixelIdx);
+          const ui32 nNew     = getNumNewSamples(buffer, pixelIdx, options);
+          workerShader.shader.setPixel(x, y);
+          for (ui32 sampleIdx = nSamples; sampleIdx < nSamples + nNew; sampleIdx++)
+          {
+            workerShader.shader.setFirstShadowRayIndex(static_cast<i32>(sampleIdx) * samplePerFrame.numRays);
+            const f32v4 color = workerShader.shader.psMain(fragment.input, *fragment.perMesh, *fragment.material);
+            buffer.addSample(pixelIdx, f32v3(color));
+          }
+          workerShader.nSamples += nNew;
+          if (nSamples + nNew >= options.maxSamples || isConverged(buffer, pixelIdx, options))
+          {
+            buffer.setDone(pixelIdx);
+          }
+        }
+      }
+    };
+
+    const auto tiles = TileScheduler(width, height, tileSize).run(renderTile, threadPool);
+    result.nPasses++;
+    result.seconds += tiles.seconds;
+    for (const auto& workerShader : shaders)
+    {
+      result.nSamples += workerShader.nSamples;
+      result.rayQueries += workerShader.shader.getRayQueryCounters();
+    }
+  }
+
+  for (ui32 pixelIdx = 0; pixelIdx < width * height; pixelIdx++)
+  {
+    const ui32 nSamples       = buffer.getNumSamples(pixelIdx);
+    result.maxSamplesPerPixel = std::max(result.maxSamplesPerPixel, nSamples);
+    // Pixels without a hit have a single, exact sample.
+    if ((nSamples == 1 && buffer.getLuminanceVariance(pixelIdx) == 0.0f) || isConverged(buffer, pixelIdx, options))
+    {
+      result.nConvergedPixels++;
+    }
+  }
+  return result;
+}
+
+ReferenceRenderer::DrawConstants ReferenceRenderer::createDrawConstants(const PerFrameConstants& perFrame) const
+{
+  const f32m4 viewMatrix =
+      glm::inverse(perFrame.inverseViewMatrix) * m_scene.getAABB().getNormalizationTransformation();
+
+  DrawConstants result;
+  result.clipToWorld = glm::inverse(perFrame.projectionMatrix * viewMatrix);
+
+  // The scene graph importer composes the world-space transformation of a node from the transformations of its
+  // ancestors, just as Scene::addToCommandList() does.
+  result.perMeshConstants.resize(m_scene.getNumInstances());
+  for (ui32 instanceIdx = 0; instanceIdx < m_scene.getNumInstances(); instanceIdx++)
+  {
+    const auto& instance          = m_scene.getInstance(instanceIdx);
+    const auto& mesh              = m_scene.getMesh(instance.meshIdx);
+    auto&       constants         = result.perMeshConstants[instanceIdx];
+    constants.modelViewMatrix     = viewMatrix * instance.modelMatrix;
+    constants.modelMatrix         = instance.modelMatrix;
+    constants.isReflectiveFlag    = mesh.isReflective ? 1 : 0;
+    constants.meshDescriptorIndex = static_cast<i32>(mesh.materialIndex * ReferenceScene::NUM_TEXTURES_PER_MATERIAL);
+  }
+  return result;
+}
+
+bool ReferenceRenderer::getFragment(const DrawConstants& drawConstants, const RayTracingShader& shader, ui32 x, ui32 y,
+                                    ui32 width, ui32 height, Fragment& fragment) const
+{
+  const Ray    ray = createCameraRay(drawConstants.clipToWorld, f32v2(f32(x), f32(y)) + 0.5f, width, height);
+  const RayHit hit = m_scene.getTLAS().traceRay(ray);
+  if (!hit.isHit())
+  {
+    return false;
+  }
+  const auto& indices   = m_scene.getIndices();
+  const auto& constants = drawConstants.perMeshConstants[hit.instanceIdx];
+  const auto& mesh      = m_scene.getMesh(m_scene.getInstance(hit.instanceIdx).meshIdx);
+  const ui32  firstIdx  = mesh.startIndex + 3 * hit.primitiveIdx;
+  fragment.input        = VertexShaderOutput::interpolate(shader.vsMain(indices[firstIdx], constants),
+                                                          shader.vsMain(indices[firstIdx + 1], constants),
+                                                          shader.vsMain(indices[firstIdx + 2], constants),
+                                                          hit.barycentrics);
+  fragment.perMesh      = &constants;
+  fragment.material     = &m_scene.getMaterial(mesh.materialIndex);
+  return true;
+}
+} // namespace gims
@@ -0,0 +1,200 @@
+#include <ReferenceScene.hpp>
+#include <algorithm>
+#include <gimslib/accel/BVHCache.hpp>
+#include <gimslib/contrib/stb/stb_image.h>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <memory>
+#include <stdexcept>
+
+using namespace gims;
+
+namespace
+{
+//! Index of the first texture of the scene graph in ReferenceScene::m_textures. The default textures come first.
+const ui32 firstSceneTextureIndex = 3;
+
+//! The default textures of SceneGraphFactory::createTextures(): white, black, and blue.
+const ui8v4 defaultTexels[firstSceneTextureIndex] = {ui8v4(255, 255, 255, 255), ui8v4(0, 0, 0, 255),
+                                                     ui8v4(0, 0, 255, 255)};
+
+//! Same as getDefaultTextureIndexForTextureType() of SceneFactory.cpp.
+ui32 getDefaultTextureIndex(ui32 textureType)
+{
+  if (textureType == SceneGraph::AMBIENT || textureType == SceneGraph::EMISSIVE)
+  {
+    return 1;
+  }
+  if (textureType == SceneGraph::HEIGHT)
+  {
+    return 2;
+  }
+  return 0;
+}
+
+ReferenceScene::Texture loadTexture(const std::filesystem::path& fileName)
+{
+  i32                                   width, height, nComponents;
+  std::unique_ptr<ui8, void (*)(void*)> image(
+      stbi_load(fileName.generic_string().c_str(), &width, &height, &nComponents, 4), &stbi_image_free);
+  if (image.get() == nullptr)
+  {
+    throw std::runtime_error("Error loading texture " + fileName.string() + ".");
+  }
+  ReferenceScene::Texture result;
+  result.width       = static_cast<ui32>(width);
+  result.height      = static_cast<ui32>(height);
+  const auto* texels = reinterpret_cast<const ui8v4*>(image.get());
+  result.texels.assign(texels, texels + size_t(result.width) * result.height);
+  return result;
+}
+} // namespace
+
+namespace gims
+{
+f32v4 ReferenceScene::Texture::sample(const f32v2& texCoord) const
+{
+  // NaN coordinates end up at the last texel, as std::min() returns its first argument for them.
+  const f32v2 wrapped = texCoord - glm::floor(texCoord);
+  const ui32  x       = static_cast<ui32>(std::min(f32(width - 1), wrapped.x * f32(width)));
+  const ui32  y       = static_cast<ui32>(std::min(f32(height - 1), wrapped.y * f32(height)));
+  return f32v4(texels[size_t(y) * width + x]) / 255.0f;
+}
+
+ReferenceScene::ReferenceScene(const SceneGraph& sceneGraph, const std::vector<ui32>& reflectiveMeshIndices,
+                               ThreadPool* threadPool, BVHCache* bvhCache)
+    : m_aabb(sceneGraph.aabb)
+{
+  // Global vertex and index buffer, as in SceneGraphFactory::createMeshes().
+  for (ui32 meshIdx = 0; meshIdx < (ui32)sceneGraph.meshes.size(); meshIdx++)
+  {
+    const SceneGraph::Mesh& inputMesh = sceneGraph.meshes[meshIdx];
+    Mesh                    mesh;
+    mesh.startVertex   = static_cast<ui32>(m_vertices.size());
+    mesh.startIndex    = static_cast<ui32>(m_indices.size());
+    mesh.nIndices      = static_cast<ui32>(inputMesh.triangles.size() * 3);
+    mesh.materialIndex = inputMesh.materialIndex;
+    mesh.isReflective  = std::find(reflectiveMeshIndices.begin(), reflectiveMeshIndices.end(), meshIdx) !=
+                        reflectiveMeshIndices.end();
+    for (size_t vIdx = 0; vIdx < inputMesh.positions.size(); vIdx++)
+    {
+      m_vertices.push_back({inputMesh.positions[vIdx], inputMesh.normals[vIdx],
+                            f32v2(inputMesh.textureCoordinates[vIdx]), inputMesh.tangents[vIdx],
+                            inputMesh.materialIndex});
+    }
+    for (const auto& triangle : inputMesh.triangles)
+    {
+      m_indices.insert(m_indices.end(), {triangle.x + mesh.startVertex, triangle.y + mesh.startVertex,
+                                         triangle.z + mesh.startVertex});
+    }
+    m_meshes.push_back(mesh);
+  }
+
+  // Materials and their texture bindings, as in SceneGraphFactory::createTextures() and createMaterials().
+  for (ui32 tIdx = 0; tIdx < firstSceneTextureIndex; tIdx++)
+  {
+    m_textures.push_back({1, 1, {defaultTexels[tIdx]}});
+  }
+  for (const auto& textureFileName : sceneGraph.textureFileNames)
+  {
+    m_textures.push_back(loadTexture(sceneGraph.directory / textureFileName));
+  }
+  for (const auto& inputMaterial : sceneGraph.materials)
+  {
+    Material material;
+    material.ambientColor             = f32v4(inputMaterial.ambientColor + inputMaterial.emissiveColor, 0.0f);
+    material.diffuseColor             = f32v4(inputMaterial.diffuseColor, 0.0f);
+    material.specularColorAndExponent = f32v4(inputMaterial.specularColor, inputMaterial.specularExponent);
+    material.reflectivity             = inputMaterial.reflectivity;
+    m_materials.push_back(material);
+    for (ui32 textureType = 0; textureType < NUM_TEXTURES_PER_MATERIAL; textureType++)
+    {
+      const ui32 textureIdx = inputMaterial.textures[textureType];
+      m_boundTextures.push_back(textureIdx == SceneGraph::NO_TEXTURE ? getDefaultTextureIndex(textureType)
+                                                                      : firstSceneTextureIndex + textureIdx);
+    }
+  }
+
+  // Acceleration structure with the instances of RayTracingUtils::createAccelerationStructures().
+  for (const auto& mesh : m_meshes)
+  {
+    TriangleMeshView view;
+    view.positions      = m_vertices.data() + mesh.startVertex;
+    view.positionStride = sizeof(Vertex);
+    view.triangles      = reinterpret_cast<const ui32v3*>(m_indices.data() + mesh.startIndex);
+    view.nTriangles     = mesh.nIndices / 3;
+    view.baseVertex     = mesh.startVertex;
+    if (bvhCache != nullptr)
+    {
+      m_tlas.addBottomLevel(view, bvhCache->getBVH(view, BVHBuildOptions(), threadPool));
+    }
+    else
+    {
+      m_tlas.addBottomLevel(view, BVHBuildOptions(), threadPool);
+    }
+  }
+  for (const auto& node : sceneGraph.nodes)
+  {
+    for (const auto meshIdx : node.meshIndices)
+    {
+      TLASInstance instance;
+      instance.transformation = f32m4x3(node.worldSpaceTransformation);
+      instance.instanceID     = m_meshes[meshIdx].startIndex;
+      instance.instanceMask   = 1;
+      instance.bottomLevelIdx = meshIdx;
+      m_tlas.addInstance(instance);
+      m_instances.push_back({meshIdx, node.worldSpaceTransformation});
+    }
+  }
+  m_tlas.build(threadPool);
+}
+
+const std::vector<ReferenceScene::Vertex>& ReferenceScene::getVertices() const
+{
+  return m_vertices;
+}
+
+const std::vector<ui32>& ReferenceScene::getIndices() const
+{
+  return m_indices;
+}
+
+ui32 ReferenceScene::getNumMeshes() const
+{
+  return static_cast<ui32>(m_meshes.size());
+}
+
+const ReferenceScene::Mesh& ReferenceScene::getMesh(ui32 meshIdx) const
+{
+  return m_meshes[meshIdx];
+}
+
+const ReferenceScene::Material& ReferenceScene::getMaterial(ui32 materialIdx) const
+{
+  return m_materials[materialIdx];
+}
+
+ui32 ReferenceScene::getNumInstances() const
+{
+  return static_cast<ui32>(m_instances.size());
+}
+
+const ReferenceScene::Instance& ReferenceScene::getInstance(ui32 instanceIdx) const
+{
+  return m_instances[instanceIdx];
+}
+
+const ReferenceScene::Texture& ReferenceScene::getBoundTexture(ui32 textureIdx) const
+{
+  return m_textures[m_boundTextures[textureIdx]];
+}
+
+const TLAS& ReferenceScene::getTLAS() const
+{
+  return m_tlas;
+}
+
+const AABB& ReferenceScene::getAABB() const
+{
+  return m_aabb;
+}
+} // namespace gims
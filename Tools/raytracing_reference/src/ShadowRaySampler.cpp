@@ -0,0 +1,58 @@
+#include <ShadowRaySampler.hpp>
+#include <gimslib/sampling/R2Sequence.hpp>
+#include <gimslib/sys/Hash.hpp>
+
+namespace
+{
+using namespace gims;
+
+f32v2 frac(const f32v2& x)
+{
+  return x - glm::floor(x);
+}
+
+f32 toUnitInterval(ui32 hash)
+{
+  return f32(hash >> 8) * (1.0f / 16777216.0f);
+}
+} // namespace
+
+namespace gims
+{
+ShadowRaySampler::ShadowRaySampler(ShadowRaySequence sequence, const BlueNoiseTile* blueNoise)
+    : m_sequence(sequence)
+    , m_sobol(sequence == ShadowRaySequence::OWEN_SOBOL)
+    , m_blueNoise(blueNoise)
+{
+}
+
+f32v2 ShadowRaySampler::get(ui32 x, ui32 y, ui32 lightIdx, ui32 rayIdx) const
+{
+  switch (m_sequence)
+  {
+  case ShadowRaySequence::SOBOL:
+  {
+    // Each light takes a pair of dimensions, so that the lights of a pixel are not shadowed in lockstep.
+    const ui32 dimension = 2 * (lightIdx % (SobolSequence::MAX_DIMENSIONS / 2));
+    return frac(m_sobol.get2D(rayIdx, dimension) + getRotation(x, y, lightIdx));
+  }
+  case ShadowRaySequence::OWEN_SOBOL:
+    // The first two dimensions are a (0,2)-sequence. Each seed yields an independent scrambling of them.
+    return m_sobol.get2D(rayIdx, 0, hash32(lightIdx, hash32(x, y)));
+  case ShadowRaySequence::R2:
+  default:
+    return R2Sequence::get(rayIdx, getRotation(x, y, lightIdx));
+  }
+}
+
+f32v2 ShadowRaySampler::getRotation(ui32 x, ui32 y, ui32 lightIdx) const
+{
+  if (m_blueNoise != nullptr)
+  {
+    // The lights share the tile and are decorrelated by the R2 points of their indices.
+    return frac(m_blueNoise->get2D(static_cast<i32>(x), static_cast<i32>(y)) + R2Sequence::get(lightIdx));
+  }
+  const ui32 hash = hash32(lightIdx, hash32(x, y));
+  return f32v2(toUnitInterval(hash), toUnitInterval(hash32(hash)));
+}
+} // namespace gims
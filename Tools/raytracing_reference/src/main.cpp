@@ -0,0 +1,421 @@
+#include <AccumulationBuffer.hpp>
+#include <ReferenceRenderer.hpp>
+#include <ReferenceScene.hpp>
+#include <ShadowRaySampler.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <gimslib/accel/BVHCache.hpp>
+#include <gimslib/io/ImageWriter.hpp>
+#include <gimslib/scene/SceneGraphImporter.hpp>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <gimslib/ui/ExaminerController.hpp>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace gims;
+
+namespace
+{
+//! Defaults are those of SceneGraphViewerApp and DX12AppConfig.
+struct Options
+{
+  std::filesystem::path scene;
+  std::filesystem::path output           = "reference.png";
+  ui32                  width            = 640;
+  ui32                  height           = 480;
+  ui32                  tileSize         = 16;
+  ui32                  nThreads         = 0;
+  f32v3                 translation      = f32v3(0.0f, -0.25f, 1.5f);
+  f32v3                 backgroundColor  = f32v3(0.25f);
+  f32                   shadowBias       = 0.375f;
+  i32                   numRays          = 16;
+  f32                   samplingOffset   = 0.01f;
+  f32                   minT             = 0.0001f;
+  f32                   reflectionFactor = 0.5f;
+  f32                   shadowFactor     = 1.0f;
+  bool                  useAreaLights    = false;
+  bool                  useReflections   = false;
+  std::vector<ui32>     reflectiveMeshes = {2};
+  LightConstants        lights;
+  bool                  hasPointLights   = false;
+  bool                  hasAreaLights    = false;
+  bool                  isProgressive    = false;
+  ProgressiveOptions    progressive;
+  std::filesystem::path varianceOutput;
+  std::string           sampler          = "sin";
+  std::filesystem::path blueNoise;
+  std::filesystem::path bvhCache;
+};
+
+void printUsage()
+{
+  std::cerr << "Usage: raytracing_reference <scene> [options]\n"
+               "  --output <file>              Writes the image as PNG or, if the file ends with .exr, as OpenEXR.\n"
+               "  --width <n>                  Width of the image (default 640).\n"
+               "  --height <n>                 Height of the image (default 480).\n"
+               "  --tile-size <n>              Width and height of the scheduled tiles (default 16).\n"
+               "  --threads <n>                Rendering threads, 0 uses one per hardware thread (default 0).\n"
+               "  --translation <x,y,z>        Translation of the examiner camera (default 0,-0.25,1.5).\n"
+               "  --background <r,g,b>         Environment and clear color (default 0.25,0.25,0.25).\n"
+               "  --num-rays <n>               Shadow rays per light (default 16).\n"
+               "  --shadow-bias <f>            Offset of ray origins along the normal (default 0.375).\n"
+               "  --sampling-offset <f>        Jitter of point-light shadow rays (default 0.01).\n"
+               "  --min-t <f>                  TMin of shadow and reflection rays (default 0.0001).\n"
+               "  --reflection-factor <f>      Weight of reflections (default 0.5).\n"
+               "  --shadow-factor <f>          Initial shadow factor of point lights (default 1).\n"
+               "  --area-lights                Shades with the area lights instead of the point lights.\n"
+               "  --reflections                Sets the reflection flag, which the shader ignores.\n"
+               "  --reflective-meshes <i,...>  Meshes drawn as reflective (default 2).\n"
+               "  --point-light <x,y,z,i>      Adds a white point light. Replaces the default point lights.\n"
+               "  --area-light <x,y,z,nx,ny,nz,i,w,h>\n"
+               "                               Adds a white area light. Replaces the default area light.\n"
+               "  --progressive                Accumulates samples until every pixel is below a noise threshold.\n"
+               "  --rays-per-sample <n>        Progressive: shadow rays per light and sample (default 1).\n"
+               "  --min-samples <n>            Progressive: samples of a pixel before it may stop (default 8).\n"
+               "  --max-samples <n>            Progressive: samples after which a pixel stops (default 1024).\n"
+               "  --noise-threshold <f>        Progressive: standard error relative to the luminance (default 0.02).\n"
+               "  --noise-floor <f>            Progressive: luminance the threshold is relative to at least "
+               "(default 0.05).\n"
+               "  --variance <file>            Progressive: writes the variance of the image as OpenEXR.\n"
+               "  --sampler <name>             Random numbers of the shadow rays: sin (the hash of the shader,\n"
+               "                               default), sobol, owen-sobol, or r2.\n"
+               "  --blue-noise <file>          Blue-noise tile that rotates the sobol and r2 sequences per pixel.\n"
+               "  --bvh-cache <directory>      Loads the BVHs from the directory, builds and stores missing ones.\n";
+}
+
+std::vector<f32> parseFloats(const std::string& argument, const std::string& value, size_t count)
+{
+  std::vector<f32>  result;
+  std::stringstream stream(value);
+  std::string       item;
+  while (std::getline(stream, item, ','))
+  {
+    result.push_back(std::stof(item));
+  }
+  if (result.size() != count)
+  {
+    throw std::runtime_error(argument + " expects " + std::to_string(count) + " comma-separated values.");
+  }
+  return result;
+}
+
+//! The lights that SceneGraphViewerApp::createLightConstantBuffers() creates.
+LightConstants createDefaultLights()
+{
+  LightConstants result;
+  result.pointLights.push_back({f32v3(-20.0f, 45.0f, -54.0f), 20.0f, f32v3(1.0f), 0.0f});
+  result.pointLights.push_back({f32v3(32.0f, 15.0f, -21.0f), 20.0f, f32v3(1.0f), 0.0f});
+  result.areaLights.push_back({f32v3(0.0f, 100.0f, 0.0f), 50.0f, f32v3(1.0f), 4.0f, f32v3(0.0f, 1.0f, 0.0f), 4.0f});
+  return result;
+}
+
+Options parseOptions(int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    throw std::runtime_error("Missing scene.");
+  }
+  Options result;
+  result.scene  = argv[1];
+  result.lights = createDefaultLights();
+  for (int i = 2; i < argc; i++)
+  {
+    const std::string argument = argv[i];
+    if (argument == "--area-lights")
+    {
+      result.useAreaLights = true;
+      continue;
+    }
+    if (argument == "--reflections")
+    {
+      result.useReflections = true;
+      continue;
+    }
+    if (argument == "--progressive")
+    {
+      result.isProgressive = true;
+      continue;
+    }
+    if (i + 1 >= argc)
+    {
+      throw std::runtime_error("Missing value for " + argument + ".");
+    }
+    const std::string value = argv[++i];
+    if (argument == "--output")
+    {
+      result.output = value;
+    }
+    else if (argument == "--width")
+    {
+      result.width = static_cast<ui32>(std::stoul(value));
+    }
+    else if (argument == "--height")
+    {
+      result.height = static_cast<ui32>(std::stoul(value));
+    }
+    else if (argument == "--tile-size")
+    {
+      result.tileSize = static_cast<ui32>(std::stoul(value));
+    }
+    else if (argument == "--threads")
+    {
+      result.nThreads = static_cast<ui32>(std::stoul(value));
+    }
+    else if (argument == "--translation")
+    {
+      const auto v       = parseFloats(argument, value, 3);
+      result.translation = f32v3(v[0], v[1], v[2]);
+    }
+    else if (argument == "--background")
+    {
+      const auto v           = parseFloats(argument, value, 3);
+      result.backgroundColor = f32v3(v[0], v[1], v[2]);
+    }
+    else if (argument == "--num-rays")
+    {
+      result.numRays = std::max(1, std::stoi(value));
+    }
+    else if (argument == "--shadow-bias")
+    {
+      result.shadowBias = std::stof(value);
+    }
+    else if (argument == "--sampling-offset")
+    {
+      result.samplingOffset = std::stof(value);
+    }
+    else if (argument == "--min-t")
+    {
+      result.minT = std::stof(value);
+    }
+    else if (argument == "--reflection-factor")
+    {
+      result.reflectionFactor = std::stof(value);
+    }
+    else if (argument == "--shadow-factor")
+    {
+      result.shadowFactor = std::stof(value);
+    }
+    else if (argument == "--reflective-meshes")
+    {
+      result.reflectiveMeshes.clear();
+      std::stringstream stream(value);
+      std::string       item;
+      while (std::getline(stream, item, ','))
+      {
+        result.reflectiveMeshes.push_back(static_cast<ui32>(std::stoul(item)));
+      }
+    }
+    else if (argument == "--point-light")
+    {
+      if (!result.hasPointLights)
+      {
+        result.lights.pointLights.clear();
+        result.hasPointLights = true;
+      }
+      const auto v = parseFloats(argument, value, 4);
+      result.lights.pointLights.push_back({f32v3(v[0], v[1], v[2]), v[3], f32v3(1.0f), 0.0f});
+    }
+    else if (argument == "--area-light")
+    {
+      if (!result.hasAreaLights)
+      {
+        result.lights.areaLights.clear();
+        result.hasAreaLights = true;
+      }
+      const auto v = parseFloats(argument, value, 9);
+      result.lights.areaLights.push_back(
+          {f32v3(v[0], v[1], v[2]), v[6], f32v3(1.0f), v[7], f32v3(v[3], v[4], v[5]), v[8]});
+    }
+    else if (argument == "--rays-per-sample")
+    {
+      result.progressive.numRaysPerSample = std::max(1, std::stoi(value));
+    }
+    else if (argument == "--min-samples")
+    {
+      result.progressive.minSamples = static_cast<ui32>(std::stoul(value));
+    }
+    else if (argument == "--max-samples")
+    {
+      result.progressive.maxSamples = std::max(1u, static_cast<ui32>(std::stoul(value)));
+    }
+    else if (argument == "--noise-threshold")
+    {
+      result.progressive.noiseThreshold = std::stof(value);
+    }
+    else if (argument == "--noise-floor")
+    {
+      result.progressive.noiseFloor = std::stof(value);
+    }
+    else if (argument == "--variance")
+    {
+      result.varianceOutput = value;
+    }
+    else if (argument == "--sampler")
+    {
+      if (value != "sin" && value != "sobol" && value != "owen-sobol" && value != "r2")
+      {
+        throw std::runtime_error("Unknown sampler " + value + ".");
+      }
+      result.sampler = value;
+    }
+    else if (argument == "--blue-noise")
+    {
+      result.blueNoise = value;
+    }
+    else if (argument == "--bvh-cache")
+    {
+      result.bvhCache = value;
+    }
+    else
+    {
+      throw std::runtime_error("Unknown option " + argument + ".");
+    }
+  }
+  return result;
+}
+
+//! The constants that SceneGraphViewerApp::updateSceneConstantBuffer() uploads.
+PerFrameConstants createPerFrameConstants(const Options& options)
+{
+  ExaminerController examinerController(true);
+  examinerController.setTranslationVector(options.translation);
+
+  PerFrameConstants result;
+  result.shadowBias        = options.shadowBias;
+  result.numRays           = options.numRays;
+  result.reflectionFactor  = options.reflectionFactor;
+  result.shadowFactor      = options.shadowFactor;
+  result.flags             = (options.useAreaLights ? 1 : 0) | (options.useReflections ? 2 : 0);
+  result.samplingOffset    = options.samplingOffset;
+  result.minT              = options.minT;
+  result.environmentColor  = options.backgroundColor;
+  result.projectionMatrix  = glm::perspectiveFovLH_ZO<f32>(glm::radians(45.0f), (f32)options.width,
+                                                           (f32)options.height, 0.01f, 1000.0f);
+  result.inverseViewMatrix = glm::inverse(examinerController.getTransformationMatrix());
+  return result;
+}
+
+//! Writes the image as OpenEXR or as PNG with colors clamped to [0, 1], like a DXGI_FORMAT_R8G8B8A8_UNORM target.
+void writeImage(const std::filesystem::path& fileName, const std::vector<f32v4>& image, ui32 width, ui32 height)
+{
+  if (fileName.extension() == ".exr")
+  {
+    writeEXR(fileName, &image[0].x, width, height, 4);
+    return;
+  }
+  std::vector<ui8v4> pixels(image.size());
+  for (size_t i = 0; i < image.size(); i++)
+  {
+    pixels[i] = ui8v4(glm::clamp(image[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+  }
+  writePNG(fileName, &pixels[0].x, width, height, 4);
+}
+
+//! Returns nullptr for the sin() hash of the shader.
+std::unique_ptr<ShadowRaySampler> createShadowRaySampler(const std::string& name, const BlueNoiseTile* blueNoise)
+{
+  if (name == "sobol")
+  {
+    return std::make_unique<ShadowRaySampler>(ShadowRaySequence::SOBOL, blueNoise);
+  }
+  if (name == "owen-sobol")
+  {
+    return std::make_unique<ShadowRaySampler>(ShadowRaySequence::OWEN_SOBOL, blueNoise);
+  }
+  if (name == "r2")
+  {
+    return std::make_unique<ShadowRaySampler>(ShadowRaySequence::R2, blueNoise);
+  }
+  return nullptr;
+}
+
+void printRayQueries(const TLASTraversalCounters& rayQueries, const Options& options)
+{
+  const f64 nQueries = f64(std::max<ui64>(rayQueries.nRays, 1));
+  std::cout << "ray queries: " << rayQueries.nRays << " ("
+            << f64(rayQueries.nRays) / (f64(options.width) * f64(options.height)) << " per pixel)"
+            << "\ntraversal steps per query: " << f64(rayQueries.getNumSteps()) / nQueries
+            << " (nodes: " << f64(rayQueries.nTopLevelNodes + rayQueries.nBottomLevelNodes) / nQueries
+            << ", instances: " << f64(rayQueries.nInstances) / nQueries
+            << ", triangles: " << f64(rayQueries.nTriangles) / nQueries << ")\n";
+}
+
+void renderFrame(const Options& options, const ReferenceRenderer& renderer, ThreadPool& threadPool)
+{
+  std::vector<f32v4> image;
+  const auto         statistics = renderer.render(createPerFrameConstants(options), options.lights, options.width,
+                                                  options.height, options.tileSize, &threadPool, image);
+  writeImage(options.output, image, options.width, options.height);
+
+  const auto& tiles = statistics.tiles;
+  std::cout << "tiles: " << tiles.nTiles << " of " << options.tileSize << "x" << options.tileSize
+            << " pixels\nworkers: " << tiles.nWorkers << "\nsteals: " << tiles.nSteals
+            << "\ntime: " << tiles.seconds * 1000.0 << " ms\ntiles/s per core: " << tiles.getTilesPerSecondPerCore()
+            << "\n";
+  printRayQueries(statistics.rayQueries, options);
+}
+
+void renderProgressive(const Options& options, const ReferenceRenderer& renderer, ThreadPool& threadPool)
+{
+  AccumulationBuffer buffer(options.width, options.height);
+  const auto         statistics = renderer.renderProgressive(createPerFrameConstants(options), options.lights,
+                                                             options.progressive, options.tileSize, &threadPool,
+                                                             buffer);
+  writeImage(options.output, buffer.getImage(), options.width, options.height);
+  if (!options.varianceOutput.empty())
+  {
+    const auto variance = buffer.getVarianceImage();
+    writeEXR(options.varianceOutput, &variance[0].x, options.width, options.height, 4);
+  }
+
+  // Uniform sampling reaches the noise threshold everywhere only with the sample count of the noisiest pixel.
+  const f64 nPixels         = f64(options.width) * f64(options.height);
+  const f64 nUniformSamples = nPixels * f64(statistics.maxSamplesPerPixel);
+  std::cout << "passes: " << statistics.nPasses << "\ntime: " << statistics.seconds * 1000.0
+            << " ms\nsamples per pixel: " << f64(statistics.nSamples) / nPixels << " (max "
+            << statistics.maxSamplesPerPixel << ")\nconverged pixels: " << 100.0 * statistics.nConvergedPixels / nPixels
+            << " %\nsamples relative to uniform sampling: " << f64(statistics.nSamples) / nUniformSamples << "\n";
+  printRayQueries(statistics.rayQueries, options);
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+  try
+  {
+    const Options options = parseOptions(argc, argv);
+    ThreadPool    threadPool(options.nThreads);
+
+    std::cerr << "Loading " << options.scene.string() << "\n";
+    const std::unique_ptr<BVHCache> bvhCache =
+        options.bvhCache.empty() ? nullptr : std::make_unique<BVHCache>(options.bvhCache);
+    const ReferenceScene scene(SceneGraphImporter::load(options.scene), options.reflectiveMeshes, &threadPool,
+                               bvhCache.get());
+
+    const std::unique_ptr<BlueNoiseTile> blueNoise =
+        options.blueNoise.empty() ? nullptr : std::make_unique<BlueNoiseTile>(options.blueNoise);
+    const std::unique_ptr<ShadowRaySampler> sampler = createShadowRaySampler(options.sampler, blueNoise.get());
+    ReferenceRenderer                       renderer(scene);
+    renderer.setShadowRaySampler(sampler.get());
+
+    if (options.isProgressive)
+    {
+      renderProgressive(options, renderer, threadPool);
+    }
+    else
+    {
+      renderFrame(options, renderer, threadPool);
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Error: " << e.what() << "\n";
+    printUsage();
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,180 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#pragma once
+#include <gimslib/accel/Ray.hpp>
+#include <gimslib/geometry/AABB.hpp>
+#include <gimslib/geometry/TriangleMeshView.hpp>
+#include <gimslib/types.hpp>
+#include <string>
+#include <vector>
+namespace gims
+{
+class ThreadPool;
+
+//! \brief Algorithms that build a BVH.
+enum class BVHBuildAlgorithm : ui32
+{
+  //! Top-down with the binned surface area heuristic (SAH). The BVH of choice for static geometry.
+  BinnedSAH = 0,
+  //! Linear BVH over the Morton codes of the primitive centroids, for rebuilds of dynamic geometry every frame. Builds
+  //! an order of magnitude faster than BinnedSAH, but traces slower unless its treelets are optimized.
+  LBVH = 1
+};
+
+//! \brief Parameters of the BVH build and of the surface area heuristic (SAH).
+struct BVHBuildOptions
+{
+  //! Number of bins per axis that candidate split planes are evaluated for. BinnedSAH only.
+  ui32              nBins = 16;
+  //! Nodes with more primitives are always split.
+  ui32              maxLeafSize = 8;
+  //! Cost of visiting an inner node relative to intersectionCost.
+  f32               traversalCost = 1.0f;
+  //! Cost of intersecting a ray with a primitive.
+  f32               intersectionCost = 1.0f;
+  //! The build algorithm.
+  BVHBuildAlgorithm algorithm = BVHBuildAlgorithm::BinnedSAH;
+  //! Bits of the Morton codes, 30 or 63. 63 bits tell apart the centroids of large meshes with small triangles, but
+  //! take twice as many radix sort passes. LBVH only.
+  ui32              mortonCodeBits = 30;
+  //! Rounds of treelet restructuring (Karras and Aila, Fast Parallel Construction of High-Quality Bounding Volume
+  //! Hierarchies, 2013), each of which lowers the SAH cost further. Zero skips it. LBVH only.
+  ui32              nTreeletRounds = 0;
+};
+
+//! \brief Figures of a built BVH.
+struct BVHStatistics
+{
+  //! Wall-clock time of the build in milliseconds.
+  f64  buildTimeMilliseconds = 0.0;
+  //! Expected cost of a random ray according to the SAH, relative to the surface area of the root.
+  f64  sahCost = 0.0;
+  //! The SAH cost right after the build. Refitting keeps it, so sahCost / sahCostAfterBuild measures the degradation.
+  f64  sahCostAfterBuild = 0.0;
+  ui32 nNodes            = 0;
+  ui32 nLeaves           = 0;
+  ui32 maxDepth          = 0;
+};
+
+//! \brief A binary bounding volume hierarchy over the triangles of a mesh or over boxes, built top-down with the binned
+//! surface area heuristic (Wald, On fast Construction of SAH-based Bounding Volume Hierarchies, 2007) or as a linear
+//! BVH, see BVHBuildAlgorithm.
+//!
+//! The nodes are stored in a compact array. The root is the first node and the two children of an inner node are
+//! adjacent. The BVH references the primitives, i.e., triangles or boxes, by their index. It does not store them.
+class BVH
+{
+public:
+  //! \brief A 32-byte node.
+  struct Node
+  {
+    f32v3 lowerLeftBottom;
+    //! Inner node: index of the left child, the right child follows it. Leaf: first entry in getPrimitiveIndices().
+    ui32  leftFirst;
+    f32v3 upperRightTop;
+    //! Number of primitives of a leaf, zero for inner nodes.
+    ui32  nPrimitives;
+
+    bool isLeaf() const
+    {
+      return nPrimitives > 0;
+    }
+  };
+  static_assert(sizeof(Node) == 32, "BVH nodes must be 32 bytes.");
+
+  //! \brief Creates an empty BVH.
+  BVH() = default;
+
+  //! \brief Builds a BVH.
+  //! \param[in]  mesh The triangles. Degenerate triangles are kept.
+  //! \param[in]  options Parameters of the SAH.
+  //! \param[in]  threadPool If not nullptr, the triangle bounds and the upper levels are processed in parallel and
+  //!             the subtrees below are built concurrently. The result does not depend on the thread pool.
+  BVH(const TriangleMeshView& mesh, const BVHBuildOptions& options = BVHBuildOptions(),
+      ThreadPool* threadPool = nullptr);
+
+  //! \brief Builds a BVH over boxes, e.g., the world-space boxes of instances.
+  //! \param[in]  aabbs Array of nAABBs boxes. Invalid boxes are kept.
+  //! \param[in]  nAABBs Number of boxes.
+  //! \param[in]  options Parameters of the SAH.
+  //! \param[in]  threadPool See above.
+  BVH(const AABB* aabbs, ui32 nAABBs, const BVHBuildOptions& options = BVHBuildOptions(),
+      ThreadPool* threadPool = nullptr);
+
+  //! \brief Returns the nodes. The first node is the root. Empty if there are no primitives.
+  const std::vector<Node>& getNodes() const;
+
+  //! \brief Returns the primitive indices that the leaves reference, sorted by leaf.
+  const std::vector<ui32>& getPrimitiveIndices() const;
+
+  //! \brief Returns the bounding box of the root, or an invalid box if the BVH is empty.
+  AABB getAABB() const;
+
+  //! \brief Returns the build time, the SAH cost, and the size of the BVH.
+  const BVHStatistics& getStatistics() const;
+
+  //! \brief Returns the options the BVH was built with.
+  const BVHBuildOptions& getOptions() const;
+
+  //! \brief Returns the bytes taken by the nodes and the primitive indices.
+  size_t getMemorySize() const;
+
+  //! \brief Computes the SAH cost of the BVH with the costs it was built with.
+  f64 computeSAHCost() const;
+
+  //! \brief Writes the nodes, the primitive indices, the options, and the statistics to a binary file.
+  //!
+  //! The data is written in the byte order of the machine, together with its hash64() and a key.
+  //! \param[in]  fileName Path to the file. An existing file is overwritten.
+  //! \param[in]  key Identifies the input the BVH was built from, e.g., BVHCache::computeKey().
+  void save(const std::string& fileName, ui64 key) const;
+
+  //! \brief Loads a BVH written by save() without rebuilding it.
+  //!
+  //! The file is memory-mapped, and its data is verified against the hash before it is copied into the BVH.
+  //! \param[in]  fileName Path to the file.
+  //! \param[in]  key The key the BVH was saved with.
+  //! \throws std::runtime_error If the file cannot be read, is damaged, or was saved with another key.
+  static BVH load(const std::string& fileName, ui64 key);
+
+  //! \brief Recomputes the boxes of all nodes bottom-up after the triangles moved, e.g., for a skinned mesh.
+  //!
+  //! The topology is kept, so the SAH cost, which the statistics are updated with, may grow.
+  //! \param[in]  mesh The mesh the BVH was built for, with the same triangles but new positions.
+  void refit(const TriangleMeshView& mesh);
+
+  //! \brief Recomputes the boxes of all nodes bottom-up after the boxes the BVH was built over changed.
+  //! \param[in]  aabbs Array of the boxes with their new values.
+  void refit(const AABB* aabbs);
+
+  //! \brief Recomputes the boxes of the leaves that contain the changed boxes and of their ancestors.
+  //!
+  //! Takes O(nChangedIndices * depth) time, including the update of the SAH cost. The first call takes O(n) time to
+  //! find the parents of the nodes.
+  //! \param[in]  aabbs Array of the boxes the BVH was built over, with their new values.
+  //! \param[in]  changedIndices Array of the indices of the boxes that changed.
+  //! \param[in]  nChangedIndices Number of changed indices.
+  void refit(const AABB* aabbs, const ui32* changedIndices, ui32 nChangedIndices);
+
+  //! \brief Intersects a ray with the triangles of a BVH built from a mesh.
+  //! \param[in]  mesh The mesh the BVH was built for.
+  //! \param[in]  ray The ray. Only hits in [ray.tMin, hit.t) are reported.
+  //! \param[in,out] hit Receives t, barycentrics, and primitiveIdx of the closest hit. Other members are untouched.
+  //! \param[in]  acceptFirstHit Stops at the first hit rather than the closest, for shadow rays.
+  //! \return True if a hit was found.
+  bool intersect(const TriangleMeshView& mesh, const Ray& ray, RayHit& hit, bool acceptFirstHit = false) const;
+
+private:
+  //! Sets the SAH cost from m_weightedAreaSum.
+  void updateSAHCost();
+
+  std::vector<Node> m_nodes;
+  std::vector<ui32> m_primitiveIndices;
+  BVHStatistics     m_statistics;
+  BVHBuildOptions   m_options;
+  f64               m_weightedAreaSum = 0.0; //! Numerator of the SAH cost, kept up to date by the refits.
+  std::vector<ui32> m_parentIndices;         //! Parent of each node, created by the first partial refit.
+  std::vector<ui32> m_leafIndices;           //! Leaf of each primitive, created by the first partial refit.
+};
+} // namespace gims
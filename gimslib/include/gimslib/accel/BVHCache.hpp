@@ -0,0 +1,46 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#pragma once
+#include <filesystem>
+#include <gimslib/accel/BVH.hpp>
+#include <gimslib/geometry/TriangleMeshView.hpp>
+#include <gimslib/types.hpp>
+namespace gims
+{
+class ThreadPool;
+
+//! \brief A directory of BVH files, so that the BVHs of a mesh are loaded rather than rebuilt on the next launch.
+//!
+//! Each BVH is stored under a key that hashes everything the build depends on: the triangles, the positions they
+//! reference, and the build options. Editing the mesh or changing the options hence misses the cache, and the stale
+//! file is simply left behind. Files are written under a temporary name and renamed, so that other processes never
+//! load a partially written file. Damaged files are rebuilt and overwritten.
+class BVHCache
+{
+public:
+  //! \brief Opens a cache directory.
+  //! \param[in]  directory The directory, which is created if it does not exist.
+  explicit BVHCache(const std::filesystem::path& directory);
+
+  //! \brief Computes the key that the BVH of a mesh is stored under. Runs at memory bandwidth.
+  //! \param[in]  mesh The mesh. Only the positions that the triangles reference are hashed, and the indices relative to
+  //!             the smallest one, so the key does not depend on the base vertex.
+  //! \param[in]  options The build options.
+  static ui64 computeKey(const TriangleMeshView& mesh, const BVHBuildOptions& options);
+
+  //! \brief Loads the BVH of a mesh from the cache, or builds it and adds it to the cache.
+  //! \param[in]  mesh The mesh.
+  //! \param[in]  options Parameters of the SAH.
+  //! \param[in]  threadPool If not nullptr, a BVH that is not cached is built in parallel.
+  //! \throws std::runtime_error If a BVH that was built cannot be written to the cache.
+  BVH getBVH(const TriangleMeshView& mesh, const BVHBuildOptions& options = BVHBuildOptions(),
+             ThreadPool* threadPool = nullptr);
+
+  //! \brief Returns the path of the file that the BVH with a key is stored in.
+  std::filesystem::path getFileName(ui64 key) const;
+
+private:
+  std::filesystem::path m_directory;
+};
+} // namespace gims
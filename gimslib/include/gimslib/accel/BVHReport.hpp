@@ -0,0 +1,82 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#pragma once
+#include <gimslib/accel/BVH.hpp>
+#include <gimslib/accel/Ray.hpp>
+#include <gimslib/geometry/TriangleMeshView.hpp>
+#include <gimslib/types.hpp>
+#include <ostream>
+#include <vector>
+namespace gims
+{
+class ThreadPool;
+
+//! \brief Work of tracing a set of rays through a BVH, closest hits only.
+struct BVHTraversalStatistics
+{
+  ui64 nRays              = 0;
+  ui64 nHits              = 0;
+  //! Inner nodes and leaves that a ray entered, averaged over the rays.
+  f64  nodesPerRay        = 0.0;
+  //! Ray-triangle tests, averaged over the rays.
+  f64  trianglesPerRay    = 0.0;
+  ui64 maxNodesPerRay     = 0;
+  ui64 maxTrianglesPerRay = 0;
+};
+
+//! \brief Quality figures of a BVH, for comparing build options and for catching regressions when assets change.
+//!
+//! The structural figures come from the BVH alone. The traversal figures are measured on a ray set, e.g., the rays of
+//! createCameraRays(), and are missing otherwise. writeJson() writes all figures, so that reports of different builds
+//! can be compared with any JSON tool.
+class BVHReport
+{
+public:
+  //! \brief Computes the structural figures of a BVH.
+  explicit BVHReport(const BVH& bvh);
+
+  //! \brief Computes the structural figures of a BVH and traces rays through it.
+  //! \param[in]  bvh The BVH.
+  //! \param[in]  mesh The mesh the BVH was built for.
+  //! \param[in]  rays The rays, which search for their closest hits.
+  //! \param[in]  threadPool If not nullptr, the rays are traced in parallel.
+  BVHReport(const BVH& bvh, const TriangleMeshView& mesh, const std::vector<Ray>& rays,
+            ThreadPool* threadPool = nullptr);
+
+  //! \brief Returns the statistics of the BVH itself, i.e., the SAH cost, the node and leaf counts, and the depth.
+  const BVHStatistics& getStatistics() const;
+
+  //! \brief Returns the number of leaves per depth. The root has depth zero.
+  const std::vector<ui32>& getDepthHistogram() const;
+
+  //! \brief Returns the number of leaves per number of primitives.
+  const std::vector<ui32>& getLeafSizeHistogram() const;
+
+  //! \brief Returns the surface area where the two children of an inner node overlap, summed over the inner nodes and
+  //! divided by the summed surface area of the inner nodes. Zero if no siblings overlap.
+  f64 getOverlapRatio() const;
+
+  //! \brief Returns the bytes taken by the nodes and the primitive indices.
+  size_t getMemorySize() const;
+
+  //! \brief Returns true if the report was created with rays.
+  bool hasTraversalStatistics() const;
+
+  //! \brief Returns the work of tracing the rays. All zero if the report was created without rays.
+  const BVHTraversalStatistics& getTraversalStatistics() const;
+
+  //! \brief Writes the build options and all figures as a JSON object.
+  void writeJson(std::ostream& stream) const;
+
+private:
+  BVHBuildOptions        m_options;
+  BVHStatistics          m_statistics;
+  std::vector<ui32>      m_depthHistogram;
+  std::vector<ui32>      m_leafSizeHistogram;
+  f64                    m_overlapRatio           = 0.0;
+  size_t                 m_memorySize             = 0;
+  bool                   m_hasTraversalStatistics = false;
+  BVHTraversalStatistics m_traversalStatistics;
+};
+} // namespace gims
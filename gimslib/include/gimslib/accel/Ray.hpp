@@ -0,0 +1,59 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#pragma once
+#include <gimslib/types.hpp>
+#include <limits>
+#include <vector>
+namespace gims
+{
+//! \brief A ray with a parametric interval, laid out like the HLSL RayDesc.
+struct Ray
+{
+  f32v3 origin;
+  f32   tMin = 0.0f;
+  //! Need not be normalized. t is measured in multiples of its length.
+  f32v3 direction;
+  f32   tMax = std::numeric_limits<f32>::infinity();
+};
+
+//! \brief The committed hit of a ray query, named after the HLSL RayQuery::Committed*() methods.
+struct RayHit
+{
+  static constexpr ui32 NO_HIT = ~0u;
+
+  //! Ray parameter of the hit. Before a query, the end of the interval that is searched.
+  f32   t            = std::numeric_limits<f32>::infinity();
+  //! Weights of the second and the third corner of the triangle.
+  f32v2 barycentrics = f32v2(0.0f);
+  //! Triangle index within its mesh, NO_HIT if nothing was hit.
+  ui32  primitiveIdx = NO_HIT;
+  //! Index of the instance in the TLAS.
+  ui32  instanceIdx  = NO_HIT;
+  //! The user-defined ID of the instance, see TLASInstance::instanceID.
+  ui32  instanceID   = NO_HIT;
+
+  bool isHit() const
+  {
+    return primitiveIdx != NO_HIT;
+  }
+};
+
+//! \brief Creates the ray of a camera through a point of the image, like createCameraRays() does for pixel centers.
+//! \param[in]  clipToWorld Inverse of projectionMatrix * viewMatrix.
+//! \param[in]  imagePosition Position in pixels, measured from the top left corner of the image. The center of pixel
+//!             (x, y) is (x + 0.5, y + 0.5).
+//! \param[in]  width Number of pixels per row.
+//! \param[in]  height Number of rows.
+Ray createCameraRay(const f32m4& clipToWorld, const f32v2& imagePosition, ui32 width, ui32 height);
+
+//! \brief Creates a ray through the center of every pixel of a camera, row by row from the top left pixel.
+//!
+//! The rays start on the near plane and are not bounded by the far plane. Their directions are normalized, so t is the
+//! distance from the near plane.
+//! \param[in]  viewMatrix Maps world space to view space.
+//! \param[in]  projectionMatrix Maps view space to clip space with depth in [0, 1], e.g., glm::perspectiveFovLH_ZO().
+//! \param[in]  width Number of pixels per row.
+//! \param[in]  height Number of rows.
+std::vector<Ray> createCameraRays(const f32m4& viewMatrix, const f32m4& projectionMatrix, ui32 width, ui32 height);
+} // namespace gims
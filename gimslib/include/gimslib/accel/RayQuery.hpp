@@ -0,0 +1,176 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#pragma once
+#include <gimslib/accel/Ray.hpp>
+#include <gimslib/accel/TLAS.hpp>
+#include <gimslib/types.hpp>
+#include <stdexcept>
+namespace gims
+{
+//! \brief The HLSL RAY_FLAG values.
+enum RAY_FLAG : ui32
+{
+  RAY_FLAG_NONE                            = 0x00,
+  RAY_FLAG_FORCE_OPAQUE                    = 0x01,
+  RAY_FLAG_FORCE_NON_OPAQUE                = 0x02,
+  RAY_FLAG_ACCEPT_FIRST_HIT_AND_END_SEARCH = 0x04,
+  RAY_FLAG_SKIP_CLOSEST_HIT_SHADER         = 0x08,
+  RAY_FLAG_CULL_BACK_FACING_TRIANGLES      = 0x10,
+  RAY_FLAG_CULL_FRONT_FACING_TRIANGLES     = 0x20,
+  RAY_FLAG_CULL_OPAQUE                     = 0x40,
+  RAY_FLAG_CULL_NON_OPAQUE                 = 0x80,
+  RAY_FLAG_SKIP_TRIANGLES                  = 0x100,
+  RAY_FLAG_SKIP_PROCEDURAL_PRIMITIVES      = 0x200
+};
+
+//! \brief The HLSL COMMITTED_STATUS values.
+enum COMMITTED_STATUS : ui32
+{
+  COMMITTED_NOTHING,
+  COMMITTED_TRIANGLE_HIT,
+  COMMITTED_PROCEDURAL_PRIMITIVE_HIT
+};
+
+//! \brief The flags that RayQuery cannot emulate.
+//!
+//! The TLAS has neither non-opaque triangles, which Proceed() would hand to the shader as candidates, nor a winding
+//! order to cull by.
+constexpr ui32 RAY_QUERY_UNSUPPORTED_FLAGS =
+    RAY_FLAG_FORCE_NON_OPAQUE | RAY_FLAG_CULL_BACK_FACING_TRIANGLES | RAY_FLAG_CULL_FRONT_FACING_TRIANGLES;
+
+//! \brief Emulates the HLSL RayQuery object of inline ray tracing on a TLAS.
+//!
+//! The methods are named as in HLSL, so that shader code ports to the CPU with the same control flow, e.g.:
+//!
+//!     RayQuery<RAY_FLAG_FORCE_OPAQUE | RAY_FLAG_SKIP_PROCEDURAL_PRIMITIVES> q;
+//!     q.TraceRayInline(tlas, 0, 0xFF, ray);
+//!     q.Proceed();
+//!     if (q.CommittedStatus() == COMMITTED_TRIANGLE_HIT) ...
+//!
+//! Every triangle of the TLAS is opaque. Hence, the first Proceed() traverses the whole structure, commits the
+//! closest hit, or any hit with RAY_FLAG_ACCEPT_FIRST_HIT_AND_END_SEARCH, and returns false, as on the GPU when no
+//! candidate needs a decision of the shader. Procedural primitives do not exist, so their flags have no effect. The
+//! work of each query is counted, see getTraversalCounters().
+//! \tparam Flags The flags of the query, which TraceRayInline() combines with its own. Must not contain
+//!         RAY_QUERY_UNSUPPORTED_FLAGS.
+template<ui32 Flags> class RayQuery
+{
+  static_assert((Flags & RAY_QUERY_UNSUPPORTED_FLAGS) == 0, "RayQuery only supports opaque triangles without culling.");
+
+public:
+  //! \brief Starts a new query. The committed hit is reset and the traversal happens in Proceed().
+  //! \param[in]  tlas The acceleration structure. Must outlive the query.
+  //! \param[in]  rayFlags Combined with Flags. Throws on RAY_QUERY_UNSUPPORTED_FLAGS.
+  //! \param[in]  instanceInclusionMask Only the lower 8 bits are used, as in HLSL.
+  //! \param[in]  ray The ray in world space.
+  void TraceRayInline(const TLAS& tlas, ui32 rayFlags, ui32 instanceInclusionMask, const Ray& ray)
+  {
+    if ((rayFlags & RAY_QUERY_UNSUPPORTED_FLAGS) != 0)
+    {
+      throw std::runtime_error("RayQuery only supports opaque triangles without culling.");
+    }
+    m_tlas                  = &tlas;
+    m_rayFlags              = Flags | rayFlags;
+    m_instanceInclusionMask = static_cast<ui8>(instanceInclusionMask);
+    m_ray                   = ray;
+    m_committedHit          = RayHit();
+    m_committedHit.t        = ray.tMax;
+    m_counters              = TLASTraversalCounters();
+    m_isDone                = false;
+  }
+
+  //! \brief Runs the traversal on the first call after TraceRayInline().
+  //! \return Always false, as there are no candidates for the shader.
+  bool Proceed()
+  {
+    if (m_isDone || m_tlas == nullptr)
+    {
+      return false;
+    }
+    m_isDone = true;
+    // All triangles are opaque, so culling opaque geometry or skipping triangles leaves nothing to hit.
+    if ((m_rayFlags & (RAY_FLAG_CULL_OPAQUE | RAY_FLAG_SKIP_TRIANGLES)) != 0)
+    {
+      return false;
+    }
+    m_committedHit = m_tlas->traceRay(m_ray, m_instanceInclusionMask,
+                                      (m_rayFlags & RAY_FLAG_ACCEPT_FIRST_HIT_AND_END_SEARCH) != 0, &m_counters);
+    return false;
+  }
+
+  //! \brief Ends the query. The committed hit so far is kept.
+  void Abort()
+  {
+    m_isDone = true;
+  }
+
+  ui32 RayFlags() const
+  {
+    return m_rayFlags;
+  }
+
+  f32 RayTMin() const
+  {
+    return m_ray.tMin;
+  }
+
+  f32v3 WorldRayOrigin() const
+  {
+    return m_ray.origin;
+  }
+
+  f32v3 WorldRayDirection() const
+  {
+    return m_ray.direction;
+  }
+
+  COMMITTED_STATUS CommittedStatus() const
+  {
+    return m_committedHit.isHit() ? COMMITTED_TRIANGLE_HIT : COMMITTED_NOTHING;
+  }
+
+  //! \brief The t of the committed hit, or TMax of the ray if nothing was committed.
+  f32 CommittedRayT() const
+  {
+    return m_committedHit.t;
+  }
+
+  f32v2 CommittedTriangleBarycentrics() const
+  {
+    return m_committedHit.barycentrics;
+  }
+
+  //! \brief The TLASInstance::instanceID of the committed hit.
+  ui32 CommittedInstanceID() const
+  {
+    return m_committedHit.instanceID;
+  }
+
+  //! \brief The index of the instance in the TLAS, i.e., the index returned by TLAS::addInstance().
+  ui32 CommittedInstanceIndex() const
+  {
+    return m_committedHit.instanceIdx;
+  }
+
+  ui32 CommittedPrimitiveIndex() const
+  {
+    return m_committedHit.primitiveIdx;
+  }
+
+  //! \brief Returns the work of the traversal since the last TraceRayInline().
+  const TLASTraversalCounters& getTraversalCounters() const
+  {
+    return m_counters;
+  }
+
+private:
+  const TLAS*           m_tlas                  = nullptr;
+  ui32                  m_rayFlags              = Flags;
+  ui8                   m_instanceInclusionMask = 0xff;
+  Ray                   m_ray;
+  RayHit                m_committedHit;
+  TLASTraversalCounters m_counters;
+  bool                  m_isDone = true;
+};
+} // namespace gims
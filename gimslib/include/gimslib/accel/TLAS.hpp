@@ -0,0 +1,161 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#pragma once
+#include <gimslib/accel/BVH.hpp>
+#include <gimslib/accel/Ray.hpp>
+#include <gimslib/geometry/AABB.hpp>
+#include <gimslib/geometry/TriangleMeshView.hpp>
+#include <gimslib/types.hpp>
+#include <vector>
+namespace gims
+{
+class ThreadPool;
+
+//! \brief An instance of a bottom-level structure, like a D3D12_RAYTRACING_INSTANCE_DESC.
+struct TLASInstance
+{
+  //! Object-to-world transformation. Its rows are the rows of D3D12_RAYTRACING_INSTANCE_DESC::Transform.
+  f32m4x3 transformation = f32m4x3(1.0f);
+  //! Reported as RayHit::instanceID. Only the lower 24 bits are kept, as in D3D12.
+  ui32    instanceID = 0;
+  //! Rays skip the instance if their instance inclusion mask shares no bit with this mask.
+  ui8     instanceMask = 0xff;
+  //! Index returned by TLAS::addBottomLevel().
+  ui32    bottomLevelIdx = 0;
+};
+
+//! \brief Work of rays traced through a TLAS, e.g., to compare the cost of shading settings.
+struct TLASTraversalCounters
+{
+  ui64 nRays             = 0;
+  //! Nodes of the top level that a ray entered.
+  ui64 nTopLevelNodes    = 0;
+  //! Instances that a ray was transformed into. Instances skipped by their mask are not counted.
+  ui64 nInstances        = 0;
+  //! Nodes of the bottom levels that a ray entered.
+  ui64 nBottomLevelNodes = 0;
+  //! Ray-triangle tests.
+  ui64 nTriangles        = 0;
+
+  //! \brief Returns the iterations of the traversal loops: nodes entered, instances, and triangles tested.
+  ui64 getNumSteps() const;
+
+  TLASTraversalCounters& operator+=(const TLASTraversalCounters& other);
+};
+
+//! \brief A two-level acceleration structure on the CPU that mirrors the D3D12 instancing model.
+//!
+//! Bottom-level structures are BVHs over meshes in object space. The top level is a BVH over the world-space boxes of
+//! the instances. Rays are transformed into the object space of each instance they reach.
+class TLAS
+{
+public:
+  //! \brief Creates an empty TLAS.
+  TLAS() = default;
+
+  //! \brief Builds a BVH over a mesh and adds it as a bottom-level structure.
+  //! \param[in]  mesh The mesh. Its data must outlive the TLAS.
+  //! \param[in]  options Parameters of the SAH.
+  //! \param[in]  threadPool If not nullptr, the BVH is built in parallel.
+  //! \return The index that instances refer to the structure by.
+  ui32 addBottomLevel(const TriangleMeshView& mesh, const BVHBuildOptions& options = BVHBuildOptions(),
+                      ThreadPool* threadPool = nullptr);
+
+  //! \brief Adds a BVH that was built over a mesh before, e.g., by a BVHCache, as a bottom-level structure.
+  //! \param[in]  mesh The mesh. Its data must outlive the TLAS.
+  //! \param[in]  bvh The BVH of the mesh.
+  //! \return The index that instances refer to the structure by.
+  ui32 addBottomLevel(const TriangleMeshView& mesh, BVH bvh);
+
+  //! \brief Adds an instance. Call build() before tracing rays.
+  //! \return The index of the instance, reported as RayHit::instanceIdx.
+  ui32 addInstance(const TLASInstance& instance);
+
+  //! \brief Replaces the transformation of an instance. Call update() or build() before tracing rays.
+  void setInstanceTransformation(ui32 instanceIdx, const f32m4x3& transformation);
+
+  //! \brief Builds the top level over the instances.
+  //!
+  //! The bottom-level BVHs are kept. Hence, rebuilding after transformations changed only depends on the number of
+  //! instances, not on the number of triangles.
+  void build(ThreadPool* threadPool = nullptr);
+
+  //! \brief Brings the top level up to date after setInstanceTransformation(), preferably by a refit.
+  //!
+  //! A refit only updates the boxes of the changed instances and their ancestors in the top level, which takes
+  //! O(changed instances * depth) time. As the topology is kept, moving instances apart degrades the top level. Hence,
+  //! it is rebuilt if its SAH cost exceeds the cost after its last build by the rebuild threshold, or if instances were
+  //! added since.
+  //! \param[in]  threadPool Used if the top level is rebuilt.
+  //! \return True if the top level was rebuilt.
+  bool update(ThreadPool* threadPool = nullptr);
+
+  //! \brief Sets the factor by which refits may increase the SAH cost of the top level before update() rebuilds it.
+  //! \param[in]  rebuildThreshold At least 1. A value of 1 rebuilds on any degradation, infinity never rebuilds.
+  void setRebuildThreshold(f32 rebuildThreshold);
+
+  //! \brief Returns the factor set with setRebuildThreshold().
+  f32 getRebuildThreshold() const;
+
+  //! \brief Finds the closest hit of a ray, like TraceRay() with RAY_FLAG_NONE.
+  //! \param[in]  ray The ray in world space.
+  //! \param[in]  instanceInclusionMask Only instances whose mask shares a bit with it are intersected.
+  //! \param[in]  acceptFirstHit Returns the first hit found, like RAY_FLAG_ACCEPT_FIRST_HIT_AND_END_SEARCH.
+  //! \param[in,out] counters If not nullptr, the work of the traversal is added to it.
+  //! \return The hit, if any.
+  RayHit traceRay(const Ray& ray, ui8 instanceInclusionMask = 0xff, bool acceptFirstHit = false,
+                  TLASTraversalCounters* counters = nullptr) const;
+
+  //! \brief Traces many rays in packets that traverse the structure together, for bulk queries like shadow rays.
+  //!
+  //! Consecutive rays form packets of 16, 8, or 4 rays, whichever of AVX-512F, AVX, or SSE the CPU supports widest.
+  //! A packet tests each box against all its rays with one instruction per slab, and visits the union of the nodes its
+  //! rays visit. Hence, order the rays coherently, e.g., by screen tiles. The closest hits equal those of traceRay(),
+  //! except that triangles hit at the same t may be reported differently.
+  //! \param[in]  rays Array of nRays rays in world space.
+  //! \param[in]  nRays Number of rays.
+  //! \param[out] hits Array of nRays hits, in the order of the rays.
+  //! \param[in]  instanceInclusionMask See traceRay().
+  //! \param[in]  acceptFirstHit See traceRay(). Ends the search of each ray separately.
+  //! \param[in]  threadPool If not nullptr, ranges of packets are traced concurrently.
+  void traceRays(const Ray* rays, ui32 nRays, RayHit* hits, ui8 instanceInclusionMask = 0xff,
+                 bool acceptFirstHit = false, ThreadPool* threadPool = nullptr) const;
+
+  //! \brief Returns the world-space bounding box of all instances.
+  AABB getAABB() const;
+
+  ui32                getNumBottomLevels() const;
+  const BVH&          getBottomLevelBVH(ui32 bottomLevelIdx) const;
+  ui32                getNumInstances() const;
+  const TLASInstance& getInstance(ui32 instanceIdx) const;
+  const BVH&          getTopLevelBVH() const;
+
+private:
+  struct BottomLevel
+  {
+    BVH              bvh;
+    TriangleMeshView mesh;
+  };
+
+  //! \brief Computes the inverse transformation and the world-space box of an instance.
+  void updateInstance(ui32 instanceIdx);
+
+  //! \brief Throws if instances changed since the last build() or update().
+  void checkIsUpToDate() const;
+
+  //! \brief Traces up to Width rays as one packet.
+  template<ui32 Width>
+  void tracePacket(const Ray* rays, ui32 nRays, RayHit* hits, ui8 instanceInclusionMask, bool acceptFirstHit) const;
+
+  std::vector<BottomLevel>  m_bottomLevels;
+  std::vector<TLASInstance> m_instances;
+  std::vector<f32m4x3>      m_worldToObjectTransformations; //! Inverses of the instance transformations.
+  std::vector<AABB>         m_worldSpaceAABBs;              //! The boxes the top level is built over.
+  BVH                       m_topLevel;
+  std::vector<ui32>         m_changedInstanceIndices; //! Instances transformed since the last build() or update().
+  std::vector<bool>         m_isInstanceChanged;      //! Avoids duplicates in m_changedInstanceIndices.
+  f32                       m_rebuildThreshold = 1.5f;
+  bool                      m_isBuilt          = true; //! False if instances were added since the last build().
+};
+} // namespace gims
@@ -0,0 +1,104 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#pragma once
+#include <array>
+#include <gimslib/accel/BVH.hpp>
+#include <gimslib/accel/Ray.hpp>
+#include <gimslib/geometry/AABB.hpp>
+#include <gimslib/geometry/TriangleMeshView.hpp>
+#include <gimslib/types.hpp>
+#include <vector>
+namespace gims
+{
+//! \brief A BVH with up to Width children per node and child bounds quantized to 8 bits, collapsed from a binary BVH.
+//!
+//! Each node stores the bounds of its children on a grid of 255^3 cells spanned over the node's own box, following
+//! Ylitie, Karras, and Laine, Efficient Incoherent Ray Traversal on GPUs Through Compressed Wide BVHs, 2017. The cell
+//! size per axis is a power of two, so dequantizing is exact up to a single addition, and the quantized bounds always
+//! contain the original bounds. Traversal tests all children of a node at once, with SSE for Width 4 and with AVX for
+//! Width 8, if the CPU supports it.
+//!
+//! The inner children of a node are stored consecutively, as are the primitives of its leaf children. Hence, a node
+//! only needs one index for each, and leaves are not stored as nodes at all. Instantiated for Width 4 and 8.
+template<ui32 Width> class WideBVH
+{
+public:
+  static_assert(Width == 4 || Width == 8, "Wide BVHs have 4 or 8 children per node.");
+
+  //! Meta value of an unused child slot.
+  static constexpr ui8 EMPTY_CHILD = 0x00;
+  //! Meta value of a child that is an inner node. Other values are the number of primitives of a leaf child.
+  static constexpr ui8 INNER_CHILD = 0x80;
+
+  //! \brief A node with the quantized bounds of its children. 52 bytes for Width 4, 80 bytes for Width 8.
+  struct Node
+  {
+    //! Lower corner of the quantization grid, the lower corner of the node's box.
+    f32v3                                 origin;
+    //! The grid cells are 2^exponents[axis] wide.
+    std::array<i8, 3>                     exponents;
+    //! Index of the first inner child in getNodes().
+    ui32                                  firstChildIdx;
+    //! Index of the first primitive of the first leaf child in getPrimitiveIndices().
+    ui32                                  firstPrimitiveIdx;
+    //! EMPTY_CHILD, INNER_CHILD, or the number of primitives of a leaf child, per slot.
+    std::array<ui8, Width>                meta;
+    //! Lower grid coordinates of the child bounds, per axis and slot.
+    std::array<std::array<ui8, Width>, 3> quantizedLower;
+    //! Upper grid coordinates of the child bounds, per axis and slot.
+    std::array<std::array<ui8, Width>, 3> quantizedUpper;
+
+    //! \brief Returns the size of a grid cell along an axis.
+    f32v3 getCellSize() const;
+
+    //! \brief Returns the bounding box of the child in a slot.
+    AABB getChildAABB(ui32 slot) const;
+  };
+
+  //! \brief Creates an empty BVH.
+  WideBVH() = default;
+
+  //! \brief Collapses a binary BVH.
+  //!
+  //! Greedily pulls up the grandchildren of the child with the largest surface area until a node has Width children
+  //! (Wald, Benthin, and Boulos, Getting Rid of Packets, 2008). Leaves are kept as they are.
+  //! \param[in]  bvh The binary BVH. Its leaves must have at most 127 primitives.
+  explicit WideBVH(const BVH& bvh);
+
+  //! \brief Returns the nodes. The first node is the root. Empty if there are no primitives.
+  const std::vector<Node>& getNodes() const;
+
+  //! \brief Returns the primitive indices that the leaves reference, sorted by leaf.
+  const std::vector<ui32>& getPrimitiveIndices() const;
+
+  //! \brief Returns the bounding box of the root, or an invalid box if the BVH is empty.
+  AABB getAABB() const;
+
+  //! \brief Returns the number of levels of nodes, leaves excluded.
+  ui32 getMaxDepth() const;
+
+  //! \brief Returns the bytes taken by the nodes and the primitive indices.
+  size_t getMemorySize() const;
+
+  //! \brief Intersects a ray with the triangles, like BVH::intersect().
+  //! \param[in]  mesh The mesh the binary BVH was built for.
+  //! \param[in]  ray The ray. Only hits in [ray.tMin, hit.t) are reported.
+  //! \param[in,out] hit Receives t, barycentrics, and primitiveIdx of the closest hit. Other members are untouched.
+  //! \param[in]  acceptFirstHit Stops at the first hit rather than the closest, for shadow rays.
+  //! \return True if a hit was found.
+  bool intersect(const TriangleMeshView& mesh, const Ray& ray, RayHit& hit, bool acceptFirstHit = false) const;
+
+private:
+  std::vector<Node> m_nodes;
+  std::vector<ui32> m_primitiveIndices;
+  AABB              m_aabb;
+  ui32              m_maxDepth = 0;
+};
+
+extern template class WideBVH<4>;
+extern template class WideBVH<8>;
+
+using BVH4 = WideBVH<4>;
+using BVH8 = WideBVH<8>;
+} // namespace gims
@@ -0,0 +1,80 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#pragma once
+#include <gimslib/types.hpp>
+namespace gims
+{
+class ThreadPool;
+
+//! \brief An Axis-Aligned Bounding-Box (AABB).
+class AABB
+{
+public:
+  //! \brief Creates an invalid bounding box. Its union with any other box yields the other box.
+  AABB();
+  AABB(const AABB& other)                = default;
+  AABB(AABB&& other) noexcept            = default;
+  AABB& operator=(const AABB& other)     = default;
+  AABB& operator=(AABB&& other) noexcept = default;
+
+  //! \brief Creates a bounding box from its corners.
+  AABB(const f32v3& lowerLeftBottom, const f32v3& upperRightTop);
+
+  //! \brief Computes a bounding box from an array of 3D positions.
+  //!
+  //! Uses SSE or AVX, whichever the CPU supports. NaN coordinates are ignored.
+  //! \param[in]  positions Array of 3D positions, i.e., packed xyz triples.
+  //! \param[in]  nPositions Number of positions.
+  //! \param[in]  threadPool If not nullptr, large arrays are split into slices that are processed concurrently.
+  AABB(f32v3 const* const positions, size_t nPositions, ThreadPool* threadPool = nullptr);
+
+  //! \brief Computes a bounding box from planar coordinate streams (structure of arrays).
+  //! \param[in]  x Array of nPositions x coordinates.
+  //! \param[in]  y Array of nPositions y coordinates.
+  //! \param[in]  z Array of nPositions z coordinates.
+  //! \param[in]  nPositions Number of positions.
+  //! \param[in]  threadPool If not nullptr, large arrays are split into slices that are processed concurrently.
+  AABB(f32 const* const x, f32 const* const y, f32 const* const z, size_t nPositions,
+       ThreadPool* threadPool = nullptr);
+
+  //! \brief Returns the affine matrix that maps the bounding box to [-0.5...0.5]^3.
+  f32m4 getNormalizationTransformation() const;
+
+  //! \brief Returns the union of this bounding box with the other bounding box.
+  AABB getUnion(const AABB& other) const;
+
+  //! \brief Returns the lower, left, bottom corner of the bounding box.
+  const f32v3& getLowerLeftBottom() const;
+
+  //! \brief Returns the upper, right, top corner of the bounding box.
+  const f32v3& getUpperRightTop() const;
+
+  //! \brief Returns the smallest bounding box that contains this bounding box after it was transformed.
+  //!
+  //! Transforms the center and the half extent with the absolute values of the matrix (Arvo, Graphics Gems, 1990),
+  //! which bounds all eight transformed corners. An invalid box stays invalid.
+  //! \param[in]  transformation An affine matrix, i.e., its last row is (0, 0, 0, 1).
+  AABB getTransformed(const f32m4& transformation) const;
+
+  //! \brief Transforms many bounding boxes, each by its own matrix, like getTransformed().
+  //! \param[in]  aabbs Array of nAABBs bounding boxes, e.g., the object-space boxes of mesh instances.
+  //! \param[in]  transformations Array of nAABBs affine matrices, e.g., the world-space matrices of the instances.
+  //! \param[in]  nAABBs Number of bounding boxes.
+  //! \param[out] transformedAABBs Array of nAABBs bounding boxes that receives the results. May alias aabbs.
+  static void getTransformed(const AABB* aabbs, const f32m4* transformations, size_t nAABBs,
+                             AABB* transformedAABBs);
+
+  //! \brief Returns the union of many transformed bounding boxes without storing the individual boxes.
+  //! \param[in]  aabbs Array of nAABBs bounding boxes.
+  //! \param[in]  transformations Array of nAABBs affine matrices.
+  //! \param[in]  nAABBs Number of bounding boxes.
+  static AABB getTransformedUnion(const AABB* aabbs, const f32m4* transformations, size_t nAABBs);
+
+private:
+  //! The lower left bottom corner of the AABB.
+  f32v3 m_lowerLeftBottom;
+  //! The upper right top of the AABB.
+  f32v3 m_upperRightTop;
+};
+} // namespace gims
@@ -0,0 +1,38 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#pragma once
+#include <gimslib/types.hpp>
+namespace gims
+{
+//! \brief Non-owning view of an indexed triangle mesh.
+//!
+//! Positions may be interleaved with other vertex attributes, e.g., the position at the start of a vertex struct.
+struct TriangleMeshView
+{
+  //! Address of the first position, i.e., three consecutive floats.
+  void const* positions = nullptr;
+  //! Bytes between two consecutive positions.
+  size_t positionStride = sizeof(f32v3);
+  //! Array of nTriangles index triples.
+  ui32v3 const* triangles = nullptr;
+  //! Number of triangles.
+  ui32 nTriangles = 0;
+  //! Subtracted from every index before it addresses a position. Allows to view a single mesh of an index buffer that
+  //! refers to a vertex buffer shared by several meshes.
+  ui32 baseVertex = 0;
+
+  //! \brief Returns the position addressed by the index vertexIdx.
+  const f32v3& getPosition(ui32 vertexIdx) const
+  {
+    return *reinterpret_cast<const f32v3*>(static_cast<const ui8*>(positions) +
+                                           size_t(vertexIdx - baseVertex) * positionStride);
+  }
+
+  //! \brief Returns the corner of triangle triangleIdx, cornerIdx is 0, 1, or 2.
+  const f32v3& getPosition(ui32 triangleIdx, ui32 cornerIdx) const
+  {
+    return getPosition(triangles[triangleIdx][cornerIdx]);
+  }
+};
+} // namespace gims
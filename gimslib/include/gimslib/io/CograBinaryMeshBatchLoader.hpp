@@ -0,0 +1,71 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#pragma once
+#include <exception>
+#include <functional>
+#include <future>
+#include <gimslib/io/CograBinaryMeshFile.hpp>
+#include <string>
+#include <vector>
+namespace gims
+{
+class ThreadPool;
+
+//! \brief Controls how CograBinaryMeshBatchLoader loads a file.
+struct CograBinaryMeshLoadOptions
+{
+  bool map             = false; //! Use CograBinaryMeshFile::map() instead of load().
+  bool verifyChecksums = true;  //! Verify the section hashes of V2 files. load() always verifies them.
+  bool validate        = true;  //! Check that indices are in range and positions are finite.
+};
+
+//! \brief A mesh loaded by CograBinaryMeshBatchLoader together with the results of its post-processing.
+struct LoadedCograBinaryMesh
+{
+  std::string         fileName;
+  CograBinaryMeshFile mesh;
+  f32v3               aabbMin;                     //! Minimum corner of the bounding box of the positions.
+  f32v3               aabbMax;                     //! Maximum corner of the bounding box of the positions.
+  f32m4               normalizationTransformation; //! Maps the bounding box into [-0.5, 0.5]^3.
+};
+
+//! \brief Loads many Cogra binary mesh files concurrently.
+//!
+//! Every file is loaded, validated and post-processed by one task of a ThreadPool. The number of files in flight is
+//! the number of workers, so a pool with more workers than cores keeps more requests in the disk queue.
+class CograBinaryMeshBatchLoader
+{
+public:
+  //! Receives a mesh on the worker that loaded it.
+  typedef std::function<void(size_t fileIdx, LoadedCograBinaryMesh&& mesh)> CompletionCallback;
+
+  //! Receives the exception raised while loading a file on the worker that loaded it.
+  typedef std::function<void(size_t fileIdx, std::exception_ptr error)> ErrorCallback;
+
+  //! \brief Creates a loader.
+  //! \param[in]  threadPool Pool that executes the loads. Must outlive all loads.
+  //! \param[in]  options Applies to all files.
+  explicit CograBinaryMeshBatchLoader(ThreadPool& threadPool, CograBinaryMeshLoadOptions options = {});
+
+  //! \brief Loads files.
+  //! \return One future per file, in the order of fileNames. A future rethrows the error of its file.
+  std::vector<std::future<LoadedCograBinaryMesh>> load(const std::vector<std::string>& fileNames);
+
+  //! \brief Loads files and hands every result to a callback as soon as it is ready.
+  //! \param[in]  fileNames Paths of the files.
+  //! \param[in]  onLoaded Called for every file that was loaded. Must be thread-safe.
+  //! \param[in]  onError Called for every file that failed. Must be thread-safe.
+  //! \return A future that becomes ready after the last callback returned. It rethrows the first exception that
+  //!         escaped a callback.
+  std::future<void> load(const std::vector<std::string>& fileNames, CompletionCallback onLoaded,
+                         ErrorCallback onError);
+
+  //! \brief Loads, validates and post-processes a single file on the calling thread.
+  static LoadedCograBinaryMesh loadFile(const std::string& fileName, const CograBinaryMeshLoadOptions& options);
+
+private:
+  ThreadPool&                m_threadPool;
+  CograBinaryMeshLoadOptions m_options;
+};
+} // namespace gims
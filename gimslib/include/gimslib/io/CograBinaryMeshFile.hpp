@@ -2,6 +2,9 @@
 /// (C) 2017-2022 by Quirin Meyer
 /// quirin.meyer@hs-coburg.de
 #pragma once
+#include <algorithm>
+#include <functional>
+#include <gimslib/io/VertexLayout.hpp>
 #include <gimslib/types.hpp>
 #include <memory>
 #include <string>
@@ -9,6 +12,9 @@
 //! Namespace for everything that is Computer Graphics related.
 namespace gims
 {
+class MappedFile;
+class ThreadPool;
+
 //! \brief Binary file for triangle meshes.
 //!
 //! Topology is encoded as an indexed face set. Three indices to vertices make a triangle. Each vertex has a position
@@ -16,15 +22,17 @@ namespace gims
 //! of arbitrary type.
 //! Moreover, values that are constant for the entire triangle mesh may be stored. Similar to attributes, an
 //! arbitrary number of constants of arbitrary type is supported.
+//! Positions, triangles, attributes, constants and their names share a single arena allocation. Copying a mesh is one
+//! allocation and one memcpy, moving it is O(1).
 class CograBinaryMeshFile
 {
+public:
   //! Maximum number of characters used for attribute and constant names
   enum
   {
     N_CHARS = 256
   };
 
-public:
   //! Type for numbers and sizes.
   typedef ui32 SizeType;
 
@@ -34,6 +42,28 @@ public:
   //! Floating point used for vertex positions.
   typedef f32 FloatType;
 
+  //! \brief Versions of the file format.
+  //!
+  //! V1 stores a header with fixed-size names, followed by the arrays back-to-back. V2 stores a section directory,
+  //! aligns every section to 64 bytes and stores a hash of every section, which is verified on load().
+  enum class FileVersion
+  {
+    V1 = 1,
+    V2 = 2
+  };
+
+  //! \brief Optional compression of the sections of V2 files. Flags may be combined.
+  //!
+  //! Compressed sections are decoded on load(), so all accessors return plain arrays regardless of the compression.
+  enum Compression : ui32
+  {
+    COMPRESS_NONE      = 0,      //! All sections are stored raw.
+    COMPRESS_INDICES   = 1 << 0, //! Triangle indices are zigzag delta and varint encoded. Lossless.
+    COMPRESS_POSITIONS = 1 << 1, //! Positions are quantized to 16 bits per component relative to their bounding box.
+    COMPRESS_NORMALS   = 1 << 2, //! Attributes of three unit-length floats are stored as two 16 bit octahedral values.
+    COMPRESS_ALL       = COMPRESS_INDICES | COMPRESS_POSITIONS | COMPRESS_NORMALS
+  };
+
   //! \brief Default constructor.
   CograBinaryMeshFile() = default;
 
@@ -53,12 +83,12 @@ public:
   void swap(CograBinaryMeshFile& other);
 
   //! Assignment operator.
-  CograBinaryMeshFile& operator=(CograBinaryMeshFile other);
+  CograBinaryMeshFile& operator=(const CograBinaryMeshFile& other);
 
   //! Move operator.
   CograBinaryMeshFile& operator=(CograBinaryMeshFile&& other) noexcept;
 
-  //! \brief Loads a file.
+  //! \brief Loads a file. Both file versions are supported.
   //!
   //! \param[in]  fileName Path to file name
   void load(const std::string& fileName);
@@ -66,7 +96,24 @@ public:
   //! \brief Saves a file.
   //!
   //! \param[in]  fileName Path to file name
-  void save(const std::string& fileName);
+  //! \param[in]  version File format version to write.
+  //! \param[in]  compression Combination of Compression flags. Requires FileVersion::V2.
+  void save(const std::string& fileName, FileVersion version = FileVersion::V1, ui32 compression = COMPRESS_NONE);
+
+  //! \brief Maps a file into memory instead of reading it.
+  //!
+  //! Positions, indices, attributes and constants point directly into the mapped file, so no copy is made and pages
+  //! are only read once they are touched. The mapping is copy-on-write: writing through the returned pointers never
+  //! modifies the file. Any operation that reallocates a stream (e.g., addAttribute() or add()) first copies the
+  //! mesh into memory owned by this object.
+  //! Sections of V2 files are 64 byte aligned, and so are the pointers into them. Compressed V2 files cannot be
+  //! referenced in place; they are decoded into memory owned by this object, and isMapped() returns false.
+  //! \param[in]  fileName Path to file name
+  //! \param[in]  verifyChecksums If true, the section hashes of a V2 file are verified. This touches every page.
+  static CograBinaryMeshFile map(const std::string& fileName, bool verifyChecksums = false);
+
+  //! \brief Returns true, if the streams of this mesh point into a mapped file.
+  bool isMapped() const;
 
   //! \brief Returns the number of vertices.
   SizeType getNumVertices() const;
@@ -183,6 +230,19 @@ public:
   //! \param  vIdx Index of the vertex
   void getAllVertexAttributes(void* result, SizeType vIdx) const;
 
+  //! \brief Returns the layout of the vertices written by getAllVertexAttributes().
+  //!
+  //! The position comes first, followed by all attributes in the order of their indices, without padding.
+  VertexLayout getPackedVertexLayout() const;
+
+  //! \brief Interleaves the positions and attributes of all vertices, e.g., into a mapped upload buffer.
+  //!
+  //! The stream of every element of layout is selected by VertexElement::stream. The size of an element must equal
+  //! the size of one element of its stream.
+  //! \param[in]  layout Layout of the vertices.
+  //! \param[out] destination Receives getNumVertices() * layout.stride bytes.
+  void getInterleavedVertices(const VertexLayout& layout, void* destination) const;
+
   //! \brief Returns the size of one component of a constant.
   //!
   //! For a light direction vector that would be 4, as a light direction vector consists of floats, and sizeof(f32)=4.
@@ -231,10 +291,28 @@ public:
 
   //! \brief Adds another QMBinFile to this QMBinFile.
   //!
+  //! The streams and attributes of src are appended in place. A stream without room moves to a block twice its size,
+  //! so adding many meshes one by one copies every element a constant number of times on average.
   //! \param  src Bin file that should be appended to this file.
   //! \return True on success, false otherwise.
   bool add(const CograBinaryMeshFile& src);
 
+  //! \brief Merges many meshes into a new mesh.
+  //!
+  //! The meshes are concatenated in the given order and the indices of every mesh are rebased onto its first vertex.
+  //! Attribute names and constants are taken from the first mesh. The result is allocated once, so merging takes
+  //! time linear in the total size of the meshes.
+  //! \param[in]  meshes Meshes to merge. The same mesh may occur more than once.
+  //! \param[in]  threadPool Copies and rebases the meshes in parallel. If nullptr, the calling thread does the work.
+  //! \return The merged mesh.
+  //! \throws std::runtime_error if the attributes of the meshes differ in number, components or component size, or
+  //!         if the merged mesh has more vertices than an index can address.
+  static CograBinaryMeshFile merge(const std::vector<const CograBinaryMeshFile*>& meshes,
+                                   ThreadPool*                                   threadPool = nullptr);
+
+  //! \brief Returns true, if both meshes have the same number of attributes with equal components and sizes.
+  bool hasSameAttributeLayout(const CograBinaryMeshFile& other) const;
+
   //! \brief Prints the information about constants to a stream.
   //! \param[in,out]  stream The stream the information should be written to.
   void printConstant(std::ostream& stream) const;
@@ -260,36 +338,116 @@ public:
   int getConstantIdx(SizeType components, SizeType componentSize, const char* name) const;
 
 private:
-  //! Vertex positions.
-  std::vector<FloatType> m_positions;
+  //! \brief Points the streams, attributes and constants into the mapped file m_mappedFile.
+  void mapSections(bool verifyChecksums);
 
-  //! Indexed face set of triangles.
-  std::vector<IndexType> m_triangles;
+  //! \brief Points the streams, attributes and constants into the mapped V2 file m_mappedFile.
+  void mapSectionsV2(bool verifyChecksums);
+
+  //! \brief Reads and decodes a V2 file.
+  //! \param[in]  readBytes Copies size bytes at offset from the beginning of the file to dst.
+  //! \param[in]  fileSize Size of the file in bytes.
+  //! \param[in]  verifyChecksums If true, the section hashes are verified.
+  void readV2(const std::function<void(ui64 offset, ui64 size, void* dst)>& readBytes, ui64 fileSize,
+              bool verifyChecksums);
+
+  //! \brief Writes a V2 file.
+  void writeV2(std::ofstream& outFile, ui32 compression);
 
-  //! All the attributes
-  std::vector<ui8*> m_attributes;
+  //! \brief Copies a mapped mesh into memory owned by this object and releases the mapping.
+  void detach();
 
-  //! Stores the number of components an attribute element posses (e.g., a normal has three components).
-  std::vector<SizeType> m_attributeComponents;
+  //! Location of a block of bytes relative to getStorage().
+  struct Block
+  {
+    size_t offset   = 0; //! Offset in bytes.
+    size_t size     = 0; //! Size in bytes.
+    size_t capacity = 0; //! Size in bytes that the block can grow to in place, if larger than size.
+
+    //! \brief Returns the number of bytes that the block occupies in the arena.
+    size_t getCapacity() const
+    {
+      return std::max(size, capacity);
+    }
+  };
 
-  //! Holds the size in bytes of each component of an attribute element, e.g., a normal component has size 4, if it
-  //! is a f32.
-  std::vector<SizeType> m_attributeComponentSize;
+  //! Describes an attribute or a constant.
+  struct Element
+  {
+    SizeType components;    //! Number of components of an element (e.g., a normal has three components).
+    SizeType componentSize; //! Size in bytes of a component (e.g., 4, if a normal component is a f32).
+    Block    data;          //! The attribute array or the constant.
+    Block    name;          //! N_CHARS characters.
+  };
 
-  //! The attribute names.
-  std::vector<char*> m_attributeNames;
+  //! Storage replaced by reserve(). Pointers into it stay valid as long as this object lives.
+  struct RetiredStorage
+  {
+    std::unique_ptr<ui8[]>      arena;
+    std::shared_ptr<MappedFile> mappedFile;
+  };
 
-  //! Constants used for example for material properties.
-  std::vector<ui8*> m_constants;
+  //! \brief Returns the first byte of the storage, which is either the arena or the mapped file.
+  ui8* getStorage() const;
+
+  //! \brief Makes sure that blocks of size bytes in total can be allocated without moving the arena.
+  //!
+  //! A mapped mesh is detached. If the arena has to grow and more than half of it is unused, it is compacted. Offsets
+  //! of blocks that were allocated before may change, so no block may be held across this call.
+  //! \return The replaced storage. Keep it until data that may point into it (e.g., a function argument) is copied.
+  [[nodiscard]] RetiredStorage reserve(size_t size);
+
+  //! \brief Moves the arena to an allocation of at least capacity bytes.
+  //! \return The previous arena.
+  std::unique_ptr<ui8[]> grow(size_t capacity);
+
+  //! \brief Appends a block of size bytes to the arena.
+  //!
+  //! Never changes the offset of other blocks. If reserve() was not called, the arena may move.
+  Block allocate(size_t size);
+
+  //! \brief Appends a name of N_CHARS characters to the arena.
+  Block allocateName(const std::string& name);
 
-  //! Stores the number of components a constant posses (e.g., a light direction vector has three components).
-  std::vector<SizeType> m_constantComponents;
+  //! \brief Marks a block as unused. Its memory is reclaimed the next time the arena is compacted.
+  void release(const Block& block);
 
-  //! Holds the size in bytes of each component of a constant, e.g., a light direction vector component has size 4,
-  //! if it is a f32.
-  std::vector<SizeType> m_constantComponentSize;
+  //! \brief Copies all blocks in use into a new arena without gaps and releases the mapping.
+  //! \param[in]  extraCapacity Number of bytes the new arena can hold in addition.
+  //! \return The replaced storage.
+  [[nodiscard]] RetiredStorage compact(size_t extraCapacity);
 
-  //! The constant names.
-  std::vector<char*> m_constantNames;
+  //! \brief Releases all blocks and descriptors.
+  void clear();
+
+  //! \brief Returns the block of a pointer into the mapped file.
+  Block getMappedBlock(const void* data, size_t size) const;
+
+  //! Holds positions, triangles, attributes, constants and names, unless the mesh is mapped.
+  std::unique_ptr<ui8[]> m_arena;
+
+  //! Number of bytes of the arena that are allocated.
+  size_t m_arenaSize = 0;
+
+  //! Number of bytes the arena can hold.
+  size_t m_arenaCapacity = 0;
+
+  //! Number of allocated bytes of the arena that are no longer in use.
+  size_t m_arenaGarbage = 0;
+
+  //! The mapped file, if the mesh was opened with map(). All blocks then refer to the mapping instead of the arena.
+  std::shared_ptr<MappedFile> m_mappedFile;
+
+  //! Vertex positions.
+  Block m_positions;
+
+  //! Indexed face set of triangles.
+  Block m_triangles;
+
+  //! All the attributes.
+  std::vector<Element> m_attributes;
+
+  //! Constants used for example for material properties.
+  std::vector<Element> m_constants;
 };
 } // namespace gims
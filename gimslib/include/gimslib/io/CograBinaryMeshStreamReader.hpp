@@ -0,0 +1,138 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#pragma once
+#include <fstream>
+#include <functional>
+#include <gimslib/io/CograBinaryMeshFile.hpp>
+#include <string>
+#include <vector>
+namespace gims
+{
+//! \brief Reads the sections of a Cogra binary mesh file in fixed-size chunks.
+//!
+//! Only the header and the constants are kept in memory. Positions, triangle indices and attributes are streamed
+//! through a callback, one chunk at a time. The peak memory consumption is therefore bounded by the chunk size and
+//! independent of the size of the mesh. Both file versions are supported; section hashes of V2 files are not
+//! verified while streaming. Compressed sections are decoded chunk by chunk, so a decoded chunk handed to a callback
+//! may be larger than the chunk size.
+class CograBinaryMeshStreamReader
+{
+public:
+  typedef CograBinaryMeshFile::SizeType  SizeType;
+  typedef CograBinaryMeshFile::IndexType IndexType;
+  typedef CograBinaryMeshFile::FloatType FloatType;
+
+  //! \brief Receives a chunk of vertex positions.
+  //! \param  positions Three floats per vertex.
+  //! \param  firstVertex Index of the first vertex in this chunk.
+  //! \param  nVertices Number of vertices in this chunk.
+  typedef std::function<void(const FloatType* positions, SizeType firstVertex, SizeType nVertices)> PositionCallback;
+
+  //! \brief Receives a chunk of triangles.
+  //! \param  indices Three indices per triangle.
+  //! \param  firstTriangle Index of the first triangle in this chunk.
+  //! \param  nTriangles Number of triangles in this chunk.
+  typedef std::function<void(const IndexType* indices, SizeType firstTriangle, SizeType nTriangles)> TriangleCallback;
+
+  //! \brief Receives a chunk of attribute elements.
+  //! \param  attributes getAttributeElementSize() bytes per vertex.
+  //! \param  firstVertex Index of the vertex the first attribute element belongs to.
+  //! \param  nVertices Number of attribute elements in this chunk.
+  typedef std::function<void(const void* attributes, SizeType firstVertex, SizeType nVertices)> AttributeCallback;
+
+  //! \brief Opens a file and reads its header and constants.
+  //! \param[in]  fileName Path to the file.
+  //! \param[in]  chunkSize Maximum number of bytes handed to a callback at once.
+  explicit CograBinaryMeshStreamReader(const std::string& fileName, size_t chunkSize = 4 << 20);
+
+  //! \brief Streams the vertex positions.
+  void readPositions(const PositionCallback& callback);
+
+  //! \brief Streams the triangle indices.
+  void readTriangles(const TriangleCallback& callback);
+
+  //! \brief Streams the attribute with index attributeIdx.
+  void readAttribute(SizeType attributeIdx, const AttributeCallback& callback);
+
+  //! \brief Returns the number of vertices.
+  SizeType getNumVertices() const;
+
+  //! \brief Returns the number of triangles.
+  SizeType getNumTriangles() const;
+
+  //! \brief Number of attributes.
+  SizeType getNumAttributes() const;
+
+  //! \brief Returns the size of one component of an attribute.
+  SizeType getAttributeComponentSize(SizeType attributeIdx) const;
+
+  //! \brief Returns the number of components an attribute element has.
+  SizeType getAttributeComponents(SizeType attributeIdx) const;
+
+  //! \brief Returns the size in bytes of an attribute element.
+  SizeType getAttributeElementSize(SizeType attributeIdx) const;
+
+  //! \brief Returns the attribute name.
+  const char* getAttributeName(SizeType attributeIdx) const;
+
+  //! \brief Number of constants.
+  SizeType getNumConstants() const;
+
+  //! \brief Returns the size of one component of a constant.
+  SizeType getConstantComponentSize(SizeType constantIdx) const;
+
+  //! \brief Returns the number of components a constant has.
+  SizeType getConstantComponents(SizeType constantIdx) const;
+
+  //! \brief Returns a pointer to the constant.
+  const void* getConstant(SizeType constantIdx) const;
+
+  //! \brief Returns the constant name.
+  const char* getConstantName(SizeType constantIdx) const;
+
+  //! \brief Returns the maximum number of bytes handed to a callback at once.
+  size_t getChunkSize() const;
+
+private:
+  //! Describes an attribute or a constant.
+  struct Element
+  {
+    SizeType          components;    //! Number of components.
+    SizeType          componentSize; //! Size in bytes of a component.
+    std::vector<char> name;          //! Zero-terminated name.
+    ui64              offset;        //! Offset of the data in bytes from the beginning of the file.
+    ui32              encoding;      //! Encoding of the data, see impl::cbm::SectionEncoding.
+  };
+
+  //! \brief Reads the header of a V1 file and derives the section offsets.
+  void readHeaderV1();
+
+  //! \brief Reads the header and the section directory of a V2 file.
+  void readHeaderV2();
+
+  //! \brief Streams and decodes delta and varint encoded triangle indices.
+  void readDeltaVarintTriangles(const TriangleCallback& callback);
+
+  //! \brief Reads nElements elements of elementSize bytes starting at offset in chunks and hands them to callback.
+  void readSection(ui64 offset, ui64 nElements, size_t elementSize,
+                   const std::function<void(const void*, ui64, ui64)>& callback);
+
+  std::string          m_fileName;
+  std::ifstream        m_file;
+  size_t               m_chunkSize;
+  std::vector<ui8>     m_chunk;
+  SizeType             m_nVertices;
+  SizeType             m_nTriangles;
+  ui64                 m_positionsOffset   = 0;
+  ui64                 m_trianglesOffset   = 0;
+  ui64                 m_trianglesSize     = 0;
+  ui32                 m_positionsEncoding = 0;
+  ui32                 m_trianglesEncoding = 0;
+  std::vector<ui8>     m_decoded;
+  std::vector<Element> m_attributes;
+  std::vector<Element> m_constants;
+  //! Values of the constants. They are small and read when the file is opened.
+  std::vector<std::vector<ui8>> m_constantValues;
+};
+} // namespace gims
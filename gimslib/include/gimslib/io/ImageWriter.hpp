@@ -0,0 +1,27 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#pragma once
+#include <filesystem>
+#include <gimslib/types.hpp>
+namespace gims
+{
+//! \brief Writes an image with 8 bits per channel as PNG.
+//!
+//! The image data is stored without compression, which keeps the writer free of dependencies. Any PNG reader, e.g.,
+//! stb_image, loads the file.
+//! \param[in]  fileName Name of the file.
+//! \param[in]  pixels width * height * nChannels values, row by row from the top left pixel.
+//! \param[in]  width Number of pixels per row.
+//! \param[in]  height Number of rows.
+//! \param[in]  nChannels 1 (gray), 2 (gray and alpha), 3 (RGB), or 4 (RGBA).
+void writePNG(const std::filesystem::path& fileName, const ui8* pixels, ui32 width, ui32 height, ui32 nChannels);
+
+//! \brief Writes an image with 32-bit floats per channel as OpenEXR, in uncompressed scanlines.
+//! \param[in]  fileName Name of the file.
+//! \param[in]  pixels width * height * nChannels values, row by row from the top left pixel.
+//! \param[in]  width Number of pixels per row.
+//! \param[in]  height Number of rows.
+//! \param[in]  nChannels 1 (Y), 3 (RGB), or 4 (RGBA).
+void writeEXR(const std::filesystem::path& fileName, const f32* pixels, ui32 width, ui32 height, ui32 nChannels);
+} // namespace gims
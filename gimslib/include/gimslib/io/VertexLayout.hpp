@@ -0,0 +1,50 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#pragma once
+#include <cstddef>
+#include <gimslib/types.hpp>
+#include <vector>
+
+namespace gims
+{
+//! \brief One element of an interleaved vertex, e.g., the normal.
+struct VertexElement
+{
+  //! Value of stream that selects the vertex positions of a CograBinaryMeshFile.
+  static constexpr ui32 POSITIONS = ~0u;
+
+  ui32 stream; //! Attribute index or POSITIONS. Only used by CograBinaryMeshFile::getInterleavedVertices().
+  ui32 offset; //! Offset in bytes of the element from the start of the vertex.
+  ui32 size;   //! Size in bytes of the element. Equals the size of one element of the planar stream.
+};
+
+//! \brief Describes the memory layout of an interleaved vertex, e.g., of a vertex buffer.
+//!
+//! Elements must not overlap and must lie within the stride. Bytes of a vertex that are not covered by any element
+//! are padding. Their content after interleaving is unspecified.
+struct VertexLayout
+{
+  ui32                       stride = 0; //! Size in bytes of one vertex.
+  std::vector<VertexElement> elements;
+};
+
+//! \brief Interleaves planar streams into vertices.
+//!
+//! Vertex i of destination receives element i of every stream. Uses AVX2 or SSE2, if available.
+//! \param[in]  layout Layout of the vertices in destination.
+//! \param[in]  streams One planar stream per element of layout, in the order of the elements. Stream k is an array
+//!             of nVertices tightly packed values of layout.elements[k].size bytes.
+//! \param[in]  nVertices Number of vertices.
+//! \param[out] destination Receives nVertices * layout.stride bytes. Must not overlap with any of the streams. Can be
+//!             a mapped upload buffer.
+void interleaveVertices(const VertexLayout& layout, const void* const* streams, size_t nVertices, void* destination);
+
+//! \brief Splits interleaved vertices into planar streams. This is the inverse of interleaveVertices().
+//! \param[in]  layout Layout of the vertices in source.
+//! \param[in]  source nVertices * layout.stride bytes.
+//! \param[in]  nVertices Number of vertices.
+//! \param[out] streams One planar stream per element of layout, in the order of the elements. Stream k receives
+//!             nVertices * layout.elements[k].size bytes. Must not overlap with source or each other.
+void deinterleaveVertices(const VertexLayout& layout, const void* source, size_t nVertices, void* const* streams);
+} // namespace gims
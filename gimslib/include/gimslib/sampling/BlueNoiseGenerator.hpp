@@ -0,0 +1,63 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#pragma once
+#include <gimslib/sampling/BlueNoiseTile.hpp>
+#include <gimslib/types.hpp>
+#include <vector>
+namespace gims
+{
+class ThreadPool;
+
+//! \brief The kinds of textures of generateBlueNoise().
+enum class BlueNoiseType
+{
+  TEXTURE_2D,    //! Every slice is an independent 2D blue-noise texture.
+  TEXTURE_3D,    //! Blue noise in all three dimensions, e.g., for a volume or for a 2D sequence over time.
+  SPATIOTEMPORAL //! Every slice is 2D blue noise and every texel is 1D blue noise over the slices.
+};
+
+//! \brief Parameters of generateBlueNoise().
+struct BlueNoiseOptions
+{
+  BlueNoiseType type           = BlueNoiseType::TEXTURE_2D;
+  ui32          width          = 64;
+  ui32          height         = 64;
+  ui32          depth          = 1;    //! Number of slices.
+  ui32          nChannels      = 1;    //! Independent textures, interleaved per texel.
+  f32           sigma          = 1.9f; //! Standard deviation in texels of the Gaussian energy within a slice.
+  f32           depthSigma     = 1.9f; //! Standard deviation in slices of the energy across slices.
+  f32           initialDensity = 0.1f; //! Fraction of the texels in the initial binary pattern.
+  ui32          seed           = 0;    //! Seed of the initial binary patterns.
+};
+
+//! \brief Blue-noise values in [0, 1), see generateBlueNoise().
+struct BlueNoiseTexture
+{
+  ui32             width     = 0;
+  ui32             height    = 0;
+  ui32             depth     = 0;
+  ui32             nChannels = 0;
+  std::vector<f32> values; //! At [((z * height + y) * width + x) * nChannels + channel].
+
+  //! \brief Returns slice z as tile, e.g., to rotate the samples of one frame.
+  BlueNoiseTile getSlice(ui32 z) const;
+};
+
+//! \brief Generates tileable blue noise with the void-and-cluster method of Ulichney, 1993.
+//!
+//! The texels of a binary pattern are ranked by repeatedly removing the tightest cluster and filling the largest
+//! void, both measured by a Gaussian energy on the torus, and the ranks become the values. SPATIOTEMPORAL restricts
+//! the energy to texels of the same slice and to the same texel in other slices, as in Wolfe et al.,
+//! "Spatiotemporal Blue Noise Masks", EGSR 2022, so that every slice and every texel over time is blue noise. The
+//! values of a slice of TEXTURE_2D and SPATIOTEMPORAL are uniformly distributed, those of TEXTURE_3D over the volume.
+//!
+//! The energies are updated incrementally within a window of three standard deviations and the extremal texel is
+//! found in a tournament tree, so a rank costs O(window * log(texels)) instead of O(texels), which turns hours into
+//! seconds for 128 x 128 x 64 texels. Ranking is sequential per texture, so the thread pool processes the independent
+//! textures, i.e., channels and, for TEXTURE_2D, slices, as well as the removal and the insertion phase of each
+//! texture, which both start from the initial pattern, in parallel. The result does not depend on the thread pool.
+//! \param[in]  options Size, kind, and energy of the texture.
+//! \param[in]  threadPool If not nullptr, independent work runs in parallel.
+BlueNoiseTexture generateBlueNoise(const BlueNoiseOptions& options, ThreadPool* threadPool);
+} // namespace gims
@@ -0,0 +1,54 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#pragma once
+#include <filesystem>
+#include <gimslib/types.hpp>
+#include <vector>
+namespace gims
+{
+//! \brief A precomputed, tileable blue-noise texture with values in [0, 1).
+//!
+//! Neighboring texels of blue noise have values far apart, so the error of a per-pixel random number drawn from the
+//! tile has no low frequencies and is perceived as finer grain than white noise. A renderer rotates a low-discrepancy
+//! sequence per pixel by the tile value (Cranley-Patterson rotation), which keeps the stratification of the sequence
+//! and distributes its error as blue noise over the image. The tile repeats, so any image size is covered.
+class BlueNoiseTile
+{
+public:
+  //! \param[in]  width Number of texels per row.
+  //! \param[in]  height Number of rows.
+  //! \param[in]  nChannels Number of independent blue-noise values per texel.
+  //! \param[in]  values width * height * nChannels values in [0, 1), row by row from the top left texel.
+  BlueNoiseTile(ui32 width, ui32 height, ui32 nChannels, std::vector<f32> values);
+
+  //! \brief Loads a tile with 8 bits per channel from an image file, e.g., a PNG.
+  //!
+  //! Value v of a channel becomes (v + 0.5) / 256, the center of its interval.
+  explicit BlueNoiseTile(const std::filesystem::path& fileName);
+
+  //! \brief Returns a channel of the texel (x, y). The coordinates wrap around.
+  f32 get(i32 x, i32 y, ui32 channel = 0) const;
+
+  //! \brief Returns two values of the texel (x, y) for the rotation of a two-dimensional sequence.
+  //!
+  //! A tile with one channel yields its value at (x, y) and at (x, y) shifted by half the tile, whose values are
+  //! uncorrelated.
+  f32v2 get2D(i32 x, i32 y) const;
+
+  ui32 getWidth() const;
+  ui32 getHeight() const;
+  ui32 getNumChannels() const;
+
+  //! \brief Returns the tile with 8 bits per channel for upload to the GPU, e.g., as Texture2DD3D12.
+  //!
+  //! The first four channels are stored in RGBA. Missing color channels are zero and a missing alpha is 255.
+  std::vector<ui8v4> createRGBA8() const;
+
+private:
+  ui32             m_width;
+  ui32             m_height;
+  ui32             m_nChannels;
+  std::vector<f32> m_values;
+};
+} // namespace gims
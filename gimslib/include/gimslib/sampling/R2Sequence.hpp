@@ -0,0 +1,31 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#pragma once
+#include <gimslib/types.hpp>
+#include <vector>
+namespace gims
+{
+//! \brief The two-dimensional R2 sequence of Roberts, an additive recurrence with the plastic number.
+//!
+//! Point i is frac(offset + 0.5 + i * (1 / g, 1 / g^2)), where g is the plastic number. The sequence has a low
+//! discrepancy for any number of points, not only for powers of two, and a point costs two multiply-adds. Different
+//! offsets, e.g., from a blue-noise tile, decorrelate the sequences of neighboring pixels.
+class R2Sequence
+{
+public:
+  //! \brief Returns point i in [0, 1)^2.
+  //! \param[in]  index Index of the point.
+  //! \param[in]  offset Toroidal shift of the sequence.
+  static f32v2 get(ui32 index, const f32v2& offset = f32v2(0.0f));
+
+  //! \brief Returns the increment (1 / g, 1 / g^2) of the recurrence, the only constant a shader needs.
+  static f32v2 getIncrement();
+
+  //! \brief Returns the points 0 to nPoints - 1 for upload to the GPU, e.g., with UploadHelper::uploadDefaultBuffer().
+  //!
+  //! The table holds the coordinates of point i as 32 bit fixed-point numbers, i.e., times 2^32, at [2 * i] and
+  //! [2 * i + 1]. A shader reads a coordinate as asuint(value) * 2^-32.
+  static std::vector<ui32> createTable(ui32 nPoints);
+};
+} // namespace gims
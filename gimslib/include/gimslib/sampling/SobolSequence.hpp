@@ -0,0 +1,61 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#pragma once
+#include <gimslib/types.hpp>
+#include <vector>
+namespace gims
+{
+//! \brief The Sobol sequence, optionally with Owen scrambling.
+//!
+//! Every prefix of 2^k points is stratified in each dimension, and the first two dimensions form a (0,2)-sequence,
+//! i.e., every prefix of 2^k points has one point in each of the 2^k boxes of every elementary interval of area
+//! 2^-k. The direction numbers of the dimensions after the first are those of Joe and Kuo (new-joe-kuo-6.21201).
+//!
+//! Owen scrambling permutes the digits of each point and the order of the points with a nested uniform scramble,
+//! hashed as in Burley, "Practical Hash-based Owen Scrambling", JCGT 2020. Each seed yields an independent,
+//! randomized sequence that keeps the stratification of the prefixes. Hence, a renderer that needs more than
+//! MAX_DIMENSIONS dimensions pads with the first two dimensions and a different seed for every pair.
+class SobolSequence
+{
+public:
+  //! Number of dimensions with direction numbers.
+  static constexpr ui32 MAX_DIMENSIONS = 8;
+
+  //! \param[in]  isOwenScrambled If true, the points are scrambled with the seed of get().
+  explicit SobolSequence(bool isOwenScrambled = false);
+
+  //! \brief Returns a coordinate of a point as 32 bit fixed-point number, i.e., the coordinate times 2^32.
+  //! \param[in]  index Index of the point.
+  //! \param[in]  dimension Smaller than MAX_DIMENSIONS.
+  //! \param[in]  seed Selects the scrambling. Ignored without Owen scrambling.
+  ui32 getFixedPoint(ui32 index, ui32 dimension, ui32 seed = 0) const;
+
+  //! \brief Returns a coordinate of a point in [0, 1).
+  f32 get(ui32 index, ui32 dimension, ui32 seed = 0) const;
+
+  //! \brief Returns the coordinates dimension and dimension + 1 of a point in [0, 1)^2.
+  f32v2 get2D(ui32 index, ui32 dimension, ui32 seed = 0) const;
+
+  bool isOwenScrambled() const;
+
+  //! \brief Returns the direction numbers, 32 per dimension, at [dimension * 32 + bit].
+  //!
+  //! A shader computes a coordinate of point i as the exclusive or of the direction numbers of the set bits of i,
+  //! so the buffer of MAX_DIMENSIONS * 32 ui32 values replaces a sample table of any size.
+  const std::vector<ui32>& getDirectionNumbers() const;
+
+  //! \brief Returns the points 0 to nPoints - 1 for upload to the GPU, e.g., with UploadHelper::uploadDefaultBuffer().
+  //!
+  //! The table holds getFixedPoint() of point i and dimension d at [i * nDimensions + d]. A shader reads the
+  //! coordinate as asuint(value) * 2^-32.
+  //! \param[in]  nPoints Number of points.
+  //! \param[in]  nDimensions At most MAX_DIMENSIONS.
+  //! \param[in]  seed Selects the scrambling. Ignored without Owen scrambling.
+  std::vector<ui32> createTable(ui32 nPoints, ui32 nDimensions, ui32 seed = 0) const;
+
+private:
+  std::vector<ui32> m_directionNumbers;
+  bool              m_isOwenScrambled;
+};
+} // namespace gims
@@ -0,0 +1,75 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#pragma once
+#include <array>
+#include <filesystem>
+#include <gimslib/geometry/AABB.hpp>
+#include <gimslib/types.hpp>
+#include <string>
+#include <vector>
+namespace gims
+{
+//! \brief CPU-side scene graph with meshes, materials, and texture references.
+//!
+//! Holds everything a renderer needs to create its resources but no resource of a graphics API. The root node is
+//! nodes[0].
+struct SceneGraph
+{
+  //! Node of the scene graph.
+  struct Node
+  {
+    f32m4             transformation;           //! Transformation to parent node.
+    f32m4             worldSpaceTransformation; //! Transformation into world space.
+    std::vector<ui32> meshIndices;              //! Indices into SceneGraph::meshes.
+    std::vector<ui32> childIndices;             //! Indices into SceneGraph::nodes.
+  };
+
+  //! Triangle mesh with planar vertex attributes. All attribute arrays have the same number of elements.
+  struct Mesh
+  {
+    std::vector<f32v3>  positions;
+    std::vector<f32v3>  normals;            //! Zero, if the source has no normals.
+    std::vector<f32v3>  textureCoordinates; //! The third component is zero. Zero, if the source has none.
+    std::vector<f32v3>  tangents;           //! Zero, if the source has no tangents.
+    std::vector<ui32v3> triangles;          //! Indices into the attribute arrays of this mesh.
+    ui32                materialIndex = 0;  //! Index into SceneGraph::materials.
+    AABB                aabb;               //! Bounding box of the positions in object space.
+  };
+
+  //! Texture slots of a material.
+  enum TextureType : ui32
+  {
+    AMBIENT,
+    DIFFUSE,
+    SPECULAR,
+    EMISSIVE,
+    HEIGHT,
+    NUM_TEXTURE_TYPES
+  };
+
+  //! Marks a texture slot without texture.
+  static constexpr ui32 NO_TEXTURE = ~0u;
+
+  //! Material parameters.
+  struct Material
+  {
+    std::string name;
+    f32v3       ambientColor     = f32v3(0.0f);
+    f32v3       diffuseColor     = f32v3(0.0f);
+    f32v3       specularColor    = f32v3(0.0f);
+    f32v3       emissiveColor    = f32v3(0.0f);
+    f32         specularExponent = 0.0f;
+    f32         reflectivity     = 0.0f;
+    //! Index into SceneGraph::textureFileNames per texture type, or NO_TEXTURE.
+    std::array<ui32, NUM_TEXTURE_TYPES> textures = {NO_TEXTURE, NO_TEXTURE, NO_TEXTURE, NO_TEXTURE, NO_TEXTURE};
+  };
+
+  std::vector<Node>                  nodes;
+  std::vector<Mesh>                  meshes;
+  std::vector<Material>              materials;
+  std::vector<std::filesystem::path> textureFileNames; //! Every texture referenced by a material, each once.
+  std::filesystem::path              directory;        //! Texture file names are relative to this directory.
+  AABB                               aabb;             //! Bounding box of all mesh instances in world space.
+};
+} // namespace gims
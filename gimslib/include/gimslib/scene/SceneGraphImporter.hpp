@@ -0,0 +1,21 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#pragma once
+#include <filesystem>
+#include <gimslib/scene/SceneGraph.hpp>
+namespace gims
+{
+//! \brief Reads scene files with the Open Asset Import Library (Assimp).
+class SceneGraphImporter
+{
+public:
+  //! \brief Loads a scene.
+  //!
+  //! Triangulates the meshes, generates smooth normals, texture coordinates, and tangents where they are missing,
+  //! and converts the scene to a left-handed coordinate system.
+  //! \param[in]  pathToScene Scene file in any format Assimp supports.
+  //! \return The scene graph. Texture files are referenced, not loaded.
+  static SceneGraph load(const std::filesystem::path& pathToScene);
+};
+} // namespace gims
@@ -0,0 +1,35 @@
+#pragma once
+#include <gimslib/types.hpp>
+
+#if defined(_M_X64) || defined(__x86_64__)
+//! Defined on x86-64. SSE2 is part of the architecture there, all other extensions must be checked at run time.
+#define GIMS_X64
+#endif
+
+// Compiles a function for an extension that the translation unit is not compiled for. Call such a function only if
+// getCpuFeatures() reports the extension. MSVC accepts the intrinsics of all extensions without annotation.
+#if defined(__GNUC__) || defined(__clang__)
+#define GIMS_TARGET_AVX     __attribute__((target("avx")))
+#define GIMS_TARGET_AVX2    __attribute__((target("avx2")))
+#define GIMS_TARGET_AVX512F __attribute__((target("avx512f")))
+#else
+#define GIMS_TARGET_AVX
+#define GIMS_TARGET_AVX2
+#define GIMS_TARGET_AVX512F
+#endif
+
+namespace gims
+{
+//! \brief Instruction set extensions that are supported by the CPU and enabled by the operating system.
+struct CpuFeatures
+{
+  bool sse41   = false;
+  bool avx     = false;
+  bool avx2    = false;
+  bool fma     = false;
+  bool avx512f = false;
+};
+
+//! \brief Detects the features of the CPU once and returns them on every call.
+const CpuFeatures& getCpuFeatures();
+} // namespace gims
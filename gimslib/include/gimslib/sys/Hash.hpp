@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+#include <gimslib/types.hpp>
+
+namespace gims
+{
+//! \brief Computes a 64 bit non-cryptographic hash of a block of memory.
+//!
+//! The hash is XXH64, which processes 32 bytes per iteration and runs at memory bandwidth on large buffers. Use it
+//! for integrity checks and cache keys, not for security.
+//! \param[in]  data First byte of the memory block.
+//! \param[in]  size Size of the memory block in bytes.
+//! \param[in]  seed Seed. Different seeds yield independent hashes.
+ui64 hash64(const void* data, size_t size, ui64 seed = 0);
+
+//! \brief Hashes a 32 bit integer, e.g., to derive the seed of a sampler from a pixel or a dimension.
+//!
+//! The mixing function is lowbias32 by Chris Wellons, a bijection with a low avalanche bias.
+//! \param[in]  value The integer.
+//! \param[in]  seed Seed. Different seeds yield independent hashes.
+ui32 hash32(ui32 value, ui32 seed = 0);
+} // namespace gims
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <gimslib/types.hpp>
+#include <string>
+
+namespace gims
+{
+//! \brief Maps a file into the address space of the process.
+//!
+//! The mapping is copy-on-write: the pages may be modified through data(), but modifications are private to the
+//! process and never written back to the file. Pages are faulted in lazily, so mapping a file costs nothing until its
+//! content is touched.
+class MappedFile
+{
+public:
+  //! \brief Maps the entire file.
+  //! \param[in]  fileName Path to the file that should be mapped.
+  explicit MappedFile(const std::string& fileName);
+
+  ~MappedFile();
+
+  MappedFile(const MappedFile& other)            = delete;
+  MappedFile& operator=(const MappedFile& other) = delete;
+
+  //! \brief Returns the first byte of the mapping.
+  ui8* data() const;
+
+  //! \brief Returns the size of the mapping in bytes.
+  size_t size() const;
+
+private:
+  ui8*   m_data = nullptr;
+  size_t m_size = 0;
+#ifdef _WIN32
+  void* m_fileHandle    = nullptr;
+  void* m_mappingHandle = nullptr;
+#else
+  int m_fileDescriptor = -1;
+#endif
+};
+} // namespace gims
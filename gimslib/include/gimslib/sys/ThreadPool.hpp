@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <gimslib/types.hpp>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace gims
+{
+//! \brief A fixed set of worker threads that execute tasks.
+//!
+//! Every worker owns a task queue. A task enqueued from within a worker goes to the queue of that worker and is
+//! processed last-in first-out, which keeps related work on the same core. Idle workers steal from the front of the
+//! other queues. The destructor processes all pending tasks before it joins the workers.
+class ThreadPool
+{
+public:
+  //! A unit of work.
+  typedef std::move_only_function<void()> Task;
+
+  //! \brief Starts the workers.
+  //! \param[in]  nThreads Number of workers. 0 uses one worker per hardware thread.
+  explicit ThreadPool(ui32 nThreads = 0);
+
+  //! \brief Processes the pending tasks and joins the workers.
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool& other)            = delete;
+  ThreadPool& operator=(const ThreadPool& other) = delete;
+
+  //! \brief Enqueues a task. Exceptions thrown by the task terminate the program, use submit() to observe them.
+  void enqueue(Task task);
+
+  //! \brief Enqueues a function and returns a future for its result or its exception.
+  template<class F> std::future<std::invoke_result_t<std::decay_t<F>>> submit(F&& function)
+  {
+    std::packaged_task<std::invoke_result_t<std::decay_t<F>>()> task(std::forward<F>(function));
+    auto                                                       result = task.get_future();
+    enqueue([task = std::move(task)]() mutable { task(); });
+    return result;
+  }
+
+  //! \brief Calls body(begin, end) for consecutive ranges of [0, count) on the workers and the calling thread.
+  //!
+  //! Returns after all ranges are processed. The calling thread processes ranges as well, so parallelFor() may be
+  //! called from within a task without risking a deadlock. The first exception thrown by body is rethrown.
+  //! \param[in]  count Number of items.
+  //! \param[in]  grainSize Maximum number of items per range.
+  //! \param[in]  body Processes the items [begin, end). Must be thread-safe.
+  void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& body);
+
+  //! \brief Returns the number of workers.
+  ui32 getNumThreads() const;
+
+private:
+  //! Tasks of one worker. Guarded by its own mutex, so workers rarely contend.
+  struct Queue
+  {
+    std::mutex       mutex;
+    std::deque<Task> tasks;
+  };
+
+  //! \brief Pops the newest task of the queue of worker workerIdx, or steals the oldest task of another queue.
+  bool tryAcquire(ui32 workerIdx, Task& task);
+
+  void workerMain(ui32 workerIdx);
+
+  std::vector<std::unique_ptr<Queue>> m_queues;
+  std::vector<std::thread>            m_threads;
+  std::atomic<ui32>                   m_nextQueue = 0;
+  std::mutex                          m_sleepMutex;
+  std::condition_variable             m_wakeUp;
+  ui64                                m_nPending = 0; //! Enqueued tasks not yet acquired. Guarded by m_sleepMutex.
+  bool                                m_stop     = false;
+};
+} // namespace gims
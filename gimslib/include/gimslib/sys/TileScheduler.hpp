@@ -0,0 +1,69 @@
+#pragma once
+#include <functional>
+#include <gimslib/types.hpp>
+#include <vector>
+
+namespace gims
+{
+class ThreadPool;
+
+//! \brief A rectangle of pixels of an image.
+struct Tile
+{
+  ui32 x;      //! Column of the top left pixel.
+  ui32 y;      //! Row of the top left pixel.
+  ui32 width;  //! Smaller than the tile size at the right border of the image.
+  ui32 height; //! Smaller than the tile size at the bottom border of the image.
+  ui32 index;  //! Position of the tile in row-major order.
+};
+
+//! \brief Timing and load balance of one TileScheduler::run().
+struct TileSchedulerStatistics
+{
+  ui32              nWorkers = 0;
+  ui32              nTiles   = 0;
+  ui64              nSteals  = 0;   //! Successful steals, each takes half of the tiles a worker has left.
+  f64               seconds  = 0.0; //! Wall-clock time of the run.
+  std::vector<ui32> tilesPerWorker; //! Tiles rendered by each worker.
+
+  //! \brief Returns the tiles per second divided by the number of workers, the scaling metric of a renderer.
+  f64 getTilesPerSecondPerCore() const;
+};
+
+//! \brief Splits an image into square tiles and renders them on a thread pool with work stealing.
+//!
+//! Every worker starts with a contiguous range of tiles, and it renders its range from the front, so that consecutive
+//! tiles of a worker are neighbors in the image. A worker without tiles steals the back half of the largest remaining
+//! range. Ranges are single atomic words, so neither the owner nor a thief ever waits for a lock.
+class TileScheduler
+{
+public:
+  //! \param[in]  width Width of the image in pixels.
+  //! \param[in]  height Height of the image in pixels.
+  //! \param[in]  tileSize Width and height of the tiles in pixels.
+  TileScheduler(ui32 width, ui32 height, ui32 tileSize = 16);
+
+  //! \brief Renders all tiles and returns after the last one is done.
+  //!
+  //! The first exception thrown by renderTile is rethrown.
+  //! \param[in]  renderTile Called once per tile with the tile and the index of the worker, which is less than the
+  //!             number of workers. Calls with the same worker index never overlap, so it may index per-worker data.
+  //! \param[in]  threadPool If not nullptr, its workers and the calling thread render the tiles. Otherwise, the calling
+  //!             thread renders them as worker 0.
+  TileSchedulerStatistics run(const std::function<void(const Tile& tile, ui32 workerIdx)>& renderTile,
+                              ThreadPool* threadPool = nullptr) const;
+
+  //! \brief Returns the number of workers that run() uses with a thread pool, or without one if it is nullptr.
+  static ui32 getNumWorkers(const ThreadPool* threadPool);
+
+  ui32 getNumTiles() const;
+  Tile getTile(ui32 tileIdx) const;
+
+private:
+  ui32 m_width;
+  ui32 m_height;
+  ui32 m_tileSize;
+  ui32 m_nTilesX;
+  ui32 m_nTilesY;
+};
+} // namespace gims
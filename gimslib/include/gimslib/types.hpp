@@ -83,9 +83,10 @@ typedef glm::bvec2 bv2;
 typedef glm::bvec3 bv3;
 typedef glm::bvec4 bv4;
 
-typedef glm::mat2 f32m2;
-typedef glm::mat3 f32m3;
-typedef glm::mat4 f32m4;
+typedef glm::mat2   f32m2;
+typedef glm::mat3   f32m3;
+typedef glm::mat4   f32m4;
+typedef glm::mat4x3 f32m4x3;
 
 typedef glm::dmat2 f64m2;
 typedef glm::dmat3 f64m3;
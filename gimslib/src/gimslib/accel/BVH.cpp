@@ -0,0 +1,770 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <gimslib/accel/BVH.hpp>
+#include <gimslib/sys/Hash.hpp>
+#include <gimslib/sys/MappedFile.hpp>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <limits>
+#include <stdexcept>
+#include "impl/BuildPrimitive.hpp"
+#include "impl/LBVHBuilder.hpp"
+#include "impl/Traversal.hpp"
+
+namespace
+{
+using namespace gims;
+
+//! Primitive ranges above this size are binned and bounded in chunks of this size on the thread pool.
+constexpr ui32 parallelChunkSize = 1 << 16;
+
+//! Nodes with at most this many primitives become the roots of subtrees that are built concurrently. The value does not
+//! depend on the thread pool, so the node order is the same with and without it.
+constexpr ui32 subtreeSize = 1 << 14;
+
+using impl::Bounds;
+using impl::getHalfArea;
+using impl::Primitive;
+
+struct Bin
+{
+  Bounds bounds;
+  ui32   count = 0;
+};
+
+struct Task
+{
+  ui32 nodeIdx;
+  ui32 begin;
+  ui32 end;
+  ui32 depth;
+};
+
+//! Accumulates [begin, end) into result, which must hold the identity. Large ranges are split into chunks that are
+//! accumulated on the thread pool and merged in order.
+template<class T, class Accumulate, class Merge>
+void reduce(ThreadPool* threadPool, ui32 begin, ui32 end, T& result, const Accumulate& accumulate, const Merge& merge)
+{
+  const ui32 n = end - begin;
+  if (threadPool == nullptr || n < 2 * parallelChunkSize)
+  {
+    accumulate(result, begin, end);
+    return;
+  }
+  const size_t   nChunks = (n + parallelChunkSize - 1) / parallelChunkSize;
+  std::vector<T> partials(nChunks, result);
+  threadPool->parallelFor(nChunks, 1,
+                          [&](size_t chunkBegin, size_t chunkEnd)
+                          {
+                            for (size_t cIdx = chunkBegin; cIdx < chunkEnd; cIdx++)
+                            {
+                              const ui32 b = begin + static_cast<ui32>(cIdx) * parallelChunkSize;
+                              accumulate(partials[cIdx], b, std::min(end, b + parallelChunkSize));
+                            }
+                          });
+  for (const auto& partial : partials)
+  {
+    merge(result, partial);
+  }
+}
+
+//! Top-down binned SAH build over a range of primitives.
+class Builder
+{
+public:
+  Builder(const BVHBuildOptions& options, std::vector<Primitive>& primitives)
+      : m_options(options)
+      , m_primitives(primitives)
+  {
+  }
+
+  //! Builds the subtree of root into nodes, whose element root.nodeIdx must exist. If deferred is not nullptr, nodes
+  //! with at most subtreeSize primitives are not processed but appended to deferred.
+  //! \return The maximum depth of the nodes that were created.
+  ui32 build(std::vector<BVH::Node>& nodes, const Task& root, std::vector<Task>* deferred,
+             ThreadPool* threadPool) const
+  {
+    ui32              maxDepth = root.depth;
+    std::vector<Task> stack    = {root};
+    Scratch           scratch;
+    scratch.bins.resize(3 * m_options.nBins);
+    scratch.rightCosts.resize(m_options.nBins);
+    while (!stack.empty())
+    {
+      const Task task = stack.back();
+      stack.pop_back();
+      maxDepth = std::max(maxDepth, task.depth);
+
+      const ui32 mid = split(nodes[task.nodeIdx], task.begin, task.end, scratch, threadPool);
+      if (mid == task.begin)
+      {
+        continue;
+      }
+
+      const auto leftIdx            = static_cast<ui32>(nodes.size());
+      nodes[task.nodeIdx].leftFirst = leftIdx;
+      nodes.resize(nodes.size() + 2);
+      const Task left  = {leftIdx, task.begin, mid, task.depth + 1};
+      const Task right = {leftIdx + 1, mid, task.end, task.depth + 1};
+      for (const auto& child : {right, left})
+      {
+        if (deferred != nullptr && child.end - child.begin <= subtreeSize)
+        {
+          deferred->push_back(child);
+        }
+        else
+        {
+          stack.push_back(child);
+        }
+      }
+    }
+    return maxDepth;
+  }
+
+private:
+  //! Storage that split() reuses for every node.
+  struct Scratch
+  {
+    std::vector<Bin> bins;
+    std::vector<f32> rightCosts;
+  };
+
+  struct Split
+  {
+    f32  cost = std::numeric_limits<f32>::max();
+    ui32 axis = 0;
+    ui32 bin  = 0;
+  };
+
+  //! Bounds node by the primitives [begin, end) and decides whether to split them. Turns the node into a leaf, or
+  //! partitions the primitives.
+  //! \return The first primitive of the right child, or begin for a leaf.
+  ui32 split(BVH::Node& node, ui32 begin, ui32 end, Scratch& scratch, ThreadPool* threadPool) const
+  {
+    using BoundsPair = std::pair<Bounds, Bounds>;
+    BoundsPair boxes;
+    reduce(
+        threadPool, begin, end, boxes,
+        [&](BoundsPair& result, ui32 b, ui32 e)
+        {
+          for (ui32 i = b; i < e; i++)
+          {
+            result.first.grow(m_primitives[i].bounds);
+            result.second.grow(m_primitives[i].bounds.getCentroid());
+          }
+        },
+        [](BoundsPair& result, const BoundsPair& other)
+        {
+          result.first.grow(other.first);
+          result.second.grow(other.second);
+        });
+    const auto& [bounds, cBox] = boxes;
+
+    node.lowerLeftBottom = bounds.lo;
+    node.upperRightTop   = bounds.hi;
+    node.leftFirst       = begin;
+    node.nPrimitives     = end - begin;
+
+    const ui32 n = end - begin;
+    if (n == 1)
+    {
+      return begin;
+    }
+
+    // Bins on all axes with a non-zero centroid extent. The scale is zero for the other axes. Small nodes use fewer
+    // bins, as the sweep over the bins would dominate their cost.
+    const ui32  nBins  = std::min(m_options.nBins, n);
+    const f32v3 extent = cBox.hi - cBox.lo;
+    f32v3       scale(0.0f);
+    for (ui32 axis = 0; axis < 3; axis++)
+    {
+      if (extent[axis] > 0.0f)
+      {
+        scale[axis] = static_cast<f32>(nBins) / extent[axis];
+      }
+    }
+    const auto getBinIdx = [&](const f32v3& centroid, ui32 axis)
+    {
+      const f32 t = (centroid[axis] - cBox.lo[axis]) * scale[axis];
+      return t > 0.0f ? static_cast<ui32>(std::min(t, static_cast<f32>(nBins - 1))) : 0u;
+    };
+
+    Split best;
+    if (scale != f32v3(0.0f))
+    {
+      std::fill(scratch.bins.begin(), scratch.bins.begin() + 3 * nBins, Bin());
+      reduce(
+          threadPool, begin, end, scratch.bins,
+          [&](std::vector<Bin>& result, ui32 b, ui32 e)
+          {
+            for (ui32 i = b; i < e; i++)
+            {
+              const Bounds& primitiveBounds = m_primitives[i].bounds;
+              const f32v3   centroid        = primitiveBounds.getCentroid();
+              for (ui32 axis = 0; axis < 3; axis++)
+              {
+                if (scale[axis] > 0.0f)
+                {
+                  Bin& bin = result[axis * nBins + getBinIdx(centroid, axis)];
+                  bin.bounds.grow(primitiveBounds);
+                  bin.count++;
+                }
+              }
+            }
+          },
+          [](std::vector<Bin>& result, const std::vector<Bin>& other)
+          {
+            for (size_t bIdx = 0; bIdx < result.size(); bIdx++)
+            {
+              result[bIdx].bounds.grow(other[bIdx].bounds);
+              result[bIdx].count += other[bIdx].count;
+            }
+          });
+      best = findBestSplit(scratch, nBins, scale);
+    }
+
+    // Compare the costs scaled by the area of the node, which may be zero.
+    const f32 area      = getHalfArea(bounds.lo, bounds.hi);
+    const f32 leafCost  = m_options.intersectionCost * static_cast<f32>(n) * area;
+    const f32 splitCost = m_options.traversalCost * area + m_options.intersectionCost * best.cost;
+    if (n <= m_options.maxLeafSize && !(splitCost < leafCost))
+    {
+      return begin;
+    }
+
+    if (best.cost == std::numeric_limits<f32>::max())
+    {
+      // All centroids coincide, any split is as good as another.
+      node.nPrimitives = 0;
+      return begin + n / 2;
+    }
+    const auto midIt =
+        std::partition(m_primitives.begin() + begin, m_primitives.begin() + end, [&](const Primitive& primitive)
+                       { return getBinIdx(primitive.bounds.getCentroid(), best.axis) <= best.bin; });
+    node.nPrimitives = 0;
+    return static_cast<ui32>(midIt - m_primitives.begin());
+  }
+
+  //! Sweeps the bins of each axis from both sides and returns the split with the smallest sum of area times count.
+  Split findBestSplit(Scratch& scratch, ui32 nBins, const f32v3& scale) const
+  {
+    auto& rightCosts = scratch.rightCosts;
+    Split best;
+    for (ui32 axis = 0; axis < 3; axis++)
+    {
+      if (scale[axis] == 0.0f)
+      {
+        continue;
+      }
+      const Bin* axisBins = &scratch.bins[axis * nBins];
+
+      Bounds rightBounds;
+      ui32   rightCount = 0;
+      for (ui32 bIdx = nBins - 1; bIdx > 0; bIdx--)
+      {
+        rightBounds.grow(axisBins[bIdx].bounds);
+        rightCount += axisBins[bIdx].count;
+        rightCosts[bIdx] = rightCount > 0 ? getHalfArea(rightBounds.lo, rightBounds.hi) * static_cast<f32>(rightCount)
+                                          : std::numeric_limits<f32>::max();
+      }
+
+      Bounds leftBounds;
+      ui32   leftCount = 0;
+      for (ui32 bIdx = 0; bIdx + 1 < nBins; bIdx++)
+      {
+        leftBounds.grow(axisBins[bIdx].bounds);
+        leftCount += axisBins[bIdx].count;
+        if (leftCount == 0 || rightCosts[bIdx + 1] == std::numeric_limits<f32>::max())
+        {
+          continue;
+        }
+        const f32 cost = getHalfArea(leftBounds.lo, leftBounds.hi) * static_cast<f32>(leftCount) + rightCosts[bIdx + 1];
+        if (cost < best.cost)
+        {
+          best = {cost, axis, bIdx};
+        }
+      }
+    }
+    return best;
+  }
+
+  const BVHBuildOptions&  m_options;
+  std::vector<Primitive>& m_primitives;
+};
+
+void checkOptions(const BVHBuildOptions& options)
+{
+  if (options.nBins < 2 || options.maxLeafSize < 1)
+  {
+    throw std::runtime_error("A BVH needs at least two bins and one primitive per leaf.");
+  }
+  if (options.mortonCodeBits != 30 && options.mortonCodeBits != 63)
+  {
+    throw std::runtime_error("Morton codes have 30 or 63 bits.");
+  }
+}
+
+//! Builds the nodes over the primitives and reorders them. Splits the upper levels, whose ranges are binned in
+//! parallel, then builds the small subtrees concurrently and appends them in the order they were deferred.
+//! \return The depth of the BVH.
+ui32 buildNodes(std::vector<Primitive>& primitives, const BVHBuildOptions& options, ThreadPool* threadPool,
+                std::vector<BVH::Node>& nodes)
+{
+  const auto nPrimitives = static_cast<ui32>(primitives.size());
+  if (nPrimitives == 0)
+  {
+    return 0;
+  }
+  const Builder     builder(options, primitives);
+  std::vector<Task> subtrees;
+  ui32              maxDepth = 0;
+  nodes.reserve(2 * size_t(nPrimitives) - 1);
+  nodes.resize(1);
+  const Task root = {0, 0, nPrimitives, 0};
+  if (nPrimitives <= subtreeSize)
+  {
+    subtrees.push_back(root);
+  }
+  else
+  {
+    maxDepth = builder.build(nodes, root, &subtrees, threadPool);
+  }
+
+  std::vector<std::vector<BVH::Node>> subtreeNodes(subtrees.size());
+  std::vector<ui32>                   subtreeDepths(subtrees.size());
+  const auto                          buildSubtrees = [&](size_t begin, size_t end)
+  {
+    for (size_t sIdx = begin; sIdx < end; sIdx++)
+    {
+      const Task& subtree = subtrees[sIdx];
+      subtreeNodes[sIdx].resize(1);
+      subtreeDepths[sIdx] =
+          builder.build(subtreeNodes[sIdx], {0, subtree.begin, subtree.end, subtree.depth}, nullptr, nullptr);
+    }
+  };
+  if (threadPool != nullptr)
+  {
+    threadPool->parallelFor(subtrees.size(), 1, buildSubtrees);
+  }
+  else
+  {
+    buildSubtrees(0, subtrees.size());
+  }
+
+  for (size_t sIdx = 0; sIdx < subtrees.size(); sIdx++)
+  {
+    // Local node 0 replaces the placeholder, local node k > 0 is appended at offset + k.
+    const auto offset  = static_cast<ui32>(nodes.size()) - 1;
+    auto&      subtree = subtreeNodes[sIdx];
+    for (auto& node : subtree)
+    {
+      if (!node.isLeaf())
+      {
+        node.leftFirst += offset;
+      }
+    }
+    nodes[subtrees[sIdx].nodeIdx] = subtree[0];
+    nodes.insert(nodes.end(), subtree.begin() + 1, subtree.end());
+    maxDepth = std::max(maxDepth, subtreeDepths[sIdx]);
+  }
+  return maxDepth;
+}
+
+//! Fills the primitive bounds, in parallel if there is a thread pool. getBounds(primitiveIdx) returns a Bounds.
+template<class GetBounds>
+std::vector<Primitive> createPrimitives(ui32 nPrimitives, ThreadPool* threadPool, const GetBounds& getBounds)
+{
+  std::vector<Primitive> primitives(nPrimitives);
+  const auto             createRange = [&](size_t begin, size_t end)
+  {
+    for (auto pIdx = static_cast<ui32>(begin); pIdx < end; pIdx++)
+    {
+      primitives[pIdx] = {getBounds(pIdx), pIdx};
+    }
+  };
+  if (threadPool != nullptr)
+  {
+    threadPool->parallelFor(nPrimitives, parallelChunkSize, createRange);
+  }
+  else
+  {
+    createRange(0, nPrimitives);
+  }
+  return primitives;
+}
+
+std::vector<ui32> extractPrimitiveIndices(const std::vector<Primitive>& primitives)
+{
+  std::vector<ui32> result(primitives.size());
+  for (size_t i = 0; i < primitives.size(); i++)
+  {
+    result[i] = primitives[i].primitiveIdx;
+  }
+  return result;
+}
+
+Bounds getTriangleBounds(const TriangleMeshView& mesh, ui32 triangleIdx)
+{
+  Bounds result;
+  for (ui32 cornerIdx = 0; cornerIdx < 3; cornerIdx++)
+  {
+    result.grow(mesh.getPosition(triangleIdx, cornerIdx));
+  }
+  return result;
+}
+
+Bounds getBounds(const AABB& aabb)
+{
+  Bounds result;
+  result.lo = aabb.getLowerLeftBottom();
+  result.hi = aabb.getUpperRightTop();
+  return result;
+}
+
+Bounds getBounds(const BVH::Node& node)
+{
+  Bounds result;
+  result.lo = node.lowerLeftBottom;
+  result.hi = node.upperRightTop;
+  return result;
+}
+
+//! The area of a node weighted with its traversal or intersection cost, a summand of the SAH cost.
+f64 getWeightedArea(const BVH::Node& node, const BVHBuildOptions& options)
+{
+  const f64 area = getHalfArea(node.lowerLeftBottom, node.upperRightTop);
+  return node.isLeaf() ? options.intersectionCost * static_cast<f64>(node.nPrimitives) * area
+                       : options.traversalCost * area;
+}
+
+f64 getWeightedAreaSum(const std::vector<BVH::Node>& nodes, const BVHBuildOptions& options)
+{
+  f64 result = 0.0;
+  for (const auto& node : nodes)
+  {
+    result += getWeightedArea(node, options);
+  }
+  return result;
+}
+
+//! Divides the weighted area sum by the area of the root. A flat root is treated like a single leaf.
+f64 getSAHCost(f64 weightedAreaSum, const std::vector<BVH::Node>& nodes, size_t nPrimitives,
+               const BVHBuildOptions& options)
+{
+  if (nodes.empty())
+  {
+    return 0.0;
+  }
+  const f64 rootArea = getHalfArea(nodes[0].lowerLeftBottom, nodes[0].upperRightTop);
+  return rootArea > 0.0 ? weightedAreaSum / rootArea : options.intersectionCost * static_cast<f64>(nPrimitives);
+}
+
+//! Recomputes the boxes of all nodes. Children are stored behind their parents, so a reverse sweep visits them first.
+//! getPrimitiveBounds(primitiveIdx) returns a Bounds.
+template<class GetPrimitiveBounds>
+void refitNodes(std::vector<BVH::Node>& nodes, const std::vector<ui32>& primitiveIndices,
+                const GetPrimitiveBounds& getPrimitiveBounds)
+{
+  for (size_t nodeIdx = nodes.size(); nodeIdx-- > 0;)
+  {
+    BVH::Node& node = nodes[nodeIdx];
+    Bounds     bounds;
+    if (node.isLeaf())
+    {
+      for (ui32 pIdx = node.leftFirst; pIdx < node.leftFirst + node.nPrimitives; pIdx++)
+      {
+        bounds.grow(getPrimitiveBounds(primitiveIndices[pIdx]));
+      }
+    }
+    else
+    {
+      bounds.grow(getBounds(nodes[node.leftFirst]));
+      bounds.grow(getBounds(nodes[node.leftFirst + 1]));
+    }
+    node.lowerLeftBottom = bounds.lo;
+    node.upperRightTop   = bounds.hi;
+  }
+}
+
+BVHStatistics computeStatistics(const std::vector<BVH::Node>& nodes, std::chrono::steady_clock::time_point start,
+                                ui32 maxDepth)
+{
+  BVHStatistics result;
+  const auto    end            = std::chrono::steady_clock::now();
+  result.buildTimeMilliseconds = std::chrono::duration<f64, std::milli>(end - start).count();
+  result.nNodes                = static_cast<ui32>(nodes.size());
+  result.nLeaves               = static_cast<ui32>(
+      std::count_if(nodes.begin(), nodes.end(), [](const BVH::Node& node) { return node.isLeaf(); }));
+  result.maxDepth = maxDepth;
+  return result;
+}
+
+//! First bytes of the files written by BVH::save().
+constexpr char fileMagic[8] = {'C', 'o', 'g', 'r', 'a', 'B', 'V', 'H'};
+constexpr ui32 fileVersion  = 1;
+
+//! Layout of the files written by BVH::save(). The nodes follow the header, the primitive indices follow the nodes.
+struct FileHeader
+{
+  char            magic[8]; //! fileMagic.
+  ui32            version;  //! fileVersion.
+  ui32            nNodes;
+  ui32            nPrimitives;
+  ui32            nLeaves;
+  ui32            maxDepth;
+  ui32            reserved0;
+  ui64            key;  //! The key passed to BVH::save().
+  ui64            hash; //! hash64() of the nodes, seeding the hash64() of the primitive indices.
+  f64             buildTimeMilliseconds;
+  f64             sahCost;
+  f64             sahCostAfterBuild;
+  BVHBuildOptions options;
+  ui8             reserved1[28];
+};
+static_assert(sizeof(FileHeader) == 128, "BVH file headers must be 128 bytes.");
+
+ui64 getPayloadHash(const void* nodes, size_t nodesSize, const void* primitiveIndices, size_t primitiveIndicesSize)
+{
+  return hash64(primitiveIndices, primitiveIndicesSize, hash64(nodes, nodesSize));
+}
+} // namespace
+
+namespace gims
+{
+BVH::BVH(const TriangleMeshView& mesh, const BVHBuildOptions& options, ThreadPool* threadPool)
+    : m_options(options)
+{
+  checkOptions(options);
+  const auto start = std::chrono::steady_clock::now();
+  auto       primitives =
+      createPrimitives(mesh.nTriangles, threadPool, [&](ui32 tIdx) { return getTriangleBounds(mesh, tIdx); });
+  const ui32 maxDepth            = options.algorithm == BVHBuildAlgorithm::LBVH
+                                       ? impl::buildLBVH(primitives, options, threadPool, m_nodes)
+                                       : buildNodes(primitives, options, threadPool, m_nodes);
+  m_primitiveIndices             = extractPrimitiveIndices(primitives);
+  m_weightedAreaSum              = getWeightedAreaSum(m_nodes, m_options);
+  m_statistics                   = computeStatistics(m_nodes, start, maxDepth);
+  updateSAHCost();
+  m_statistics.sahCostAfterBuild = m_statistics.sahCost;
+}
+
+BVH::BVH(const AABB* aabbs, ui32 nAABBs, const BVHBuildOptions& options, ThreadPool* threadPool)
+    : m_options(options)
+{
+  checkOptions(options);
+  const auto start      = std::chrono::steady_clock::now();
+  auto       primitives = createPrimitives(nAABBs, threadPool, [&](ui32 aIdx) { return getBounds(aabbs[aIdx]); });
+  const ui32 maxDepth   = options.algorithm == BVHBuildAlgorithm::LBVH
+                              ? impl::buildLBVH(primitives, options, threadPool, m_nodes)
+                              : buildNodes(primitives, options, threadPool, m_nodes);
+  m_primitiveIndices    = extractPrimitiveIndices(primitives);
+  m_weightedAreaSum     = getWeightedAreaSum(m_nodes, m_options);
+  m_statistics          = computeStatistics(m_nodes, start, maxDepth);
+  updateSAHCost();
+  m_statistics.sahCostAfterBuild = m_statistics.sahCost;
+}
+
+const std::vector<BVH::Node>& BVH::getNodes() const
+{
+  return m_nodes;
+}
+
+const std::vector<ui32>& BVH::getPrimitiveIndices() const
+{
+  return m_primitiveIndices;
+}
+
+AABB BVH::getAABB() const
+{
+  if (m_nodes.empty())
+  {
+    return AABB();
+  }
+  return AABB(m_nodes[0].lowerLeftBottom, m_nodes[0].upperRightTop);
+}
+
+const BVHStatistics& BVH::getStatistics() const
+{
+  return m_statistics;
+}
+
+const BVHBuildOptions& BVH::getOptions() const
+{
+  return m_options;
+}
+
+size_t BVH::getMemorySize() const
+{
+  return m_nodes.size() * sizeof(Node) + m_primitiveIndices.size() * sizeof(ui32);
+}
+
+f64 BVH::computeSAHCost() const
+{
+  return getSAHCost(getWeightedAreaSum(m_nodes, m_options), m_nodes, m_primitiveIndices.size(), m_options);
+}
+
+void BVH::save(const std::string& fileName, ui64 key) const
+{
+  const size_t nodesSize            = m_nodes.size() * sizeof(Node);
+  const size_t primitiveIndicesSize = m_primitiveIndices.size() * sizeof(ui32);
+
+  FileHeader header = {};
+  std::memcpy(header.magic, fileMagic, sizeof(fileMagic));
+  header.version               = fileVersion;
+  header.nNodes                = static_cast<ui32>(m_nodes.size());
+  header.nPrimitives           = static_cast<ui32>(m_primitiveIndices.size());
+  header.nLeaves               = m_statistics.nLeaves;
+  header.maxDepth              = m_statistics.maxDepth;
+  header.key                   = key;
+  header.options               = m_options;
+  header.buildTimeMilliseconds = m_statistics.buildTimeMilliseconds;
+  header.sahCost               = m_statistics.sahCost;
+  header.sahCostAfterBuild     = m_statistics.sahCostAfterBuild;
+  header.hash = getPayloadHash(m_nodes.data(), nodesSize, m_primitiveIndices.data(), primitiveIndicesSize);
+
+  std::ofstream outFile(fileName, std::ios::out | std::ios::binary);
+  outFile.write((const char*)&header, sizeof(header));
+  outFile.write((const char*)m_nodes.data(), nodesSize);
+  outFile.write((const char*)m_primitiveIndices.data(), primitiveIndicesSize);
+  outFile.close();
+  if (!outFile)
+  {
+    throw std::runtime_error("Error writing file " + fileName + ".");
+  }
+}
+
+BVH BVH::load(const std::string& fileName, ui64 key)
+{
+  const MappedFile file(fileName);
+  FileHeader       header;
+  if (file.size() < sizeof(header))
+  {
+    throw std::runtime_error(fileName + " is not a BVH file.");
+  }
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (std::memcmp(header.magic, fileMagic, sizeof(fileMagic)) != 0 || header.version != fileVersion)
+  {
+    throw std::runtime_error(fileName + " is not a BVH file of version " + std::to_string(fileVersion) + ".");
+  }
+  if (header.key != key)
+  {
+    throw std::runtime_error(fileName + " holds the BVH of other data.");
+  }
+  const size_t nodesSize            = size_t(header.nNodes) * sizeof(Node);
+  const size_t primitiveIndicesSize = size_t(header.nPrimitives) * sizeof(ui32);
+  if (file.size() != sizeof(header) + nodesSize + primitiveIndicesSize)
+  {
+    throw std::runtime_error(fileName + " has an unexpected size.");
+  }
+  // The mapping starts at a page boundary, so the nodes and the indices are aligned.
+  const auto* nodes            = reinterpret_cast<const Node*>(file.data() + sizeof(header));
+  const auto* primitiveIndices = reinterpret_cast<const ui32*>(nodes + header.nNodes);
+  if (getPayloadHash(nodes, nodesSize, primitiveIndices, primitiveIndicesSize) != header.hash)
+  {
+    throw std::runtime_error("Checksum mismatch in " + fileName + ".");
+  }
+
+  BVH result;
+  result.m_nodes.assign(nodes, nodes + header.nNodes);
+  result.m_primitiveIndices.assign(primitiveIndices, primitiveIndices + header.nPrimitives);
+  result.m_options                          = header.options;
+  result.m_weightedAreaSum                  = getWeightedAreaSum(result.m_nodes, result.m_options);
+  result.m_statistics.buildTimeMilliseconds = header.buildTimeMilliseconds;
+  result.m_statistics.sahCost               = header.sahCost;
+  result.m_statistics.sahCostAfterBuild     = header.sahCostAfterBuild;
+  result.m_statistics.nNodes                = header.nNodes;
+  result.m_statistics.nLeaves               = header.nLeaves;
+  result.m_statistics.maxDepth              = header.maxDepth;
+  return result;
+}
+
+void BVH::refit(const TriangleMeshView& mesh)
+{
+  refitNodes(m_nodes, m_primitiveIndices, [&](ui32 tIdx) { return getTriangleBounds(mesh, tIdx); });
+  m_weightedAreaSum = getWeightedAreaSum(m_nodes, m_options);
+  updateSAHCost();
+}
+
+void BVH::refit(const AABB* aabbs)
+{
+  refitNodes(m_nodes, m_primitiveIndices, [&](ui32 aIdx) { return getBounds(aabbs[aIdx]); });
+  m_weightedAreaSum = getWeightedAreaSum(m_nodes, m_options);
+  updateSAHCost();
+}
+
+void BVH::refit(const AABB* aabbs, const ui32* changedIndices, ui32 nChangedIndices)
+{
+  if (m_nodes.empty())
+  {
+    return;
+  }
+  if (m_parentIndices.empty())
+  {
+    m_parentIndices.resize(m_nodes.size(), 0);
+    m_leafIndices.resize(m_primitiveIndices.size(), 0);
+    for (ui32 nodeIdx = 0; nodeIdx < m_nodes.size(); nodeIdx++)
+    {
+      const Node& node = m_nodes[nodeIdx];
+      if (node.isLeaf())
+      {
+        for (ui32 pIdx = node.leftFirst; pIdx < node.leftFirst + node.nPrimitives; pIdx++)
+        {
+          m_leafIndices[m_primitiveIndices[pIdx]] = nodeIdx;
+        }
+      }
+      else
+      {
+        m_parentIndices[node.leftFirst]     = nodeIdx;
+        m_parentIndices[node.leftFirst + 1] = nodeIdx;
+      }
+    }
+  }
+
+  for (ui32 cIdx = 0; cIdx < nChangedIndices; cIdx++)
+  {
+    // Walks up until a box does not change. Its ancestors then do not change either.
+    ui32   nodeIdx = m_leafIndices[changedIndices[cIdx]];
+    Bounds bounds;
+    for (ui32 pIdx = m_nodes[nodeIdx].leftFirst; pIdx < m_nodes[nodeIdx].leftFirst + m_nodes[nodeIdx].nPrimitives;
+         pIdx++)
+    {
+      bounds.grow(getBounds(aabbs[m_primitiveIndices[pIdx]]));
+    }
+    while (true)
+    {
+      Node& node = m_nodes[nodeIdx];
+      if (bounds.lo == node.lowerLeftBottom && bounds.hi == node.upperRightTop)
+      {
+        break;
+      }
+      m_weightedAreaSum -= getWeightedArea(node, m_options);
+      node.lowerLeftBottom = bounds.lo;
+      node.upperRightTop   = bounds.hi;
+      m_weightedAreaSum += getWeightedArea(node, m_options);
+      if (nodeIdx == 0)
+      {
+        break;
+      }
+      nodeIdx            = m_parentIndices[nodeIdx];
+      const Node& parent = m_nodes[nodeIdx];
+      bounds             = getBounds(m_nodes[parent.leftFirst]);
+      bounds.grow(getBounds(m_nodes[parent.leftFirst + 1]));
+    }
+  }
+  updateSAHCost();
+}
+
+void BVH::updateSAHCost()
+{
+  m_statistics.sahCost = getSAHCost(m_weightedAreaSum, m_nodes, m_primitiveIndices.size(), m_options);
+}
+
+bool BVH::intersect(const TriangleMeshView& mesh, const Ray& ray, RayHit& hit, bool acceptFirstHit) const
+{
+  return impl::intersectTriangles(*this, mesh, ray, hit, acceptFirstHit);
+}
+} // namespace gims
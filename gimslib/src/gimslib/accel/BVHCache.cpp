@@ -0,0 +1,119 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <gimslib/accel/BVHCache.hpp>
+#include <gimslib/sys/Hash.hpp>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+using namespace gims;
+
+//! Seeds the keys. Increment it when the builder or the key changes, so that BVHs of older versions are no longer
+//! loaded.
+constexpr ui64 keyVersion = 2;
+
+//! Number of triangles or positions that are gathered and hashed at once.
+constexpr ui32 hashChunkSize = 4096;
+} // namespace
+
+namespace gims
+{
+BVHCache::BVHCache(const std::filesystem::path& directory)
+    : m_directory(directory)
+{
+  std::filesystem::create_directories(m_directory);
+}
+
+ui64 BVHCache::computeKey(const TriangleMeshView& mesh, const BVHBuildOptions& options)
+{
+  ui64 key = hash64(&options, sizeof(options), keyVersion);
+  if (mesh.nTriangles == 0)
+  {
+    return key;
+  }
+
+  // The indices are hashed relative to the smallest index, followed by the positions from there on, so the key covers
+  // the geometry, whatever the base vertex is. The BVH references triangles, not vertices, so it is the same, too.
+  ui32 minIdx = std::numeric_limits<ui32>::max();
+  ui32 maxIdx = 0;
+  for (ui32 tIdx = 0; tIdx < mesh.nTriangles; tIdx++)
+  {
+    for (i32 cIdx = 0; cIdx < 3; cIdx++)
+    {
+      minIdx = std::min(minIdx, mesh.triangles[tIdx][cIdx]);
+      maxIdx = std::max(maxIdx, mesh.triangles[tIdx][cIdx]);
+    }
+  }
+  std::array<ui32v3, hashChunkSize> triangleChunk;
+  for (ui64 firstIdx = 0; firstIdx < mesh.nTriangles; firstIdx += hashChunkSize)
+  {
+    const ui32 nTriangles = static_cast<ui32>(std::min<ui64>(hashChunkSize, mesh.nTriangles - firstIdx));
+    for (ui32 tIdx = 0; tIdx < nTriangles; tIdx++)
+    {
+      triangleChunk[tIdx] = mesh.triangles[firstIdx + tIdx] - ui32v3(minIdx);
+    }
+    key = hash64(triangleChunk.data(), nTriangles * sizeof(ui32v3), key);
+  }
+
+  // Tightly packed positions are hashed in place, others are gathered.
+  std::array<f32v3, hashChunkSize> chunk;
+  for (ui64 firstIdx = minIdx; firstIdx <= maxIdx; firstIdx += hashChunkSize)
+  {
+    const ui32   nPositions = static_cast<ui32>(std::min<ui64>(hashChunkSize, ui64(maxIdx) + 1 - firstIdx));
+    const f32v3* positions  = &mesh.getPosition(static_cast<ui32>(firstIdx));
+    if (mesh.positionStride != sizeof(f32v3))
+    {
+      for (ui32 pIdx = 0; pIdx < nPositions; pIdx++)
+      {
+        chunk[pIdx] = mesh.getPosition(static_cast<ui32>(firstIdx + pIdx));
+      }
+      positions = chunk.data();
+    }
+    key = hash64(positions, nPositions * sizeof(f32v3), key);
+  }
+  return key;
+}
+
+BVH BVHCache::getBVH(const TriangleMeshView& mesh, const BVHBuildOptions& options, ThreadPool* threadPool)
+{
+  const ui64 key      = computeKey(mesh, options);
+  const auto fileName = getFileName(key);
+  if (std::filesystem::exists(fileName))
+  {
+    try
+    {
+      return BVH::load(fileName.string(), key);
+    }
+    catch (const std::runtime_error&)
+    {
+      // Damaged or foreign files are replaced below.
+    }
+  }
+
+  BVH        result(mesh, options, threadPool);
+  const auto tempFileName = fileName.string() + "." + std::to_string(std::random_device()()) + ".tmp";
+  result.save(tempFileName, key);
+  std::error_code error;
+  std::filesystem::rename(tempFileName, fileName, error);
+  if (error)
+  {
+    // Another process may hold the file open. Its BVH is as good as this one.
+    std::filesystem::remove(tempFileName, error);
+  }
+  return result;
+}
+
+std::filesystem::path BVHCache::getFileName(ui64 key) const
+{
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.bvh", static_cast<unsigned long long>(key));
+  return m_directory / name;
+}
+} // namespace gims
@@ -0,0 +1,207 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#include <algorithm>
+#include <gimslib/accel/BVHReport.hpp>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <mutex>
+#include <utility>
+#include "impl/BuildPrimitive.hpp"
+#include "impl/Traversal.hpp"
+
+namespace
+{
+using namespace gims;
+
+//! Rays per range of the parallel traversal.
+constexpr size_t rayChunkSize = 1024;
+
+//! Half the surface area of the overlap of two boxes, zero if they are disjoint.
+f32 getOverlapHalfArea(const BVH::Node& a, const BVH::Node& b)
+{
+  const f32v3 lo = glm::max(a.lowerLeftBottom, b.lowerLeftBottom);
+  const f32v3 hi = glm::min(a.upperRightTop, b.upperRightTop);
+  return hi.x >= lo.x && hi.y >= lo.y && hi.z >= lo.z ? impl::getHalfArea(lo, hi) : 0.0f;
+}
+
+const char* getAlgorithmName(BVHBuildAlgorithm algorithm)
+{
+  return algorithm == BVHBuildAlgorithm::LBVH ? "LBVH" : "BinnedSAH";
+}
+
+void writeHistogram(std::ostream& stream, const std::vector<ui32>& histogram)
+{
+  stream << "[";
+  for (size_t i = 0; i < histogram.size(); i++)
+  {
+    stream << (i == 0 ? "" : ", ") << histogram[i];
+  }
+  stream << "]";
+}
+} // namespace
+
+namespace gims
+{
+BVHReport::BVHReport(const BVH& bvh)
+    : m_options(bvh.getOptions())
+    , m_statistics(bvh.getStatistics())
+    , m_memorySize(bvh.getMemorySize())
+{
+  const auto& nodes = bvh.getNodes();
+  if (nodes.empty())
+  {
+    return;
+  }
+  f64                                overlapArea = 0.0;
+  f64                                innerArea   = 0.0;
+  std::vector<std::pair<ui32, ui32>> stack       = {{0, 0}};
+  while (!stack.empty())
+  {
+    const auto [nodeIdx, depth] = stack.back();
+    stack.pop_back();
+    const BVH::Node& node = nodes[nodeIdx];
+    if (node.isLeaf())
+    {
+      m_depthHistogram.resize(std::max<size_t>(m_depthHistogram.size(), depth + 1));
+      m_leafSizeHistogram.resize(std::max<size_t>(m_leafSizeHistogram.size(), node.nPrimitives + 1));
+      m_depthHistogram[depth]++;
+      m_leafSizeHistogram[node.nPrimitives]++;
+      continue;
+    }
+    overlapArea += getOverlapHalfArea(nodes[node.leftFirst], nodes[node.leftFirst + 1]);
+    innerArea += impl::getHalfArea(node.lowerLeftBottom, node.upperRightTop);
+    stack.push_back({node.leftFirst, depth + 1});
+    stack.push_back({node.leftFirst + 1, depth + 1});
+  }
+  m_overlapRatio = innerArea > 0.0 ? overlapArea / innerArea : 0.0;
+}
+
+BVHReport::BVHReport(const BVH& bvh, const TriangleMeshView& mesh, const std::vector<Ray>& rays,
+                     ThreadPool* threadPool)
+    : BVHReport(bvh)
+{
+  m_hasTraversalStatistics    = true;
+  m_traversalStatistics.nRays = rays.size();
+  ui64       nNodes           = 0;
+  ui64       nTriangles       = 0;
+  std::mutex mutex;
+  const auto trace = [&](size_t begin, size_t end)
+  {
+    BVHTraversalStatistics  rangeStatistics;
+    impl::TraversalCounters rangeCounters;
+    for (size_t rIdx = begin; rIdx < end; rIdx++)
+    {
+      const Ray&                ray = rays[rIdx];
+      const impl::WatertightRay watertightRay(ray.origin, ray.direction);
+      impl::TraversalCounters   counters;
+      f32                       tHit = ray.tMax;
+      bool                      hit  = false;
+      impl::traverse(
+          bvh, ray, tHit,
+          [&](ui32 tIdx)
+          {
+            const ui32v3& triangle = mesh.triangles[tIdx];
+            f32           t;
+            f32v2         barycentrics;
+            if (impl::intersectTriangle(watertightRay, mesh.getPosition(triangle.x), mesh.getPosition(triangle.y),
+                                        mesh.getPosition(triangle.z), ray.tMin, tHit, t, barycentrics))
+            {
+              tHit = t;
+              hit  = true;
+            }
+            return false;
+          },
+          &counters);
+      rangeStatistics.nHits += hit ? 1 : 0;
+      rangeStatistics.maxNodesPerRay     = std::max(rangeStatistics.maxNodesPerRay, counters.nNodes);
+      rangeStatistics.maxTrianglesPerRay = std::max(rangeStatistics.maxTrianglesPerRay, counters.nPrimitives);
+      rangeCounters.nNodes += counters.nNodes;
+      rangeCounters.nPrimitives += counters.nPrimitives;
+    }
+    const std::lock_guard lock(mutex);
+    auto&                 total = m_traversalStatistics;
+    total.nHits += rangeStatistics.nHits;
+    total.maxNodesPerRay     = std::max(total.maxNodesPerRay, rangeStatistics.maxNodesPerRay);
+    total.maxTrianglesPerRay = std::max(total.maxTrianglesPerRay, rangeStatistics.maxTrianglesPerRay);
+    nNodes += rangeCounters.nNodes;
+    nTriangles += rangeCounters.nPrimitives;
+  };
+  if (threadPool != nullptr)
+  {
+    threadPool->parallelFor(rays.size(), rayChunkSize, trace);
+  }
+  else
+  {
+    trace(0, rays.size());
+  }
+  if (!rays.empty())
+  {
+    m_traversalStatistics.nodesPerRay     = static_cast<f64>(nNodes) / static_cast<f64>(rays.size());
+    m_traversalStatistics.trianglesPerRay = static_cast<f64>(nTriangles) / static_cast<f64>(rays.size());
+  }
+}
+
+const BVHStatistics& BVHReport::getStatistics() const
+{
+  return m_statistics;
+}
+
+const std::vector<ui32>& BVHReport::getDepthHistogram() const
+{
+  return m_depthHistogram;
+}
+
+const std::vector<ui32>& BVHReport::getLeafSizeHistogram() const
+{
+  return m_leafSizeHistogram;
+}
+
+f64 BVHReport::getOverlapRatio() const
+{
+  return m_overlapRatio;
+}
+
+size_t BVHReport::getMemorySize() const
+{
+  return m_memorySize;
+}
+
+bool BVHReport::hasTraversalStatistics() const
+{
+  return m_hasTraversalStatistics;
+}
+
+const BVHTraversalStatistics& BVHReport::getTraversalStatistics() const
+{
+  return m_traversalStatistics;
+}
+
+void BVHReport::writeJson(std::ostream& stream) const
+{
+  const auto precision = stream.precision(8);
+  stream << "{\n  \"options\": {\"algorithm\": \"" << getAlgorithmName(m_options.algorithm)
+         << "\", \"bins\": " << m_options.nBins << ", \"maxLeafSize\": " << m_options.maxLeafSize
+         << ", \"traversalCost\": " << m_options.traversalCost
+         << ", \"intersectionCost\": " << m_options.intersectionCost
+         << ", \"mortonCodeBits\": " << m_options.mortonCodeBits
+         << ", \"treeletRounds\": " << m_options.nTreeletRounds << "},\n";
+  stream << "  \"buildTimeMs\": " << m_statistics.buildTimeMilliseconds << ",\n  \"sahCost\": " << m_statistics.sahCost
+         << ",\n  \"sahCostAfterBuild\": " << m_statistics.sahCostAfterBuild
+         << ",\n  \"nodes\": " << m_statistics.nNodes << ",\n  \"leaves\": " << m_statistics.nLeaves
+         << ",\n  \"maxDepth\": " << m_statistics.maxDepth << ",\n  \"overlapRatio\": " << m_overlapRatio
+         << ",\n  \"memoryBytes\": " << m_memorySize << ",\n  \"depthHistogram\": ";
+  writeHistogram(stream, m_depthHistogram);
+  stream << ",\n  \"leafSizeHistogram\": ";
+  writeHistogram(stream, m_leafSizeHistogram);
+  if (m_hasTraversalStatistics)
+  {
+    const auto& t = m_traversalStatistics;
+    stream << ",\n  \"traversal\": {\"rays\": " << t.nRays << ", \"hits\": " << t.nHits
+           << ", \"nodesPerRay\": " << t.nodesPerRay << ", \"trianglesPerRay\": " << t.trianglesPerRay
+           << ", \"maxNodesPerRay\": " << t.maxNodesPerRay << ", \"maxTrianglesPerRay\": " << t.maxTrianglesPerRay
+           << "}";
+  }
+  stream << "\n}\n";
+  stream.precision(precision);
+}
+} // namespace gims
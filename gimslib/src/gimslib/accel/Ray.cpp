@@ -0,0 +1,34 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#include <gimslib/accel/Ray.hpp>
+
+namespace gims
+{
+Ray createCameraRay(const f32m4& clipToWorld, const f32v2& imagePosition, ui32 width, ui32 height)
+{
+  // Normalized device coordinates have y pointing up.
+  const f32   ndcX      = imagePosition.x / static_cast<f32>(width) * 2.0f - 1.0f;
+  const f32   ndcY      = 1.0f - imagePosition.y / static_cast<f32>(height) * 2.0f;
+  const f32v4 nearPoint = clipToWorld * f32v4(ndcX, ndcY, 0.0f, 1.0f);
+  const f32v4 farPoint  = clipToWorld * f32v4(ndcX, ndcY, 1.0f, 1.0f);
+  Ray         result;
+  result.origin    = f32v3(nearPoint) / nearPoint.w;
+  result.direction = glm::normalize(f32v3(farPoint) / farPoint.w - result.origin);
+  return result;
+}
+
+std::vector<Ray> createCameraRays(const f32m4& viewMatrix, const f32m4& projectionMatrix, ui32 width, ui32 height)
+{
+  const f32m4      clipToWorld = glm::inverse(projectionMatrix * viewMatrix);
+  std::vector<Ray> result(size_t(width) * height);
+  for (ui32 y = 0; y < height; y++)
+  {
+    for (ui32 x = 0; x < width; x++)
+    {
+      result[size_t(y) * width + x] = createCameraRay(clipToWorld, f32v2(f32(x), f32(y)) + 0.5f, width, height);
+    }
+  }
+  return result;
+}
+} // namespace gims
@@ -0,0 +1,339 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#include <algorithm>
+#include <bit>
+#include <gimslib/accel/TLAS.hpp>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "impl/PacketTraversal.hpp"
+#include "impl/Traversal.hpp"
+
+namespace
+{
+using namespace gims;
+
+//! Number of rays traced by one task when a thread pool is used, a multiple of every packet width.
+constexpr size_t raysPerTask = 1 << 12;
+
+//! Instances are costly to intersect, so the top level splits down to single instances.
+BVHBuildOptions getTopLevelOptions()
+{
+  BVHBuildOptions result;
+  result.maxLeafSize = 1;
+  return result;
+}
+} // namespace
+
+namespace gims
+{
+ui64 TLASTraversalCounters::getNumSteps() const
+{
+  return nTopLevelNodes + nInstances + nBottomLevelNodes + nTriangles;
+}
+
+TLASTraversalCounters& TLASTraversalCounters::operator+=(const TLASTraversalCounters& other)
+{
+  nRays += other.nRays;
+  nTopLevelNodes += other.nTopLevelNodes;
+  nInstances += other.nInstances;
+  nBottomLevelNodes += other.nBottomLevelNodes;
+  nTriangles += other.nTriangles;
+  return *this;
+}
+
+ui32 TLAS::addBottomLevel(const TriangleMeshView& mesh, const BVHBuildOptions& options, ThreadPool* threadPool)
+{
+  m_bottomLevels.push_back({BVH(mesh, options, threadPool), mesh});
+  return static_cast<ui32>(m_bottomLevels.size() - 1);
+}
+
+ui32 TLAS::addBottomLevel(const TriangleMeshView& mesh, BVH bvh)
+{
+  m_bottomLevels.push_back({std::move(bvh), mesh});
+  return static_cast<ui32>(m_bottomLevels.size() - 1);
+}
+
+ui32 TLAS::addInstance(const TLASInstance& instance)
+{
+  if (instance.bottomLevelIdx >= m_bottomLevels.size())
+  {
+    throw std::runtime_error("Bottom-level structure " + std::to_string(instance.bottomLevelIdx) + " does not exist.");
+  }
+  m_instances.push_back(instance);
+  m_instances.back().instanceID &= 0xffffff;
+  m_isBuilt = false;
+  return static_cast<ui32>(m_instances.size() - 1);
+}
+
+void TLAS::setInstanceTransformation(ui32 instanceIdx, const f32m4x3& transformation)
+{
+  m_instances.at(instanceIdx).transformation = transformation;
+  if (instanceIdx < m_isInstanceChanged.size() && !m_isInstanceChanged[instanceIdx])
+  {
+    m_isInstanceChanged[instanceIdx] = true;
+    m_changedInstanceIndices.push_back(instanceIdx);
+  }
+}
+
+void TLAS::build(ThreadPool* threadPool)
+{
+  const auto nInstances = static_cast<ui32>(m_instances.size());
+  m_worldToObjectTransformations.resize(nInstances);
+  m_worldSpaceAABBs.resize(nInstances);
+  std::vector<AABB>  objectSpaceAABBs(nInstances);
+  std::vector<f32m4> objectToWorldTransformations(nInstances);
+  for (ui32 iIdx = 0; iIdx < nInstances; iIdx++)
+  {
+    const auto& instance                 = m_instances[iIdx];
+    objectSpaceAABBs[iIdx]               = m_bottomLevels[instance.bottomLevelIdx].bvh.getAABB();
+    objectToWorldTransformations[iIdx]   = f32m4(instance.transformation);
+    m_worldToObjectTransformations[iIdx] = f32m4x3(glm::inverse(objectToWorldTransformations[iIdx]));
+  }
+  AABB::getTransformed(objectSpaceAABBs.data(), objectToWorldTransformations.data(), nInstances,
+                       m_worldSpaceAABBs.data());
+  m_topLevel = BVH(m_worldSpaceAABBs.data(), nInstances, getTopLevelOptions(), threadPool);
+  m_changedInstanceIndices.clear();
+  m_isInstanceChanged.assign(nInstances, false);
+  m_isBuilt = true;
+}
+
+bool TLAS::update(ThreadPool* threadPool)
+{
+  if (!m_isBuilt)
+  {
+    build(threadPool);
+    return true;
+  }
+  if (m_changedInstanceIndices.empty())
+  {
+    return false;
+  }
+  for (const auto iIdx : m_changedInstanceIndices)
+  {
+    updateInstance(iIdx);
+    m_isInstanceChanged[iIdx] = false;
+  }
+  m_topLevel.refit(m_worldSpaceAABBs.data(), m_changedInstanceIndices.data(),
+                   static_cast<ui32>(m_changedInstanceIndices.size()));
+  m_changedInstanceIndices.clear();
+
+  const auto& statistics = m_topLevel.getStatistics();
+  if (statistics.sahCost > m_rebuildThreshold * statistics.sahCostAfterBuild)
+  {
+    m_topLevel = BVH(m_worldSpaceAABBs.data(), static_cast<ui32>(m_worldSpaceAABBs.size()), getTopLevelOptions(),
+                     threadPool);
+    return true;
+  }
+  return false;
+}
+
+void TLAS::setRebuildThreshold(f32 rebuildThreshold)
+{
+  if (!(rebuildThreshold >= 1.0f))
+  {
+    throw std::runtime_error("The rebuild threshold must be at least 1.");
+  }
+  m_rebuildThreshold = rebuildThreshold;
+}
+
+f32 TLAS::getRebuildThreshold() const
+{
+  return m_rebuildThreshold;
+}
+
+void TLAS::updateInstance(ui32 instanceIdx)
+{
+  const auto& instance                        = m_instances[instanceIdx];
+  const auto  objectToWorldTransformation     = f32m4(instance.transformation);
+  m_worldToObjectTransformations[instanceIdx] = f32m4x3(glm::inverse(objectToWorldTransformation));
+  m_worldSpaceAABBs[instanceIdx] =
+      m_bottomLevels[instance.bottomLevelIdx].bvh.getAABB().getTransformed(objectToWorldTransformation);
+}
+
+void TLAS::checkIsUpToDate() const
+{
+  if (!m_isBuilt || !m_changedInstanceIndices.empty())
+  {
+    throw std::runtime_error("The instances of the TLAS changed. Call TLAS::update() before tracing rays.");
+  }
+}
+
+template<ui32 Width>
+void TLAS::tracePacket(const Ray* rays, ui32 nRays, RayHit* hits, ui8 instanceInclusionMask, bool acceptFirstHit) const
+{
+  impl::RayPacket<Width> packet;
+  for (ui32 lane = 0; lane < nRays; lane++)
+  {
+    packet.setRay(lane, rays[lane].origin, rays[lane].direction, rays[lane].tMin, rays[lane].tMax);
+    hits[lane]   = RayHit();
+    hits[lane].t = rays[lane].tMax;
+  }
+  impl::traverse(
+      m_topLevel, packet,
+      [&](ui32 iIdx, ui32 laneMask)
+      {
+        const auto& instance = m_instances[iIdx];
+        if ((instance.instanceMask & instanceInclusionMask) == 0)
+        {
+          return;
+        }
+        // As in traceRay(), the directions are not normalized, so t is the same in both spaces.
+        const f32m4x3&         worldToObject = m_worldToObjectTransformations[iIdx];
+        impl::RayPacket<Width> objectSpacePacket;
+        for (ui32 mask = laneMask; mask != 0; mask &= mask - 1)
+        {
+          const ui32 lane = std::countr_zero(mask);
+          objectSpacePacket.setRay(lane, worldToObject * f32v4(rays[lane].origin, 1.0f),
+                                   worldToObject * f32v4(rays[lane].direction, 0.0f), rays[lane].tMin,
+                                   packet.tMax[lane]);
+        }
+
+        const auto& bottomLevel = m_bottomLevels[instance.bottomLevelIdx];
+        impl::traverse(bottomLevel.bvh, objectSpacePacket,
+                       [&](ui32 tIdx, ui32 triangleLaneMask)
+                       {
+                         const ui32v3& triangle = bottomLevel.mesh.triangles[tIdx];
+                         const f32v3   p0       = bottomLevel.mesh.getPosition(triangle.x);
+                         const f32v3   p1       = bottomLevel.mesh.getPosition(triangle.y);
+                         const f32v3   p2       = bottomLevel.mesh.getPosition(triangle.z);
+                         for (ui32 mask = triangleLaneMask; mask != 0; mask &= mask - 1)
+                         {
+                           const ui32 lane = std::countr_zero(mask);
+                           f32        t;
+                           f32v2      barycentrics;
+                           if (!impl::intersectTriangle(objectSpacePacket.rays[lane], p0, p1, p2,
+                                                        objectSpacePacket.tMin[lane], objectSpacePacket.tMax[lane], t,
+                                                        barycentrics))
+                           {
+                             continue;
+                           }
+                           objectSpacePacket.tMax[lane] = t;
+                           hits[lane].t                 = t;
+                           hits[lane].barycentrics      = barycentrics;
+                           hits[lane].primitiveIdx      = tIdx;
+                           hits[lane].instanceIdx       = iIdx;
+                           hits[lane].instanceID        = instance.instanceID;
+                           if (acceptFirstHit)
+                           {
+                             objectSpacePacket.activeMask &= ~(1u << lane);
+                           }
+                         }
+                       });
+
+        for (ui32 mask = laneMask; mask != 0; mask &= mask - 1)
+        {
+          const ui32 lane   = std::countr_zero(mask);
+          packet.tMax[lane] = objectSpacePacket.tMax[lane];
+        }
+        // Lanes that left the object-space packet found their first hit.
+        packet.activeMask &= objectSpacePacket.activeMask | ~laneMask;
+      });
+}
+
+RayHit TLAS::traceRay(const Ray& ray, ui8 instanceInclusionMask, bool acceptFirstHit,
+                      TLASTraversalCounters* counters) const
+{
+  checkIsUpToDate();
+  RayHit hit;
+  hit.t = ray.tMax;
+  impl::TraversalCounters topLevelCounters;
+  impl::TraversalCounters bottomLevelCounters;
+  ui64                    nInstances = 0;
+  impl::traverse(
+      m_topLevel, ray, hit.t,
+      [&](ui32 iIdx)
+      {
+        const auto& instance = m_instances[iIdx];
+        if ((instance.instanceMask & instanceInclusionMask) == 0)
+        {
+          return false;
+        }
+        nInstances++;
+        // The direction is not normalized, so t is the same in both spaces.
+        const f32m4x3& worldToObject = m_worldToObjectTransformations[iIdx];
+        Ray            objectSpaceRay;
+        objectSpaceRay.origin    = worldToObject * f32v4(ray.origin, 1.0f);
+        objectSpaceRay.direction = worldToObject * f32v4(ray.direction, 0.0f);
+        objectSpaceRay.tMin      = ray.tMin;
+
+        const auto& bottomLevel = m_bottomLevels[instance.bottomLevelIdx];
+        if (!impl::intersectTriangles(bottomLevel.bvh, bottomLevel.mesh, objectSpaceRay, hit, acceptFirstHit,
+                                      counters != nullptr ? &bottomLevelCounters : nullptr))
+        {
+          return false;
+        }
+        hit.instanceIdx = iIdx;
+        hit.instanceID  = instance.instanceID;
+        return acceptFirstHit;
+      },
+      counters != nullptr ? &topLevelCounters : nullptr);
+
+  if (counters != nullptr)
+  {
+    counters->nRays++;
+    counters->nTopLevelNodes += topLevelCounters.nNodes;
+    counters->nInstances += nInstances;
+    counters->nBottomLevelNodes += bottomLevelCounters.nNodes;
+    counters->nTriangles += bottomLevelCounters.nPrimitives;
+  }
+  return hit;
+}
+
+void TLAS::traceRays(const Ray* rays, ui32 nRays, RayHit* hits, ui8 instanceInclusionMask, bool acceptFirstHit,
+                     ThreadPool* threadPool) const
+{
+  checkIsUpToDate();
+  const ui32 width       = impl::getPacketWidth();
+  const auto tracePacket =
+      width == 16 ? &TLAS::tracePacket<16> : (width == 8 ? &TLAS::tracePacket<8> : &TLAS::tracePacket<4>);
+  const auto traceRange  = [&](size_t begin, size_t end)
+  {
+    for (size_t first = begin; first < end; first += width)
+    {
+      const auto nPacketRays = static_cast<ui32>(std::min<size_t>(width, end - first));
+      (this->*tracePacket)(rays + first, nPacketRays, hits + first, instanceInclusionMask, acceptFirstHit);
+    }
+  };
+  if (threadPool != nullptr)
+  {
+    threadPool->parallelFor(nRays, raysPerTask, traceRange);
+  }
+  else
+  {
+    traceRange(0, nRays);
+  }
+}
+
+AABB TLAS::getAABB() const
+{
+  return m_topLevel.getAABB();
+}
+
+ui32 TLAS::getNumBottomLevels() const
+{
+  return static_cast<ui32>(m_bottomLevels.size());
+}
+
+const BVH& TLAS::getBottomLevelBVH(ui32 bottomLevelIdx) const
+{
+  return m_bottomLevels.at(bottomLevelIdx).bvh;
+}
+
+ui32 TLAS::getNumInstances() const
+{
+  return static_cast<ui32>(m_instances.size());
+}
+
+const TLASInstance& TLAS::getInstance(ui32 instanceIdx) const
+{
+  return m_instances.at(instanceIdx);
+}
+
+const BVH& TLAS::getTopLevelBVH() const
+{
+  return m_topLevel;
+}
+} // namespace gims
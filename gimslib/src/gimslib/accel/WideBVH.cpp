@@ -0,0 +1,466 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <gimslib/accel/WideBVH.hpp>
+#include <gimslib/sys/CpuFeatures.hpp>
+#include <limits>
+#include <stdexcept>
+#include "impl/Traversal.hpp"
+#ifdef GIMS_X64
+#include <immintrin.h>
+#endif
+
+namespace
+{
+using namespace gims;
+
+//! An inner node, or the primitives of a leaf if nPrimitives is not zero, and the distance where the ray enters it.
+struct Entry
+{
+  ui32 index;
+  ui32 nPrimitives;
+  f32  tEntry;
+};
+
+//! Half the surface area of a box, zero for invalid boxes.
+f32 getHalfArea(const BVH::Node& node)
+{
+  const f32v3 e = node.upperRightTop - node.lowerLeftBottom;
+  return e.x >= 0.0f ? e.x * e.y + e.y * e.z + e.z * e.x : 0.0f;
+}
+
+bool isValid(const BVH::Node& node)
+{
+  return node.lowerLeftBottom.x <= node.upperRightTop.x && node.lowerLeftBottom.y <= node.upperRightTop.y &&
+         node.lowerLeftBottom.z <= node.upperRightTop.z;
+}
+
+//! 2^exponent, exact for the exponents of normalized floats.
+f32 getCellSize(i8 exponent)
+{
+  return std::bit_cast<f32>(static_cast<ui32>(exponent + 127) << 23);
+}
+
+//! Returns the smallest exponent such that 255 cells of size 2^exponent span [lo, hi] in float arithmetic.
+i8 getExponent(f32 lo, f32 hi)
+{
+  i32 exponent = -126;
+  if (hi > lo)
+  {
+    std::frexp((hi - lo) / 255.0f, &exponent);
+    exponent = std::max(exponent - 1, -126);
+  }
+  while (exponent < 127 && lo + 255.0f * getCellSize(static_cast<i8>(exponent)) < hi)
+  {
+    exponent++;
+  }
+  return static_cast<i8>(exponent);
+}
+
+//! Returns the largest grid coordinate whose dequantized value does not exceed value.
+ui8 quantizeLower(f32 origin, f32 cellSize, f32 value)
+{
+  i32 q = std::clamp(static_cast<i32>(std::floor((value - origin) / cellSize)), 0, 255);
+  while (q > 0 && origin + static_cast<f32>(q) * cellSize > value)
+  {
+    q--;
+  }
+  return static_cast<ui8>(q);
+}
+
+//! Returns the smallest grid coordinate whose dequantized value is not below value.
+ui8 quantizeUpper(f32 origin, f32 cellSize, f32 value)
+{
+  i32 q = std::clamp(static_cast<i32>(std::ceil((value - origin) / cellSize)), 0, 255);
+  while (q < 255 && origin + static_cast<f32>(q) * cellSize < value)
+  {
+    q++;
+  }
+  return static_cast<ui8>(q);
+}
+
+//! Returns the binary nodes that become the children of a wide node. A leaf becomes the only child of the root.
+template<ui32 Width>
+ui32 collapse(const std::vector<BVH::Node>& nodes, ui32 nodeIdx, std::array<ui32, Width>& children)
+{
+  if (nodes[nodeIdx].isLeaf())
+  {
+    children[0] = nodeIdx;
+    return 1;
+  }
+  children[0]     = nodes[nodeIdx].leftFirst;
+  children[1]     = nodes[nodeIdx].leftFirst + 1;
+  ui32 nChildren = 2;
+  while (nChildren < Width)
+  {
+    ui32 largestIdx  = Width;
+    f32  largestArea = -1.0f;
+    for (ui32 cIdx = 0; cIdx < nChildren; cIdx++)
+    {
+      const BVH::Node& child = nodes[children[cIdx]];
+      if (!child.isLeaf() && getHalfArea(child) > largestArea)
+      {
+        largestIdx  = cIdx;
+        largestArea = getHalfArea(child);
+      }
+    }
+    if (largestIdx == Width)
+    {
+      break;
+    }
+    const ui32 firstGrandchildIdx = nodes[children[largestIdx]].leftFirst;
+    children[largestIdx]          = firstGrandchildIdx;
+    children[nChildren++]         = firstGrandchildIdx + 1;
+  }
+  return nChildren;
+}
+
+//! Intersects a ray with the quantized bounds of all children, like impl::intersectBox().
+//! \param[out] tEntries Entry distance per slot.
+//! \return Bit i is set if the ray overlaps the child in slot i. Empty slots may be set as well.
+template<ui32 Width>
+ui32 intersectChildrenScalar(const typename WideBVH<Width>::Node& node, const f32v3& origin,
+                             const f32v3& invDirection, f32 tMin, f32 tMax, f32* tEntries)
+{
+  ui32 result = 0;
+  for (ui32 slot = 0; slot < Width; slot++)
+  {
+    const AABB aabb = node.getChildAABB(slot);
+    if (impl::intersectBox(aabb.getLowerLeftBottom(), aabb.getUpperRightTop(), origin, invDirection, tMin, tMax,
+                           tEntries[slot]))
+    {
+      result |= 1u << slot;
+    }
+  }
+  return result;
+}
+
+#ifdef GIMS_X64
+// As in the packet kernels, the operand order of min and max reproduces the NaN handling of impl::intersectBox().
+
+__m128 loadQuantizedSSE(const ui8* quantized)
+{
+  i32 bytes;
+  std::memcpy(&bytes, quantized, sizeof(bytes));
+  const __m128i zero = _mm_setzero_si128();
+  return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero), zero));
+}
+
+ui32 intersectChildrenSSE(const WideBVH<4>::Node& node, const f32v3& origin, const f32v3& invDirection, f32 tMin,
+                          f32 tMax, f32* tEntries)
+{
+  const f32v3 cellSize = node.getCellSize();
+  __m128      tNear    = _mm_set1_ps(tMin);
+  __m128      tFar     = _mm_set1_ps(tMax);
+  for (i32 axis = 0; axis < 3; axis++)
+  {
+    const __m128 gridOrigin = _mm_set1_ps(node.origin[axis]);
+    const __m128 scale      = _mm_set1_ps(cellSize[axis]);
+    const __m128 lo   = _mm_add_ps(gridOrigin, _mm_mul_ps(loadQuantizedSSE(node.quantizedLower[axis].data()), scale));
+    const __m128 hi   = _mm_add_ps(gridOrigin, _mm_mul_ps(loadQuantizedSSE(node.quantizedUpper[axis].data()), scale));
+    const __m128 o    = _mm_set1_ps(origin[axis]);
+    const __m128 invD = _mm_set1_ps(invDirection[axis]);
+    const __m128 t0   = _mm_mul_ps(_mm_sub_ps(lo, o), invD);
+    const __m128 t1   = _mm_mul_ps(_mm_sub_ps(hi, o), invD);
+    tNear             = _mm_max_ps(_mm_min_ps(t1, t0), tNear);
+    tFar              = _mm_min_ps(_mm_max_ps(t1, t0), tFar);
+  }
+  _mm_storeu_ps(tEntries, tNear);
+  return static_cast<ui32>(_mm_movemask_ps(_mm_cmple_ps(tNear, tFar)));
+}
+
+GIMS_TARGET_AVX __m256 loadQuantizedAVX(const ui8* quantized)
+{
+  const __m128i zero  = _mm_setzero_si128();
+  const __m128i words = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(quantized)), zero);
+  const __m128  lower = _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero));
+  const __m128  upper = _mm_cvtepi32_ps(_mm_unpackhi_epi16(words, zero));
+  return _mm256_insertf128_ps(_mm256_castps128_ps256(lower), upper, 1);
+}
+
+GIMS_TARGET_AVX ui32 intersectChildrenAVX(const WideBVH<8>::Node& node, const f32v3& origin,
+                                          const f32v3& invDirection, f32 tMin, f32 tMax, f32* tEntries)
+{
+  const f32v3 cellSize = node.getCellSize();
+  __m256      tNear    = _mm256_set1_ps(tMin);
+  __m256      tFar     = _mm256_set1_ps(tMax);
+  for (i32 axis = 0; axis < 3; axis++)
+  {
+    const __m256 gridOrigin = _mm256_set1_ps(node.origin[axis]);
+    const __m256 scale      = _mm256_set1_ps(cellSize[axis]);
+    const __m256 lo =
+        _mm256_add_ps(gridOrigin, _mm256_mul_ps(loadQuantizedAVX(node.quantizedLower[axis].data()), scale));
+    const __m256 hi =
+        _mm256_add_ps(gridOrigin, _mm256_mul_ps(loadQuantizedAVX(node.quantizedUpper[axis].data()), scale));
+    const __m256 o    = _mm256_set1_ps(origin[axis]);
+    const __m256 invD = _mm256_set1_ps(invDirection[axis]);
+    const __m256 t0   = _mm256_mul_ps(_mm256_sub_ps(lo, o), invD);
+    const __m256 t1   = _mm256_mul_ps(_mm256_sub_ps(hi, o), invD);
+    tNear             = _mm256_max_ps(_mm256_min_ps(t1, t0), tNear);
+    tFar              = _mm256_min_ps(_mm256_max_ps(t1, t0), tFar);
+  }
+  _mm256_storeu_ps(tEntries, tNear);
+  return static_cast<ui32>(_mm256_movemask_ps(_mm256_cmp_ps(tNear, tFar, _CMP_LE_OQ)));
+}
+#endif
+
+//! Intersects a ray with the triangles of a wide BVH. IntersectChildren is one of the child tests above.
+template<ui32 Width, auto IntersectChildren>
+bool traverse(const WideBVH<Width>& bvh, const TriangleMeshView& mesh, const Ray& ray, RayHit& hit, bool acceptFirstHit)
+{
+  using Node                   = typename WideBVH<Width>::Node;
+  const auto& nodes            = bvh.getNodes();
+  const auto& primitiveIndices = bvh.getPrimitiveIndices();
+  if (nodes.empty())
+  {
+    return false;
+  }
+  const impl::WatertightRay watertightRay(ray.origin, ray.direction);
+  const f32v3               invDirection = 1.0f / ray.direction;
+  // Every node on the path from the root leaves at most Width - 1 entries behind.
+  impl::TraversalStack<Entry, 256> stack(size_t(bvh.getMaxDepth()) * (Width - 1) + 1);
+  stack.push({0, 0, ray.tMin});
+  bool found = false;
+  while (!stack.isEmpty())
+  {
+    Entry entry = stack.pop();
+    if (entry.tEntry > hit.t)
+    {
+      continue;
+    }
+    // Descends to the nearest child that the ray overlaps and leaves the others on the stack, nearest on top.
+    bool isLeaf = entry.nPrimitives > 0;
+    while (!isLeaf)
+    {
+      const Node&            node = nodes[entry.index];
+      std::array<f32, Width> tEntries;
+      const ui32 hitMask = IntersectChildren(node, ray.origin, invDirection, ray.tMin, hit.t, tEntries.data());
+
+      std::array<Entry, Width> children;
+      ui32                     nChildren    = 0;
+      ui32                     childIdx     = node.firstChildIdx;
+      ui32                     primitiveIdx = node.firstPrimitiveIdx;
+      for (ui32 slot = 0; slot < Width; slot++)
+      {
+        const ui8 meta = node.meta[slot];
+        if (meta == WideBVH<Width>::EMPTY_CHILD)
+        {
+          continue;
+        }
+        const Entry child = meta == WideBVH<Width>::INNER_CHILD ? Entry{childIdx++, 0, tEntries[slot]}
+                                                                : Entry{primitiveIdx, meta, tEntries[slot]};
+        primitiveIdx += meta == WideBVH<Width>::INNER_CHILD ? 0 : meta;
+        if ((hitMask & (1u << slot)) == 0)
+        {
+          continue;
+        }
+        // Sorted by decreasing entry distance.
+        ui32 insertIdx = nChildren++;
+        while (insertIdx > 0 && children[insertIdx - 1].tEntry < child.tEntry)
+        {
+          children[insertIdx] = children[insertIdx - 1];
+          insertIdx--;
+        }
+        children[insertIdx] = child;
+      }
+      if (nChildren == 0)
+      {
+        break;
+      }
+      for (ui32 cIdx = 0; cIdx + 1 < nChildren; cIdx++)
+      {
+        stack.push(children[cIdx]);
+      }
+      entry  = children[nChildren - 1];
+      isLeaf = entry.nPrimitives > 0;
+    }
+    if (!isLeaf)
+    {
+      continue;
+    }
+    for (ui32 pIdx = entry.index; pIdx < entry.index + entry.nPrimitives; pIdx++)
+    {
+      const ui32    tIdx     = primitiveIndices[pIdx];
+      const ui32v3& triangle = mesh.triangles[tIdx];
+      f32           t;
+      f32v2         barycentrics;
+      if (impl::intersectTriangle(watertightRay, mesh.getPosition(triangle.x), mesh.getPosition(triangle.y),
+                                  mesh.getPosition(triangle.z), ray.tMin, hit.t, t, barycentrics))
+      {
+        hit.t            = t;
+        hit.barycentrics = barycentrics;
+        hit.primitiveIdx = tIdx;
+        found            = true;
+        if (acceptFirstHit)
+        {
+          return true;
+        }
+      }
+    }
+  }
+  return found;
+}
+
+#ifdef GIMS_X64
+GIMS_TARGET_AVX bool traverseAVX(const WideBVH<8>& bvh, const TriangleMeshView& mesh, const Ray& ray, RayHit& hit,
+                                 bool acceptFirstHit)
+{
+  return traverse<8, intersectChildrenAVX>(bvh, mesh, ray, hit, acceptFirstHit);
+}
+#endif
+} // namespace
+
+namespace gims
+{
+template<ui32 Width> f32v3 WideBVH<Width>::Node::getCellSize() const
+{
+  return f32v3(::getCellSize(exponents[0]), ::getCellSize(exponents[1]), ::getCellSize(exponents[2]));
+}
+
+template<ui32 Width> AABB WideBVH<Width>::Node::getChildAABB(ui32 slot) const
+{
+  const f32v3 cellSize = getCellSize();
+  f32v3       lowerLeftBottom, upperRightTop;
+  for (i32 axis = 0; axis < 3; axis++)
+  {
+    lowerLeftBottom[axis] = origin[axis] + static_cast<f32>(quantizedLower[axis][slot]) * cellSize[axis];
+    upperRightTop[axis]   = origin[axis] + static_cast<f32>(quantizedUpper[axis][slot]) * cellSize[axis];
+  }
+  return AABB(lowerLeftBottom, upperRightTop);
+}
+
+template<ui32 Width> WideBVH<Width>::WideBVH(const BVH& bvh)
+{
+  const auto& binaryNodes      = bvh.getNodes();
+  const auto& primitiveIndices = bvh.getPrimitiveIndices();
+  if (binaryNodes.empty())
+  {
+    return;
+  }
+  m_aabb = bvh.getAABB();
+  m_primitiveIndices.reserve(primitiveIndices.size());
+
+  // Breadth-first, so that the inner children of a node are created consecutively.
+  struct Task
+  {
+    ui32 binaryNodeIdx;
+    ui32 nodeIdx;
+    ui32 depth;
+  };
+  std::vector<Task> tasks = {{0, 0, 1}};
+  m_nodes.emplace_back();
+  for (size_t tIdx = 0; tIdx < tasks.size(); tIdx++)
+  {
+    const Task task = tasks[tIdx];
+    m_maxDepth      = std::max(m_maxDepth, task.depth);
+
+    std::array<ui32, Width> children;
+    const ui32              nChildren = collapse<Width>(binaryNodes, task.binaryNodeIdx, children);
+
+    // Children with invalid bounds contain no triangle that a ray can hit, so they are dropped.
+    Node node              = {};
+    node.firstChildIdx     = static_cast<ui32>(m_nodes.size());
+    node.firstPrimitiveIdx = static_cast<ui32>(m_primitiveIndices.size());
+    f32v3 lo(std::numeric_limits<f32>::max());
+    f32v3 hi(-std::numeric_limits<f32>::max());
+    for (ui32 cIdx = 0; cIdx < nChildren; cIdx++)
+    {
+      const BVH::Node& child = binaryNodes[children[cIdx]];
+      if (isValid(child))
+      {
+        lo = glm::min(lo, child.lowerLeftBottom);
+        hi = glm::max(hi, child.upperRightTop);
+      }
+    }
+    node.origin = lo;
+    for (i32 axis = 0; axis < 3; axis++)
+    {
+      node.exponents[axis] = getExponent(lo[axis], hi[axis]);
+    }
+    const f32v3 cellSize = node.getCellSize();
+
+    ui32 slot = 0;
+    for (ui32 cIdx = 0; cIdx < nChildren; cIdx++)
+    {
+      const BVH::Node& child = binaryNodes[children[cIdx]];
+      if (!isValid(child))
+      {
+        continue;
+      }
+      for (i32 axis = 0; axis < 3; axis++)
+      {
+        node.quantizedLower[axis][slot] = quantizeLower(lo[axis], cellSize[axis], child.lowerLeftBottom[axis]);
+        node.quantizedUpper[axis][slot] = quantizeUpper(lo[axis], cellSize[axis], child.upperRightTop[axis]);
+      }
+      if (child.isLeaf())
+      {
+        if (child.nPrimitives >= INNER_CHILD)
+        {
+          throw std::runtime_error("Leaves with more than 127 primitives cannot be collapsed.");
+        }
+        node.meta[slot] = static_cast<ui8>(child.nPrimitives);
+        m_primitiveIndices.insert(m_primitiveIndices.end(), primitiveIndices.begin() + child.leftFirst,
+                                  primitiveIndices.begin() + child.leftFirst + child.nPrimitives);
+      }
+      else
+      {
+        node.meta[slot] = INNER_CHILD;
+        tasks.push_back({children[cIdx], static_cast<ui32>(m_nodes.size()), task.depth + 1});
+        m_nodes.emplace_back();
+      }
+      slot++;
+    }
+    m_nodes[task.nodeIdx] = node;
+  }
+}
+
+template<ui32 Width> const std::vector<typename WideBVH<Width>::Node>& WideBVH<Width>::getNodes() const
+{
+  return m_nodes;
+}
+
+template<ui32 Width> const std::vector<ui32>& WideBVH<Width>::getPrimitiveIndices() const
+{
+  return m_primitiveIndices;
+}
+
+template<ui32 Width> AABB WideBVH<Width>::getAABB() const
+{
+  return m_aabb;
+}
+
+template<ui32 Width> ui32 WideBVH<Width>::getMaxDepth() const
+{
+  return m_maxDepth;
+}
+
+template<ui32 Width> size_t WideBVH<Width>::getMemorySize() const
+{
+  return m_nodes.size() * sizeof(Node) + m_primitiveIndices.size() * sizeof(ui32);
+}
+
+template<ui32 Width>
+bool WideBVH<Width>::intersect(const TriangleMeshView& mesh, const Ray& ray, RayHit& hit, bool acceptFirstHit) const
+{
+#ifdef GIMS_X64
+  if constexpr (Width == 4)
+  {
+    return traverse<4, intersectChildrenSSE>(*this, mesh, ray, hit, acceptFirstHit);
+  }
+  else
+  {
+    return getCpuFeatures().avx ? traverseAVX(*this, mesh, ray, hit, acceptFirstHit)
+                                : traverse<8, intersectChildrenScalar<8>>(*this, mesh, ray, hit, acceptFirstHit);
+  }
+#else
+  return traverse<Width, intersectChildrenScalar<Width>>(*this, mesh, ray, hit, acceptFirstHit);
+#endif
+}
+
+template class WideBVH<4>;
+template class WideBVH<8>;
+} // namespace gims
@@ -0,0 +1,48 @@
+#pragma once
+#include <gimslib/types.hpp>
+#include <limits>
+
+namespace gims
+{
+namespace impl
+{
+//! \brief A box that grows in place, cheaper than AABB::getUnion() in the inner loops of the builders.
+struct Bounds
+{
+  f32v3 lo = f32v3(std::numeric_limits<f32>::max());
+  f32v3 hi = f32v3(-std::numeric_limits<f32>::max());
+
+  void grow(const f32v3& p)
+  {
+    lo = glm::min(lo, p);
+    hi = glm::max(hi, p);
+  }
+
+  void grow(const Bounds& other)
+  {
+    lo = glm::min(lo, other.lo);
+    hi = glm::max(hi, other.hi);
+  }
+
+  f32v3 getCentroid() const
+  {
+    return (lo + hi) * 0.5f;
+  }
+};
+
+//! \brief The bounds of a triangle or box. The builders reorder these records rather than indices into them, so that
+//! they read memory sequentially.
+struct Primitive
+{
+  Bounds bounds;
+  ui32   primitiveIdx;
+};
+
+//! \brief Half the surface area of a box, zero for invalid boxes.
+inline f32 getHalfArea(const f32v3& lo, const f32v3& hi)
+{
+  const f32v3 e = hi - lo;
+  return e.x >= 0.0f ? e.x * e.y + e.y * e.z + e.z * e.x : 0.0f;
+}
+} // namespace impl
+} // namespace gims
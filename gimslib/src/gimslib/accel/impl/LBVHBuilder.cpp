@@ -0,0 +1,560 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <functional>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <limits>
+#include "LBVHBuilder.hpp"
+
+namespace
+{
+using namespace gims;
+using impl::Bounds;
+using impl::getHalfArea;
+using impl::Primitive;
+
+//! Items per range of the parallel loops and per block of the radix sort. The blocks do not depend on the thread pool,
+//! so neither does the result.
+constexpr size_t chunkSize = 1 << 14;
+
+//! Maximum number of subtrees that a treelet rearranges.
+constexpr ui32 treeletSize = 7;
+
+constexpr ui32 noNode = std::numeric_limits<ui32>::max();
+
+//! Calls body(begin, end) for ranges of [0, count), on the thread pool if there is one.
+void forEachRange(ThreadPool* threadPool, size_t count, size_t grainSize,
+                  const std::function<void(size_t begin, size_t end)>& body)
+{
+  if (threadPool != nullptr)
+  {
+    threadPool->parallelFor(count, grainSize, body);
+  }
+  else
+  {
+    body(0, count);
+  }
+}
+
+//! Inserts two zero bits after each of the lower 10 bits.
+ui32 expandBits(ui32 v)
+{
+  v = (v * 0x00010001u) & 0xff0000ffu;
+  v = (v * 0x00000101u) & 0x0f00f00fu;
+  v = (v * 0x00000011u) & 0xc30c30c3u;
+  v = (v * 0x00000005u) & 0x49249249u;
+  return v;
+}
+
+//! Inserts two zero bits after each of the lower 21 bits.
+ui64 expandBits(ui64 v)
+{
+  v &= 0x1fffffull;
+  v = (v | v << 32) & 0x1f00000000ffffull;
+  v = (v | v << 16) & 0x1f0000ff0000ffull;
+  v = (v | v << 8) & 0x100f00f00f00f00full;
+  v = (v | v << 4) & 0x10c30c30c30c30c3ull;
+  v = (v | v << 2) & 0x1249249249249249ull;
+  return v;
+}
+
+//! Returns the Morton code of a point in the unit cube, 30 bits for ui32 codes and 63 bits for ui64 codes. Points
+//! outside are clamped, NaN coordinates become zero.
+template<class Code> Code getMortonCode(const f32v3& p)
+{
+  constexpr ui32 bitsPerAxis   = sizeof(Code) == 4 ? 10 : 21;
+  constexpr f32  maxCoordinate = static_cast<f32>((1u << bitsPerAxis) - 1);
+  Code           code          = 0;
+  for (i32 axis = 0; axis < 3; axis++)
+  {
+    const f32  t = std::min(p[axis] * maxCoordinate, maxCoordinate);
+    const Code q = t > 0.0f ? static_cast<Code>(t) : 0;
+    code |= expandBits(q) << (2 - axis);
+  }
+  return code;
+}
+
+template<class Code> struct CodedPrimitive
+{
+  Code code;
+  ui32 primitiveIdx;
+};
+
+//! Sorts by code with a least significant digit radix sort of 8-bit digits. Blocks of the items are counted and
+//! scattered in parallel. Passes over digits that all codes share are skipped.
+template<class Code> void radixSort(std::vector<CodedPrimitive<Code>>& items, ThreadPool* threadPool)
+{
+  const size_t                       n       = items.size();
+  const size_t                       nBlocks = (n + chunkSize - 1) / chunkSize;
+  std::vector<CodedPrimitive<Code>>  sorted(n);
+  std::vector<std::array<ui32, 256>> offsets(nBlocks);
+  for (ui32 shift = 0; shift < 8 * sizeof(Code); shift += 8)
+  {
+    const auto getDigit = [shift](const CodedPrimitive<Code>& item) { return (item.code >> shift) & 0xff; };
+    forEachRange(threadPool, nBlocks, 1,
+                 [&](size_t begin, size_t end)
+                 {
+                   for (size_t bIdx = begin; bIdx < end; bIdx++)
+                   {
+                     offsets[bIdx].fill(0);
+                     for (size_t iIdx = bIdx * chunkSize; iIdx < std::min(n, (bIdx + 1) * chunkSize); iIdx++)
+                     {
+                       offsets[bIdx][getDigit(items[iIdx])]++;
+                     }
+                   }
+                 });
+
+    bool isShared = false;
+    for (ui32 digit = 0; digit < 256 && !isShared; digit++)
+    {
+      size_t count = 0;
+      for (const auto& blockOffsets : offsets)
+      {
+        count += blockOffsets[digit];
+      }
+      isShared = count == n;
+    }
+    if (isShared)
+    {
+      continue;
+    }
+
+    // Items with a smaller digit go first, and items with the same digit keep their order across the blocks.
+    ui32 offset = 0;
+    for (ui32 digit = 0; digit < 256; digit++)
+    {
+      for (auto& blockOffsets : offsets)
+      {
+        const ui32 count     = blockOffsets[digit];
+        blockOffsets[digit]  = offset;
+        offset              += count;
+      }
+    }
+    forEachRange(threadPool, nBlocks, 1,
+                 [&](size_t begin, size_t end)
+                 {
+                   for (size_t bIdx = begin; bIdx < end; bIdx++)
+                   {
+                     for (size_t iIdx = bIdx * chunkSize; iIdx < std::min(n, (bIdx + 1) * chunkSize); iIdx++)
+                     {
+                       sorted[offsets[bIdx][getDigit(items[iIdx])]++] = items[iIdx];
+                     }
+                   }
+                 });
+    items.swap(sorted);
+  }
+}
+
+//! A node of the intermediate binary tree. Leaf k holds the k-th sorted primitive, inner node i is stored at n + i.
+struct TreeNode
+{
+  Bounds bounds;
+  ui32   left;
+  ui32   right;
+  ui32   parent;
+  ui32   nPrimitives;
+  //! SAH cost of the subtree, not divided by the area of the root.
+  f32    cost;
+  //! True, if the subtree is cheaper as a single leaf.
+  bool   isCollapsed;
+};
+
+template<class Code> class LBVHBuilder
+{
+public:
+  LBVHBuilder(std::vector<Primitive>& primitives, const BVHBuildOptions& options, ThreadPool* threadPool)
+      : m_primitives(primitives)
+      , m_options(options)
+      , m_threadPool(threadPool)
+      , m_n(static_cast<ui32>(primitives.size()))
+  {
+  }
+
+  //! Builds the nodes and reorders the primitives. Requires at least two primitives.
+  //! \return The depth of the BVH.
+  ui32 build(std::vector<BVH::Node>& nodes)
+  {
+    sortPrimitives();
+    createTree();
+    processBottomUp([this](ui32 nodeIdx) { updateNode(nodeIdx); });
+    for (ui32 round = 0; round < m_options.nTreeletRounds; round++)
+    {
+      // As in Karras and Aila, the minimum size of the restructured subtrees doubles every round, which spends the
+      // later rounds where the SAH cost can drop the most.
+      const ui32 minPrimitives = treeletSize << round;
+      processBottomUp(
+          [&](ui32 nodeIdx)
+          {
+            updateNode(nodeIdx);
+            if (m_tree[nodeIdx].nPrimitives >= minPrimitives)
+            {
+              optimizeTreelet(nodeIdx);
+            }
+          });
+    }
+    return emitNodes(nodes);
+  }
+
+private:
+  //! Sorts the primitives by the Morton codes of their centroids within the box of the centroids.
+  void sortPrimitives()
+  {
+    const size_t        nBlocks = (m_n + chunkSize - 1) / chunkSize;
+    std::vector<Bounds> blockBounds(nBlocks);
+    forEachRange(m_threadPool, nBlocks, 1,
+                 [&](size_t begin, size_t end)
+                 {
+                   for (size_t bIdx = begin; bIdx < end; bIdx++)
+                   {
+                     for (size_t pIdx = bIdx * chunkSize; pIdx < std::min<size_t>(m_n, (bIdx + 1) * chunkSize); pIdx++)
+                     {
+                       blockBounds[bIdx].grow(m_primitives[pIdx].bounds.getCentroid());
+                     }
+                   }
+                 });
+    Bounds centroidBounds;
+    for (const auto& bounds : blockBounds)
+    {
+      centroidBounds.grow(bounds);
+    }
+    const f32v3 extent = centroidBounds.hi - centroidBounds.lo;
+    const f32v3 scale(extent.x > 0.0f ? 1.0f / extent.x : 0.0f, extent.y > 0.0f ? 1.0f / extent.y : 0.0f,
+                      extent.z > 0.0f ? 1.0f / extent.z : 0.0f);
+
+    m_items.resize(m_n);
+    forEachRange(m_threadPool, m_n, chunkSize,
+                 [&](size_t begin, size_t end)
+                 {
+                   for (size_t pIdx = begin; pIdx < end; pIdx++)
+                   {
+                     const f32v3 p = (m_primitives[pIdx].bounds.getCentroid() - centroidBounds.lo) * scale;
+                     m_items[pIdx] = {getMortonCode<Code>(p), static_cast<ui32>(pIdx)};
+                   }
+                 });
+    radixSort(m_items, m_threadPool);
+  }
+
+  //! Length of the common prefix of the codes of the sorted primitives i and j, -1 if j is out of range. Equal codes
+  //! are told apart by the indices.
+  i32 getCommonPrefixLength(i64 i, i64 j) const
+  {
+    if (j < 0 || j >= m_n)
+    {
+      return -1;
+    }
+    const Code a = m_items[i].code;
+    const Code b = m_items[j].code;
+    if (a != b)
+    {
+      return std::countl_zero(static_cast<Code>(a ^ b));
+    }
+    return 8 * static_cast<i32>(sizeof(Code)) + std::countl_zero(static_cast<ui32>(i ^ j));
+  }
+
+  //! Creates the leaves and finds the children of all inner nodes independently (Karras, 2012). Each inner node covers
+  //! a range of sorted primitives, which is split where the common prefix of its codes ends.
+  void createTree()
+  {
+    m_tree.resize(2 * size_t(m_n) - 1);
+    forEachRange(m_threadPool, m_n, chunkSize,
+                 [&](size_t begin, size_t end)
+                 {
+                   for (size_t lIdx = begin; lIdx < end; lIdx++)
+                   {
+                     const Bounds& bounds = m_primitives[m_items[lIdx].primitiveIdx].bounds;
+                     const f32     cost   = m_options.intersectionCost * getHalfArea(bounds.lo, bounds.hi);
+                     m_tree[lIdx]         = {bounds, noNode, noNode, noNode, 1, cost, true};
+                   }
+                 });
+    m_tree[m_n].parent = noNode;
+    forEachRange(m_threadPool, m_n - 1, chunkSize,
+                 [&](size_t begin, size_t end)
+                 {
+                   for (size_t iIdx = begin; iIdx < end; iIdx++)
+                   {
+                     createInnerNode(static_cast<i64>(iIdx));
+                   }
+                 });
+  }
+
+  //! Finds the range of sorted primitives of inner node i and its split, and links the children to the node.
+  void createInnerNode(i64 i)
+  {
+    // The range starts at i and extends towards the neighbor with the longer common prefix.
+    const i64 d         = getCommonPrefixLength(i, i + 1) > getCommonPrefixLength(i, i - 1) ? 1 : -1;
+    const i32 minLength = getCommonPrefixLength(i, i - d);
+    i64       maxLength = 2;
+    while (getCommonPrefixLength(i, i + maxLength * d) > minLength)
+    {
+      maxLength *= 2;
+    }
+    i64 length = 0;
+    for (i64 t = maxLength / 2; t >= 1; t /= 2)
+    {
+      if (getCommonPrefixLength(i, i + (length + t) * d) > minLength)
+      {
+        length += t;
+      }
+    }
+    const i64 j = i + length * d;
+
+    // The split is the last primitive that shares more than the common prefix of the whole range with i.
+    const i32 nodeLength = getCommonPrefixLength(i, j);
+    i64       split      = 0;
+    i64       t          = length;
+    do
+    {
+      t = (t + 1) / 2;
+      if (getCommonPrefixLength(i, i + (split + t) * d) > nodeLength)
+      {
+        split += t;
+      }
+    } while (t > 1);
+    const i64 gamma = i + split * d + std::min<i64>(d, 0);
+
+    const auto nodeIdx        = static_cast<ui32>(m_n + i);
+    TreeNode&  node           = m_tree[nodeIdx];
+    node.left                 = static_cast<ui32>(std::min(i, j) == gamma ? gamma : m_n + gamma);
+    node.right                = static_cast<ui32>(std::max(i, j) == gamma + 1 ? gamma + 1 : m_n + gamma + 1);
+    m_tree[node.left].parent  = nodeIdx;
+    m_tree[node.right].parent = nodeIdx;
+  }
+
+  //! Calls process(nodeIdx) for every inner node once both of its children are processed. One thread climbs from each
+  //! leaf. The first thread that reaches a node stops there, the second one processes it and climbs on.
+  template<class Process> void processBottomUp(const Process& process)
+  {
+    std::vector<std::atomic<ui32>> visits(m_n - 1);
+    forEachRange(m_threadPool, m_n, chunkSize,
+                 [&](size_t begin, size_t end)
+                 {
+                   for (size_t lIdx = begin; lIdx < end; lIdx++)
+                   {
+                     ui32 nodeIdx = m_tree[lIdx].parent;
+                     while (nodeIdx != noNode && visits[nodeIdx - m_n].fetch_add(1, std::memory_order_acq_rel) == 1)
+                     {
+                       process(nodeIdx);
+                       nodeIdx = m_tree[nodeIdx].parent;
+                     }
+                   }
+                 });
+  }
+
+  //! Computes the bounds and the SAH cost of an inner node from its children.
+  void updateNode(ui32 nodeIdx)
+  {
+    TreeNode&       node  = m_tree[nodeIdx];
+    const TreeNode& left  = m_tree[node.left];
+    const TreeNode& right = m_tree[node.right];
+    node.bounds           = left.bounds;
+    node.bounds.grow(right.bounds);
+    node.nPrimitives    = left.nPrimitives + right.nPrimitives;
+    const f32 area      = getHalfArea(node.bounds.lo, node.bounds.hi);
+    const f32 splitCost = m_options.traversalCost * area + left.cost + right.cost;
+    const f32 leafCost  = m_options.intersectionCost * area * static_cast<f32>(node.nPrimitives);
+    node.isCollapsed    = node.nPrimitives <= m_options.maxLeafSize && leafCost <= splitCost;
+    node.cost           = node.isCollapsed ? leafCost : splitCost;
+  }
+
+  //! Rearranges the subtrees of the treelet below an inner node into the topology with the lowest SAH cost.
+  //!
+  //! The treelet grows from the node by replacing its largest subtree with the two children of that subtree, until it
+  //! has treeletSize subtrees. Dynamic programming over all subsets of the subtrees then finds the optimal partition of
+  //! each subset, and the inner nodes of the treelet are reused for the new topology.
+  void optimizeTreelet(ui32 rootIdx)
+  {
+    std::array<ui32, treeletSize>     subtrees   = {m_tree[rootIdx].left, m_tree[rootIdx].right};
+    std::array<ui32, treeletSize - 2> innerNodes = {};
+    ui32                              nSubtrees  = 2;
+    ui32                              nInner     = 0;
+    while (nSubtrees < treeletSize)
+    {
+      ui32 largestIdx  = treeletSize;
+      f32  largestArea = -1.0f;
+      for (ui32 sIdx = 0; sIdx < nSubtrees; sIdx++)
+      {
+        const Bounds& bounds = m_tree[subtrees[sIdx]].bounds;
+        if (subtrees[sIdx] >= m_n && getHalfArea(bounds.lo, bounds.hi) > largestArea)
+        {
+          largestIdx  = sIdx;
+          largestArea = getHalfArea(bounds.lo, bounds.hi);
+        }
+      }
+      if (largestIdx == treeletSize)
+      {
+        break;
+      }
+      const TreeNode& largest = m_tree[subtrees[largestIdx]];
+      innerNodes[nInner++]    = subtrees[largestIdx];
+      subtrees[largestIdx]    = largest.left;
+      subtrees[nSubtrees++]   = largest.right;
+    }
+    if (nSubtrees < 3)
+    {
+      return;
+    }
+
+    // Subset s contains subtree k if bit k is set. Subsets are processed after all of their own subsets.
+    const ui32                            nSubsets = 1u << nSubtrees;
+    std::array<Bounds, 1u << treeletSize> bounds;
+    std::array<ui32, 1u << treeletSize>   nPrimitives;
+    std::array<f32, 1u << treeletSize>    costs;
+    std::array<ui32, 1u << treeletSize>   partitions;
+    nPrimitives[0] = 0;
+    for (ui32 s = 1; s < nSubsets; s++)
+    {
+      const auto      lowestIdx = static_cast<ui32>(std::countr_zero(s));
+      const ui32      rest      = s & (s - 1);
+      const TreeNode& lowest    = m_tree[subtrees[lowestIdx]];
+      bounds[s]                 = bounds[rest];
+      bounds[s].grow(lowest.bounds);
+      nPrimitives[s] = nPrimitives[rest] + lowest.nPrimitives;
+      if (rest == 0)
+      {
+        costs[s] = lowest.cost;
+        continue;
+      }
+      // Each partition is visited once, with the lowest subtree in the first part.
+      f32  bestCost      = std::numeric_limits<f32>::infinity();
+      ui32 bestPartition = 0;
+      for (ui32 p = (s - 1) & s; p > 0; p = (p - 1) & s)
+      {
+        if ((p & (1u << lowestIdx)) != 0 && costs[p] + costs[s ^ p] < bestCost)
+        {
+          bestCost      = costs[p] + costs[s ^ p];
+          bestPartition = p;
+        }
+      }
+      const f32 area = getHalfArea(bounds[s].lo, bounds[s].hi);
+      costs[s]       = m_options.traversalCost * area + bestCost;
+      if (nPrimitives[s] <= m_options.maxLeafSize)
+      {
+        costs[s] = std::min(costs[s], m_options.intersectionCost * area * static_cast<f32>(nPrimitives[s]));
+      }
+      partitions[s] = bestPartition;
+    }
+    if (!(costs[nSubsets - 1] < m_tree[rootIdx].cost))
+    {
+      return;
+    }
+
+    ui32       nUsed    = 0;
+    const auto assemble = [&](const auto& self, ui32 s, ui32 nodeIdx) -> void
+    {
+      const std::array<ui32, 2> parts = {partitions[s], s ^ partitions[s]};
+      std::array<ui32, 2>       children;
+      for (ui32 cIdx = 0; cIdx < 2; cIdx++)
+      {
+        if (std::has_single_bit(parts[cIdx]))
+        {
+          children[cIdx] = subtrees[std::countr_zero(parts[cIdx])];
+        }
+        else
+        {
+          children[cIdx] = innerNodes[nUsed++];
+          self(self, parts[cIdx], children[cIdx]);
+        }
+        m_tree[children[cIdx]].parent = nodeIdx;
+      }
+      m_tree[nodeIdx].left  = children[0];
+      m_tree[nodeIdx].right = children[1];
+      updateNode(nodeIdx);
+    };
+    assemble(assemble, nSubsets - 1, rootIdx);
+  }
+
+  //! Writes the tree depth-first into nodes, with collapsed subtrees as leaves, and reorders the primitives.
+  //! \return The depth of the BVH.
+  ui32 emitNodes(std::vector<BVH::Node>& nodes)
+  {
+    struct Task
+    {
+      ui32 treeNodeIdx;
+      ui32 nodeIdx;
+      ui32 depth;
+    };
+    std::vector<Primitive> orderedPrimitives;
+    orderedPrimitives.reserve(m_n);
+    std::vector<Task> tasks    = {{m_n, 0, 0}};
+    std::vector<ui32> subtree;
+    ui32              maxDepth = 0;
+    nodes.reserve(2 * size_t(m_n) - 1);
+    nodes.resize(1);
+    while (!tasks.empty())
+    {
+      const Task task = tasks.back();
+      tasks.pop_back();
+      maxDepth                 = std::max(maxDepth, task.depth);
+      const TreeNode& treeNode = m_tree[task.treeNodeIdx];
+      BVH::Node       node;
+      node.lowerLeftBottom = treeNode.bounds.lo;
+      node.upperRightTop   = treeNode.bounds.hi;
+      if (treeNode.isCollapsed)
+      {
+        node.leftFirst = static_cast<ui32>(orderedPrimitives.size());
+        subtree.push_back(task.treeNodeIdx);
+        while (!subtree.empty())
+        {
+          const ui32 treeNodeIdx = subtree.back();
+          subtree.pop_back();
+          if (treeNodeIdx < m_n)
+          {
+            orderedPrimitives.push_back(m_primitives[m_items[treeNodeIdx].primitiveIdx]);
+          }
+          else
+          {
+            subtree.push_back(m_tree[treeNodeIdx].right);
+            subtree.push_back(m_tree[treeNodeIdx].left);
+          }
+        }
+        node.nPrimitives = static_cast<ui32>(orderedPrimitives.size()) - node.leftFirst;
+      }
+      else
+      {
+        node.leftFirst   = static_cast<ui32>(nodes.size());
+        node.nPrimitives = 0;
+        nodes.resize(nodes.size() + 2);
+        tasks.push_back({treeNode.right, node.leftFirst + 1, task.depth + 1});
+        tasks.push_back({treeNode.left, node.leftFirst, task.depth + 1});
+      }
+      nodes[task.nodeIdx] = node;
+    }
+    m_primitives = std::move(orderedPrimitives);
+    return maxDepth;
+  }
+
+  std::vector<Primitive>&           m_primitives;
+  const BVHBuildOptions&            m_options;
+  ThreadPool*                       m_threadPool;
+  const ui32                        m_n;
+  std::vector<CodedPrimitive<Code>> m_items;
+  std::vector<TreeNode>             m_tree;
+};
+} // namespace
+
+namespace gims
+{
+namespace impl
+{
+ui32 buildLBVH(std::vector<Primitive>& primitives, const BVHBuildOptions& options, ThreadPool* threadPool,
+               std::vector<BVH::Node>& nodes)
+{
+  if (primitives.empty())
+  {
+    return 0;
+  }
+  if (primitives.size() == 1)
+  {
+    nodes.resize(1);
+    nodes[0] = {primitives[0].bounds.lo, 0, primitives[0].bounds.hi, 1};
+    return 0;
+  }
+  if (options.mortonCodeBits == 63)
+  {
+    return LBVHBuilder<ui64>(primitives, options, threadPool).build(nodes);
+  }
+  return LBVHBuilder<ui32>(primitives, options, threadPool).build(nodes);
+}
+} // namespace impl
+} // namespace gims
@@ -0,0 +1,24 @@
+#pragma once
+#include <gimslib/accel/BVH.hpp>
+#include <vector>
+#include "BuildPrimitive.hpp"
+
+namespace gims
+{
+class ThreadPool;
+
+namespace impl
+{
+//! \brief Builds the nodes of a linear BVH over the primitives and reorders them, like the binned SAH build.
+//!
+//! Sorts the primitives by the Morton codes of their centroids with a parallel radix sort and creates all inner nodes
+//! at once from the sorted codes (Karras, Maximizing Parallelism in the Construction of BVHs, Octrees, and k-d Trees,
+//! 2012). The bounds and the SAH costs are then propagated bottom-up, where the second thread that reaches a node
+//! processes it, and optionally treelets of seven subtrees are restructured to their optimal topology (Karras and Aila,
+//! 2013). Finally, subtrees whose SAH cost is lower as a leaf are collapsed. Every step except the last is parallel,
+//! as a GPU builder would be, and the result does not depend on the thread pool.
+//! \return The depth of the BVH.
+ui32 buildLBVH(std::vector<Primitive>& primitives, const BVHBuildOptions& options, ThreadPool* threadPool,
+               std::vector<BVH::Node>& nodes);
+} // namespace impl
+} // namespace gims
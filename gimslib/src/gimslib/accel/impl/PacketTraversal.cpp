@@ -0,0 +1,109 @@
+#include <gimslib/sys/CpuFeatures.hpp>
+#include "PacketTraversal.hpp"
+#ifdef GIMS_X64
+#include <immintrin.h>
+#endif
+
+// The vector kernels pass the operands of min and max in the order that reproduces std::min and std::max in the
+// scalar intersectBox(). Hence, NaN slabs are ignored alike, and all packet widths report the same lanes.
+
+namespace
+{
+using namespace gims;
+
+template<ui32 Width> ui32 intersectBoxScalar(const BVH::Node& node, const impl::RayPacket<Width>& packet)
+{
+  ui32 result = 0;
+  for (ui32 lane = 0; lane < Width; lane++)
+  {
+    const f32v3 origin(packet.origin[0][lane], packet.origin[1][lane], packet.origin[2][lane]);
+    const f32v3 invDirection(packet.invDirection[0][lane], packet.invDirection[1][lane],
+                             packet.invDirection[2][lane]);
+    f32         tEntry;
+    if (impl::intersectBox(node.lowerLeftBottom, node.upperRightTop, origin, invDirection, packet.tMin[lane],
+                           packet.tMax[lane], tEntry))
+    {
+      result |= 1u << lane;
+    }
+  }
+  return result;
+}
+} // namespace
+
+namespace gims
+{
+namespace impl
+{
+#ifdef GIMS_X64
+ui32 intersectBox(const BVH::Node& node, const RayPacket<4>& packet)
+{
+  __m128 tNear = _mm_loadu_ps(packet.tMin.data());
+  __m128 tFar  = _mm_loadu_ps(packet.tMax.data());
+  for (i32 axis = 0; axis < 3; axis++)
+  {
+    const __m128 o    = _mm_loadu_ps(packet.origin[axis].data());
+    const __m128 invD = _mm_loadu_ps(packet.invDirection[axis].data());
+    const __m128 t0   = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.lowerLeftBottom[axis]), o), invD);
+    const __m128 t1   = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.upperRightTop[axis]), o), invD);
+    tNear             = _mm_max_ps(_mm_min_ps(t1, t0), tNear);
+    tFar              = _mm_min_ps(_mm_max_ps(t1, t0), tFar);
+  }
+  return static_cast<ui32>(_mm_movemask_ps(_mm_cmple_ps(tNear, tFar)));
+}
+
+GIMS_TARGET_AVX ui32 intersectBox(const BVH::Node& node, const RayPacket<8>& packet)
+{
+  __m256 tNear = _mm256_loadu_ps(packet.tMin.data());
+  __m256 tFar  = _mm256_loadu_ps(packet.tMax.data());
+  for (i32 axis = 0; axis < 3; axis++)
+  {
+    const __m256 o    = _mm256_loadu_ps(packet.origin[axis].data());
+    const __m256 invD = _mm256_loadu_ps(packet.invDirection[axis].data());
+    const __m256 t0   = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.lowerLeftBottom[axis]), o), invD);
+    const __m256 t1   = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.upperRightTop[axis]), o), invD);
+    tNear             = _mm256_max_ps(_mm256_min_ps(t1, t0), tNear);
+    tFar              = _mm256_min_ps(_mm256_max_ps(t1, t0), tFar);
+  }
+  return static_cast<ui32>(_mm256_movemask_ps(_mm256_cmp_ps(tNear, tFar, _CMP_LE_OQ)));
+}
+
+GIMS_TARGET_AVX512F ui32 intersectBox(const BVH::Node& node, const RayPacket<16>& packet)
+{
+  __m512 tNear = _mm512_loadu_ps(packet.tMin.data());
+  __m512 tFar  = _mm512_loadu_ps(packet.tMax.data());
+  for (i32 axis = 0; axis < 3; axis++)
+  {
+    const __m512 o    = _mm512_loadu_ps(packet.origin[axis].data());
+    const __m512 invD = _mm512_loadu_ps(packet.invDirection[axis].data());
+    const __m512 t0   = _mm512_mul_ps(_mm512_sub_ps(_mm512_set1_ps(node.lowerLeftBottom[axis]), o), invD);
+    const __m512 t1   = _mm512_mul_ps(_mm512_sub_ps(_mm512_set1_ps(node.upperRightTop[axis]), o), invD);
+    // The masked forms with all lanes set avoid a false -Wuninitialized of GCC 12 in _mm512_min_ps and _mm512_max_ps.
+    tNear = _mm512_mask_max_ps(tNear, 0xffff, _mm512_mask_min_ps(t0, 0xffff, t1, t0), tNear);
+    tFar  = _mm512_mask_min_ps(tFar, 0xffff, _mm512_mask_max_ps(t0, 0xffff, t1, t0), tFar);
+  }
+  return static_cast<ui32>(_mm512_cmp_ps_mask(tNear, tFar, _CMP_LE_OQ));
+}
+#else
+ui32 intersectBox(const BVH::Node& node, const RayPacket<4>& packet)
+{
+  return intersectBoxScalar(node, packet);
+}
+
+ui32 intersectBox(const BVH::Node& node, const RayPacket<8>& packet)
+{
+  return intersectBoxScalar(node, packet);
+}
+
+ui32 intersectBox(const BVH::Node& node, const RayPacket<16>& packet)
+{
+  return intersectBoxScalar(node, packet);
+}
+#endif
+
+ui32 getPacketWidth()
+{
+  const auto& features = getCpuFeatures();
+  return features.avx512f ? 16 : (features.avx ? 8 : 4);
+}
+} // namespace impl
+} // namespace gims
@@ -0,0 +1,99 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <gimslib/accel/BVH.hpp>
+#include "Traversal.hpp"
+
+namespace gims
+{
+namespace impl
+{
+//! \brief Up to Width rays that traverse a BVH together, one per lane.
+//!
+//! The box test reads the rays as structure of arrays. The triangle test runs per lane on the prepared rays.
+template<ui32 Width> struct RayPacket
+{
+  static_assert(Width == 4 || Width == 8 || Width == 16, "Packets have 4, 8, or 16 lanes.");
+
+  //! Lanes of the x, y, and z coordinates. Inactive lanes are zero, so that the kernels read no indeterminate values.
+  std::array<std::array<f32, Width>, 3> origin       = {};
+  std::array<std::array<f32, Width>, 3> invDirection = {};
+  std::array<f32, Width>                tMin         = {};
+  //! End of the interval of each lane. Shrinks to the closest hit found so far.
+  std::array<f32, Width>           tMax = {};
+  std::array<WatertightRay, Width> rays;
+  //! Bit i is set while lane i searches for hits.
+  ui32 activeMask = 0;
+
+  void setRay(ui32 lane, const f32v3& rayOrigin, const f32v3& rayDirection, f32 rayTMin, f32 rayTMax)
+  {
+    const f32v3 rayInvDirection = 1.0f / rayDirection;
+    for (i32 axis = 0; axis < 3; axis++)
+    {
+      origin[axis][lane]       = rayOrigin[axis];
+      invDirection[axis][lane] = rayInvDirection[axis];
+    }
+    tMin[lane] = rayTMin;
+    tMax[lane] = rayTMax;
+    rays[lane] = WatertightRay(rayOrigin, rayDirection);
+    activeMask |= 1u << lane;
+  }
+};
+
+//! \brief Intersects all lanes of a packet with a box by the slab method, like intersectBox().
+//!
+//! The 4-lane version uses SSE. The 8-lane and the 16-lane versions use AVX and AVX-512F. Call them only if
+//! getCpuFeatures() reports the extension. On other architectures, all versions are scalar.
+//! \return Bit i is set if lane i overlaps the box within [tMin, tMax]. Inactive lanes may be set as well.
+ui32 intersectBox(const BVH::Node& node, const RayPacket<4>& packet);
+ui32 intersectBox(const BVH::Node& node, const RayPacket<8>& packet);
+ui32 intersectBox(const BVH::Node& node, const RayPacket<16>& packet);
+
+//! \brief Returns the widest packet that the CPU processes with a single instruction per box slab.
+ui32 getPacketWidth();
+
+//! \brief Visits the leaves of a BVH that any active lane of a packet overlaps.
+//!
+//! A node is tested when it is popped, so lanes culled by closer hits in between skip it. Children are visited in the
+//! order of the first active lane. intersectPrimitive(primitiveIdx, laneMask) may shrink packet.tMax and clear bits of
+//! packet.activeMask. The traversal ends when no lane is active.
+template<ui32 Width, class IntersectPrimitive>
+void traverse(const BVH& bvh, RayPacket<Width>& packet, const IntersectPrimitive& intersectPrimitive)
+{
+  const auto& nodes = bvh.getNodes();
+  if (nodes.empty())
+  {
+    return;
+  }
+  const auto&      primitiveIndices = bvh.getPrimitiveIndices();
+  TraversalStack<> stack(size_t(bvh.getStatistics().maxDepth) + 1);
+  stack.push({0, 0.0f});
+  while (!stack.isEmpty() && packet.activeMask != 0)
+  {
+    const BVH::Node& node     = nodes[stack.pop().nodeIdx];
+    ui32             laneMask = intersectBox(node, packet) & packet.activeMask;
+    if (laneMask == 0)
+    {
+      continue;
+    }
+    if (node.isLeaf())
+    {
+      for (ui32 pIdx = node.leftFirst; pIdx < node.leftFirst + node.nPrimitives && laneMask != 0; pIdx++)
+      {
+        intersectPrimitive(primitiveIndices[pIdx], laneMask);
+        laneMask &= packet.activeMask;
+      }
+      continue;
+    }
+    const BVH::Node& left  = nodes[node.leftFirst];
+    const BVH::Node& right = nodes[node.leftFirst + 1];
+    // Twice the vector from the center of the left child to the center of the right child.
+    const f32v3  offset    = right.lowerLeftBottom + right.upperRightTop - left.lowerLeftBottom - left.upperRightTop;
+    const f32v3& direction = packet.rays[std::countr_zero(laneMask)].direction;
+    const bool   leftFirst = glm::dot(offset, direction) >= 0.0f;
+    stack.push({leftFirst ? node.leftFirst + 1 : node.leftFirst, 0.0f});
+    stack.push({leftFirst ? node.leftFirst : node.leftFirst + 1, 0.0f});
+  }
+}
+} // namespace impl
+} // namespace gims
@@ -0,0 +1,273 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <gimslib/accel/BVH.hpp>
+#include <gimslib/accel/Ray.hpp>
+#include <gimslib/geometry/TriangleMeshView.hpp>
+#include <vector>
+
+namespace gims
+{
+namespace impl
+{
+//! \brief Intersects a ray with a box by the slab method.
+//!
+//! A zero direction component yields NaN on the slabs through the origin, which the min/max operand order ignores.
+//! \param[out] tEntry Ray parameter where the ray enters the box, clamped to tMin.
+//! \return True if the ray overlaps the box within [tMin, tMax].
+inline bool intersectBox(const f32v3& lowerLeftBottom, const f32v3& upperRightTop, const f32v3& origin,
+                         const f32v3& invDirection, f32 tMin, f32 tMax, f32& tEntry)
+{
+  for (i32 axis = 0; axis < 3; axis++)
+  {
+    const f32 t0 = (lowerLeftBottom[axis] - origin[axis]) * invDirection[axis];
+    const f32 t1 = (upperRightTop[axis] - origin[axis]) * invDirection[axis];
+    tMin         = std::max(tMin, std::min(t0, t1));
+    tMax         = std::min(tMax, std::max(t0, t1));
+  }
+  tEntry = tMin;
+  return tMin <= tMax;
+}
+
+//! \brief A ray prepared for the watertight triangle test.
+//!
+//! The test shears and scales space such that the ray becomes the positive z axis from the origin. kz is the axis of
+//! the largest direction component, which keeps the shear numerically harmless.
+struct WatertightRay
+{
+  f32v3 origin;
+  f32v3 direction;
+  f32v3 shear; //! Shear of x and y by z and the scale of z.
+  i32   kx;
+  i32   ky;
+  i32   kz;
+
+  WatertightRay() = default;
+
+  WatertightRay(const f32v3& rayOrigin, const f32v3& rayDirection)
+      : origin(rayOrigin)
+      , direction(rayDirection)
+  {
+    const f32v3 absDirection = glm::abs(direction);
+    kz = absDirection.x > absDirection.y ? (absDirection.x > absDirection.z ? 0 : 2)
+                                         : (absDirection.y > absDirection.z ? 1 : 2);
+    kx = (kz + 1) % 3;
+    ky = (kx + 1) % 3;
+    if (direction[kz] < 0.0f)
+    {
+      std::swap(kx, ky);
+    }
+    shear = f32v3(direction[kx] / direction[kz], direction[ky] / direction[kz], 1.0f / direction[kz]);
+  }
+};
+
+//! \brief Intersects a ray with a triangle without gaps or double hits along shared edges (Woop, Benthin, and Wald,
+//! Watertight Ray/Triangle Intersection, 2013). Both sides are hit.
+//! \param[out] t Ray parameter of the hit in [tMin, tMax).
+//! \param[out] barycentrics Weights of p1 and p2.
+inline bool intersectTriangle(const WatertightRay& ray, const f32v3& p0, const f32v3& p1, const f32v3& p2, f32 tMin,
+                              f32 tMax, f32& t, f32v2& barycentrics)
+{
+  const f32v3 a  = p0 - ray.origin;
+  const f32v3 b  = p1 - ray.origin;
+  const f32v3 c  = p2 - ray.origin;
+  const f32   ax = a[ray.kx] - ray.shear.x * a[ray.kz];
+  const f32   ay = a[ray.ky] - ray.shear.y * a[ray.kz];
+  const f32   bx = b[ray.kx] - ray.shear.x * b[ray.kz];
+  const f32   by = b[ray.ky] - ray.shear.y * b[ray.kz];
+  const f32   cx = c[ray.kx] - ray.shear.x * c[ray.kz];
+  const f32   cy = c[ray.ky] - ray.shear.y * c[ray.kz];
+
+  // Scaled barycentrics as 2D edge functions. On an edge, single precision cannot decide the sign.
+  f32 u = cx * by - cy * bx;
+  f32 v = ax * cy - ay * cx;
+  f32 w = bx * ay - by * ax;
+  if (u == 0.0f || v == 0.0f || w == 0.0f)
+  {
+    u = static_cast<f32>(f64(cx) * f64(by) - f64(cy) * f64(bx));
+    v = static_cast<f32>(f64(ax) * f64(cy) - f64(ay) * f64(cx));
+    w = static_cast<f32>(f64(bx) * f64(ay) - f64(by) * f64(ax));
+  }
+  if ((u < 0.0f || v < 0.0f || w < 0.0f) && (u > 0.0f || v > 0.0f || w > 0.0f))
+  {
+    return false;
+  }
+  const f32 det = u + v + w;
+  if (det == 0.0f)
+  {
+    return false;
+  }
+  const f32 invDet = 1.0f / det;
+  t                = (u * a[ray.kz] + v * b[ray.kz] + w * c[ray.kz]) * ray.shear.z * invDet;
+  barycentrics     = f32v2(v, w) * invDet;
+  return t >= tMin && t < tMax;
+}
+
+//! \brief A node yet to visit and the distance where the ray enters it.
+struct TraversalEntry
+{
+  ui32 nodeIdx;
+  f32  tEntry;
+};
+
+//! \brief Stack of entries yet to visit. Stacks larger than FixedSize fall back to the heap.
+template<class Entry = TraversalEntry, size_t FixedSize = 64> class TraversalStack
+{
+public:
+  explicit TraversalStack(size_t maxSize)
+  {
+    if (maxSize > FixedSize)
+    {
+      m_heapEntries.resize(maxSize);
+      m_entries = m_heapEntries.data();
+    }
+    else
+    {
+      m_entries = m_fixedEntries.data();
+    }
+  }
+
+  void push(const Entry& entry)
+  {
+    m_entries[m_size++] = entry;
+  }
+
+  Entry pop()
+  {
+    return m_entries[--m_size];
+  }
+
+  bool isEmpty() const
+  {
+    return m_size == 0;
+  }
+
+private:
+  std::array<Entry, FixedSize> m_fixedEntries;
+  std::vector<Entry>           m_heapEntries;
+  Entry*                       m_entries = nullptr;
+  size_t                       m_size    = 0;
+};
+
+//! \brief Work of traversals, for the statistics of the BVH quality.
+struct TraversalCounters
+{
+  //! Inner nodes and leaves that a ray entered.
+  ui64 nNodes      = 0;
+  //! Calls of intersectPrimitive.
+  ui64 nPrimitives = 0;
+};
+
+//! \brief Visits the leaves of a BVH that a ray overlaps, nearer children first.
+//!
+//! Nodes behind tCurrent are culled, so intersectPrimitive may shorten it. intersectPrimitive(primitiveIdx) returns
+//! true to end the traversal. If counters is not nullptr, the work is added to it.
+template<class IntersectPrimitive>
+void traverse(const BVH& bvh, const Ray& ray, const f32& tCurrent, const IntersectPrimitive& intersectPrimitive,
+              TraversalCounters* counters = nullptr)
+{
+  const auto& nodes = bvh.getNodes();
+  if (nodes.empty())
+  {
+    return;
+  }
+  const auto&      primitiveIndices = bvh.getPrimitiveIndices();
+  const f32v3      invDirection     = 1.0f / ray.direction;
+  // Every inner node on the path from the root pushes at most one entry.
+  TraversalStack<> stack(size_t(bvh.getStatistics().maxDepth) + 1);
+  f32              tEntry;
+  if (intersectBox(nodes[0].lowerLeftBottom, nodes[0].upperRightTop, ray.origin, invDirection, ray.tMin, tCurrent,
+                   tEntry))
+  {
+    stack.push({0, tEntry});
+  }
+  while (!stack.isEmpty())
+  {
+    const auto entry = stack.pop();
+    if (entry.tEntry > tCurrent)
+    {
+      continue;
+    }
+    const BVH::Node* node = &nodes[entry.nodeIdx];
+    while (!node->isLeaf())
+    {
+      if (counters != nullptr)
+      {
+        counters->nNodes++;
+      }
+      const BVH::Node& left  = nodes[node->leftFirst];
+      const BVH::Node& right = nodes[node->leftFirst + 1];
+      f32              tLeft, tRight;
+      const bool       hitLeft =
+          intersectBox(left.lowerLeftBottom, left.upperRightTop, ray.origin, invDirection, ray.tMin, tCurrent, tLeft);
+      const bool hitRight = intersectBox(right.lowerLeftBottom, right.upperRightTop, ray.origin, invDirection,
+                                         ray.tMin, tCurrent, tRight);
+      if (hitLeft && hitRight)
+      {
+        const bool leftFirst = tLeft <= tRight;
+        stack.push({leftFirst ? node->leftFirst + 1 : node->leftFirst, leftFirst ? tRight : tLeft});
+        node = leftFirst ? &left : &right;
+      }
+      else if (hitLeft || hitRight)
+      {
+        node = hitLeft ? &left : &right;
+      }
+      else
+      {
+        node = nullptr;
+        break;
+      }
+    }
+    if (node == nullptr)
+    {
+      continue;
+    }
+    if (counters != nullptr)
+    {
+      counters->nNodes++;
+    }
+    for (ui32 pIdx = node->leftFirst; pIdx < node->leftFirst + node->nPrimitives; pIdx++)
+    {
+      if (counters != nullptr)
+      {
+        counters->nPrimitives++;
+      }
+      if (intersectPrimitive(primitiveIndices[pIdx]))
+      {
+        return;
+      }
+    }
+  }
+}
+
+//! \brief Intersects a ray with the triangles of a BVH built from a mesh, see BVH::intersect().
+//!
+//! If counters is not nullptr, the work is added to it.
+inline bool intersectTriangles(const BVH& bvh, const TriangleMeshView& mesh, const Ray& ray, RayHit& hit,
+                               bool acceptFirstHit, TraversalCounters* counters = nullptr)
+{
+  const WatertightRay watertightRay(ray.origin, ray.direction);
+  bool                found = false;
+  traverse(
+      bvh, ray, hit.t,
+      [&](ui32 tIdx)
+      {
+        const ui32v3& triangle = mesh.triangles[tIdx];
+        f32           t;
+        f32v2         barycentrics;
+        if (!intersectTriangle(watertightRay, mesh.getPosition(triangle.x), mesh.getPosition(triangle.y),
+                               mesh.getPosition(triangle.z), ray.tMin, hit.t, t, barycentrics))
+        {
+          return false;
+        }
+        hit.t            = t;
+        hit.barycentrics = barycentrics;
+        hit.primitiveIdx = tIdx;
+        found            = true;
+        return acceptFirstHit;
+      },
+      counters);
+  return found;
+}
+} // namespace impl
+} // namespace gims
@@ -0,0 +1,375 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#include <gimslib/geometry/AABB.hpp>
+#include <gimslib/sys/CpuFeatures.hpp>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <limits>
+#include <vector>
+#ifdef GIMS_X64
+#include <immintrin.h>
+#endif
+
+namespace
+{
+using namespace gims;
+
+//! Number of positions per slice processed by one task when a thread pool is used. 3 MiB of packed positions.
+const size_t parallelSliceSize = size_t(1) << 18;
+
+// The kernels extend lo and hi by the positions. As in glm::min(lo, p), a NaN coordinate p never replaces the
+// accumulated value, so the vector kernels pass the new values as the first operand of min and max.
+
+void minMaxPackedScalar(const f32* positions, size_t nPositions, f32v3& lo, f32v3& hi)
+{
+  for (size_t pIdx = 0; pIdx < nPositions; pIdx++)
+  {
+    const f32v3 p(positions[3 * pIdx + 0], positions[3 * pIdx + 1], positions[3 * pIdx + 2]);
+    lo = glm::min(lo, p);
+    hi = glm::max(hi, p);
+  }
+}
+
+void minMaxStreamScalar(const f32* values, size_t nValues, f32& lo, f32& hi)
+{
+  for (size_t vIdx = 0; vIdx < nValues; vIdx++)
+  {
+    lo = glm::min(lo, values[vIdx]);
+    hi = glm::max(hi, values[vIdx]);
+  }
+}
+
+#ifdef GIMS_X64
+//! Folds the lanes of the accumulators of the stream kernels into lo and hi.
+void reduceStreamLanes(const f32* lanesLo, const f32* lanesHi, size_t nLanes, f32& lo, f32& hi)
+{
+  for (size_t k = 0; k < nLanes; k++)
+  {
+    lo = glm::min(lo, lanesLo[k]);
+    hi = glm::max(hi, lanesHi[k]);
+  }
+}
+
+//! Folds the lanes of the accumulators of the packed kernels into lo and hi. W consecutive vector registers cover
+//! 3 * W floats, so lane k of the concatenated registers holds coordinate k % 3.
+void reducePackedLanes(const f32* lanesLo, const f32* lanesHi, size_t nLanes, f32v3& lo, f32v3& hi)
+{
+  for (size_t k = 0; k < nLanes; k++)
+  {
+    lo[k % 3] = glm::min(lo[k % 3], lanesLo[k]);
+    hi[k % 3] = glm::max(hi[k % 3], lanesHi[k]);
+  }
+}
+
+//! Processes 4 positions, i.e., 3 SSE registers, per iteration.
+void minMaxPackedSSE(const f32* positions, size_t nPositions, f32v3& lo, f32v3& hi)
+{
+  const size_t nChunks = nPositions / 4;
+  __m128       lo0 = _mm_set1_ps(std::numeric_limits<f32>::max()), lo1 = lo0, lo2 = lo0;
+  __m128       hi0 = _mm_set1_ps(-std::numeric_limits<f32>::max()), hi1 = hi0, hi2 = hi0;
+  for (size_t cIdx = 0; cIdx < nChunks; cIdx++)
+  {
+    const f32*   chunk = positions + 12 * cIdx;
+    const __m128 a     = _mm_loadu_ps(chunk + 0);
+    const __m128 b     = _mm_loadu_ps(chunk + 4);
+    const __m128 c     = _mm_loadu_ps(chunk + 8);
+    lo0                = _mm_min_ps(a, lo0);
+    lo1                = _mm_min_ps(b, lo1);
+    lo2                = _mm_min_ps(c, lo2);
+    hi0                = _mm_max_ps(a, hi0);
+    hi1                = _mm_max_ps(b, hi1);
+    hi2                = _mm_max_ps(c, hi2);
+  }
+  alignas(16) f32 lanesLo[12], lanesHi[12];
+  _mm_store_ps(lanesLo + 0, lo0);
+  _mm_store_ps(lanesLo + 4, lo1);
+  _mm_store_ps(lanesLo + 8, lo2);
+  _mm_store_ps(lanesHi + 0, hi0);
+  _mm_store_ps(lanesHi + 4, hi1);
+  _mm_store_ps(lanesHi + 8, hi2);
+  reducePackedLanes(lanesLo, lanesHi, 12, lo, hi);
+  minMaxPackedScalar(positions + 12 * nChunks, nPositions - 4 * nChunks, lo, hi);
+}
+
+//! Processes 8 positions, i.e., 3 AVX registers, per iteration.
+GIMS_TARGET_AVX void minMaxPackedAVX(const f32* positions, size_t nPositions, f32v3& lo, f32v3& hi)
+{
+  const size_t nChunks = nPositions / 8;
+  __m256       lo0 = _mm256_set1_ps(std::numeric_limits<f32>::max()), lo1 = lo0, lo2 = lo0;
+  __m256       hi0 = _mm256_set1_ps(-std::numeric_limits<f32>::max()), hi1 = hi0, hi2 = hi0;
+  for (size_t cIdx = 0; cIdx < nChunks; cIdx++)
+  {
+    const f32*   chunk = positions + 24 * cIdx;
+    const __m256 a     = _mm256_loadu_ps(chunk + 0);
+    const __m256 b     = _mm256_loadu_ps(chunk + 8);
+    const __m256 c     = _mm256_loadu_ps(chunk + 16);
+    lo0                = _mm256_min_ps(a, lo0);
+    lo1                = _mm256_min_ps(b, lo1);
+    lo2                = _mm256_min_ps(c, lo2);
+    hi0                = _mm256_max_ps(a, hi0);
+    hi1                = _mm256_max_ps(b, hi1);
+    hi2                = _mm256_max_ps(c, hi2);
+  }
+  alignas(32) f32 lanesLo[24], lanesHi[24];
+  _mm256_store_ps(lanesLo + 0, lo0);
+  _mm256_store_ps(lanesLo + 8, lo1);
+  _mm256_store_ps(lanesLo + 16, lo2);
+  _mm256_store_ps(lanesHi + 0, hi0);
+  _mm256_store_ps(lanesHi + 8, hi1);
+  _mm256_store_ps(lanesHi + 16, hi2);
+  _mm256_zeroupper();
+  reducePackedLanes(lanesLo, lanesHi, 24, lo, hi);
+  minMaxPackedScalar(positions + 24 * nChunks, nPositions - 8 * nChunks, lo, hi);
+}
+
+void minMaxStreamSSE(const f32* values, size_t nValues, f32& lo, f32& hi)
+{
+  const size_t nChunks = nValues / 8;
+  __m128       lo0 = _mm_set1_ps(lo), lo1 = lo0;
+  __m128       hi0 = _mm_set1_ps(hi), hi1 = hi0;
+  for (size_t cIdx = 0; cIdx < nChunks; cIdx++)
+  {
+    const __m128 a = _mm_loadu_ps(values + 8 * cIdx);
+    const __m128 b = _mm_loadu_ps(values + 8 * cIdx + 4);
+    lo0            = _mm_min_ps(a, lo0);
+    lo1            = _mm_min_ps(b, lo1);
+    hi0            = _mm_max_ps(a, hi0);
+    hi1            = _mm_max_ps(b, hi1);
+  }
+  alignas(16) f32 lanesLo[4], lanesHi[4];
+  _mm_store_ps(lanesLo, _mm_min_ps(lo0, lo1));
+  _mm_store_ps(lanesHi, _mm_max_ps(hi0, hi1));
+  reduceStreamLanes(lanesLo, lanesHi, 4, lo, hi);
+  minMaxStreamScalar(values + 8 * nChunks, nValues - 8 * nChunks, lo, hi);
+}
+
+GIMS_TARGET_AVX void minMaxStreamAVX(const f32* values, size_t nValues, f32& lo, f32& hi)
+{
+  const size_t nChunks = nValues / 16;
+  __m256       lo0 = _mm256_set1_ps(lo), lo1 = lo0;
+  __m256       hi0 = _mm256_set1_ps(hi), hi1 = hi0;
+  for (size_t cIdx = 0; cIdx < nChunks; cIdx++)
+  {
+    const __m256 a = _mm256_loadu_ps(values + 16 * cIdx);
+    const __m256 b = _mm256_loadu_ps(values + 16 * cIdx + 8);
+    lo0            = _mm256_min_ps(a, lo0);
+    lo1            = _mm256_min_ps(b, lo1);
+    hi0            = _mm256_max_ps(a, hi0);
+    hi1            = _mm256_max_ps(b, hi1);
+  }
+  alignas(32) f32 lanesLo[8], lanesHi[8];
+  _mm256_store_ps(lanesLo, _mm256_min_ps(lo0, lo1));
+  _mm256_store_ps(lanesHi, _mm256_max_ps(hi0, hi1));
+  _mm256_zeroupper();
+  reduceStreamLanes(lanesLo, lanesHi, 8, lo, hi);
+  minMaxStreamScalar(values + 16 * nChunks, nValues - 16 * nChunks, lo, hi);
+}
+#endif
+
+void minMaxPacked(const f32* positions, size_t nPositions, f32v3& lo, f32v3& hi)
+{
+#ifdef GIMS_X64
+  if (getCpuFeatures().avx)
+  {
+    minMaxPackedAVX(positions, nPositions, lo, hi);
+  }
+  else
+  {
+    minMaxPackedSSE(positions, nPositions, lo, hi);
+  }
+#else
+  minMaxPackedScalar(positions, nPositions, lo, hi);
+#endif
+}
+
+void minMaxStream(const f32* values, size_t nValues, f32& lo, f32& hi)
+{
+#ifdef GIMS_X64
+  if (getCpuFeatures().avx)
+  {
+    minMaxStreamAVX(values, nValues, lo, hi);
+  }
+  else
+  {
+    minMaxStreamSSE(values, nValues, lo, hi);
+  }
+#else
+  minMaxStreamScalar(values, nValues, lo, hi);
+#endif
+}
+
+//! False for the boxes created by AABB() and for the boxes of empty position arrays.
+inline bool isValid(const f32v3& lo, const f32v3& hi)
+{
+  return lo.x <= hi.x && lo.y <= hi.y && lo.z <= hi.z;
+}
+
+//! \brief Bounds the box [lo, hi] transformed by the affine matrix m.
+//!
+//! The center c moves to m * c. A corner c + s * e with s in {-1, 1}^3 moves to m * c + M * (s * e), where M is the
+//! upper 3x3 block of m. Component i of M * (s * e) is at most sum_j |M_ij| e_j, so the half extent of the result is
+//! |M| * e. The bound is attained by a corner, so the result is tight.
+inline void transformBox(const f32v3& lo, const f32v3& hi, const f32m4& m, f32v3& transformedLo, f32v3& transformedHi)
+{
+  const f32v3 c = (lo + hi) * 0.5f;
+  const f32v3 e = (hi - lo) * 0.5f;
+#ifdef GIMS_X64
+  // glm matrices are column-major, so every column is one register.
+  const __m128 signMask = _mm_set1_ps(-0.0f);
+  const __m128 col0     = _mm_loadu_ps(&m[0].x);
+  const __m128 col1     = _mm_loadu_ps(&m[1].x);
+  const __m128 col2     = _mm_loadu_ps(&m[2].x);
+  const __m128 col3     = _mm_loadu_ps(&m[3].x);
+  const __m128 center   = _mm_add_ps(_mm_add_ps(_mm_mul_ps(col0, _mm_set1_ps(c.x)), _mm_mul_ps(col1, _mm_set1_ps(c.y))),
+                                     _mm_add_ps(_mm_mul_ps(col2, _mm_set1_ps(c.z)), col3));
+  const __m128 extent   = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, col0), _mm_set1_ps(e.x)),
+                                                _mm_mul_ps(_mm_andnot_ps(signMask, col1), _mm_set1_ps(e.y))),
+                                     _mm_mul_ps(_mm_andnot_ps(signMask, col2), _mm_set1_ps(e.z)));
+  alignas(16) f32 resultLo[4], resultHi[4];
+  _mm_store_ps(resultLo, _mm_sub_ps(center, extent));
+  _mm_store_ps(resultHi, _mm_add_ps(center, extent));
+  transformedLo = f32v3(resultLo[0], resultLo[1], resultLo[2]);
+  transformedHi = f32v3(resultHi[0], resultHi[1], resultHi[2]);
+#else
+  const f32v3 center = f32v3(m * f32v4(c, 1.0f));
+  const f32v3 extent = glm::abs(f32v3(m[0])) * e.x + glm::abs(f32v3(m[1])) * e.y + glm::abs(f32v3(m[2])) * e.z;
+  transformedLo      = center - extent;
+  transformedHi      = center + extent;
+#endif
+}
+
+//! Calls computeSlice(begin, end) for slices of [0, nPositions), concurrently if a thread pool is given and the
+//! input is large, and returns the union of the results.
+template <class F> AABB computeSliced(size_t nPositions, ThreadPool* threadPool, const F& computeSlice)
+{
+  if (threadPool == nullptr || nPositions <= parallelSliceSize)
+  {
+    return computeSlice(0, nPositions);
+  }
+  std::vector<AABB> slices((nPositions + parallelSliceSize - 1) / parallelSliceSize);
+  threadPool->parallelFor(nPositions, parallelSliceSize,
+                          [&](size_t begin, size_t end)
+                          { slices[begin / parallelSliceSize] = computeSlice(begin, end); });
+  AABB result;
+  for (const auto& slice : slices)
+  {
+    result = result.getUnion(slice);
+  }
+  return result;
+}
+} // namespace
+
+namespace gims
+{
+AABB::AABB()
+    : m_lowerLeftBottom(std::numeric_limits<f32>::max())
+    , m_upperRightTop(-std::numeric_limits<f32>::max())
+{
+}
+
+AABB::AABB(const f32v3& lowerLeftBottom, const f32v3& upperRightTop)
+    : m_lowerLeftBottom(lowerLeftBottom)
+    , m_upperRightTop(upperRightTop)
+{
+}
+
+AABB::AABB(f32v3 const* const positions, size_t nPositions, ThreadPool* threadPool)
+{
+  static_assert(sizeof(f32v3) == 3 * sizeof(f32), "The kernels expect packed xyz triples.");
+  *this = computeSliced(nPositions, threadPool,
+                        [positions](size_t begin, size_t end)
+                        {
+                          AABB       result;
+                          const f32* slice = reinterpret_cast<const f32*>(positions) + 3 * begin;
+                          minMaxPacked(slice, end - begin, result.m_lowerLeftBottom, result.m_upperRightTop);
+                          return result;
+                        });
+}
+
+AABB::AABB(f32 const* const x, f32 const* const y, f32 const* const z, size_t nPositions, ThreadPool* threadPool)
+{
+  *this = computeSliced(nPositions, threadPool,
+                        [x, y, z](size_t begin, size_t end)
+                        {
+                          AABB result;
+                          minMaxStream(x + begin, end - begin, result.m_lowerLeftBottom.x, result.m_upperRightTop.x);
+                          minMaxStream(y + begin, end - begin, result.m_lowerLeftBottom.y, result.m_upperRightTop.y);
+                          minMaxStream(z + begin, end - begin, result.m_lowerLeftBottom.z, result.m_upperRightTop.z);
+                          return result;
+                        });
+}
+
+f32m4 AABB::getNormalizationTransformation() const
+{
+  // Scale to [-0.5,...,0.5]^3
+  const f32v3 diagonalDistance = m_upperRightTop - m_lowerLeftBottom;
+  const f32   maxDimension     = glm::max(glm::max(diagonalDistance.x, diagonalDistance.y), diagonalDistance.z);
+  const f32   scalingFactor    = 1.0f / maxDimension;
+  const f32m4 scale            = glm::scale(f32m4(1.0f), f32v3(scalingFactor));
+
+  // Translate center
+  const f32v3 center      = (m_upperRightTop + m_lowerLeftBottom) / 2.0f;
+  const f32m4 translation = glm::translate(f32m4(1.0f), -center);
+
+  return scale * translation;
+}
+
+AABB AABB::getUnion(const AABB& other) const
+{
+  AABB result;
+  result.m_lowerLeftBottom = glm::min(m_lowerLeftBottom, other.m_lowerLeftBottom);
+  result.m_upperRightTop   = glm::max(m_upperRightTop, other.m_upperRightTop);
+  return result;
+}
+
+const f32v3& AABB::getLowerLeftBottom() const
+{
+  return m_lowerLeftBottom;
+}
+
+const f32v3& AABB::getUpperRightTop() const
+{
+  return m_upperRightTop;
+}
+
+AABB AABB::getTransformed(const f32m4& transformation) const
+{
+  AABB result;
+  getTransformed(this, &transformation, 1, &result);
+  return result;
+}
+
+void AABB::getTransformed(const AABB* aabbs, const f32m4* transformations, size_t nAABBs, AABB* transformedAABBs)
+{
+  for (size_t bIdx = 0; bIdx < nAABBs; bIdx++)
+  {
+    const AABB& aabb = aabbs[bIdx];
+    if (!isValid(aabb.m_lowerLeftBottom, aabb.m_upperRightTop))
+    {
+      transformedAABBs[bIdx] = AABB();
+      continue;
+    }
+    f32v3 lo, hi;
+    transformBox(aabb.m_lowerLeftBottom, aabb.m_upperRightTop, transformations[bIdx], lo, hi);
+    transformedAABBs[bIdx] = AABB(lo, hi);
+  }
+}
+
+AABB AABB::getTransformedUnion(const AABB* aabbs, const f32m4* transformations, size_t nAABBs)
+{
+  f32v3 lo(std::numeric_limits<f32>::max());
+  f32v3 hi(-std::numeric_limits<f32>::max());
+  for (size_t bIdx = 0; bIdx < nAABBs; bIdx++)
+  {
+    const AABB& aabb = aabbs[bIdx];
+    if (isValid(aabb.m_lowerLeftBottom, aabb.m_upperRightTop))
+    {
+      f32v3 transformedLo, transformedHi;
+      transformBox(aabb.m_lowerLeftBottom, aabb.m_upperRightTop, transformations[bIdx], transformedLo, transformedHi);
+      lo = glm::min(lo, transformedLo);
+      hi = glm::max(hi, transformedHi);
+    }
+  }
+  return AABB(lo, hi);
+}
+} // namespace gims
@@ -0,0 +1,169 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#include <atomic>
+#include <cmath>
+#include <gimslib/geometry/AABB.hpp>
+#include <gimslib/io/CograBinaryMeshBatchLoader.hpp>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+
+namespace
+{
+using namespace gims;
+
+void validate(const CograBinaryMeshFile& mesh, const std::string& fileName)
+{
+  const auto* positions = mesh.getPositionsPtr();
+  for (size_t i = 0; i < size_t(mesh.getNumVertices()) * 3; i++)
+  {
+    if (!std::isfinite(positions[i]))
+    {
+      throw std::runtime_error("Non-finite vertex position in " + fileName + ".");
+    }
+  }
+  const auto* indices = mesh.getTriangleIndices();
+  for (size_t i = 0; i < size_t(mesh.getNumTriangles()) * 3; i++)
+  {
+    if (indices[i] >= mesh.getNumVertices())
+    {
+      throw std::runtime_error("Vertex index out of range in " + fileName + ".");
+    }
+  }
+}
+} // namespace
+
+namespace gims
+{
+CograBinaryMeshBatchLoader::CograBinaryMeshBatchLoader(ThreadPool& threadPool, CograBinaryMeshLoadOptions options)
+    : m_threadPool(threadPool)
+    , m_options(options)
+{
+}
+
+std::vector<std::future<LoadedCograBinaryMesh>> CograBinaryMeshBatchLoader::load(
+    const std::vector<std::string>& fileNames)
+{
+  std::vector<std::future<LoadedCograBinaryMesh>> result;
+  result.reserve(fileNames.size());
+  for (const auto& fileName : fileNames)
+  {
+    result.push_back(m_threadPool.submit([fileName, options = m_options]() { return loadFile(fileName, options); }));
+  }
+  return result;
+}
+
+std::future<void> CograBinaryMeshBatchLoader::load(const std::vector<std::string>& fileNames,
+                                                   CompletionCallback onLoaded, ErrorCallback onError)
+{
+  // Shared by all tasks. The task that finishes last fulfills the promise.
+  struct Batch
+  {
+    CompletionCallback  onLoaded;
+    ErrorCallback       onError;
+    std::atomic<size_t> nRemaining;
+    std::promise<void>  done;
+    std::mutex          callbackErrorMutex;
+    std::exception_ptr  callbackError; //! First exception that escaped a callback.
+  };
+  auto batch        = std::make_shared<Batch>();
+  batch->onLoaded   = std::move(onLoaded);
+  batch->onError    = std::move(onError);
+  batch->nRemaining = fileNames.size();
+  auto result       = batch->done.get_future();
+  if (fileNames.empty())
+  {
+    batch->done.set_value();
+    return result;
+  }
+
+  for (size_t fileIdx = 0; fileIdx < fileNames.size(); fileIdx++)
+  {
+    m_threadPool.enqueue(
+        [batch, fileIdx, fileName = fileNames[fileIdx], options = m_options]()
+        {
+          // Errors of the callbacks must not skip the countdown, or the promise is never fulfilled.
+          try
+          {
+            std::optional<LoadedCograBinaryMesh> loaded;
+            std::exception_ptr                   loadError;
+            try
+            {
+              loaded = loadFile(fileName, options);
+            }
+            catch (...)
+            {
+              loadError = std::current_exception();
+            }
+            if (loadError)
+            {
+              batch->onError(fileIdx, loadError);
+            }
+            else
+            {
+              batch->onLoaded(fileIdx, std::move(*loaded));
+            }
+          }
+          catch (...)
+          {
+            const std::lock_guard<std::mutex> lock(batch->callbackErrorMutex);
+            if (!batch->callbackError)
+            {
+              batch->callbackError = std::current_exception();
+            }
+          }
+          if (batch->nRemaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+          {
+            if (batch->callbackError)
+            {
+              batch->done.set_exception(batch->callbackError);
+            }
+            else
+            {
+              batch->done.set_value();
+            }
+          }
+        });
+  }
+  return result;
+}
+
+LoadedCograBinaryMesh CograBinaryMeshBatchLoader::loadFile(const std::string&                fileName,
+                                                           const CograBinaryMeshLoadOptions& options)
+{
+  LoadedCograBinaryMesh result;
+  result.fileName = fileName;
+  if (options.map)
+  {
+    result.mesh = CograBinaryMeshFile::map(fileName, options.verifyChecksums);
+  }
+  else
+  {
+    result.mesh.load(fileName);
+  }
+  if (options.validate)
+  {
+    validate(result.mesh, fileName);
+  }
+
+  const AABB aabb(reinterpret_cast<const f32v3*>(result.mesh.getPositionsPtr()), result.mesh.getNumVertices());
+  result.aabbMin = aabb.getLowerLeftBottom();
+  result.aabbMax = aabb.getUpperRightTop();
+
+  // Same as AABB::getNormalizationTransformation(), but also defined for empty and flat boxes.
+  result.normalizationTransformation = f32m4(1.0f);
+  if (result.mesh.getNumVertices() > 0)
+  {
+    const f32v3 diagonal     = result.aabbMax - result.aabbMin;
+    const f32   maxDimension = glm::max(glm::max(diagonal.x, diagonal.y), diagonal.z);
+    const f32   scaling      = maxDimension > 0.0f ? 1.0f / maxDimension : 1.0f;
+    const f32v3 center       = (result.aabbMax + result.aabbMin) * 0.5f;
+    result.normalizationTransformation =
+        glm::scale(f32m4(1.0f), f32v3(scaling)) * glm::translate(f32m4(1.0f), -center);
+  }
+  return result;
+}
+} // namespace gims
@@ -4,52 +4,186 @@
 #include <algorithm>
 #include <cstring>
 #include <fstream>
+#include <functional>
 #include <gimslib/io/CograBinaryMeshFile.hpp>
+#include <gimslib/sys/Hash.hpp>
+#include <gimslib/sys/MappedFile.hpp>
+#include <gimslib/sys/ThreadPool.hpp>
 #include <istream>
+#include <limits>
 #include <ostream>
+#include <stdexcept>
+#include <utility>
+
+#include "impl/CograBinaryMeshCodec.hpp"
+#include "impl/CograBinaryMeshFormat.hpp"
+
+namespace
+{
+//! Walks over the bytes of a mapped file and hands out pointers to consecutive sections.
+class MappedSectionReader
+{
+public:
+  MappedSectionReader(gims::ui8* data, size_t size)
+      : m_begin(data)
+      , m_current(data)
+      , m_end(data + size)
+  {
+  }
+
+  //! Returns a pointer to count elements of type T at offset bytes from the beginning.
+  template<class T> T* at(size_t offset, size_t count) const
+  {
+    const size_t size = static_cast<size_t>(m_end - m_begin);
+    if (offset > size || size - offset < sizeof(T) * count)
+    {
+      throw std::runtime_error("Section exceeds the mapped file.");
+    }
+    return reinterpret_cast<T*>(m_begin + offset);
+  }
+
+  //! Returns a pointer to the next count elements of type T and advances behind them.
+  template<class T> T* take(size_t count)
+  {
+    const size_t nBytes = sizeof(T) * count;
+    if (static_cast<size_t>(m_end - m_current) < nBytes)
+    {
+      throw std::runtime_error("Unexpected end of mapped file.");
+    }
+    T* result = reinterpret_cast<T*>(m_current);
+    m_current += nBytes;
+    return result;
+  }
+
+  //! Reads a single value. The value does not need to be aligned.
+  template<class T> T read()
+  {
+    T value;
+    std::memcpy(&value, take<gims::ui8>(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  //! Copies count consecutive values into the vector dst.
+  template<class T> void read(std::vector<T>& dst, size_t count)
+  {
+    const gims::ui8* src = take<gims::ui8>(sizeof(T) * count);
+    dst.resize(count);
+    if (count != 0)
+    {
+      std::memcpy(dst.data(), src, sizeof(T) * count);
+    }
+  }
+
+private:
+  gims::ui8* m_begin;
+  gims::ui8* m_current;
+  gims::ui8* m_end;
+};
+
+//! Decodes the encoded payload of a V2 section to decodedSize bytes at dst. encoded and dst may be the same for raw
+//! sections.
+void decodeSection(const gims::impl::cbm::SectionEntryV2& section, const gims::ui8* encoded, void* dst,
+                   gims::ui64 decodedSize)
+{
+  using namespace gims;
+  using namespace gims::impl::cbm;
+  const auto unexpectedSize = []() { return std::runtime_error("A .cbm section has an unexpected size."); };
+  switch (section.encoding)
+  {
+  case ENCODING_RAW:
+    if (section.size != decodedSize)
+    {
+      throw unexpectedSize();
+    }
+    if (encoded != dst)
+    {
+      std::memcpy(dst, encoded, decodedSize);
+    }
+    break;
+  case ENCODING_DELTA_VARINT:
+  {
+    const size_t count    = decodedSize / sizeof(ui32);
+    ui32         previous = 0;
+    size_t       nDecoded = 0;
+    const size_t consumed = decodeDeltaVarint(encoded, section.size, (ui32*)dst, count, previous, nDecoded);
+    if (nDecoded != count || consumed != section.size)
+    {
+      throw unexpectedSize();
+    }
+    break;
+  }
+  case ENCODING_QUANTIZED_AABB16:
+  {
+    const size_t nVertices = decodedSize / (3 * sizeof(f32));
+    if (section.size != sizeof(PositionQuantization) + nVertices * 3 * sizeof(ui16))
+    {
+      throw unexpectedSize();
+    }
+    PositionQuantization quantization;
+    std::memcpy(&quantization, encoded, sizeof(quantization));
+    dequantizePositions((const ui16*)(encoded + sizeof(quantization)), nVertices, quantization, (f32*)dst);
+    break;
+  }
+  case ENCODING_OCTAHEDRAL16:
+  {
+    const size_t n = decodedSize / (3 * sizeof(f32));
+    if (section.components != 3 || section.componentSize != sizeof(f32) || section.size != n * 2 * sizeof(i16))
+    {
+      throw unexpectedSize();
+    }
+    decodeOctahedral((const i16*)encoded, n, (f32*)dst);
+    break;
+  }
+  default:
+    throw std::runtime_error("Unsupported .cbm section encoding " + std::to_string(section.encoding) + ".");
+  }
+}
+//! Blocks are aligned to this many bytes within the arena.
+constexpr size_t ARENA_ALIGNMENT = 16;
+
+//! Rounds size up to the next multiple of ARENA_ALIGNMENT.
+inline size_t alignBlock(size_t size)
+{
+  return (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+}
+} // namespace
 
 namespace gims
 {
 
 CograBinaryMeshFile::CograBinaryMeshFile(const CograBinaryMeshFile& other)
+    : m_positions(other.m_positions)
+    , m_triangles(other.m_triangles)
+    , m_attributes(other.m_attributes)
+    , m_constants(other.m_constants)
 {
-  m_positions              = other.m_positions;
-  m_triangles              = other.m_triangles;
-  m_attributeComponents    = other.m_attributeComponents;
-  m_attributeComponentSize = other.m_attributeComponentSize;
-  m_constantComponents     = other.m_constantComponents;
-  m_constantComponentSize  = other.m_constantComponentSize;
-
-  for (size_t i = 0; i < other.m_attributes.size(); i++)
+  if (other.m_mappedFile)
   {
-    const auto nBytes   = m_attributeComponents[i] * m_attributeComponentSize[i] * getNumVertices();
-    m_attributes[i]     = new ui8[nBytes];
-    m_attributeNames[i] = new char[N_CHARS];
-    std::copy(other.m_attributes[i], other.m_attributes[i] + nBytes, m_attributes[i]);
-    std::copy(other.m_attributeNames[i], other.m_attributeNames[i] + sizeof(char) * N_CHARS, m_attributeNames[i]);
+    // Copies never share the copy-on-write pages of a mapping, so modifications stay private to each copy.
+    m_mappedFile = other.m_mappedFile;
+    detach();
+    return;
   }
-
-  for (SizeType i = 0; i < getNumConstants(); i++)
+  m_arenaSize     = other.m_arenaSize;
+  m_arenaCapacity = other.m_arenaSize;
+  m_arenaGarbage  = other.m_arenaGarbage;
+  if (m_arenaSize != 0)
   {
-    const auto nBytes  = m_constantComponents[i] * m_constantComponentSize[i];
-    m_constants[i]     = new ui8[nBytes];
-    m_constantNames[i] = new char[N_CHARS];
-    std::copy(other.m_constants[i], other.m_constants[i] + nBytes, m_constants[i]);
-    std::copy(other.m_constantNames[i], other.m_constantNames[i] + sizeof(char) * N_CHARS, m_constantNames[i]);
+    m_arena.reset(new ui8[m_arenaSize]);
+    std::memcpy(m_arena.get(), other.m_arena.get(), m_arenaSize);
   }
 }
 
 CograBinaryMeshFile::CograBinaryMeshFile(CograBinaryMeshFile&& other) noexcept
-    : m_positions(std::exchange(other.m_positions, {}))
+    : m_arena(std::exchange(other.m_arena, {}))
+    , m_arenaSize(std::exchange(other.m_arenaSize, 0))
+    , m_arenaCapacity(std::exchange(other.m_arenaCapacity, 0))
+    , m_arenaGarbage(std::exchange(other.m_arenaGarbage, 0))
+    , m_mappedFile(std::exchange(other.m_mappedFile, {}))
+    , m_positions(std::exchange(other.m_positions, {}))
     , m_triangles(std::exchange(other.m_triangles, {}))
     , m_attributes(std::exchange(other.m_attributes, {}))
-    , m_attributeComponents(std::exchange(other.m_attributeComponents, {}))
-    , m_attributeComponentSize(std::exchange(other.m_attributeComponentSize, {}))
-    , m_attributeNames(std::exchange(m_attributeNames, {}))
-    , m_constants(std::exchange(m_constants, {}))
-    , m_constantComponents(std::exchange(m_constantComponents, {}))
-    , m_constantComponentSize(std::exchange(m_constantComponentSize, {}))
-    , m_constantNames(std::exchange(m_constantNames, {}))
+    , m_constants(std::exchange(other.m_constants, {}))
 {
 }
 
@@ -58,15 +192,12 @@ CograBinaryMeshFile::CograBinaryMeshFile(const std::string& fileName)
   load(fileName);
 }
 
-CograBinaryMeshFile::~CograBinaryMeshFile()
-{
-  freeAttributes();
-  freeConstants();
-}
+CograBinaryMeshFile::~CograBinaryMeshFile() = default;
 
-CograBinaryMeshFile& CograBinaryMeshFile::operator=(CograBinaryMeshFile other)
+CograBinaryMeshFile& CograBinaryMeshFile::operator=(const CograBinaryMeshFile& other)
 {
-  other.swap(*this);
+  CograBinaryMeshFile copy(other);
+  copy.swap(*this);
   return *this;
 }
 
@@ -78,16 +209,15 @@ CograBinaryMeshFile& CograBinaryMeshFile::operator=(CograBinaryMeshFile&& other)
 
 void CograBinaryMeshFile::swap(CograBinaryMeshFile& other)
 {
-  m_positions.swap(other.m_positions);
-  m_triangles.swap(other.m_triangles);
+  m_arena.swap(other.m_arena);
+  std::swap(m_arenaSize, other.m_arenaSize);
+  std::swap(m_arenaCapacity, other.m_arenaCapacity);
+  std::swap(m_arenaGarbage, other.m_arenaGarbage);
+  m_mappedFile.swap(other.m_mappedFile);
+  std::swap(m_positions, other.m_positions);
+  std::swap(m_triangles, other.m_triangles);
   m_attributes.swap(other.m_attributes);
-  m_attributeComponents.swap(other.m_attributeComponents);
-  m_attributeComponentSize.swap(other.m_attributeComponentSize);
-  m_attributeNames.swap(other.m_attributeNames);
   m_constants.swap(other.m_constants);
-  m_constantComponents.swap(other.m_constantComponents);
-  m_constantComponentSize.swap(other.m_constantComponentSize);
-  m_constantNames.swap(other.m_constantNames);
 }
 
 void CograBinaryMeshFile::load(const std::string& fileName)
@@ -101,269 +231,938 @@ void CograBinaryMeshFile::load(const std::string& fileName)
   }
   inFile.exceptions(std::ifstream::eofbit | std::ifstream::failbit | std::ifstream::badbit);
 
+  char magic[sizeof(impl::cbm::MAGIC)];
+  inFile.read(magic, sizeof(magic));
+  inFile.seekg(0);
+  if (impl::cbm::isV2(magic))
+  {
+    inFile.seekg(0, std::ios::end);
+    const ui64 fileSize = static_cast<ui64>(inFile.tellg());
+    readV2(
+        [&](ui64 offset, ui64 size, void* dst)
+        {
+          inFile.seekg(offset);
+          inFile.read((char*)dst, size);
+        },
+        fileSize, true);
+    return;
+  }
+
   readHeader(inFile);
   // read vertices
-  inFile.read((char*)&m_positions[0], sizeof(FloatType) * 3 * getNumVertices());
-  inFile.read((char*)&m_triangles[0], sizeof(IndexType) * 3 * getNumTriangles());
+  inFile.read((char*)getPositionsPtr(), m_positions.size);
+  inFile.read((char*)getTriangleIndices(), m_triangles.size);
 
   for (SizeType i = 0; i < getNumAttributes(); i++)
   {
-    inFile.read((char*)m_attributes[i], getAttributeElementSize(i) * getNumVertices());
+    inFile.read((char*)getAttributePtr(i), m_attributes[i].data.size);
   }
 
   for (SizeType i = 0; i < getNumConstants(); i++)
   {
-    inFile.read((char*)m_constants[i], getConstantElementSize(i));
+    inFile.read((char*)getConstant(i), m_constants[i].data.size);
   }
 }
 
-void CograBinaryMeshFile::save(const std::string& fileName)
+void CograBinaryMeshFile::save(const std::string& fileName, FileVersion version, ui32 compression)
 {
+  if (compression != COMPRESS_NONE && version != FileVersion::V2)
+  {
+    throw std::runtime_error("Compressed .cbm files require FileVersion::V2.");
+  }
   std::ofstream outFile;
   outFile.open(fileName, std::ios::out | std::ios::binary);
+  if (version == FileVersion::V2)
+  {
+    writeV2(outFile, compression);
+    outFile.close();
+    return;
+  }
   writeHeader(outFile);
-  outFile.write((const char*)&m_positions[0], sizeof(FloatType) * 3 * getNumVertices());
-  outFile.write((const char*)&m_triangles[0], sizeof(IndexType) * 3 * getNumTriangles());
+  outFile.write((const char*)getPositionsPtr(), m_positions.size);
+  outFile.write((const char*)getTriangleIndices(), m_triangles.size);
   for (SizeType i = 0; i < getNumAttributes(); i++)
   {
-    SizeType size = getAttributeElementSize(i) * getNumVertices();
-    outFile.write((const char*)m_attributes[i], size);
+    outFile.write((const char*)getAttributePtr(i), m_attributes[i].data.size);
   }
 
   for (SizeType i = 0; i < getNumConstants(); i++)
   {
-    SizeType size = getConstantElementSize(i);
-    outFile.write((const char*)m_constants[i], size);
+    outFile.write((const char*)getConstant(i), m_constants[i].data.size);
   }
   outFile.close();
 }
 
+CograBinaryMeshFile CograBinaryMeshFile::map(const std::string& fileName, bool verifyChecksums)
+{
+  CograBinaryMeshFile result;
+  result.m_mappedFile = std::make_shared<MappedFile>(fileName);
+  result.mapSections(verifyChecksums);
+  return result;
+}
+
+bool CograBinaryMeshFile::isMapped() const
+{
+  return m_mappedFile != nullptr;
+}
+
+void CograBinaryMeshFile::mapSections(bool verifyChecksums)
+{
+  if (m_mappedFile->size() >= sizeof(impl::cbm::MAGIC) && impl::cbm::isV2(m_mappedFile->data()))
+  {
+    mapSectionsV2(verifyChecksums);
+    return;
+  }
+  MappedSectionReader reader(m_mappedFile->data(), m_mappedFile->size());
+
+  // The blocks refer to the mapping, the layout is the one of readHeader().
+  const auto readElements = [&](std::vector<Element>& elements)
+  {
+    const size_t nElements = reader.read<SizeType>();
+    elements.resize(nElements);
+    for (auto& e : elements)
+    {
+      e.components = reader.read<SizeType>();
+    }
+    for (auto& e : elements)
+    {
+      e.componentSize = reader.read<SizeType>();
+    }
+    for (auto& e : elements)
+    {
+      e.name = getMappedBlock(reader.take<char>(N_CHARS), N_CHARS);
+    }
+  };
+
+  const size_t nV = reader.read<SizeType>();
+  const size_t nT = reader.read<SizeType>();
+  readElements(m_attributes);
+  readElements(m_constants);
+
+  m_positions = getMappedBlock(reader.take<FloatType>(3 * nV), 3 * nV * sizeof(FloatType));
+  m_triangles = getMappedBlock(reader.take<IndexType>(3 * nT), 3 * nT * sizeof(IndexType));
+  for (auto& a : m_attributes)
+  {
+    const size_t size = size_t(a.components) * a.componentSize * nV;
+    a.data            = getMappedBlock(reader.take<ui8>(size), size);
+  }
+  for (auto& c : m_constants)
+  {
+    const size_t size = size_t(c.components) * c.componentSize;
+    c.data            = getMappedBlock(reader.take<ui8>(size), size);
+  }
+}
+
+void CograBinaryMeshFile::mapSectionsV2(bool verifyChecksums)
+{
+  using namespace impl::cbm;
+  MappedSectionReader reader(m_mappedFile->data(), m_mappedFile->size());
+
+  const auto header = reader.read<FileHeaderV2>();
+  if (header.version != VERSION_2)
+  {
+    throw std::runtime_error("Unsupported .cbm version " + std::to_string(header.version) + ".");
+  }
+  checkSectionDirectory(header.nSections, m_mappedFile->size());
+  std::vector<SectionEntryV2> sections;
+  reader.read(sections, header.nSections);
+  checkMeshSections(header, sections, m_mappedFile->size());
+
+  if (std::any_of(sections.begin(), sections.end(),
+                  [](const SectionEntryV2& section) { return section.encoding != ENCODING_RAW; }))
+  {
+    // Compressed sections cannot be referenced in place. They are decoded into memory owned by this object, which
+    // releases the mapping. The local reference keeps the mapping alive while decoding.
+    const auto mappedFile = m_mappedFile;
+    readV2([&](ui64 offset, ui64 size, void* dst) { std::memcpy(dst, reader.at<ui8>(offset, size), size); },
+           mappedFile->size(), verifyChecksums);
+    return;
+  }
+
+  const auto payload = [&](const SectionEntryV2& section, ui64 expectedSize) -> Block
+  {
+    if (section.size != expectedSize)
+    {
+      throw std::runtime_error("A .cbm section has an unexpected size.");
+    }
+    auto* data = reader.at<ui8>(section.offset, section.size);
+    if (verifyChecksums && hash64(data, section.size) != section.hash)
+    {
+      throw std::runtime_error("Checksum mismatch in .cbm section.");
+    }
+    return getMappedBlock(data, section.size);
+  };
+
+  Block             names;
+  const ui64        nV = header.nVertices;
+  const ui64        nT = header.nTriangles;
+  std::vector<ui32> attributeNameOffsets;
+  std::vector<ui32> constantNameOffsets;
+  for (const auto& section : sections)
+  {
+    switch (section.type)
+    {
+    case SECTION_NAMES:
+      names = payload(section, section.size);
+      break;
+    case SECTION_POSITIONS:
+      m_positions = payload(section, 3 * nV * sizeof(FloatType));
+      break;
+    case SECTION_TRIANGLES:
+      m_triangles = payload(section, 3 * nT * sizeof(IndexType));
+      break;
+    case SECTION_ATTRIBUTE:
+      m_attributes.push_back({section.components, section.componentSize,
+                              payload(section, ui64(section.components) * section.componentSize * nV), {}});
+      attributeNameOffsets.push_back(section.nameOffset);
+      break;
+    case SECTION_CONSTANT:
+      m_constants.push_back({section.components, section.componentSize,
+                             payload(section, ui64(section.components) * section.componentSize), {}});
+      constantNameOffsets.push_back(section.nameOffset);
+      break;
+    default:
+      // Sections unknown to this version are skipped.
+      break;
+    }
+  }
+
+  const auto name = [&](ui32 nameOffset) -> Block
+  {
+    if (size_t(nameOffset) + N_CHARS > names.size)
+    {
+      throw std::runtime_error("A .cbm name exceeds the names section.");
+    }
+    return {names.offset + nameOffset, N_CHARS};
+  };
+  for (size_t i = 0; i < m_attributes.size(); i++)
+  {
+    m_attributes[i].name = name(attributeNameOffsets[i]);
+  }
+  for (size_t i = 0; i < m_constants.size(); i++)
+  {
+    m_constants[i].name = name(constantNameOffsets[i]);
+  }
+}
+
+void CograBinaryMeshFile::readV2(const std::function<void(ui64 offset, ui64 size, void* dst)>& readBytes,
+                                 ui64 fileSize, bool verifyChecksums)
+{
+  using namespace impl::cbm;
+  FileHeaderV2 header;
+  readBytes(0, sizeof(header), &header);
+  if (header.version != VERSION_2)
+  {
+    throw std::runtime_error("Unsupported .cbm version " + std::to_string(header.version) + ".");
+  }
+  checkSectionDirectory(header.nSections, fileSize);
+  std::vector<SectionEntryV2> sections(header.nSections);
+  readBytes(sizeof(header), sizeof(SectionEntryV2) * sections.size(), sections.data());
+  checkMeshSections(header, sections, fileSize);
+
+  // One allocation for the whole mesh.
+  const ui64 nV        = header.nVertices;
+  const ui64 nT        = header.nTriangles;
+  size_t     arenaSize = alignBlock(3 * nV * sizeof(FloatType)) + alignBlock(3 * nT * sizeof(IndexType));
+  for (const auto& section : sections)
+  {
+    if (section.type == SECTION_ATTRIBUTE)
+    {
+      arenaSize += alignBlock(size_t(section.components) * section.componentSize * nV) + alignBlock(N_CHARS);
+    }
+    else if (section.type == SECTION_CONSTANT)
+    {
+      arenaSize += alignBlock(size_t(section.components) * section.componentSize) + alignBlock(N_CHARS);
+    }
+  }
+  clear();
+  (void)reserve(arenaSize);
+  m_positions = allocate(3 * nV * sizeof(FloatType));
+  m_triangles = allocate(3 * nT * sizeof(IndexType));
+
+  // Raw payloads are read in place, encoded payloads are staged in encoded and decoded into place.
+  std::vector<ui8> encoded;
+  const auto       readPayload = [&](const SectionEntryV2& section, void* dst, ui64 decodedSize)
+  {
+    ui8* payload = (ui8*)dst;
+    if (section.encoding != ENCODING_RAW)
+    {
+      encoded.resize(section.size);
+      payload = encoded.data();
+    }
+    else if (section.size != decodedSize)
+    {
+      throw std::runtime_error("A .cbm section has an unexpected size.");
+    }
+    readBytes(section.offset, section.size, payload);
+    if (verifyChecksums && hash64(payload, section.size) != section.hash)
+    {
+      throw std::runtime_error("Checksum mismatch in .cbm section.");
+    }
+    decodeSection(section, payload, dst, decodedSize);
+  };
+
+  std::vector<char> names;
+  std::vector<ui32> attributeNameOffsets;
+  std::vector<ui32> constantNameOffsets;
+  for (const auto& section : sections)
+  {
+    switch (section.type)
+    {
+    case SECTION_NAMES:
+      names.resize(section.size);
+      readPayload(section, names.data(), section.size);
+      break;
+    case SECTION_POSITIONS:
+      readPayload(section, getPositionsPtr(), m_positions.size);
+      break;
+    case SECTION_TRIANGLES:
+      readPayload(section, getTriangleIndices(), m_triangles.size);
+      break;
+    case SECTION_ATTRIBUTE:
+    {
+      const Element a = {section.components, section.componentSize,
+                         allocate(size_t(section.components) * section.componentSize * nV), allocate(N_CHARS)};
+      readPayload(section, getStorage() + a.data.offset, a.data.size);
+      m_attributes.push_back(a);
+      attributeNameOffsets.push_back(section.nameOffset);
+      break;
+    }
+    case SECTION_CONSTANT:
+    {
+      const Element c = {section.components, section.componentSize,
+                         allocate(size_t(section.components) * section.componentSize), allocate(N_CHARS)};
+      readPayload(section, getStorage() + c.data.offset, c.data.size);
+      m_constants.push_back(c);
+      constantNameOffsets.push_back(section.nameOffset);
+      break;
+    }
+    default:
+      // Sections unknown to this version are skipped.
+      break;
+    }
+  }
+
+  const auto copyName = [&](const Element& element, ui32 nameOffset)
+  {
+    if (size_t(nameOffset) + N_CHARS > names.size())
+    {
+      throw std::runtime_error("A .cbm name exceeds the names section.");
+    }
+    std::memcpy(getStorage() + element.name.offset, names.data() + nameOffset, N_CHARS);
+  };
+  for (size_t i = 0; i < m_attributes.size(); i++)
+  {
+    copyName(m_attributes[i], attributeNameOffsets[i]);
+  }
+  for (size_t i = 0; i < m_constants.size(); i++)
+  {
+    copyName(m_constants[i], constantNameOffsets[i]);
+  }
+}
+
+void CograBinaryMeshFile::writeV2(std::ofstream& outFile, ui32 compression)
+{
+  using namespace impl::cbm;
+  const SizeType nA = getNumAttributes();
+  const SizeType nC = getNumConstants();
+
+  // Names are padded to N_CHARS, so that pointers into a mapped names section behave like V1 names.
+  std::vector<char> names(size_t(nA + nC) * N_CHARS, '\0');
+  for (SizeType i = 0; i < nA; i++)
+  {
+    std::copy(getAttributeName(i), getAttributeName(i) + N_CHARS, names.data() + size_t(i) * N_CHARS);
+  }
+  for (SizeType i = 0; i < nC; i++)
+  {
+    std::copy(getConstantName(i), getConstantName(i) + N_CHARS, names.data() + size_t(nA + i) * N_CHARS);
+  }
+
+  std::vector<SectionEntryV2> sections;
+  std::vector<const void*>    payloads;
+  const auto addSection = [&](ui32 type, ui32 encoding, ui32 components, ui32 componentSize, ui32 nameOffset,
+                              const void* data, ui64 size)
+  {
+    SectionEntryV2 section = {};
+    section.type           = type;
+    section.encoding       = encoding;
+    section.components     = components;
+    section.componentSize  = componentSize;
+    section.nameOffset     = nameOffset;
+    section.size           = size;
+    section.hash           = hash64(data, size);
+    sections.push_back(section);
+    payloads.push_back(data);
+  };
+
+  // Owns the encoded payloads until they are written. Reserved up front, so payloads never dangle.
+  std::vector<std::vector<ui8>> encodedPayloads;
+  encodedPayloads.reserve(2 + size_t(nA));
+  const SizeType nV = getNumVertices();
+
+  addSection(SECTION_NAMES, ENCODING_RAW, 0, 0, 0, names.data(), names.size());
+  if (compression & COMPRESS_POSITIONS)
+  {
+    const auto quantization = computeQuantization(getPositionsPtr(), nV);
+    auto&      encoded      = encodedPayloads.emplace_back(sizeof(quantization) + size_t(nV) * 3 * sizeof(ui16));
+    std::memcpy(encoded.data(), &quantization, sizeof(quantization));
+    quantizePositions(getPositionsPtr(), nV, quantization, (ui16*)(encoded.data() + sizeof(quantization)));
+    addSection(SECTION_POSITIONS, ENCODING_QUANTIZED_AABB16, 3, sizeof(FloatType), 0, encoded.data(), encoded.size());
+  }
+  else
+  {
+    addSection(SECTION_POSITIONS, ENCODING_RAW, 3, sizeof(FloatType), 0, getPositionsPtr(),
+               ui64(nV) * 3 * sizeof(FloatType));
+  }
+  if (compression & COMPRESS_INDICES)
+  {
+    auto& encoded = encodedPayloads.emplace_back();
+    encodeDeltaVarint(getTriangleIndices(), size_t(getNumTriangles()) * 3, encoded);
+    addSection(SECTION_TRIANGLES, ENCODING_DELTA_VARINT, 3, sizeof(IndexType), 0, encoded.data(), encoded.size());
+  }
+  else
+  {
+    addSection(SECTION_TRIANGLES, ENCODING_RAW, 3, sizeof(IndexType), 0, getTriangleIndices(),
+               ui64(getNumTriangles()) * 3 * sizeof(IndexType));
+  }
+  for (SizeType i = 0; i < nA; i++)
+  {
+    const bool octahedral = (compression & COMPRESS_NORMALS) && getAttributeComponents(i) == 3 &&
+                            getAttributeComponentSize(i) == sizeof(f32) &&
+                            isUnitLength((const f32*)getAttributePtr(i), nV);
+    if (octahedral)
+    {
+      auto& encoded = encodedPayloads.emplace_back(size_t(nV) * 2 * sizeof(i16));
+      encodeOctahedral((const f32*)getAttributePtr(i), nV, (i16*)encoded.data());
+      addSection(SECTION_ATTRIBUTE, ENCODING_OCTAHEDRAL16, 3, sizeof(f32), i * N_CHARS, encoded.data(),
+                 encoded.size());
+    }
+    else
+    {
+      addSection(SECTION_ATTRIBUTE, ENCODING_RAW, getAttributeComponents(i), getAttributeComponentSize(i),
+                 i * N_CHARS, getAttributePtr(i), ui64(getAttributeElementSize(i)) * nV);
+    }
+  }
+  for (SizeType i = 0; i < nC; i++)
+  {
+    addSection(SECTION_CONSTANT, ENCODING_RAW, getConstantComponents(i), getConstantComponentSize(i),
+               (nA + i) * N_CHARS, getConstant(i), getConstantElementSize(i));
+  }
+
+  ui64 offset = alignSection(sizeof(FileHeaderV2) + sections.size() * sizeof(SectionEntryV2));
+  for (auto& section : sections)
+  {
+    section.offset = offset;
+    offset         = alignSection(offset + section.size);
+  }
+
+  FileHeaderV2 header = {};
+  std::copy(std::begin(MAGIC), std::end(MAGIC), header.magic);
+  header.version    = VERSION_2;
+  header.nSections  = static_cast<ui32>(sections.size());
+  header.nVertices  = getNumVertices();
+  header.nTriangles = getNumTriangles();
+  outFile.write((const char*)&header, sizeof(header));
+  outFile.write((const char*)sections.data(), sections.size() * sizeof(SectionEntryV2));
+
+  const char padding[SECTION_ALIGNMENT] = {};
+  ui64       position                   = sizeof(FileHeaderV2) + sections.size() * sizeof(SectionEntryV2);
+  for (size_t i = 0; i < sections.size(); i++)
+  {
+    outFile.write(padding, sections[i].offset - position);
+    outFile.write((const char*)payloads[i], sections[i].size);
+    position = sections[i].offset + sections[i].size;
+  }
+}
+void CograBinaryMeshFile::detach()
+{
+  if (m_mappedFile)
+  {
+    (void)compact(0);
+  }
+}
+
+ui8* CograBinaryMeshFile::getStorage() const
+{
+  return m_mappedFile ? m_mappedFile->data() : m_arena.get();
+}
+
+CograBinaryMeshFile::RetiredStorage CograBinaryMeshFile::reserve(size_t size)
+{
+  if (m_mappedFile)
+  {
+    return compact(size);
+  }
+  const size_t required = alignBlock(m_arenaSize) + size;
+  if (required <= m_arenaCapacity)
+  {
+    return {};
+  }
+  if (m_arenaGarbage > m_arenaSize / 2)
+  {
+    return compact(size);
+  }
+
+  RetiredStorage retired;
+  retired.arena = grow(required);
+  return retired;
+}
+
+std::unique_ptr<ui8[]> CograBinaryMeshFile::grow(size_t capacity)
+{
+  // Grows geometrically, so that repeated additions take amortized constant time.
+  capacity    = std::max(capacity, 2 * m_arenaCapacity);
+  auto result = std::exchange(m_arena, std::unique_ptr<ui8[]>(new ui8[capacity]));
+  if (m_arenaSize != 0)
+  {
+    std::memcpy(m_arena.get(), result.get(), m_arenaSize);
+  }
+  m_arenaCapacity = capacity;
+  return result;
+}
+
+CograBinaryMeshFile::Block CograBinaryMeshFile::allocate(size_t size)
+{
+  const size_t offset = alignBlock(m_arenaSize);
+  if (offset + size > m_arenaCapacity)
+  {
+    grow(offset + size);
+  }
+  m_arenaSize = offset + size;
+  return {offset, size};
+}
+
+CograBinaryMeshFile::Block CograBinaryMeshFile::allocateName(const std::string& name)
+{
+  const Block result = allocate(N_CHARS);
+  char*       a      = (char*)getStorage() + result.offset;
+  std::memset(a, '\0', N_CHARS);
+  std::copy_n(name.data(), std::min<size_t>(N_CHARS, name.length()), a);
+  return result;
+}
+
+void CograBinaryMeshFile::release(const Block& block)
+{
+  if (!m_mappedFile)
+  {
+    m_arenaGarbage += alignBlock(block.getCapacity());
+  }
+}
+
+CograBinaryMeshFile::RetiredStorage CograBinaryMeshFile::compact(size_t extraCapacity)
+{
+  size_t capacity = alignBlock(m_positions.getCapacity()) + alignBlock(m_triangles.getCapacity()) + extraCapacity;
+  for (const auto& e : m_attributes)
+  {
+    capacity += alignBlock(e.data.getCapacity()) + alignBlock(e.name.size);
+  }
+  for (const auto& e : m_constants)
+  {
+    capacity += alignBlock(e.data.size) + alignBlock(e.name.size);
+  }
+
+  RetiredStorage retired;
+  const ui8*     source = getStorage();
+  retired.arena         = std::move(m_arena);
+  retired.mappedFile    = std::move(m_mappedFile);
+  m_arena.reset(capacity != 0 ? new ui8[capacity] : nullptr);
+  m_mappedFile.reset();
+  m_arenaSize     = 0;
+  m_arenaCapacity = capacity;
+  m_arenaGarbage  = 0;
+
+  // Blocks keep their room to grow in place.
+  const auto relocate = [&](Block& block)
+  {
+    const Block moved = allocate(block.getCapacity());
+    if (block.size != 0)
+    {
+      std::memcpy(m_arena.get() + moved.offset, source + block.offset, block.size);
+    }
+    block = {moved.offset, block.size, moved.size};
+  };
+  relocate(m_positions);
+  relocate(m_triangles);
+  for (auto& e : m_attributes)
+  {
+    relocate(e.data);
+    relocate(e.name);
+  }
+  for (auto& e : m_constants)
+  {
+    relocate(e.data);
+    relocate(e.name);
+  }
+  return retired;
+}
+
+void CograBinaryMeshFile::clear()
+{
+  m_arena.reset();
+  m_arenaSize     = 0;
+  m_arenaCapacity = 0;
+  m_arenaGarbage  = 0;
+  m_mappedFile.reset();
+  m_positions = {};
+  m_triangles = {};
+  m_attributes.clear();
+  m_constants.clear();
+}
+
+CograBinaryMeshFile::Block CograBinaryMeshFile::getMappedBlock(const void* data, size_t size) const
+{
+  return {static_cast<size_t>((const ui8*)data - m_mappedFile->data()), size};
+}
+
 CograBinaryMeshFile::SizeType CograBinaryMeshFile::getNumVertices() const
 {
-  return static_cast<ui32>(m_positions.size() / 3);
+  return static_cast<ui32>(m_positions.size / (3 * sizeof(FloatType)));
 }
 
 CograBinaryMeshFile::SizeType CograBinaryMeshFile::getNumTriangles() const
 {
-  return static_cast<ui32>(m_triangles.size() / 3);
+  return static_cast<ui32>(m_triangles.size / (3 * sizeof(IndexType)));
 }
 
 const CograBinaryMeshFile::FloatType* CograBinaryMeshFile::getPositionsPtr() const
 {
-  return m_positions.data();
+  return (const FloatType*)(getStorage() + m_positions.offset);
 }
 
 CograBinaryMeshFile::FloatType* CograBinaryMeshFile::getPositionsPtr()
 {
-  return m_positions.data();
+  return (FloatType*)(getStorage() + m_positions.offset);
 }
 
 const CograBinaryMeshFile::IndexType* CograBinaryMeshFile::getTriangleIndices() const
 {
-  return &m_triangles[0];
+  return (const IndexType*)(getStorage() + m_triangles.offset);
 }
 
 CograBinaryMeshFile::IndexType* CograBinaryMeshFile::getTriangleIndices()
 {
-  return &m_triangles[0];
+  return (IndexType*)(getStorage() + m_triangles.offset);
 }
 
 void CograBinaryMeshFile::setPositions(const FloatType* vertices, const SizeType nVertices)
 {
-  m_positions.resize(nVertices * 3);
-  for (SizeType i = 0; i < nVertices * 3; i++)
-  {
-    m_positions[i] = vertices[i];
-  }
+  const size_t size    = size_t(nVertices) * 3 * sizeof(FloatType);
+  const auto   retired = reserve(alignBlock(size));
+  const Block  block   = allocate(size);
+  std::memcpy(getStorage() + block.offset, vertices, size);
+  release(std::exchange(m_positions, block));
 }
 
 void CograBinaryMeshFile::setTriangleIndices(const IndexType* triIdx, const SizeType nTriangles)
 {
-  m_triangles.resize(nTriangles * 3);
-  for (SizeType i = 0; i < nTriangles * 3; i++)
-  {
-    m_triangles[i] = triIdx[i];
-  }
+  const size_t size    = size_t(nTriangles) * 3 * sizeof(IndexType);
+  const auto   retired = reserve(alignBlock(size));
+  const Block  block   = allocate(size);
+  std::memcpy(getStorage() + block.offset, triIdx, size);
+  release(std::exchange(m_triangles, block));
 }
 
 void CograBinaryMeshFile::readHeader(std::ifstream& inFile)
 {
   SizeType nV;
   SizeType nT;
-  SizeType nA;
-  SizeType nC;
-  freeAttributes();
+  clear();
   inFile.read((char*)&nV, sizeof(SizeType));
-  m_positions.resize(nV * 3);
   inFile.read((char*)&nT, sizeof(SizeType));
-  m_triangles.resize(nT * 3);
-  inFile.read((char*)&nA, sizeof(SizeType));
 
-  m_attributeComponents.resize(nA);
-  m_attributeComponentSize.resize(nA);
-  m_attributeNames.resize(nA);
-  m_attributes.resize(nA);
-
-  if (nA != 0)
+  // Names are read into a buffer, as the arena is allocated once all sizes are known.
+  std::vector<char> names;
+  const auto        readElements = [&](std::vector<Element>& elements)
   {
-    inFile.read((char*)&m_attributeComponents[0], nA * sizeof(SizeType));
-    inFile.read((char*)&m_attributeComponentSize[0], nA * sizeof(SizeType));
-
-    for (SizeType i = 0; i < getNumAttributes(); i++)
+    SizeType nElements;
+    inFile.read((char*)&nElements, sizeof(SizeType));
+    elements.resize(nElements);
+    for (auto& e : elements)
     {
-      m_attributes[i]     = new ui8[m_attributeComponents[i] * m_attributeComponentSize[i] * getNumVertices()];
-      m_attributeNames[i] = new char[N_CHARS];
-      std::memset(m_attributeNames[i], '\0', N_CHARS);
-      inFile.read((char*)(m_attributeNames[i]), sizeof(char) * N_CHARS);
+      inFile.read((char*)&e.components, sizeof(SizeType));
     }
-  }
-
-  inFile.read((char*)&nC, sizeof(SizeType));
-  m_constantComponents.resize(nC);
-  m_constantComponentSize.resize(nC);
-  m_constantNames.resize(nC);
-  m_constants.resize(nC);
+    for (auto& e : elements)
+    {
+      inFile.read((char*)&e.componentSize, sizeof(SizeType));
+    }
+    const size_t first = names.size();
+    names.resize(first + size_t(nElements) * N_CHARS);
+    if (nElements != 0)
+    {
+      inFile.read(names.data() + first, size_t(nElements) * N_CHARS);
+    }
+  };
+  readElements(m_attributes);
+  readElements(m_constants);
 
-  if (nC != 0)
+  size_t arenaSize = alignBlock(size_t(nV) * 3 * sizeof(FloatType)) + alignBlock(size_t(nT) * 3 * sizeof(IndexType));
+  for (const auto& a : m_attributes)
   {
-    inFile.read((char*)&m_constantComponents[0], nC * sizeof(SizeType));
-    inFile.read((char*)&m_constantComponentSize[0], nC * sizeof(SizeType));
+    arenaSize += alignBlock(size_t(a.components) * a.componentSize * nV) + alignBlock(N_CHARS);
+  }
+  for (const auto& c : m_constants)
+  {
+    arenaSize += alignBlock(size_t(c.components) * c.componentSize) + alignBlock(N_CHARS);
+  }
+  (void)reserve(arenaSize);
 
-    for (SizeType i = 0; i < getNumConstants(); i++)
-    {
-      m_constants[i]     = (new ui8[m_constantComponents[i] * m_constantComponentSize[i]]);
-      m_constantNames[i] = new char[N_CHARS];
-      inFile.read((char*)m_constantNames[i], sizeof(ui8) * N_CHARS);
-    }
+  m_positions = allocate(size_t(nV) * 3 * sizeof(FloatType));
+  m_triangles = allocate(size_t(nT) * 3 * sizeof(IndexType));
+  size_t name = 0;
+  for (auto& a : m_attributes)
+  {
+    a.data = allocate(size_t(a.components) * a.componentSize * nV);
+    a.name = allocate(N_CHARS);
+    std::memcpy(getStorage() + a.name.offset, names.data() + N_CHARS * name++, N_CHARS);
+  }
+  for (auto& c : m_constants)
+  {
+    c.data = allocate(size_t(c.components) * c.componentSize);
+    c.name = allocate(N_CHARS);
+    std::memcpy(getStorage() + c.name.offset, names.data() + N_CHARS * name++, N_CHARS);
   }
 }
 
 void CograBinaryMeshFile::writeHeader(std::ofstream& outFile)
 {
-  SizeType nV = getNumVertices();
-  SizeType nT = getNumTriangles();
-  SizeType nA = getNumAttributes();
-  SizeType nC = getNumConstants();
-  outFile.write((const char*)&nV, sizeof(SizeType));
-  outFile.write((const char*)&nT, sizeof(SizeType));
-  outFile.write((const char*)&nA, sizeof(SizeType));
-  if (nA != 0)
+  SizeType   nV            = getNumVertices();
+  SizeType   nT            = getNumTriangles();
+  const auto writeElements = [&](const std::vector<Element>& elements)
   {
-    outFile.write((const char*)&m_attributeComponents[0], nA * sizeof(SizeType));
-    outFile.write((const char*)&m_attributeComponentSize[0], nA * sizeof(SizeType));
-    for (SizeType i = 0; i < nA; i++)
+    const SizeType nElements = static_cast<SizeType>(elements.size());
+    outFile.write((const char*)&nElements, sizeof(SizeType));
+    for (const auto& e : elements)
     {
-      outFile.write((const char*)(m_attributeNames[i]), sizeof(char) * N_CHARS);
+      outFile.write((const char*)&e.components, sizeof(SizeType));
     }
-  }
-  outFile.write((const char*)&nC, sizeof(SizeType));
-  if (nC != 0)
-  {
-    outFile.write((const char*)&m_constantComponents[0], nC * sizeof(SizeType));
-    outFile.write((const char*)&m_constantComponentSize[0], nC * sizeof(SizeType));
-    for (SizeType i = 0; i < nC; i++)
+    for (const auto& e : elements)
     {
-      outFile.write((const char*)(m_constantNames[i]), sizeof(char) * N_CHARS);
+      outFile.write((const char*)&e.componentSize, sizeof(SizeType));
     }
-  }
+    for (const auto& e : elements)
+    {
+      outFile.write((const char*)getStorage() + e.name.offset, sizeof(char) * N_CHARS);
+    }
+  };
+  outFile.write((const char*)&nV, sizeof(SizeType));
+  outFile.write((const char*)&nT, sizeof(SizeType));
+  writeElements(m_attributes);
+  writeElements(m_constants);
 }
 
 bool CograBinaryMeshFile::add(const CograBinaryMeshFile& src)
 {
-  // checks
-  if (this->getNumAttributes() != src.getNumAttributes())
+  if (!hasSameAttributeLayout(src))
   {
     return false;
   }
+  const size_t nV = getNumVertices();
+  const size_t nT = getNumTriangles();
+  if (nV + src.getNumVertices() > std::numeric_limits<IndexType>::max() ||
+      nT + src.getNumTriangles() > std::numeric_limits<SizeType>::max())
+  {
+    throw std::runtime_error("The merged mesh has too many vertices or triangles.");
+  }
 
-  const SizeType nAttributes = src.getNumAttributes();
-
-  for (SizeType i = 0; i < nAttributes; i++)
+  // Bytes of the block that a stream moves to, if it cannot grow in place.
+  const auto getGrowth = [](const Block& block, const Block& added) -> size_t
+  {
+    const size_t size = block.size + added.size;
+    return size <= block.getCapacity() ? 0 : alignBlock(2 * size);
+  };
+  size_t required = getGrowth(m_positions, src.m_positions) + getGrowth(m_triangles, src.m_triangles);
+  for (size_t aIdx = 0; aIdx < m_attributes.size(); aIdx++)
+  {
+    required += getGrowth(m_attributes[aIdx].data, src.m_attributes[aIdx].data);
+  }
+  const auto retired = reserve(required);
+
+  // src may be this object, so its blocks are read before any block of this object grows. Moved blocks stay intact
+  // until the arena is compacted.
+  const ui8*         srcStorage   = src.getStorage();
+  const Block        srcPositions = src.m_positions;
+  const Block        srcTriangles = src.m_triangles;
+  std::vector<Block> srcAttributes;
+  for (const auto& a : src.m_attributes)
+  {
+    srcAttributes.push_back(a.data);
+  }
+  const auto append = [&](Block& block, const Block& added)
   {
-    if (this->getAttributeComponentSize(i) != src.getAttributeComponentSize(i))
+    if (block.size + added.size > block.getCapacity())
     {
-      return false;
+      const Block moved = allocate(2 * (block.size + added.size));
+      if (block.size != 0)
+      {
+        std::memcpy(getStorage() + moved.offset, getStorage() + block.offset, block.size);
+      }
+      release(block);
+      block = {moved.offset, block.size, moved.size};
     }
-    if (this->getAttributeComponents(i) != src.getAttributeComponents(i))
+    if (added.size != 0)
     {
-      return false;
+      std::memcpy(getStorage() + block.offset + block.size, srcStorage + added.offset, added.size);
     }
+    block.size += added.size;
+  };
+  append(m_positions, srcPositions);
+  append(m_triangles, srcTriangles);
+  for (size_t aIdx = 0; aIdx < m_attributes.size(); aIdx++)
+  {
+    append(m_attributes[aIdx].data, srcAttributes[aIdx]);
   }
 
-  // merge
+  // translate index buffer
+  IndexType* const rebased = getTriangleIndices() + nT * 3;
+  for (size_t i = 0; i < srcTriangles.size / sizeof(IndexType); i++)
+  {
+    rebased[i] += static_cast<IndexType>(nV);
+  }
+  return true;
+}
 
-  auto* vertices = new FloatType[(this->getNumVertices() + src.getNumVertices()) * 3];
-  memcpy((void*)&vertices[0], (void*)this->getPositionsPtr(), this->getNumVertices() * 3 * sizeof(FloatType));
-  memcpy((void*)&vertices[this->getNumVertices() * 3], (void*)src.getPositionsPtr(),
-         src.getNumVertices() * 3 * sizeof(FloatType));
+CograBinaryMeshFile CograBinaryMeshFile::merge(const std::vector<const CograBinaryMeshFile*>& meshes,
+                                               ThreadPool*                                   threadPool)
+{
+  CograBinaryMeshFile result;
+  if (meshes.empty())
+  {
+    return result;
+  }
+  const CograBinaryMeshFile& first = *meshes.front();
 
-  auto* idxBuffer = new IndexType[(this->getNumTriangles() + src.getNumTriangles()) * 3];
-  memcpy((void*)&idxBuffer[0], (void*)this->getTriangleIndices(), this->getNumTriangles() * 3 * sizeof(IndexType));
-  // translate index buffer
-  for (SizeType i = 0; i < src.getNumTriangles() * 3; i++)
+  // checks and the first vertex and triangle of every mesh in the result
+  std::vector<size_t> firstVertex(meshes.size() + 1, 0);
+  std::vector<size_t> firstTriangle(meshes.size() + 1, 0);
+  for (size_t mIdx = 0; mIdx < meshes.size(); mIdx++)
   {
-    idxBuffer[this->getNumTriangles() * 3 + i] = src.getTriangleIndices()[i] + getNumVertices();
+    if (!first.hasSameAttributeLayout(*meshes[mIdx]))
+    {
+      throw std::runtime_error("Cannot merge meshes with different attributes.");
+    }
+    firstVertex[mIdx + 1]   = firstVertex[mIdx] + meshes[mIdx]->getNumVertices();
+    firstTriangle[mIdx + 1] = firstTriangle[mIdx] + meshes[mIdx]->getNumTriangles();
+  }
+  const size_t nV = firstVertex.back();
+  const size_t nT = firstTriangle.back();
+  if (nV > std::numeric_limits<IndexType>::max() || nT > std::numeric_limits<SizeType>::max())
+  {
+    throw std::runtime_error("The merged mesh has too many vertices or triangles.");
   }
 
-  std::vector<ui8*> attributes(nAttributes);
-  for (SizeType i = 0; i < nAttributes; i++)
+  // one reservation for all streams
+  result.m_attributes = first.m_attributes;
+  result.m_constants  = first.m_constants;
+  size_t arenaSize    = alignBlock(nV * 3 * sizeof(FloatType)) + alignBlock(nT * 3 * sizeof(IndexType));
+  for (const auto& a : first.m_attributes)
   {
-    SizeType attribSize = src.getAttributeComponents(i) * src.getAttributeComponentSize(i);
-    auto     attr       = new ui8[(this->getNumVertices() + src.getNumVertices()) * attribSize];
-    memcpy((void*)&attr[0], this->getAttributePtr(i), this->getNumVertices() * attribSize);
-    memcpy((void*)&attr[this->getNumVertices() * attribSize], src.getAttributePtr(i),
-           src.getNumVertices() * attribSize);
-    attributes[i] = attr;
+    arenaSize += alignBlock(nV * a.components * a.componentSize) + alignBlock(N_CHARS);
   }
+  for (const auto& c : first.m_constants)
+  {
+    arenaSize += alignBlock(c.data.size) + alignBlock(N_CHARS);
+  }
+  (void)result.reserve(arenaSize);
 
-  this->setPositions(vertices, this->getNumVertices() + src.getNumVertices());
-  this->setTriangleIndices(idxBuffer, this->getNumTriangles() + src.getNumTriangles());
+  const auto copyBlock = [&](const Block& src)
+  {
+    const Block dst = result.allocate(src.size);
+    std::memcpy(result.getStorage() + dst.offset, first.getStorage() + src.offset, src.size);
+    return dst;
+  };
+  result.m_positions = result.allocate(nV * 3 * sizeof(FloatType));
+  result.m_triangles = result.allocate(nT * 3 * sizeof(IndexType));
+  for (auto& a : result.m_attributes)
+  {
+    a.data = result.allocate(nV * a.components * a.componentSize);
+    a.name = copyBlock(a.name);
+  }
+  for (auto& c : result.m_constants)
+  {
+    c.data = copyBlock(c.data);
+    c.name = copyBlock(c.name);
+  }
 
-  for (SizeType i = 0; i < nAttributes; i++)
+  // Every mesh writes to its own slice of the streams, so the meshes are independent.
+  ui8* const       storage     = result.getStorage();
+  IndexType* const triangles   = reinterpret_cast<IndexType*>(storage + result.m_triangles.offset);
+  const auto       mergeMeshes = [&](size_t begin, size_t end)
   {
-    this->replaceAttribute(i, attributes[i]);
+    for (size_t mIdx = begin; mIdx < end; mIdx++)
+    {
+      const CograBinaryMeshFile& mesh          = *meshes[mIdx];
+      const size_t               nMeshVertices = mesh.getNumVertices();
+      if (nMeshVertices != 0)
+      {
+        std::memcpy(storage + result.m_positions.offset + firstVertex[mIdx] * 3 * sizeof(FloatType),
+                    mesh.getPositionsPtr(), nMeshVertices * 3 * sizeof(FloatType));
+      }
+      const IndexType  base    = static_cast<IndexType>(firstVertex[mIdx]);
+      const IndexType* indices = mesh.getTriangleIndices();
+      IndexType*       rebased = triangles + firstTriangle[mIdx] * 3;
+      for (size_t i = 0; i < size_t(mesh.getNumTriangles()) * 3; i++)
+      {
+        rebased[i] = indices[i] + base;
+      }
+      for (size_t aIdx = 0; aIdx < result.m_attributes.size(); aIdx++)
+      {
+        const size_t elementSize = mesh.getAttributeElementSize(static_cast<SizeType>(aIdx));
+        if (nMeshVertices != 0)
+        {
+          std::memcpy(storage + result.m_attributes[aIdx].data.offset + firstVertex[mIdx] * elementSize,
+                      mesh.getAttributePtr(static_cast<SizeType>(aIdx)), nMeshVertices * elementSize);
+        }
+      }
+    }
+  };
+  if (threadPool != nullptr)
+  {
+    threadPool->parallelFor(meshes.size(), 1, mergeMeshes);
   }
+  else
+  {
+    mergeMeshes(0, meshes.size());
+  }
+  return result;
+}
 
-  // tidy up
-  for (SizeType i = 0; i < nAttributes; i++)
+bool CograBinaryMeshFile::hasSameAttributeLayout(const CograBinaryMeshFile& other) const
+{
+  if (getNumAttributes() != other.getNumAttributes())
   {
-    delete[] attributes[i];
+    return false;
+  }
+  for (SizeType i = 0; i < getNumAttributes(); i++)
+  {
+    if (getAttributeComponentSize(i) != other.getAttributeComponentSize(i) ||
+        getAttributeComponents(i) != other.getAttributeComponents(i))
+    {
+      return false;
+    }
   }
   return true;
 }
 
 CograBinaryMeshFile::SizeType CograBinaryMeshFile::getNumAttributes() const
 {
-  return static_cast<ui32>(m_attributeComponents.size());
+  return static_cast<ui32>(m_attributes.size());
 }
 
 CograBinaryMeshFile::SizeType CograBinaryMeshFile::addAttribute(const void* attribute, const SizeType nComponents,
                                                                 const SizeType     componentSize,
                                                                 const std::string& attributeName)
 {
-  SizeType size = getNumVertices() * nComponents * componentSize;
-  auto*    p    = new ui8[size];
-
-  memcpy((void*)p, attribute, size);
-  m_attributes.push_back(p);
-  m_attributeComponentSize.push_back(componentSize);
-  m_attributeComponents.push_back(nComponents);
-
-  auto* a = new char[N_CHARS];
-  memset((void*)a, '\0', N_CHARS);
-  SizeType l = std::min<SizeType>(static_cast<ui32>(N_CHARS), static_cast<ui32>(attributeName.length()));
-  for (SizeType i = 0; i < l; i++)
-  {
-    a[i] = attributeName[i];
-  }
-
-  m_attributeNames.push_back(a);
+  const size_t size    = size_t(getNumVertices()) * nComponents * componentSize;
+  const auto   retired = reserve(alignBlock(size) + alignBlock(N_CHARS));
+  const Block  data    = allocate(size);
+  std::memcpy(getStorage() + data.offset, attribute, size);
+  m_attributes.push_back({nComponents, componentSize, data, allocateName(attributeName)});
   return static_cast<ui32>(m_attributes.size());
 }
 
 void* CograBinaryMeshFile::getAttributePtr(SizeType attributeIdx) const
 {
-  return m_attributes[attributeIdx];
+  return getStorage() + m_attributes[attributeIdx].data.offset;
 }
 
 void* CograBinaryMeshFile::replaceAttribute(SizeType attributeIdx, const void* attribute)
@@ -372,61 +1171,52 @@ void* CograBinaryMeshFile::replaceAttribute(SizeType attributeIdx, const void* a
   {
     return nullptr;
   }
-  SizeType size = getNumVertices() * m_attributeComponentSize[attributeIdx] * m_attributeComponents[attributeIdx];
-  auto     p    = new ui8[size];
-  memcpy((void*)p, attribute, size);
-  delete[] m_attributes[attributeIdx];
-  m_attributes[attributeIdx] = p;
-  return p;
+  const size_t size    = m_attributes[attributeIdx].data.size;
+  const auto   retired = reserve(alignBlock(size));
+  const Block  data    = allocate(size);
+  std::memcpy(getStorage() + data.offset, attribute, size);
+  release(std::exchange(m_attributes[attributeIdx].data, data));
+  return getAttributePtr(attributeIdx);
 }
 
 CograBinaryMeshFile::SizeType CograBinaryMeshFile::getAttributeComponentSize(SizeType attributeIdx) const
 {
-  return m_attributeComponentSize[attributeIdx];
+  return m_attributes[attributeIdx].componentSize;
 }
 
 CograBinaryMeshFile::SizeType CograBinaryMeshFile::getAttributeComponents(SizeType attributeIdx) const
 {
-  return m_attributeComponents[attributeIdx];
+  return m_attributes[attributeIdx].components;
 }
 
 CograBinaryMeshFile::SizeType CograBinaryMeshFile::getAttributeElementSize(SizeType attributeIdx) const
 {
-  return m_attributeComponentSize[attributeIdx] * m_attributeComponents[attributeIdx];
+  return m_attributes[attributeIdx].componentSize * m_attributes[attributeIdx].components;
 }
 
 const char* CograBinaryMeshFile::getAttributeName(SizeType attributeIdx) const
 {
-  return m_attributeNames[attributeIdx];
+  return (const char*)getStorage() + m_attributes[attributeIdx].name.offset;
 }
 
 void CograBinaryMeshFile::freeAttributes()
 {
-  for (SizeType i = 0; i < getNumAttributes(); i++)
+  for (const auto& a : m_attributes)
   {
-    if (m_attributes[i])
-    {
-      delete[] m_attributes[i];
-      m_attributes[i] = nullptr;
-    }
-    m_attributeComponents[i]    = 0;
-    m_attributeComponentSize[i] = 0;
-    if (m_attributeNames[i])
-    {
-      delete[] m_attributeNames[i];
-      m_attributeNames[i] = nullptr;
-    }
+    release(a.data);
+    release(a.name);
   }
+  m_attributes.clear();
 }
 
 CograBinaryMeshFile::SizeType CograBinaryMeshFile::getConstantComponentSize(SizeType constantIdx) const
 {
-  return m_constantComponentSize[constantIdx];
+  return m_constants[constantIdx].componentSize;
 }
 
 CograBinaryMeshFile::SizeType CograBinaryMeshFile::getConstantComponents(SizeType constantIdx) const
 {
-  return m_constantComponents[constantIdx];
+  return m_constants[constantIdx].components;
 }
 
 CograBinaryMeshFile::SizeType CograBinaryMeshFile::getConstantElementSize(SizeType constantIdx) const
@@ -436,58 +1226,47 @@ CograBinaryMeshFile::SizeType CograBinaryMeshFile::getConstantElementSize(SizeTy
 
 const char* CograBinaryMeshFile::getConstantName(SizeType constantIdx) const
 {
-  return m_constantNames[constantIdx];
+  return (const char*)getStorage() + m_constants[constantIdx].name.offset;
 }
 
 CograBinaryMeshFile::SizeType CograBinaryMeshFile::getNumConstants() const
 {
-  return static_cast<ui32>(m_constantComponentSize.size());
+  return static_cast<ui32>(m_constants.size());
 }
 
 void CograBinaryMeshFile::freeConstants()
 {
-  for (SizeType i = 0; i < getNumConstants(); i++)
+  for (const auto& c : m_constants)
   {
-    delete[] m_constants[i];
-    m_constants[i]             = nullptr;
-    m_constantComponents[i]    = 0;
-    m_constantComponentSize[i] = 0;
-    delete[] m_constantNames[i];
-    m_constantNames[i] = nullptr;
+    release(c.data);
+    release(c.name);
   }
+  m_constants.clear();
 }
 
 CograBinaryMeshFile::SizeType CograBinaryMeshFile::addConstant(const void* constant, const SizeType nComponents,
                                                                const SizeType     componentSize,
                                                                const std::string& constantName)
 {
-  SizeType size = nComponents * componentSize;
-  auto     p    = new ui8[size];
-
-  memcpy((void*)p, constant, size);
-  m_constants.push_back(p);
-  m_constantComponentSize.push_back(componentSize);
-  m_constantComponents.push_back(nComponents);
-
-  auto* a = new char[N_CHARS];
-  memset((void*)a, '\0', N_CHARS);
-  SizeType l = std::min<SizeType>((SizeType)N_CHARS, (SizeType)constantName.length());
-  for (SizeType i = 0; i < l; i++)
-  {
-    a[i] = constantName[i];
-  }
-
-  m_constantNames.push_back(a);
+  const size_t size    = size_t(nComponents) * componentSize;
+  const auto   retired = reserve(alignBlock(size) + alignBlock(N_CHARS));
+  const Block  data    = allocate(size);
+  std::memcpy(getStorage() + data.offset, constant, size);
+  m_constants.push_back({nComponents, componentSize, data, allocateName(constantName)});
   return (SizeType)m_constants.size();
 }
 
 void* CograBinaryMeshFile::getConstant(SizeType constantIdx) const
 {
-  return m_constants[constantIdx];
+  return getStorage() + m_constants[constantIdx].data.offset;
 }
 
 void CograBinaryMeshFile::overwriteConstants(const CograBinaryMeshFile& src)
 {
+  if (&src == this)
+  {
+    return;
+  }
   freeConstants();
   for (SizeType t = 0; t < src.getNumConstants(); t++)
   {
@@ -499,7 +1278,7 @@ void CograBinaryMeshFile::overwriteConstants(const CograBinaryMeshFile& src)
 int CograBinaryMeshFile::getConstantIdx(const char* name) const
 {
   for (ui32 i = 0; i < getNumConstants(); i++)
-    if (strcmp(name, m_constantNames[i]) == 0)
+    if (strcmp(name, getConstantName(i)) == 0)
     {
       return i;
     }
@@ -552,18 +1331,55 @@ int CograBinaryMeshFile::getIntegerConstant(const char* name, bool* ok /*= 0*/)
 
 void CograBinaryMeshFile::getAllVertexAttributes(void* const result, const SizeType vIdx) const
 {
-  // Add the vertices
-  ((f32* const)result)[vIdx + 0] = m_positions[vIdx + 0];
-  ((f32* const)result)[vIdx + 1] = m_positions[vIdx + 1];
-  ((f32* const)result)[vIdx + 2] = m_positions[vIdx + 2];
-  SizeType offset                = 3 * 4;
-  // Add the attributes.
+  auto* const dst = static_cast<ui8*>(result);
+  std::memcpy(dst, getPositionsPtr() + size_t(vIdx) * 3, 3 * sizeof(FloatType));
+  size_t offset = 3 * sizeof(FloatType);
+  for (SizeType aIdx = 0; aIdx < getNumAttributes(); aIdx++)
+  {
+    const SizeType elementSize = getAttributeElementSize(aIdx);
+    std::memcpy(dst + offset, static_cast<const ui8*>(getAttributePtr(aIdx)) + size_t(vIdx) * elementSize,
+                elementSize);
+    offset += elementSize;
+  }
+}
+
+VertexLayout CograBinaryMeshFile::getPackedVertexLayout() const
+{
+  VertexLayout result;
+  result.elements.push_back({VertexElement::POSITIONS, 0, 3 * sizeof(FloatType)});
+  result.stride = 3 * sizeof(FloatType);
   for (SizeType aIdx = 0; aIdx < getNumAttributes(); aIdx++)
-    for (SizeType cIdx = 0; cIdx < getAttributeElementSize(aIdx); cIdx++)
+  {
+    result.elements.push_back({aIdx, result.stride, getAttributeElementSize(aIdx)});
+    result.stride += getAttributeElementSize(aIdx);
+  }
+  return result;
+}
+
+void CograBinaryMeshFile::getInterleavedVertices(const VertexLayout& layout, void* destination) const
+{
+  std::vector<const void*> streams;
+  streams.reserve(layout.elements.size());
+  for (const auto& element : layout.elements)
+  {
+    if (element.stream == VertexElement::POSITIONS)
     {
-      ((unsigned char* const)result)[offset++] =
-          ((unsigned char const*)getAttributePtr(aIdx))[vIdx * getAttributeElementSize(aIdx) + cIdx];
+      if (element.size != 3 * sizeof(FloatType))
+      {
+        throw std::runtime_error("The size of the position element must be 12 bytes.");
+      }
+      streams.push_back(getPositionsPtr());
     }
+    else
+    {
+      if (element.stream >= getNumAttributes() || element.size != getAttributeElementSize(element.stream))
+      {
+        throw std::runtime_error("A vertex element does not match an attribute of the mesh.");
+      }
+      streams.push_back(getAttributePtr(element.stream));
+    }
+  }
+  interleaveVertices(layout, streams.data(), getNumVertices(), destination);
 }
 
 void CograBinaryMeshFile::printAttributes(std::ostream& stream) const
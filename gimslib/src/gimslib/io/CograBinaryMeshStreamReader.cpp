@@ -0,0 +1,377 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#include <algorithm>
+#include <cstring>
+#include <gimslib/io/CograBinaryMeshStreamReader.hpp>
+#include <stdexcept>
+
+#include "impl/CograBinaryMeshCodec.hpp"
+#include "impl/CograBinaryMeshFormat.hpp"
+
+namespace
+{
+template<class T> T readValue(std::ifstream& inFile)
+{
+  T value;
+  inFile.read((char*)&value, sizeof(T));
+  return value;
+}
+} // namespace
+
+namespace gims
+{
+CograBinaryMeshStreamReader::CograBinaryMeshStreamReader(const std::string& fileName, size_t chunkSize)
+    : m_fileName(fileName)
+    , m_chunkSize(chunkSize)
+{
+  m_file.open(fileName, std::ios::in | std::ios::binary);
+  if (!m_file.is_open())
+  {
+    throw std::runtime_error("Error opening file" + fileName + ".");
+  }
+  m_file.exceptions(std::ifstream::eofbit | std::ifstream::failbit | std::ifstream::badbit);
+
+  char magic[sizeof(impl::cbm::MAGIC)];
+  m_file.read(magic, sizeof(magic));
+  m_file.seekg(0);
+  if (impl::cbm::isV2(magic))
+  {
+    readHeaderV2();
+  }
+  else
+  {
+    readHeaderV1();
+  }
+
+  m_constantValues.resize(m_constants.size());
+  for (size_t i = 0; i < m_constants.size(); i++)
+  {
+    if (m_constants[i].encoding != impl::cbm::ENCODING_RAW)
+    {
+      throw std::runtime_error("Unsupported .cbm section encoding " + std::to_string(m_constants[i].encoding) + ".");
+    }
+    m_constantValues[i].resize(m_constants[i].components * m_constants[i].componentSize);
+    m_file.seekg(m_constants[i].offset);
+    m_file.read((char*)m_constantValues[i].data(), m_constantValues[i].size());
+  }
+}
+
+void CograBinaryMeshStreamReader::readHeaderV1()
+{
+  // The header mirrors CograBinaryMeshFile::readHeader(), but only the element descriptions are kept.
+  const auto readElements = [&](std::vector<Element>& elements)
+  {
+    const SizeType nElements = readValue<SizeType>(m_file);
+    elements.resize(nElements);
+    for (auto& e : elements)
+    {
+      e.components = readValue<SizeType>(m_file);
+      e.encoding   = impl::cbm::ENCODING_RAW;
+    }
+    for (auto& e : elements)
+    {
+      e.componentSize = readValue<SizeType>(m_file);
+    }
+    for (auto& e : elements)
+    {
+      e.name.resize(CograBinaryMeshFile::N_CHARS + 1, '\0');
+      m_file.read(e.name.data(), CograBinaryMeshFile::N_CHARS);
+    }
+  };
+
+  m_nVertices  = readValue<SizeType>(m_file);
+  m_nTriangles = readValue<SizeType>(m_file);
+  readElements(m_attributes);
+  readElements(m_constants);
+
+  // Sections follow each other without gaps.
+  m_positionsOffset = static_cast<ui64>(m_file.tellg());
+  m_trianglesOffset = m_positionsOffset + ui64(m_nVertices) * 3 * sizeof(FloatType);
+  ui64 offset       = m_trianglesOffset + ui64(m_nTriangles) * 3 * sizeof(IndexType);
+  for (auto& a : m_attributes)
+  {
+    a.offset = offset;
+    offset += ui64(a.components) * a.componentSize * m_nVertices;
+  }
+
+  for (auto& c : m_constants)
+  {
+    c.offset = offset;
+    offset += ui64(c.components) * c.componentSize;
+  }
+}
+
+void CograBinaryMeshStreamReader::readHeaderV2()
+{
+  using namespace impl::cbm;
+  const auto header = readValue<FileHeaderV2>(m_file);
+  if (header.version != VERSION_2)
+  {
+    throw std::runtime_error("Unsupported .cbm version " + std::to_string(header.version) + ".");
+  }
+  m_nVertices  = header.nVertices;
+  m_nTriangles = header.nTriangles;
+
+  m_file.seekg(0, std::ios::end);
+  const ui64 fileSize = static_cast<ui64>(m_file.tellg());
+  m_file.seekg(sizeof(header));
+  checkSectionDirectory(header.nSections, fileSize);
+  std::vector<SectionEntryV2> sections(header.nSections);
+  m_file.read((char*)sections.data(), sections.size() * sizeof(SectionEntryV2));
+  checkMeshSections(header, sections, fileSize);
+
+  std::vector<char> names;
+  std::vector<ui32> attributeNameOffsets;
+  std::vector<ui32> constantNameOffsets;
+  for (const auto& section : sections)
+  {
+    if (section.encoding > ENCODING_OCTAHEDRAL16)
+    {
+      throw std::runtime_error("Unsupported .cbm section encoding " + std::to_string(section.encoding) + ".");
+    }
+    switch (section.type)
+    {
+    case SECTION_NAMES:
+      if (section.encoding != ENCODING_RAW)
+      {
+        throw std::runtime_error("Unsupported .cbm section encoding " + std::to_string(section.encoding) + ".");
+      }
+      names.resize(section.size);
+      m_file.seekg(section.offset);
+      m_file.read(names.data(), section.size);
+      break;
+    case SECTION_POSITIONS:
+      m_positionsOffset   = section.offset;
+      m_positionsEncoding = section.encoding;
+      break;
+    case SECTION_TRIANGLES:
+      m_trianglesOffset   = section.offset;
+      m_trianglesEncoding = section.encoding;
+      m_trianglesSize     = section.size;
+      break;
+    case SECTION_ATTRIBUTE:
+      m_attributes.push_back({section.components, section.componentSize, {}, section.offset, section.encoding});
+      attributeNameOffsets.push_back(section.nameOffset);
+      break;
+    case SECTION_CONSTANT:
+      m_constants.push_back({section.components, section.componentSize, {}, section.offset, section.encoding});
+      constantNameOffsets.push_back(section.nameOffset);
+      break;
+    default:
+      // Sections unknown to this version are skipped.
+      break;
+    }
+  }
+
+  const auto assignName = [&](Element& element, ui32 nameOffset)
+  {
+    if (size_t(nameOffset) + CograBinaryMeshFile::N_CHARS > names.size())
+    {
+      throw std::runtime_error("A .cbm name exceeds the names section.");
+    }
+    element.name.assign(names.data() + nameOffset, names.data() + nameOffset + CograBinaryMeshFile::N_CHARS);
+    element.name.push_back('\0');
+  };
+  for (size_t i = 0; i < m_attributes.size(); i++)
+  {
+    assignName(m_attributes[i], attributeNameOffsets[i]);
+  }
+  for (size_t i = 0; i < m_constants.size(); i++)
+  {
+    assignName(m_constants[i], constantNameOffsets[i]);
+  }
+}
+
+void CograBinaryMeshStreamReader::readPositions(const PositionCallback& callback)
+{
+  using namespace impl::cbm;
+  if (m_positionsEncoding == ENCODING_QUANTIZED_AABB16)
+  {
+    PositionQuantization quantization;
+    m_file.seekg(m_positionsOffset);
+    m_file.read((char*)&quantization, sizeof(quantization));
+    readSection(m_positionsOffset + sizeof(quantization), m_nVertices, 3 * sizeof(ui16),
+                [&](const void* data, ui64 first, ui64 count)
+                {
+                  m_decoded.resize(count * 3 * sizeof(FloatType));
+                  dequantizePositions((const ui16*)data, count, quantization, (FloatType*)m_decoded.data());
+                  callback((const FloatType*)m_decoded.data(), static_cast<SizeType>(first),
+                           static_cast<SizeType>(count));
+                });
+    return;
+  }
+  readSection(m_positionsOffset, m_nVertices, 3 * sizeof(FloatType),
+              [&](const void* data, ui64 first, ui64 count)
+              { callback((const FloatType*)data, static_cast<SizeType>(first), static_cast<SizeType>(count)); });
+}
+
+void CograBinaryMeshStreamReader::readTriangles(const TriangleCallback& callback)
+{
+  if (m_trianglesEncoding == impl::cbm::ENCODING_DELTA_VARINT)
+  {
+    readDeltaVarintTriangles(callback);
+    return;
+  }
+  readSection(m_trianglesOffset, m_nTriangles, 3 * sizeof(IndexType),
+              [&](const void* data, ui64 first, ui64 count)
+              { callback((const IndexType*)data, static_cast<SizeType>(first), static_cast<SizeType>(count)); });
+}
+
+void CograBinaryMeshStreamReader::readAttribute(SizeType attributeIdx, const AttributeCallback& callback)
+{
+  if (m_attributes.at(attributeIdx).encoding == impl::cbm::ENCODING_OCTAHEDRAL16)
+  {
+    readSection(m_attributes[attributeIdx].offset, m_nVertices, 2 * sizeof(i16),
+                [&](const void* data, ui64 first, ui64 count)
+                {
+                  m_decoded.resize(count * 3 * sizeof(f32));
+                  impl::cbm::decodeOctahedral((const i16*)data, count, (f32*)m_decoded.data());
+                  callback(m_decoded.data(), static_cast<SizeType>(first), static_cast<SizeType>(count));
+                });
+    return;
+  }
+  readSection(m_attributes.at(attributeIdx).offset, m_nVertices, getAttributeElementSize(attributeIdx),
+              [&](const void* data, ui64 first, ui64 count)
+              { callback(data, static_cast<SizeType>(first), static_cast<SizeType>(count)); });
+}
+
+void CograBinaryMeshStreamReader::readSection(ui64 offset, ui64 nElements, size_t elementSize,
+                                              const std::function<void(const void*, ui64, ui64)>& callback)
+{
+  if (nElements == 0 || elementSize == 0)
+  {
+    return;
+  }
+  // A chunk holds at least one element, and never splits an element.
+  const ui64 elementsPerChunk = std::max<ui64>(1, m_chunkSize / elementSize);
+  m_chunk.resize(elementsPerChunk * elementSize);
+
+  m_file.seekg(offset);
+  for (ui64 first = 0; first < nElements; first += elementsPerChunk)
+  {
+    const ui64 count = std::min(elementsPerChunk, nElements - first);
+    m_file.read((char*)m_chunk.data(), count * elementSize);
+    callback(m_chunk.data(), first, count);
+  }
+}
+
+void CograBinaryMeshStreamReader::readDeltaVarintTriangles(const TriangleCallback& callback)
+{
+  if (m_nTriangles == 0)
+  {
+    return;
+  }
+  // Varints have variable length. Bytes of a varint that is cut off at the end of a chunk are carried over to the
+  // front of the next chunk.
+  const ui64 trianglesPerChunk = std::max<ui64>(1, m_chunkSize / (3 * sizeof(IndexType)));
+  m_decoded.resize(trianglesPerChunk * 3 * sizeof(IndexType));
+  m_chunk.resize(std::max<size_t>(m_chunkSize, 16));
+  auto* indices = (IndexType*)m_decoded.data();
+
+  m_file.seekg(m_trianglesOffset);
+  ui64   remainingBytes = m_trianglesSize;
+  size_t carried        = 0;
+  size_t nBuffered      = 0;
+  ui32   previous       = 0;
+  ui64   first          = 0;
+  while (first < m_nTriangles)
+  {
+    const size_t nRead = static_cast<size_t>(std::min<ui64>(m_chunk.size() - carried, remainingBytes));
+    m_file.read((char*)m_chunk.data() + carried, nRead);
+    remainingBytes -= nRead;
+    const size_t available = carried + nRead;
+
+    size_t position = 0;
+    while (first < m_nTriangles)
+    {
+      const size_t capacity = static_cast<size_t>(std::min(trianglesPerChunk, m_nTriangles - first) * 3);
+      size_t       nDecoded = 0;
+      position += impl::cbm::decodeDeltaVarint(m_chunk.data() + position, available - position, indices + nBuffered,
+                                               capacity - nBuffered, previous, nDecoded);
+      nBuffered += nDecoded;
+      if (nBuffered < capacity)
+      {
+        break;
+      }
+      callback(indices, static_cast<SizeType>(first), static_cast<SizeType>(capacity / 3));
+      first += capacity / 3;
+      nBuffered = 0;
+    }
+
+    if (first < m_nTriangles && nRead == 0)
+    {
+      throw std::runtime_error("The .cbm index section is truncated.");
+    }
+    carried = available - position;
+    std::memmove(m_chunk.data(), m_chunk.data() + position, carried);
+  }
+}
+
+CograBinaryMeshStreamReader::SizeType CograBinaryMeshStreamReader::getNumVertices() const
+{
+  return m_nVertices;
+}
+
+CograBinaryMeshStreamReader::SizeType CograBinaryMeshStreamReader::getNumTriangles() const
+{
+  return m_nTriangles;
+}
+
+CograBinaryMeshStreamReader::SizeType CograBinaryMeshStreamReader::getNumAttributes() const
+{
+  return static_cast<SizeType>(m_attributes.size());
+}
+
+CograBinaryMeshStreamReader::SizeType CograBinaryMeshStreamReader::getAttributeComponentSize(
+    SizeType attributeIdx) const
+{
+  return m_attributes[attributeIdx].componentSize;
+}
+
+CograBinaryMeshStreamReader::SizeType CograBinaryMeshStreamReader::getAttributeComponents(SizeType attributeIdx) const
+{
+  return m_attributes[attributeIdx].components;
+}
+
+CograBinaryMeshStreamReader::SizeType CograBinaryMeshStreamReader::getAttributeElementSize(SizeType attributeIdx) const
+{
+  return m_attributes[attributeIdx].components * m_attributes[attributeIdx].componentSize;
+}
+
+const char* CograBinaryMeshStreamReader::getAttributeName(SizeType attributeIdx) const
+{
+  return m_attributes[attributeIdx].name.data();
+}
+
+CograBinaryMeshStreamReader::SizeType CograBinaryMeshStreamReader::getNumConstants() const
+{
+  return static_cast<SizeType>(m_constants.size());
+}
+
+CograBinaryMeshStreamReader::SizeType CograBinaryMeshStreamReader::getConstantComponentSize(
+    SizeType constantIdx) const
+{
+  return m_constants[constantIdx].componentSize;
+}
+
+CograBinaryMeshStreamReader::SizeType CograBinaryMeshStreamReader::getConstantComponents(SizeType constantIdx) const
+{
+  return m_constants[constantIdx].components;
+}
+
+const void* CograBinaryMeshStreamReader::getConstant(SizeType constantIdx) const
+{
+  return m_constantValues[constantIdx].data();
+}
+
+const char* CograBinaryMeshStreamReader::getConstantName(SizeType constantIdx) const
+{
+  return m_constants[constantIdx].name.data();
+}
+
+size_t CograBinaryMeshStreamReader::getChunkSize() const
+{
+  return m_chunkSize;
+}
+} // namespace gims
@@ -0,0 +1,240 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <gimslib/io/ImageWriter.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+using namespace gims;
+
+//! Largest payload of a stored deflate block.
+constexpr size_t maxStoredBlockSize = 65535;
+
+void appendBigEndian(std::vector<ui8>& buffer, ui32 value)
+{
+  buffer.insert(buffer.end(), {ui8(value >> 24), ui8(value >> 16), ui8(value >> 8), ui8(value)});
+}
+
+template<class T> void appendLittleEndian(std::vector<ui8>& buffer, T value)
+{
+  const size_t size = buffer.size();
+  buffer.resize(size + sizeof(T));
+  std::memcpy(buffer.data() + size, &value, sizeof(T));
+  if constexpr (std::endian::native == std::endian::big)
+  {
+    std::reverse(buffer.begin() + static_cast<std::ptrdiff_t>(size), buffer.end());
+  }
+}
+
+void appendString(std::vector<ui8>& buffer, const char* string)
+{
+  buffer.insert(buffer.end(), string, string + std::strlen(string) + 1);
+}
+
+//! CRC-32 of the PNG chunks, computed bytewise with the reflected polynomial 0xedb88320.
+ui32 updateCrc32(ui32 crc, const ui8* data, size_t size)
+{
+  static const auto table = []()
+  {
+    std::array<ui32, 256> result;
+    for (ui32 i = 0; i < 256; i++)
+    {
+      ui32 c = i;
+      for (ui32 k = 0; k < 8; k++)
+      {
+        c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+      }
+      result[i] = c;
+    }
+    return result;
+  }();
+  crc = ~crc;
+  for (size_t i = 0; i < size; i++)
+  {
+    crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+//! Adler-32 checksum that ends a zlib stream.
+ui32 computeAdler32(const ui8* data, size_t size)
+{
+  // 5552 is the largest number of bytes whose sums cannot overflow 32 bits before the modulo.
+  ui32 a = 1;
+  ui32 b = 0;
+  for (size_t begin = 0; begin < size; begin += 5552)
+  {
+    const size_t end = std::min(size, begin + 5552);
+    for (size_t i = begin; i < end; i++)
+    {
+      a += data[i];
+      b += a;
+    }
+    a %= 65521;
+    b %= 65521;
+  }
+  return (b << 16) | a;
+}
+
+void appendChunk(std::vector<ui8>& file, const char* type, const std::vector<ui8>& data)
+{
+  appendBigEndian(file, static_cast<ui32>(data.size()));
+  const size_t typeOffset = file.size();
+  file.insert(file.end(), type, type + 4);
+  file.insert(file.end(), data.begin(), data.end());
+  appendBigEndian(file, updateCrc32(0, file.data() + typeOffset, file.size() - typeOffset));
+}
+
+void writeFile(const std::filesystem::path& fileName, const std::vector<ui8>& data)
+{
+  std::ofstream outFile(fileName, std::ios::out | std::ios::binary);
+  outFile.write(reinterpret_cast<const char*>(data.data()), std::streamsize(data.size()));
+  outFile.close();
+  if (!outFile)
+  {
+    throw std::runtime_error("Error writing file " + fileName.string() + ".");
+  }
+}
+} // namespace
+
+namespace gims
+{
+void writePNG(const std::filesystem::path& fileName, const ui8* pixels, ui32 width, ui32 height, ui32 nChannels)
+{
+  static const ui8 colorTypes[] = {0, 4, 2, 6};
+  if (nChannels < 1 || nChannels > 4)
+  {
+    throw std::runtime_error("PNG images have 1 to 4 channels.");
+  }
+
+  // Every row starts with filter type 0, i.e., the bytes are stored as they are.
+  const size_t     rowSize = size_t(width) * nChannels;
+  std::vector<ui8> rows;
+  rows.reserve((rowSize + 1) * height);
+  for (ui32 y = 0; y < height; y++)
+  {
+    rows.push_back(0);
+    rows.insert(rows.end(), pixels + y * rowSize, pixels + (y + 1) * rowSize);
+  }
+
+  // zlib stream of stored deflate blocks.
+  std::vector<ui8> imageData = {0x78, 0x01};
+  imageData.reserve(rows.size() + rows.size() / maxStoredBlockSize * 5 + 16);
+  size_t offset = 0;
+  do
+  {
+    const size_t blockSize = std::min(maxStoredBlockSize, rows.size() - offset);
+    const bool   isFinal   = offset + blockSize == rows.size();
+    imageData.insert(imageData.end(), {ui8(isFinal ? 1 : 0), ui8(blockSize), ui8(blockSize >> 8),
+                                       ui8(~blockSize), ui8(~blockSize >> 8)});
+    imageData.insert(imageData.end(), rows.begin() + offset, rows.begin() + offset + blockSize);
+    offset += blockSize;
+  } while (offset < rows.size());
+  appendBigEndian(imageData, computeAdler32(rows.data(), rows.size()));
+
+  std::vector<ui8> header;
+  appendBigEndian(header, width);
+  appendBigEndian(header, height);
+  header.insert(header.end(), {8, colorTypes[nChannels - 1], 0, 0, 0});
+
+  std::vector<ui8> file = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+  file.reserve(imageData.size() + 64);
+  appendChunk(file, "IHDR", header);
+  appendChunk(file, "IDAT", imageData);
+  appendChunk(file, "IEND", {});
+  writeFile(fileName, file);
+}
+
+void writeEXR(const std::filesystem::path& fileName, const f32* pixels, ui32 width, ui32 height, ui32 nChannels)
+{
+  // Channels are stored in alphabetical order of their names. channelIdx maps them to the components of a pixel.
+  const char* const names[]      = {"A", "B", "G", "R"};
+  const ui32        channelIdx[] = {3, 2, 1, 0};
+  std::vector<ui32> channels;
+  if (nChannels == 1)
+  {
+    channels = {0};
+  }
+  else if (nChannels == 3 || nChannels == 4)
+  {
+    for (ui32 i = nChannels == 4 ? 0 : 1; i < 4; i++)
+    {
+      channels.push_back(i);
+    }
+  }
+  else
+  {
+    throw std::runtime_error("EXR images have 1, 3, or 4 channels.");
+  }
+
+  std::vector<ui8> file;
+  appendLittleEndian<ui32>(file, 20000630); // magic number
+  appendLittleEndian<ui32>(file, 2);        // version 2, single-part scanline image
+
+  std::vector<ui8> channelList;
+  for (const ui32 c : channels)
+  {
+    appendString(channelList, nChannels == 1 ? "Y" : names[c]);
+    appendLittleEndian<i32>(channelList, 2); // FLOAT
+    channelList.insert(channelList.end(), {0, 0, 0, 0});
+    appendLittleEndian<i32>(channelList, 1);
+    appendLittleEndian<i32>(channelList, 1);
+  }
+  channelList.push_back(0);
+
+  const auto appendAttribute = [&](const char* name, const char* type, const std::vector<ui8>& value)
+  {
+    appendString(file, name);
+    appendString(file, type);
+    appendLittleEndian<i32>(file, static_cast<i32>(value.size()));
+    file.insert(file.end(), value.begin(), value.end());
+  };
+  std::vector<ui8> window;
+  for (const i32 v : {0, 0, i32(width) - 1, i32(height) - 1})
+  {
+    appendLittleEndian<i32>(window, v);
+  }
+  std::vector<ui8> one;
+  appendLittleEndian<f32>(one, 1.0f);
+  appendAttribute("channels", "chlist", channelList);
+  appendAttribute("compression", "compression", {0});
+  appendAttribute("dataWindow", "box2i", window);
+  appendAttribute("displayWindow", "box2i", window);
+  appendAttribute("lineOrder", "lineOrder", {0});
+  appendAttribute("pixelAspectRatio", "float", one);
+  appendAttribute("screenWindowCenter", "v2f", std::vector<ui8>(8, 0));
+  appendAttribute("screenWindowWidth", "float", one);
+  file.push_back(0);
+
+  // Offset table, followed by one block per scanline: y, size of the data, and the rows of the channels.
+  const ui32 lineSize  = width * static_cast<ui32>(channels.size()) * sizeof(f32);
+  const ui64 firstLine = file.size() + ui64(height) * sizeof(ui64);
+  file.reserve(firstLine + ui64(height) * (lineSize + 8));
+  for (ui32 y = 0; y < height; y++)
+  {
+    appendLittleEndian<ui64>(file, firstLine + ui64(y) * (lineSize + 8));
+  }
+  for (ui32 y = 0; y < height; y++)
+  {
+    appendLittleEndian<i32>(file, static_cast<i32>(y));
+    appendLittleEndian<ui32>(file, lineSize);
+    for (const ui32 c : channels)
+    {
+      const ui32 component = nChannels == 1 ? 0 : channelIdx[c];
+      for (ui32 x = 0; x < width; x++)
+      {
+        appendLittleEndian<f32>(file, pixels[(size_t(y) * width + x) * nChannels + component]);
+      }
+    }
+  }
+  writeFile(fileName, file);
+}
+} // namespace gims
@@ -0,0 +1,246 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#include <algorithm>
+#include <cstring>
+#include <gimslib/io/VertexLayout.hpp>
+#include <gimslib/sys/CpuFeatures.hpp>
+#include <stdexcept>
+#ifdef GIMS_X64
+#include <immintrin.h>
+#endif
+
+namespace
+{
+using namespace gims;
+
+//! An element of a layout together with its planar stream.
+struct Stream
+{
+  ui8* data;
+  ui32 offset;
+  ui32 size;
+};
+
+//! Validates the layout and pairs its elements with the streams, sorted by offset.
+std::vector<Stream> getStreams(const VertexLayout& layout, void* const* streams)
+{
+  if (layout.stride == 0)
+  {
+    throw std::runtime_error("The stride of a vertex layout must not be zero.");
+  }
+  std::vector<Stream> result;
+  result.reserve(layout.elements.size());
+  for (size_t eIdx = 0; eIdx < layout.elements.size(); eIdx++)
+  {
+    const auto& element = layout.elements[eIdx];
+    if (element.size == 0 || size_t(element.offset) + element.size > layout.stride)
+    {
+      throw std::runtime_error("A vertex element must be non-empty and lie within the stride.");
+    }
+    result.push_back({static_cast<ui8*>(streams[eIdx]), element.offset, element.size});
+  }
+  std::sort(result.begin(), result.end(), [](const Stream& a, const Stream& b) { return a.offset < b.offset; });
+  for (size_t eIdx = 1; eIdx < result.size(); eIdx++)
+  {
+    if (result[eIdx - 1].offset + result[eIdx - 1].size > result[eIdx].offset)
+    {
+      throw std::runtime_error("The elements of a vertex layout must not overlap.");
+    }
+  }
+  return result;
+}
+
+//! \brief Number of leading vertices that can be copied in chunks of chunkSize bytes.
+//!
+//! The vector kernels copy every element with whole chunks and thus read and write up to chunkSize - 1 bytes past
+//! its end. That is harmless as long as the excess stays inside the buffers: the bytes behind an element belong to
+//! an element with a larger offset, to padding or to the next vertex, and all of them are written afterwards. This
+//! function returns the number of vertices for which no chunk leaves the interleaved or the planar buffer.
+size_t getNumChunkedVertices(const std::vector<Stream>& streams, ui32 stride, size_t nVertices, ui32 chunkSize)
+{
+  size_t result = nVertices;
+  for (const auto& stream : streams)
+  {
+    const size_t wideSize = (size_t(stream.size) + chunkSize - 1) / chunkSize * chunkSize;
+    if (nVertices * stride < stream.offset + wideSize || nVertices * stream.size < wideSize)
+    {
+      return 0;
+    }
+    result = std::min(result, (nVertices * stride - stream.offset - wideSize) / stride + 1);
+    result = std::min(result, (nVertices * stream.size - wideSize) / stream.size + 1);
+  }
+  return result;
+}
+
+template <ui32 Size> inline void copyFixed(ui8* dst, const ui8* src)
+{
+  std::memcpy(dst, src, Size);
+}
+
+//! Copies exactly size bytes. The common sizes compile to plain moves.
+inline void copyElement(ui8* dst, const ui8* src, ui32 size)
+{
+  switch (size)
+  {
+  case 4:
+    copyFixed<4>(dst, src);
+    break;
+  case 8:
+    copyFixed<8>(dst, src);
+    break;
+  case 12:
+    copyFixed<12>(dst, src);
+    break;
+  case 16:
+    copyFixed<16>(dst, src);
+    break;
+  default:
+    std::memcpy(dst, src, size);
+    break;
+  }
+}
+
+void interleaveScalar(const std::vector<Stream>& streams, ui32 stride, size_t begin, size_t end, ui8* destination)
+{
+  for (size_t vIdx = begin; vIdx < end; vIdx++)
+  {
+    ui8* const vertex = destination + vIdx * stride;
+    for (const auto& stream : streams)
+    {
+      copyElement(vertex + stream.offset, stream.data + vIdx * stream.size, stream.size);
+    }
+  }
+}
+
+void deinterleaveScalar(const std::vector<Stream>& streams, ui32 stride, size_t begin, size_t end, const ui8* source)
+{
+  for (const auto& stream : streams)
+  {
+    for (size_t vIdx = begin; vIdx < end; vIdx++)
+    {
+      copyElement(stream.data + vIdx * stream.size, source + vIdx * stride + stream.offset, stream.size);
+    }
+  }
+}
+
+#ifdef GIMS_X64
+// The vector kernels must visit the vertices in ascending order and, within a vertex, the elements in ascending
+// offset order. Otherwise, the excess of a chunk would overwrite bytes that were already written.
+
+void interleaveSSE2(const std::vector<Stream>& streams, ui32 stride, size_t end, ui8* destination)
+{
+  for (size_t vIdx = 0; vIdx < end; vIdx++)
+  {
+    ui8* const vertex = destination + vIdx * stride;
+    for (const auto& stream : streams)
+    {
+      const ui8* src = stream.data + vIdx * stream.size;
+      ui8*       dst = vertex + stream.offset;
+      for (ui32 cIdx = 0; cIdx < stream.size; cIdx += 16)
+      {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + cIdx),
+                         _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + cIdx)));
+      }
+    }
+  }
+}
+
+void deinterleaveSSE2(const std::vector<Stream>& streams, ui32 stride, size_t end, const ui8* source)
+{
+  for (const auto& stream : streams)
+  {
+    for (size_t vIdx = 0; vIdx < end; vIdx++)
+    {
+      const ui8* src = source + vIdx * stride + stream.offset;
+      ui8*       dst = stream.data + vIdx * stream.size;
+      for (ui32 cIdx = 0; cIdx < stream.size; cIdx += 16)
+      {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + cIdx),
+                         _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + cIdx)));
+      }
+    }
+  }
+}
+
+GIMS_TARGET_AVX2 void interleaveAVX2(const std::vector<Stream>& streams, ui32 stride, size_t end, ui8* destination)
+{
+  for (size_t vIdx = 0; vIdx < end; vIdx++)
+  {
+    ui8* const vertex = destination + vIdx * stride;
+    for (const auto& stream : streams)
+    {
+      const ui8* src = stream.data + vIdx * stream.size;
+      ui8*       dst = vertex + stream.offset;
+      for (ui32 cIdx = 0; cIdx < stream.size; cIdx += 32)
+      {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + cIdx),
+                            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + cIdx)));
+      }
+    }
+  }
+  _mm256_zeroupper();
+}
+
+GIMS_TARGET_AVX2 void deinterleaveAVX2(const std::vector<Stream>& streams, ui32 stride, size_t end, const ui8* source)
+{
+  for (const auto& stream : streams)
+  {
+    for (size_t vIdx = 0; vIdx < end; vIdx++)
+    {
+      const ui8* src = source + vIdx * stride + stream.offset;
+      ui8*       dst = stream.data + vIdx * stream.size;
+      for (ui32 cIdx = 0; cIdx < stream.size; cIdx += 32)
+      {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + cIdx),
+                            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + cIdx)));
+      }
+    }
+  }
+  _mm256_zeroupper();
+}
+#endif
+} // namespace
+
+namespace gims
+{
+void interleaveVertices(const VertexLayout& layout, const void* const* streams, size_t nVertices, void* destination)
+{
+  const auto sorted = getStreams(layout, const_cast<void* const*>(streams));
+  auto*      dst    = static_cast<ui8*>(destination);
+  size_t     nDone  = 0;
+#ifdef GIMS_X64
+  if (getCpuFeatures().avx2)
+  {
+    nDone = getNumChunkedVertices(sorted, layout.stride, nVertices, 32);
+    interleaveAVX2(sorted, layout.stride, nDone, dst);
+  }
+  else
+  {
+    nDone = getNumChunkedVertices(sorted, layout.stride, nVertices, 16);
+    interleaveSSE2(sorted, layout.stride, nDone, dst);
+  }
+#endif
+  interleaveScalar(sorted, layout.stride, nDone, nVertices, dst);
+}
+
+void deinterleaveVertices(const VertexLayout& layout, const void* source, size_t nVertices, void* const* streams)
+{
+  const auto sorted = getStreams(layout, streams);
+  const auto src    = static_cast<const ui8*>(source);
+  size_t     nDone  = 0;
+#ifdef GIMS_X64
+  if (getCpuFeatures().avx2)
+  {
+    nDone = getNumChunkedVertices(sorted, layout.stride, nVertices, 32);
+    deinterleaveAVX2(sorted, layout.stride, nDone, src);
+  }
+  else
+  {
+    nDone = getNumChunkedVertices(sorted, layout.stride, nVertices, 16);
+    deinterleaveSSE2(sorted, layout.stride, nDone, src);
+  }
+#endif
+  deinterleaveScalar(sorted, layout.stride, nDone, nVertices, src);
+}
+} // namespace gims
@@ -0,0 +1,261 @@
+#include "CograBinaryMeshCodec.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <gimslib/sys/CpuFeatures.hpp>
+#include <limits>
+#include <stdexcept>
+#ifdef GIMS_X64
+#include <immintrin.h>
+#endif
+
+namespace
+{
+using gims::f32;
+using gims::i32;
+using gims::ui32;
+
+inline ui32 zigzag(ui32 delta)
+{
+  return (delta << 1) ^ static_cast<ui32>(static_cast<i32>(delta) >> 31);
+}
+
+inline ui32 unzigzag(ui32 value)
+{
+  return (value >> 1) ^ (0u - (value & 1u));
+}
+
+inline f32 signNotZero(f32 v)
+{
+  return v >= 0.0f ? 1.0f : -1.0f;
+}
+
+#ifdef GIMS_X64
+//! Decodes 16 single-byte varints, i.e., bytes below 0x80: the codes are unzigzagged in four lanes and summed up
+//! starting at previous. Returns the last value.
+inline ui32 decodeSingleByteBlock(__m128i bytes, ui32 previous, ui32* dst)
+{
+  const __m128i zero     = _mm_setzero_si128();
+  const __m128i one      = _mm_set1_epi32(1);
+  const __m128i low      = _mm_unpacklo_epi8(bytes, zero);
+  const __m128i high     = _mm_unpackhi_epi8(bytes, zero);
+  const __m128i codes[4] = {_mm_unpacklo_epi16(low, zero), _mm_unpackhi_epi16(low, zero),
+                            _mm_unpacklo_epi16(high, zero), _mm_unpackhi_epi16(high, zero)};
+  __m128i       running  = _mm_set1_epi32(static_cast<i32>(previous));
+  for (const __m128i& code : codes)
+  {
+    __m128i delta = _mm_xor_si128(_mm_srli_epi32(code, 1), _mm_sub_epi32(zero, _mm_and_si128(code, one)));
+    delta         = _mm_add_epi32(delta, _mm_slli_si128(delta, 4));
+    delta         = _mm_add_epi32(delta, _mm_slli_si128(delta, 8));
+    running       = _mm_add_epi32(delta, running);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), running);
+    running = _mm_shuffle_epi32(running, _MM_SHUFFLE(3, 3, 3, 3));
+    dst += 4;
+  }
+  return static_cast<ui32>(_mm_cvtsi128_si32(running));
+}
+#endif
+} // namespace
+
+namespace gims
+{
+namespace impl
+{
+namespace cbm
+{
+void encodeDeltaVarint(const ui32* values, size_t count, std::vector<ui8>& out)
+{
+  out.reserve(out.size() + count * 2);
+  ui32 previous = 0;
+  for (size_t i = 0; i < count; i++)
+  {
+    // Unsigned subtraction wraps, zigzag maps small negative and positive deltas to small codes.
+    ui32 code = zigzag(values[i] - previous);
+    previous  = values[i];
+    while (code >= 0x80)
+    {
+      out.push_back(static_cast<ui8>(code | 0x80));
+      code >>= 7;
+    }
+    out.push_back(static_cast<ui8>(code));
+  }
+}
+
+size_t decodeDeltaVarint(const ui8* src, size_t srcSize, ui32* dst, size_t count, ui32& previous, size_t& nDecoded)
+{
+  size_t consumed = 0;
+  size_t n        = 0;
+  ui32   value    = previous;
+#ifdef GIMS_X64
+  // Blocks are only tried again behind the first multi-byte varint of the last block that failed.
+  size_t nextBlock = 0;
+#endif
+  while (n < count && consumed < srcSize)
+  {
+#ifdef GIMS_X64
+    // Most deltas of a vertex cache optimized mesh fit into a single byte, so runs of 16 are decoded at once.
+    if (consumed >= nextBlock && count - n >= 16 && srcSize - consumed >= 16)
+    {
+      const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + consumed));
+      const ui32    mask  = static_cast<ui32>(_mm_movemask_epi8(bytes));
+      if (mask == 0)
+      {
+        value = decodeSingleByteBlock(bytes, value, dst + n);
+        n += 16;
+        consumed += 16;
+        continue;
+      }
+      nextBlock = consumed + static_cast<size_t>(std::countr_zero(mask)) + 1;
+    }
+#endif
+    const ui8 first = src[consumed];
+    // Single-byte varints outside of blocks.
+    if (first < 0x80)
+    {
+      value += unzigzag(first);
+      dst[n++] = value;
+      consumed++;
+      continue;
+    }
+
+    ui32   code     = 0;
+    ui32   shift    = 0;
+    size_t p        = consumed;
+    bool   complete = false;
+    while (p < srcSize)
+    {
+      const ui8 b = src[p++];
+      code |= static_cast<ui32>(b & 0x7f) << shift;
+      if (b < 0x80)
+      {
+        complete = true;
+        break;
+      }
+      shift += 7;
+      if (shift > 28)
+      {
+        throw std::runtime_error("Malformed varint in .cbm index section.");
+      }
+    }
+    if (!complete)
+    {
+      break;
+    }
+    value += unzigzag(code);
+    dst[n++] = value;
+    consumed = p;
+  }
+  previous = value;
+  nDecoded = n;
+  return consumed;
+}
+
+PositionQuantization computeQuantization(const f32* positions, size_t nVertices)
+{
+  PositionQuantization result = {};
+  if (nVertices == 0)
+  {
+    return result;
+  }
+  f32 max[3];
+  for (int c = 0; c < 3; c++)
+  {
+    result.min[c] = positions[c];
+    max[c]        = positions[c];
+  }
+  for (size_t i = 1; i < nVertices; i++)
+  {
+    for (int c = 0; c < 3; c++)
+    {
+      result.min[c] = std::min(result.min[c], positions[i * 3 + c]);
+      max[c]        = std::max(max[c], positions[i * 3 + c]);
+    }
+  }
+  for (int c = 0; c < 3; c++)
+  {
+    result.scale[c] = (max[c] - result.min[c]) / 65535.0f;
+  }
+  return result;
+}
+
+void quantizePositions(const f32* positions, size_t nVertices, const PositionQuantization& quantization, ui16* dst)
+{
+  f32 invScale[3];
+  for (int c = 0; c < 3; c++)
+  {
+    invScale[c] = quantization.scale[c] > 0.0f ? 1.0f / quantization.scale[c] : 0.0f;
+  }
+  for (size_t i = 0; i < nVertices * 3; i++)
+  {
+    const int c = static_cast<int>(i % 3);
+    const f32 q = (positions[i] - quantization.min[c]) * invScale[c] + 0.5f;
+    dst[i]      = static_cast<ui16>(std::clamp(q, 0.0f, 65535.0f));
+  }
+}
+
+void dequantizePositions(const ui16* src, size_t nVertices, const PositionQuantization& quantization, f32* dst)
+{
+  const f32 minX = quantization.min[0], minY = quantization.min[1], minZ = quantization.min[2];
+  const f32 scaleX = quantization.scale[0], scaleY = quantization.scale[1], scaleZ = quantization.scale[2];
+  for (size_t i = 0; i < nVertices; i++)
+  {
+    dst[i * 3 + 0] = minX + static_cast<f32>(src[i * 3 + 0]) * scaleX;
+    dst[i * 3 + 1] = minY + static_cast<f32>(src[i * 3 + 1]) * scaleY;
+    dst[i * 3 + 2] = minZ + static_cast<f32>(src[i * 3 + 2]) * scaleZ;
+  }
+}
+
+bool isUnitLength(const f32* vectors, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    const f32 x = vectors[i * 3 + 0], y = vectors[i * 3 + 1], z = vectors[i * 3 + 2];
+    if (!(std::abs(x * x + y * y + z * z - 1.0f) < 2e-3f))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+void encodeOctahedral(const f32* vectors, size_t n, i16* dst)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    const f32 x = vectors[i * 3 + 0], y = vectors[i * 3 + 1], z = vectors[i * 3 + 2];
+    // Project onto the octahedron |x| + |y| + |z| = 1 and fold the lower hemisphere over the diagonals.
+    const f32 invL1 = 1.0f / (std::abs(x) + std::abs(y) + std::abs(z));
+    f32       u     = x * invL1;
+    f32       v     = y * invL1;
+    if (z < 0.0f)
+    {
+      const f32 foldedU = (1.0f - std::abs(v)) * signNotZero(u);
+      const f32 foldedV = (1.0f - std::abs(u)) * signNotZero(v);
+      u                 = foldedU;
+      v                 = foldedV;
+    }
+    dst[i * 2 + 0] = static_cast<i16>(std::round(std::clamp(u, -1.0f, 1.0f) * 32767.0f));
+    dst[i * 2 + 1] = static_cast<i16>(std::round(std::clamp(v, -1.0f, 1.0f) * 32767.0f));
+  }
+}
+
+void decodeOctahedral(const i16* src, size_t n, f32* dst)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    f32       u = std::max(static_cast<f32>(src[i * 2 + 0]) * (1.0f / 32767.0f), -1.0f);
+    f32       v = std::max(static_cast<f32>(src[i * 2 + 1]) * (1.0f / 32767.0f), -1.0f);
+    const f32 w = 1.0f - std::abs(u) - std::abs(v);
+    // Unfolds the lower hemisphere without branching.
+    const f32 t = std::max(-w, 0.0f);
+    u -= std::copysign(t, u);
+    v -= std::copysign(t, v);
+    const f32 invLength = 1.0f / std::sqrt(u * u + v * v + w * w);
+    dst[i * 3 + 0]      = u * invLength;
+    dst[i * 3 + 1]      = v * invLength;
+    dst[i * 3 + 2]      = w * invLength;
+  }
+}
+} // namespace cbm
+} // namespace impl
+} // namespace gims
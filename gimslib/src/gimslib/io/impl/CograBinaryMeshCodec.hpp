@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <gimslib/types.hpp>
+#include <vector>
+
+namespace gims
+{
+namespace impl
+{
+//! \brief Encoders and decoders for compressed sections of version 2 Cogra binary mesh files.
+//!
+//! The fixed-rate decoders for positions and unit vectors are straight loops without data-dependent branches, so that
+//! the compiler vectorizes them. The varint decoder has a fast path for the common case of single byte deltas.
+namespace cbm
+{
+//! Maps 16 bit integer coordinates back to the bounding box of the positions: p = min + q * scale.
+struct PositionQuantization
+{
+  f32 min[3];
+  f32 scale[3];
+};
+static_assert(sizeof(PositionQuantization) == 24);
+
+//! \brief Appends the delta and varint encoded values to out.
+void encodeDeltaVarint(const ui32* values, size_t count, std::vector<ui8>& out);
+
+//! \brief Decodes up to count values.
+//!
+//! Decoding stops early if src ends in the middle of a varint, so a stream can be decoded in pieces.
+//! \param[in]      src Encoded bytes.
+//! \param[in]      srcSize Number of encoded bytes.
+//! \param[out]     dst Receives the decoded values.
+//! \param[in]      count Maximum number of values to decode.
+//! \param[in,out]  previous Last value of the previous piece. Start with 0.
+//! \param[out]     nDecoded Number of decoded values.
+//! \return Number of consumed bytes.
+size_t decodeDeltaVarint(const ui8* src, size_t srcSize, ui32* dst, size_t count, ui32& previous, size_t& nDecoded);
+
+//! \brief Computes the quantization of the bounding box of nVertices positions.
+PositionQuantization computeQuantization(const f32* positions, size_t nVertices);
+
+//! \brief Quantizes nVertices positions to three ui16 each.
+void quantizePositions(const f32* positions, size_t nVertices, const PositionQuantization& quantization, ui16* dst);
+
+//! \brief Reconstructs nVertices positions.
+void dequantizePositions(const ui16* src, size_t nVertices, const PositionQuantization& quantization, f32* dst);
+
+//! \brief Returns true, if all n vectors of three f32 have unit length.
+bool isUnitLength(const f32* vectors, size_t n);
+
+//! \brief Encodes n unit vectors of three f32 to two snorm16 each.
+void encodeOctahedral(const f32* vectors, size_t n, i16* dst);
+
+//! \brief Decodes n unit vectors of three f32.
+void decodeOctahedral(const i16* src, size_t n, f32* dst);
+} // namespace cbm
+} // namespace impl
+} // namespace gims
@@ -0,0 +1,114 @@
+#pragma once
+#include <cstring>
+#include <gimslib/io/CograBinaryMeshFile.hpp>
+#include <gimslib/types.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace gims
+{
+namespace impl
+{
+//! \brief On-disk layout of version 2 Cogra binary mesh files.
+//!
+//! A v2 file starts with a 64 byte FileHeaderV2, followed by the section directory (one SectionEntryV2 per section).
+//! Every payload starts at a multiple of SECTION_ALIGNMENT bytes from the beginning of the file and carries the hash64()
+//! of its bytes in its directory entry. v1 files start with the vertex count instead of the magic.
+namespace cbm
+{
+constexpr char MAGIC[8]          = {'C', 'o', 'g', 'r', 'a', 'C', 'B', 'M'};
+constexpr ui32 VERSION_2         = 2;
+constexpr ui64 SECTION_ALIGNMENT = 64;
+
+//! Type of a section.
+enum SectionType : ui32
+{
+  SECTION_NAMES     = 1, //! Attribute and constant names, each padded to N_CHARS bytes.
+  SECTION_POSITIONS = 2, //! Three FloatType per vertex.
+  SECTION_TRIANGLES = 3, //! Three IndexType per triangle.
+  SECTION_ATTRIBUTE = 4, //! One attribute element per vertex.
+  SECTION_CONSTANT  = 5  //! One constant.
+};
+
+//! Encoding of a section payload.
+enum SectionEncoding : ui32
+{
+  ENCODING_RAW              = 0, //! The payload is stored as is.
+  ENCODING_DELTA_VARINT     = 1, //! Indices: zigzag encoded difference to the previous index as LEB128 varint.
+  ENCODING_QUANTIZED_AABB16 = 2, //! Positions: PositionQuantization followed by three ui16 per vertex.
+  ENCODING_OCTAHEDRAL16     = 3  //! Unit vectors of three f32: two snorm16 on the octahedron per element.
+};
+
+struct FileHeaderV2
+{
+  char magic[8];    //! MAGIC.
+  ui32 version;     //! VERSION_2.
+  ui32 nSections;   //! Number of entries in the section directory.
+  ui32 nVertices;   //! Number of vertices.
+  ui32 nTriangles;  //! Number of triangles.
+  ui8  reserved[40];
+};
+static_assert(sizeof(FileHeaderV2) == 64);
+
+struct SectionEntryV2
+{
+  ui32 type;          //! SectionType.
+  ui32 encoding;      //! SectionEncoding of the payload.
+  ui32 components;    //! Number of components of an attribute or constant element.
+  ui32 componentSize; //! Size in bytes of one component.
+  ui32 nameOffset;    //! Offset of the name within the names section.
+  ui32 reserved;
+  ui64 offset;        //! Offset of the payload from the beginning of the file.
+  ui64 size;          //! Size of the encoded payload in bytes.
+  ui64 hash;          //! hash64() of the encoded payload.
+};
+static_assert(sizeof(SectionEntryV2) == 48);
+
+//! Rounds offset up to the next multiple of SECTION_ALIGNMENT.
+inline ui64 alignSection(ui64 offset)
+{
+  return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+}
+
+//! Throws if the section directory of nSections entries does not fit into a file of fileSize bytes, so that a corrupt
+//! header fails before the directory is allocated.
+inline void checkSectionDirectory(ui32 nSections, ui64 fileSize)
+{
+  if (sizeof(FileHeaderV2) + ui64(nSections) * sizeof(SectionEntryV2) > fileSize)
+  {
+    throw std::runtime_error("Unsupported .cbm section directory of " + std::to_string(nSections) + " sections.");
+  }
+}
+
+//! Throws if the directory lacks the positions of the vertices or the triangles of the header, or if the counts of
+//! the header exceed what a file of fileSize bytes can encode, so that a corrupt header fails before the mesh is
+//! allocated. Positions take at least three ui16 per vertex and indices at least one byte each.
+inline void checkMeshSections(const FileHeaderV2& header, const std::vector<SectionEntryV2>& sections, ui64 fileSize)
+{
+  bool hasPositions = false;
+  bool hasTriangles = false;
+  for (const auto& section : sections)
+  {
+    hasPositions = hasPositions || section.type == SECTION_POSITIONS;
+    hasTriangles = hasTriangles || section.type == SECTION_TRIANGLES;
+  }
+  if ((header.nVertices > 0 && !hasPositions) || (header.nTriangles > 0 && !hasTriangles))
+  {
+    throw std::runtime_error("A .cbm file lacks its positions or triangles section.");
+  }
+  if (ui64(header.nVertices) * 3 * sizeof(ui16) + ui64(header.nTriangles) * 3 > fileSize)
+  {
+    throw std::runtime_error("Unsupported .cbm header of " + std::to_string(header.nVertices) + " vertices and " +
+                             std::to_string(header.nTriangles) + " triangles.");
+  }
+}
+
+//! True, if the first bytes of a file are the v2 magic.
+inline bool isV2(const void* firstBytes)
+{
+  return std::memcmp(firstBytes, MAGIC, sizeof(MAGIC)) == 0;
+}
+} // namespace cbm
+} // namespace impl
+} // namespace gims
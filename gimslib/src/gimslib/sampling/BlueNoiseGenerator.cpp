@@ -0,0 +1,101 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#include "impl/VoidAndCluster.hpp"
+#include <algorithm>
+#include <gimslib/sampling/BlueNoiseGenerator.hpp>
+#include <gimslib/sys/Hash.hpp>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <numeric>
+#include <stdexcept>
+
+namespace
+{
+using namespace gims;
+
+//! Replaces the ranks of a slice by their order within the slice, which keeps the order but makes the values of the
+//! slice uniformly distributed.
+void rankWithinSlices(std::vector<ui32>& ranks, ui32 nTexelsPerSlice)
+{
+  std::vector<ui32> order(nTexelsPerSlice);
+  for (size_t first = 0; first < ranks.size(); first += nTexelsPerSlice)
+  {
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&](ui32 a, ui32 b) { return ranks[first + a] < ranks[first + b]; });
+    for (ui32 rank = 0; rank < nTexelsPerSlice; rank++)
+    {
+      ranks[first + order[rank]] = rank;
+    }
+  }
+}
+} // namespace
+
+namespace gims
+{
+BlueNoiseTile BlueNoiseTexture::getSlice(ui32 z) const
+{
+  const size_t nValuesPerSlice = size_t(width) * height * nChannels;
+  const auto   first           = values.begin() + static_cast<std::ptrdiff_t>(z * nValuesPerSlice);
+  return BlueNoiseTile(width, height, nChannels,
+                       std::vector<f32>(first, first + static_cast<std::ptrdiff_t>(nValuesPerSlice)));
+}
+
+BlueNoiseTexture generateBlueNoise(const BlueNoiseOptions& options, ThreadPool* threadPool)
+{
+  if (options.width == 0 || options.height == 0 || options.depth == 0 || options.nChannels == 0)
+  {
+    throw std::runtime_error("The blue-noise texture must not be empty.");
+  }
+  // TEXTURE_2D ranks every slice on its own, the other kinds rank the volume.
+  const bool isVolume            = options.type != BlueNoiseType::TEXTURE_2D;
+  const ui32 nTexelsPerSlice     = options.width * options.height;
+  const ui32 nTexelsPerTexture   = isVolume ? nTexelsPerSlice * options.depth : nTexelsPerSlice;
+  const ui32 nTexturesPerChannel = isVolume ? 1 : options.depth;
+
+  impl::VoidAndClusterDomain domain;
+  domain.width            = options.width;
+  domain.height           = options.height;
+  domain.depth            = isVolume ? options.depth : 1;
+  domain.sigma            = options.sigma;
+  domain.depthSigma       = options.depthSigma;
+  domain.isSpatiotemporal = options.type == BlueNoiseType::SPATIOTEMPORAL;
+
+  BlueNoiseTexture result;
+  result.width     = options.width;
+  result.height    = options.height;
+  result.depth     = options.depth;
+  result.nChannels = options.nChannels;
+  result.values.resize(size_t(nTexelsPerSlice) * options.depth * options.nChannels);
+
+  const auto generateTextures = [&](size_t begin, size_t end)
+  {
+    for (size_t textureIdx = begin; textureIdx < end; textureIdx++)
+    {
+      const ui32 channel = static_cast<ui32>(textureIdx) / nTexturesPerChannel;
+      const ui32 firstZ  = static_cast<ui32>(textureIdx) % nTexturesPerChannel;
+      auto       ranks   = impl::rankVoidAndCluster(domain, options.initialDensity,
+                                                    hash32(static_cast<ui32>(textureIdx), options.seed), threadPool);
+      if (domain.isSpatiotemporal)
+      {
+        rankWithinSlices(ranks, nTexelsPerSlice);
+      }
+      const ui32 nRanks = domain.isSpatiotemporal ? nTexelsPerSlice : nTexelsPerTexture;
+      for (ui32 texelIdx = 0; texelIdx < nTexelsPerTexture; texelIdx++)
+      {
+        const size_t volumeIdx = size_t(firstZ) * nTexelsPerSlice + texelIdx;
+        result.values[volumeIdx * options.nChannels + channel] = (f32(ranks[texelIdx]) + 0.5f) / f32(nRanks);
+      }
+    }
+  };
+  const size_t nTextures = size_t(options.nChannels) * nTexturesPerChannel;
+  if (threadPool != nullptr)
+  {
+    threadPool->parallelFor(nTextures, 1, generateTextures);
+  }
+  else
+  {
+    generateTextures(0, nTextures);
+  }
+  return result;
+}
+} // namespace gims
@@ -0,0 +1,100 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#include <algorithm>
+#include <gimslib/contrib/stb/stb_image.h>
+#include <gimslib/sampling/BlueNoiseTile.hpp>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+using namespace gims;
+
+ui32 wrap(i32 coordinate, ui32 size)
+{
+  const i32 result = coordinate % static_cast<i32>(size);
+  return static_cast<ui32>(result < 0 ? result + static_cast<i32>(size) : result);
+}
+} // namespace
+
+namespace gims
+{
+BlueNoiseTile::BlueNoiseTile(ui32 width, ui32 height, ui32 nChannels, std::vector<f32> values)
+    : m_width(width)
+    , m_height(height)
+    , m_nChannels(nChannels)
+    , m_values(std::move(values))
+{
+  if (width == 0 || height == 0 || nChannels == 0 || m_values.size() != size_t(width) * height * nChannels)
+  {
+    throw std::runtime_error("The blue-noise tile needs width * height * nChannels values.");
+  }
+}
+
+BlueNoiseTile::BlueNoiseTile(const std::filesystem::path& fileName)
+    : m_width(0)
+    , m_height(0)
+    , m_nChannels(0)
+{
+  i32                                   width, height, nChannels;
+  std::unique_ptr<ui8, void (*)(void*)> image(
+      stbi_load(fileName.generic_string().c_str(), &width, &height, &nChannels, 0), &stbi_image_free);
+  if (image.get() == nullptr)
+  {
+    throw std::runtime_error("Error loading blue-noise tile " + fileName.string() + ".");
+  }
+  m_width     = static_cast<ui32>(width);
+  m_height    = static_cast<ui32>(height);
+  m_nChannels = static_cast<ui32>(nChannels);
+  m_values.resize(size_t(m_width) * m_height * m_nChannels);
+  for (size_t i = 0; i < m_values.size(); i++)
+  {
+    m_values[i] = (f32(image.get()[i]) + 0.5f) / 256.0f;
+  }
+}
+
+f32 BlueNoiseTile::get(i32 x, i32 y, ui32 channel) const
+{
+  return m_values[(size_t(wrap(y, m_height)) * m_width + wrap(x, m_width)) * m_nChannels + channel];
+}
+
+f32v2 BlueNoiseTile::get2D(i32 x, i32 y) const
+{
+  if (m_nChannels > 1)
+  {
+    return f32v2(get(x, y, 0), get(x, y, 1));
+  }
+  return f32v2(get(x, y), get(x + static_cast<i32>(m_width / 2), y + static_cast<i32>(m_height / 2)));
+}
+
+ui32 BlueNoiseTile::getWidth() const
+{
+  return m_width;
+}
+
+ui32 BlueNoiseTile::getHeight() const
+{
+  return m_height;
+}
+
+ui32 BlueNoiseTile::getNumChannels() const
+{
+  return m_nChannels;
+}
+
+std::vector<ui8v4> BlueNoiseTile::createRGBA8() const
+{
+  std::vector<ui8v4> result(size_t(m_width) * m_height, ui8v4(0, 0, 0, 255));
+  for (size_t texelIdx = 0; texelIdx < result.size(); texelIdx++)
+  {
+    for (ui32 channel = 0; channel < std::min(m_nChannels, 4u); channel++)
+    {
+      const f32 value           = m_values[texelIdx * m_nChannels + channel];
+      result[texelIdx][channel] = static_cast<ui8>(std::clamp(value * 256.0f, 0.0f, 255.0f));
+    }
+  }
+  return result;
+}
+} // namespace gims
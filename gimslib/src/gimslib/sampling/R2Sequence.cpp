@@ -0,0 +1,54 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#include <cmath>
+#include <gimslib/sampling/R2Sequence.hpp>
+
+namespace
+{
+using namespace gims;
+
+//! The plastic number, the real root of x^3 = x + 1.
+constexpr f64 PLASTIC_NUMBER = 1.32471795724474602596;
+constexpr f64 INCREMENT_X    = 1.0 / PLASTIC_NUMBER;
+constexpr f64 INCREMENT_Y    = 1.0 / (PLASTIC_NUMBER * PLASTIC_NUMBER);
+
+f64 frac(f64 x)
+{
+  return x - std::floor(x);
+}
+
+//! Point i in double precision, which keeps 32 fractional bits for indices up to 2^20.
+f64v2 getPoint(ui32 index, const f64v2& offset)
+{
+  return f64v2(frac(offset.x + 0.5 + f64(index) * INCREMENT_X), frac(offset.y + 0.5 + f64(index) * INCREMENT_Y));
+}
+} // namespace
+
+namespace gims
+{
+f32v2 R2Sequence::get(ui32 index, const f32v2& offset)
+{
+  // Rounding to float may yield 1.
+  const f64v2 point = getPoint(index, f64v2(offset));
+  return glm::min(f32v2(point), f32v2(1.0f - 1.0f / 16777216.0f));
+}
+
+f32v2 R2Sequence::getIncrement()
+{
+  return f32v2(f32(INCREMENT_X), f32(INCREMENT_Y));
+}
+
+std::vector<ui32> R2Sequence::createTable(ui32 nPoints)
+{
+  std::vector<ui32> result(size_t(nPoints) * 2);
+  for (ui32 i = 0; i < nPoints; i++)
+  {
+    const f64v2 point = getPoint(i, f64v2(0.0));
+
+    result[size_t(i) * 2]     = static_cast<ui32>(point.x * 4294967296.0);
+    result[size_t(i) * 2 + 1] = static_cast<ui32>(point.y * 4294967296.0);
+  }
+  return result;
+}
+} // namespace gims
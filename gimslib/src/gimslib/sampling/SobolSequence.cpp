@@ -0,0 +1,152 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#include <gimslib/sampling/SobolSequence.hpp>
+#include <gimslib/sys/Hash.hpp>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+using namespace gims;
+
+//! A primitive polynomial x^s + a_1 x^(s-1) + ... + a_(s-1) x + 1 with the initial direction numbers m_1 to m_s.
+struct DirectionParameters
+{
+  ui32 s;
+  ui32 a; //! The coefficients a_1 to a_(s-1), a_1 in the most significant bit.
+  ui32 m[5];
+};
+
+//! Dimensions 2 to 8 of new-joe-kuo-6.21201. The first dimension is the van der Corput sequence.
+constexpr DirectionParameters DIRECTION_PARAMETERS[SobolSequence::MAX_DIMENSIONS - 1] = {
+    {1, 0, {1}},
+    {2, 1, {1, 3}},
+    {3, 1, {1, 3, 1}},
+    {3, 2, {1, 1, 1}},
+    {4, 1, {1, 1, 3, 3}},
+    {4, 4, {1, 3, 5, 13}},
+    {5, 2, {1, 1, 5, 5, 17}},
+};
+
+ui32 reverseBits(ui32 x)
+{
+  x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+  x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+  x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+  x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+  return (x >> 16) | (x << 16);
+}
+
+//! A hash whose bits only depend on the bits of x of lower or equal significance, as Owen scrambling requires after
+//! the bits are reversed. Constants of Burley 2020.
+ui32 laineKarrasPermutation(ui32 x, ui32 seed)
+{
+  x += seed;
+  x ^= x * 0x6C50B47Cu;
+  x ^= x * 0xB82F1E52u;
+  x ^= x * 0xC7AFE638u;
+  x ^= x * 0x8D22F6E6u;
+  return x;
+}
+
+//! Owen scrambling of a 32 bit fixed-point number: every bit is flipped depending on the bits above it.
+ui32 nestedUniformScramble(ui32 x, ui32 seed)
+{
+  return reverseBits(laineKarrasPermutation(reverseBits(x), seed));
+}
+
+f32 toUnitInterval(ui32 fixedPoint)
+{
+  // 24 bits, so that the float is below 1.
+  return f32(fixedPoint >> 8) * (1.0f / 16777216.0f);
+}
+} // namespace
+
+namespace gims
+{
+SobolSequence::SobolSequence(bool isOwenScrambled)
+    : m_directionNumbers(MAX_DIMENSIONS * 32)
+    , m_isOwenScrambled(isOwenScrambled)
+{
+  for (ui32 bit = 0; bit < 32; bit++)
+  {
+    m_directionNumbers[bit] = 1u << (31 - bit);
+  }
+  for (ui32 dimension = 1; dimension < MAX_DIMENSIONS; dimension++)
+  {
+    const DirectionParameters& p = DIRECTION_PARAMETERS[dimension - 1];
+    ui32*                      v = &m_directionNumbers[dimension * 32];
+    for (ui32 bit = 0; bit < p.s; bit++)
+    {
+      v[bit] = p.m[bit] << (31 - bit);
+    }
+    for (ui32 bit = p.s; bit < 32; bit++)
+    {
+      v[bit] = v[bit - p.s] ^ (v[bit - p.s] >> p.s);
+      for (ui32 k = 1; k < p.s; k++)
+      {
+        if ((p.a >> (p.s - 1 - k)) & 1u)
+        {
+          v[bit] ^= v[bit - k];
+        }
+      }
+    }
+  }
+}
+
+ui32 SobolSequence::getFixedPoint(ui32 index, ui32 dimension, ui32 seed) const
+{
+  if (m_isOwenScrambled)
+  {
+    index = nestedUniformScramble(index, seed);
+  }
+  const ui32* v      = &m_directionNumbers[dimension * 32];
+  ui32        result = 0;
+  for (ui32 bit = 0; index != 0; bit++, index >>= 1)
+  {
+    if (index & 1u)
+    {
+      result ^= v[bit];
+    }
+  }
+  return m_isOwenScrambled ? nestedUniformScramble(result, hash32(dimension, seed)) : result;
+}
+
+f32 SobolSequence::get(ui32 index, ui32 dimension, ui32 seed) const
+{
+  return toUnitInterval(getFixedPoint(index, dimension, seed));
+}
+
+f32v2 SobolSequence::get2D(ui32 index, ui32 dimension, ui32 seed) const
+{
+  return f32v2(get(index, dimension, seed), get(index, dimension + 1, seed));
+}
+
+bool SobolSequence::isOwenScrambled() const
+{
+  return m_isOwenScrambled;
+}
+
+const std::vector<ui32>& SobolSequence::getDirectionNumbers() const
+{
+  return m_directionNumbers;
+}
+
+std::vector<ui32> SobolSequence::createTable(ui32 nPoints, ui32 nDimensions, ui32 seed) const
+{
+  if (nDimensions > MAX_DIMENSIONS)
+  {
+    throw std::runtime_error("The Sobol sequence has at most " + std::to_string(MAX_DIMENSIONS) + " dimensions.");
+  }
+  std::vector<ui32> result(size_t(nPoints) * nDimensions);
+  for (ui32 i = 0; i < nPoints; i++)
+  {
+    for (ui32 d = 0; d < nDimensions; d++)
+    {
+      result[size_t(i) * nDimensions + d] = getFixedPoint(i, d, seed);
+    }
+  }
+  return result;
+}
+} // namespace gims
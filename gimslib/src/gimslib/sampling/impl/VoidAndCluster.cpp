@@ -0,0 +1,362 @@
+#include "VoidAndCluster.hpp"
+#include <algorithm>
+#include <cmath>
+#include <gimslib/sys/Hash.hpp>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <stdexcept>
+
+namespace
+{
+using namespace gims;
+using namespace gims::impl;
+
+//! An offset of the energy window and the energy at it in fixed point, so that updates are exact.
+struct Tap
+{
+  i32  dx;
+  i32  dy;
+  i32  dz;
+  ui32 weight;
+};
+
+//! Taps within three standard deviations, limited to half the domain so that no texel is reached twice. The weights
+//! are scaled such that the energy of a texel, at most the sum of all weights, fits into 32 bits.
+std::vector<Tap> createTaps(const VoidAndClusterDomain& domain)
+{
+  const i32 rx = std::min(static_cast<i32>(std::ceil(3.0f * domain.sigma)), static_cast<i32>(domain.width - 1) / 2);
+  const i32 ry = std::min(static_cast<i32>(std::ceil(3.0f * domain.sigma)), static_cast<i32>(domain.height - 1) / 2);
+  const i32 rz =
+      std::min(static_cast<i32>(std::ceil(3.0f * domain.depthSigma)), static_cast<i32>(domain.depth - 1) / 2);
+  const f64 sigma2      = f64(domain.sigma) * domain.sigma;
+  const f64 depthSigma2 = f64(domain.depthSigma) * domain.depthSigma;
+
+  struct Offset
+  {
+    i32 dx;
+    i32 dy;
+    i32 dz;
+    f64 weight;
+  };
+  std::vector<Offset> offsets;
+  f64                 sumOfWeights = 0.0;
+  for (i32 dz = -rz; dz <= rz; dz++)
+  {
+    for (i32 dy = -ry; dy <= ry; dy++)
+    {
+      for (i32 dx = -rx; dx <= rx; dx++)
+      {
+        if (domain.isSpatiotemporal && dz != 0 && (dx != 0 || dy != 0))
+        {
+          continue;
+        }
+        const f64 distance2 = f64(dx * dx + dy * dy) / sigma2 + f64(dz * dz) / depthSigma2;
+        if (distance2 <= 9.0)
+        {
+          offsets.push_back({dx, dy, dz, std::exp(-0.5 * distance2)});
+          sumOfWeights += offsets.back().weight;
+        }
+      }
+    }
+  }
+
+  const f64        scale = 4294967295.0 / sumOfWeights;
+  std::vector<Tap> result;
+  for (const Offset& offset : offsets)
+  {
+    result.push_back({offset.dx, offset.dy, offset.dz, static_cast<ui32>(offset.weight * scale)});
+  }
+  return result;
+}
+
+//! The state of one phase: a binary pattern and the energy of every texel.
+struct Pattern
+{
+  std::vector<ui8>  isSet;
+  std::vector<ui32> energies;
+};
+
+//! \brief A tournament tree over the texels that finds the set texel of maximum energy or the unset one of minimum.
+//!
+//! Every node holds the minimum key of its subtree. A key packs the energy, inverted to find the maximum, above the
+//! index of the texel, so that a node compares its children without looking up energies and ties go to the smaller
+//! index. Ineligible texels have the largest key. A changed texel replays its ancestors until one keeps its key.
+class ExtremumTree
+{
+public:
+  ExtremumTree(const Pattern& pattern, bool findsMaximumSetTexel)
+      : m_pattern(pattern)
+      , m_findsMaximumSetTexel(findsMaximumSetTexel)
+  {
+    const ui32 nTexels = static_cast<ui32>(pattern.isSet.size());
+    m_nLeaves          = 1;
+    while (m_nLeaves < nTexels)
+    {
+      m_nLeaves *= 2;
+    }
+    m_keys.assign(2 * size_t(m_nLeaves), INELIGIBLE);
+    for (ui32 texelIdx = 0; texelIdx < nTexels; texelIdx++)
+    {
+      m_keys[m_nLeaves + texelIdx] = getKey(texelIdx);
+    }
+    for (ui32 nodeIdx = m_nLeaves - 1; nodeIdx > 0; nodeIdx--)
+    {
+      m_keys[nodeIdx] = std::min(m_keys[2 * nodeIdx], m_keys[2 * nodeIdx + 1]);
+    }
+  }
+
+  //! \brief Updates the tree after the energies or the states of texels changed.
+  void update(const std::vector<ui32>& texels)
+  {
+    for (const ui32 texelIdx : texels)
+    {
+      ui32 nodeIdx    = m_nLeaves + texelIdx;
+      m_keys[nodeIdx] = getKey(texelIdx);
+      while (nodeIdx > 1)
+      {
+        nodeIdx            = nodeIdx / 2;
+        const ui64 minimum = std::min(m_keys[2 * nodeIdx], m_keys[2 * nodeIdx + 1]);
+        if (m_keys[nodeIdx] == minimum)
+        {
+          break;
+        }
+        m_keys[nodeIdx] = minimum;
+      }
+    }
+  }
+
+  //! \brief Returns the winning texel. At least one texel must be eligible.
+  ui32 get() const
+  {
+    return static_cast<ui32>(m_keys[1]);
+  }
+
+private:
+  static constexpr ui64 INELIGIBLE = ~ui64(0);
+
+  ui64 getKey(ui32 texelIdx) const
+  {
+    if ((m_pattern.isSet[texelIdx] != 0) != m_findsMaximumSetTexel)
+    {
+      return INELIGIBLE;
+    }
+    const ui32 energy = m_pattern.energies[texelIdx];
+    return (ui64(m_findsMaximumSetTexel ? ~energy : energy) << 32) | texelIdx;
+  }
+
+  const Pattern&    m_pattern;
+  bool              m_findsMaximumSetTexel;
+  ui32              m_nLeaves;
+  std::vector<ui64> m_keys;
+};
+
+class VoidAndCluster
+{
+public:
+  explicit VoidAndCluster(const VoidAndClusterDomain& domain)
+      : m_domain(domain)
+      , m_taps(createTaps(domain))
+      , m_nTexels(domain.width * domain.height * domain.depth)
+  {
+    m_window.reserve(m_taps.size());
+  }
+
+  ui32 getNumTexels() const
+  {
+    return m_nTexels;
+  }
+
+  //! \brief Sets or clears a texel and updates the energies of its window, which m_window lists afterwards.
+  void toggle(Pattern& pattern, ui32 texelIdx)
+  {
+    const bool isSet        = pattern.isSet[texelIdx] == 0;
+    pattern.isSet[texelIdx] = isSet ? 1 : 0;
+
+    const i32 x = static_cast<i32>(texelIdx % m_domain.width);
+    const i32 y = static_cast<i32>((texelIdx / m_domain.width) % m_domain.height);
+    const i32 z = static_cast<i32>(texelIdx / (m_domain.width * m_domain.height));
+    m_window.clear();
+    for (const Tap& tap : m_taps)
+    {
+      const ui32 neighborIdx = getIndex(x + tap.dx, y + tap.dy, z + tap.dz);
+      if (isSet)
+      {
+        pattern.energies[neighborIdx] += tap.weight;
+      }
+      else
+      {
+        pattern.energies[neighborIdx] -= tap.weight;
+      }
+      m_window.push_back(neighborIdx);
+    }
+  }
+
+  const std::vector<ui32>& getWindow() const
+  {
+    return m_window;
+  }
+
+  //! \brief Sets the random texels of the initial pattern and computes all energies.
+  Pattern createInitialPattern(f32 initialDensity, ui32 seed, ThreadPool* threadPool) const
+  {
+    Pattern result;
+    result.isSet.assign(m_nTexels, 0);
+    result.energies.assign(m_nTexels, 0);
+    const ui32 nSet =
+        std::clamp(static_cast<ui32>(std::lround(f64(initialDensity) * m_nTexels)), 1u, std::max(m_nTexels / 2, 1u));
+    for (ui32 nDrawn = 0, counter = 0; nDrawn < nSet; counter++)
+    {
+      const ui32 texelIdx = hash32(counter, seed) % m_nTexels;
+      if (result.isSet[texelIdx] == 0)
+      {
+        result.isSet[texelIdx] = 1;
+        nDrawn++;
+      }
+    }
+
+    // The kernel is symmetric, so the energy of a texel gathers the weights of the set texels in its window.
+    const auto computeEnergies = [&](size_t begin, size_t end)
+    {
+      for (size_t texelIdx = begin; texelIdx < end; texelIdx++)
+      {
+        const i32 x      = static_cast<i32>(texelIdx % m_domain.width);
+        const i32 y      = static_cast<i32>((texelIdx / m_domain.width) % m_domain.height);
+        const i32 z      = static_cast<i32>(texelIdx / (size_t(m_domain.width) * m_domain.height));
+        ui32      energy = 0;
+        for (const Tap& tap : m_taps)
+        {
+          energy += result.isSet[getIndex(x + tap.dx, y + tap.dy, z + tap.dz)] != 0 ? tap.weight : 0;
+        }
+        result.energies[texelIdx] = energy;
+      }
+    };
+    if (threadPool != nullptr)
+    {
+      threadPool->parallelFor(m_nTexels, 4096, computeEnergies);
+    }
+    else
+    {
+      computeEnergies(0, m_nTexels);
+    }
+    return result;
+  }
+
+private:
+  ui32 getIndex(i32 x, i32 y, i32 z) const
+  {
+    return (wrap(z, m_domain.depth) * m_domain.height + wrap(y, m_domain.height)) * m_domain.width +
+           wrap(x, m_domain.width);
+  }
+
+  //! Taps reach at most half the domain, so one correction suffices.
+  static ui32 wrap(i32 coordinate, ui32 size)
+  {
+    if (coordinate < 0)
+    {
+      return static_cast<ui32>(coordinate + static_cast<i32>(size));
+    }
+    return static_cast<ui32>(coordinate) >= size ? static_cast<ui32>(coordinate) - size : static_cast<ui32>(coordinate);
+  }
+
+  VoidAndClusterDomain m_domain;
+  std::vector<Tap>     m_taps;
+  ui32                 m_nTexels;
+  std::vector<ui32>    m_window;
+};
+
+//! Swaps the tightest cluster into the largest void until the cluster is the void, as in Ulichney's initial pattern.
+void relax(VoidAndCluster& voidAndCluster, Pattern& pattern)
+{
+  ExtremumTree clusters(pattern, true);
+  ExtremumTree voids(pattern, false);
+  for (ui32 iteration = 0; iteration < voidAndCluster.getNumTexels(); iteration++)
+  {
+    const ui32 clusterIdx = clusters.get();
+    voidAndCluster.toggle(pattern, clusterIdx);
+    clusters.update(voidAndCluster.getWindow());
+    voids.update(voidAndCluster.getWindow());
+
+    const ui32 voidIdx = voids.get();
+    voidAndCluster.toggle(pattern, voidIdx);
+    clusters.update(voidAndCluster.getWindow());
+    voids.update(voidAndCluster.getWindow());
+    if (voidIdx == clusterIdx)
+    {
+      return;
+    }
+  }
+}
+
+//! Ranks the set texels from nSet - 1 down to 0 by removing the tightest cluster.
+void removeClusters(VoidAndCluster voidAndCluster, Pattern pattern, ui32 nSet, std::vector<ui32>& ranks)
+{
+  ExtremumTree clusters(pattern, true);
+  for (ui32 rank = nSet; rank > 0; rank--)
+  {
+    const ui32 clusterIdx = clusters.get();
+    ranks[clusterIdx]     = rank - 1;
+    voidAndCluster.toggle(pattern, clusterIdx);
+    clusters.update(voidAndCluster.getWindow());
+  }
+}
+
+//! Ranks the unset texels from nSet up by filling the largest void. Ulichney's third phase, which finds the tightest
+//! cluster of unset texels beyond half the texels, selects the same texels, because the energies of the unset texels
+//! are the total energy minus those of the set texels.
+void fillVoids(VoidAndCluster voidAndCluster, Pattern pattern, ui32 nSet, std::vector<ui32>& ranks)
+{
+  ExtremumTree voids(pattern, false);
+  for (ui32 rank = nSet; rank < voidAndCluster.getNumTexels(); rank++)
+  {
+    const ui32 voidIdx = voids.get();
+    ranks[voidIdx]     = rank;
+    voidAndCluster.toggle(pattern, voidIdx);
+    voids.update(voidAndCluster.getWindow());
+  }
+}
+} // namespace
+
+namespace gims
+{
+namespace impl
+{
+std::vector<ui32> rankVoidAndCluster(const VoidAndClusterDomain& domain, f32 initialDensity, ui32 seed,
+                                     ThreadPool* threadPool)
+{
+  if (domain.width == 0 || domain.height == 0 || domain.depth == 0 || domain.sigma <= 0.0f ||
+      domain.depthSigma <= 0.0f)
+  {
+    throw std::runtime_error("Void-and-cluster needs a non-empty domain and positive standard deviations.");
+  }
+  VoidAndCluster voidAndCluster(domain);
+  Pattern        pattern = voidAndCluster.createInitialPattern(initialDensity, seed, threadPool);
+  relax(voidAndCluster, pattern);
+
+  const ui32        nSet = static_cast<ui32>(std::count(pattern.isSet.begin(), pattern.isSet.end(), ui8(1)));
+  std::vector<ui32> ranks(voidAndCluster.getNumTexels());
+  // Each phase works on copies of the pattern and of the window, and they write the ranks of disjoint texels.
+  const auto runPhases = [&](size_t begin, size_t end)
+  {
+    for (size_t phase = begin; phase < end; phase++)
+    {
+      if (phase == 0)
+      {
+        removeClusters(voidAndCluster, pattern, nSet, ranks);
+      }
+      else
+      {
+        fillVoids(voidAndCluster, pattern, nSet, ranks);
+      }
+    }
+  };
+  if (threadPool != nullptr)
+  {
+    threadPool->parallelFor(2, 1, runPhases);
+  }
+  else
+  {
+    runPhases(0, 2);
+  }
+  return ranks;
+}
+} // namespace impl
+} // namespace gims
@@ -0,0 +1,31 @@
+#pragma once
+#include <gimslib/types.hpp>
+#include <vector>
+
+namespace gims
+{
+class ThreadPool;
+
+namespace impl
+{
+//! \brief A torus of texels and the energy that a set texel adds to its neighbors.
+struct VoidAndClusterDomain
+{
+  ui32 width;
+  ui32 height;
+  ui32 depth;
+  f32  sigma;            //! Standard deviation of the Gaussian within a slice.
+  f32  depthSigma;       //! Standard deviation of the Gaussian across slices.
+  bool isSpatiotemporal; //! If true, texels only affect their slice and the same texel in the other slices.
+};
+
+//! \brief Ranks the texels of the domain with void-and-cluster.
+//!
+//! The initial pattern of initialDensity * texels random texels is relaxed until its tightest cluster is its largest
+//! void. Then, a copy removes its tightest clusters and another fills its largest voids, which assigns the ranks below
+//! and above the size of the pattern, respectively. The two phases run in parallel.
+//! \return A permutation of [0, texels), the rank of texel (z * height + y) * width + x.
+std::vector<ui32> rankVoidAndCluster(const VoidAndClusterDomain& domain, f32 initialDensity, ui32 seed,
+                                     ThreadPool* threadPool);
+} // namespace impl
+} // namespace gims
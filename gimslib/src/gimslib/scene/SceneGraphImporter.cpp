@@ -0,0 +1,225 @@
+/// Cogra --- Coburg Graphics Framework
+/// (C) 2017-2022 by Quirin Meyer
+/// quirin.meyer@hs-coburg.de
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+#include <gimslib/scene/SceneGraphImporter.hpp>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace
+{
+using namespace gims;
+
+f32m4 aiMatrix4x4ToGlm(const aiMatrix4x4& from)
+{
+  return glm::transpose(glm::make_mat4(&from.a1));
+}
+
+//! Returns the color stored under the Assimp key triple (use AI_MATKEY_COLOR_*) or zero, if it does not exist.
+f32v3 getColor(char const* const pKey, unsigned int type, unsigned int idx, aiMaterial const* const material)
+{
+  aiColor3D color;
+  if (material->Get(pKey, type, idx, color) == aiReturn_SUCCESS)
+  {
+    return f32v3(color.r, color.g, color.b);
+  }
+  return f32v3(0.0f);
+}
+
+//! Returns the float stored under the Assimp key triple or zero, if it does not exist.
+f32 getFloat(char const* const pKey, unsigned int type, unsigned int idx, aiMaterial const* const material)
+{
+  ai_real value;
+  if (aiGetMaterialFloat(material, pKey, type, idx, &value) == aiReturn_SUCCESS)
+  {
+    return static_cast<f32>(value);
+  }
+  return 0.0f;
+}
+
+SceneGraph::Mesh createMesh(aiMesh const* const inputMesh)
+{
+  SceneGraph::Mesh result;
+  const ui32       nVertices = inputMesh->mNumVertices;
+  result.positions.reserve(nVertices);
+  result.normals.reserve(nVertices);
+  result.textureCoordinates.reserve(nVertices);
+  result.tangents.reserve(nVertices);
+  for (ui32 vIdx = 0; vIdx < nVertices; vIdx++)
+  {
+    const aiVector3D& position = inputMesh->mVertices[vIdx];
+    result.positions.emplace_back(position.x, position.y, position.z);
+
+    if (inputMesh->HasNormals())
+    {
+      const aiVector3D& normal = inputMesh->mNormals[vIdx];
+      result.normals.emplace_back(normal.x, normal.y, normal.z);
+    }
+    else
+    {
+      result.normals.emplace_back(0.0f);
+    }
+
+    if (inputMesh->HasTextureCoords(0))
+    {
+      const aiVector3D& textureCoordinate = inputMesh->mTextureCoords[0][vIdx];
+      result.textureCoordinates.emplace_back(textureCoordinate.x, textureCoordinate.y, 0.0f);
+    }
+    else
+    {
+      result.textureCoordinates.emplace_back(0.0f);
+    }
+
+    if (inputMesh->HasTangentsAndBitangents())
+    {
+      const aiVector3D& tangent = inputMesh->mTangents[vIdx];
+      result.tangents.emplace_back(tangent.x, tangent.y, tangent.z);
+    }
+    else
+    {
+      result.tangents.emplace_back(0.0f);
+    }
+  }
+
+  // Triangulation leaves only points and lines with fewer indices, which we do not render.
+  result.triangles.reserve(inputMesh->mNumFaces);
+  for (ui32 fIdx = 0; fIdx < inputMesh->mNumFaces; fIdx++)
+  {
+    const aiFace& face = inputMesh->mFaces[fIdx];
+    if (face.mNumIndices == 3)
+    {
+      result.triangles.emplace_back(face.mIndices[0], face.mIndices[1], face.mIndices[2]);
+    }
+  }
+
+  result.materialIndex = inputMesh->mMaterialIndex;
+  result.aabb          = AABB(result.positions.data(), nVertices);
+  return result;
+}
+
+ui32 createNodes(aiNode const* const inputNode, const f32m4& parentWorldSpaceTransformation, SceneGraph& scene)
+{
+  const auto nodeIdx = static_cast<ui32>(scene.nodes.size());
+  scene.nodes.emplace_back();
+  {
+    auto& node                    = scene.nodes.back();
+    node.transformation           = aiMatrix4x4ToGlm(inputNode->mTransformation);
+    node.worldSpaceTransformation = parentWorldSpaceTransformation * node.transformation;
+    node.meshIndices.assign(inputNode->mMeshes, inputNode->mMeshes + inputNode->mNumMeshes);
+  }
+
+  for (ui32 cIdx = 0; cIdx < inputNode->mNumChildren; cIdx++)
+  {
+    // Copy, as creating the child may reallocate the nodes.
+    const f32m4 worldSpaceTransformation = scene.nodes[nodeIdx].worldSpaceTransformation;
+    const ui32  childIdx                 = createNodes(inputNode->mChildren[cIdx], worldSpaceTransformation, scene);
+    scene.nodes[nodeIdx].childIndices.push_back(childIdx);
+  }
+  return nodeIdx;
+}
+
+void createMaterials(aiScene const* const inputScene, SceneGraph& scene)
+{
+  std::unordered_map<std::filesystem::path, ui32> textureFileNameToIndex;
+  const auto getTextureIndex = [&](const aiString& path)
+  {
+    const auto [iterator, inserted] =
+        textureFileNameToIndex.emplace(path.C_Str(), static_cast<ui32>(scene.textureFileNames.size()));
+    if (inserted)
+    {
+      scene.textureFileNames.emplace_back(path.C_Str());
+    }
+    return iterator->second;
+  };
+
+  static const std::array<aiTextureType, SceneGraph::NUM_TEXTURE_TYPES> textureTypes = {
+      aiTextureType_AMBIENT, aiTextureType_DIFFUSE, aiTextureType_SPECULAR, aiTextureType_EMISSIVE,
+      aiTextureType_HEIGHT};
+
+  scene.materials.reserve(inputScene->mNumMaterials);
+  for (ui32 mIdx = 0; mIdx < inputScene->mNumMaterials; mIdx++)
+  {
+    aiMaterial const* const inputMaterial = inputScene->mMaterials[mIdx];
+    SceneGraph::Material    material;
+    material.name             = inputMaterial->GetName().C_Str();
+    material.ambientColor     = getColor(AI_MATKEY_COLOR_AMBIENT, inputMaterial);
+    material.diffuseColor     = getColor(AI_MATKEY_COLOR_DIFFUSE, inputMaterial);
+    material.specularColor    = getColor(AI_MATKEY_COLOR_SPECULAR, inputMaterial);
+    material.emissiveColor    = getColor(AI_MATKEY_COLOR_EMISSIVE, inputMaterial);
+    material.specularExponent = getFloat(AI_MATKEY_SHININESS, inputMaterial);
+    material.reflectivity     = getFloat(AI_MATKEY_REFLECTIVITY, inputMaterial);
+
+    // Register every texture of the material, also those of types without a slot.
+    for (ui32 textureType = aiTextureType_NONE; textureType < aiTextureType_UNKNOWN; textureType++)
+    {
+      for (ui32 tIdx = 0; tIdx < inputMaterial->GetTextureCount(static_cast<aiTextureType>(textureType)); tIdx++)
+      {
+        aiString path;
+        inputMaterial->GetTexture(static_cast<aiTextureType>(textureType), tIdx, &path);
+        getTextureIndex(path);
+      }
+    }
+    for (ui32 slot = 0; slot < SceneGraph::NUM_TEXTURE_TYPES; slot++)
+    {
+      aiString path;
+      if (inputMaterial->GetTextureCount(textureTypes[slot]) > 0 &&
+          inputMaterial->GetTexture(textureTypes[slot], 0, &path) == aiReturn_SUCCESS)
+      {
+        material.textures[slot] = getTextureIndex(path);
+      }
+    }
+    scene.materials.push_back(std::move(material));
+  }
+}
+} // namespace
+
+namespace gims
+{
+SceneGraph SceneGraphImporter::load(const std::filesystem::path& pathToScene)
+{
+  const auto absolutePath = std::filesystem::weakly_canonical(pathToScene);
+  if (!std::filesystem::exists(absolutePath))
+  {
+    throw std::runtime_error(absolutePath.string() + " does not exist.");
+  }
+
+  const auto arguments = aiPostProcessSteps::aiProcess_Triangulate | aiProcess_GenSmoothNormals |
+                         aiProcess_GenUVCoords | aiProcess_ConvertToLeftHanded | aiProcess_OptimizeMeshes |
+                         aiProcess_RemoveRedundantMaterials | aiProcess_ImproveCacheLocality |
+                         aiProcess_FindInvalidData | aiProcess_FindDegenerates | aiProcess_CalcTangentSpace;
+
+  Assimp::Importer imp;
+  imp.SetPropertyBool(AI_CONFIG_PP_FD_REMOVE, true);
+  const aiScene* inputScene = imp.ReadFile(absolutePath.string(), arguments);
+  if (!inputScene || !inputScene->mRootNode)
+  {
+    throw std::runtime_error(absolutePath.string() + " can't be loaded with Assimp: " + imp.GetErrorString());
+  }
+
+  SceneGraph result;
+  result.directory = absolutePath.parent_path();
+
+  result.meshes.reserve(inputScene->mNumMeshes);
+  for (ui32 mIdx = 0; mIdx < inputScene->mNumMeshes; mIdx++)
+  {
+    result.meshes.push_back(createMesh(inputScene->mMeshes[mIdx]));
+  }
+  createNodes(inputScene->mRootNode, f32m4(1.0f), result);
+  createMaterials(inputScene, result);
+
+  std::vector<AABB>  instanceAABBs;
+  std::vector<f32m4> instanceTransformations;
+  for (const auto& node : result.nodes)
+  {
+    for (const auto meshIdx : node.meshIndices)
+    {
+      instanceAABBs.push_back(result.meshes[meshIdx].aabb);
+      instanceTransformations.push_back(node.worldSpaceTransformation);
+    }
+  }
+  result.aabb = AABB::getTransformedUnion(instanceAABBs.data(), instanceTransformations.data(), instanceAABBs.size());
+  return result;
+}
+} // namespace gims
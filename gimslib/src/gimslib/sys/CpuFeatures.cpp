@@ -0,0 +1,53 @@
+#include <gimslib/sys/CpuFeatures.hpp>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace
+{
+gims::CpuFeatures detectCpuFeatures()
+{
+  gims::CpuFeatures features;
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  int info[4] = {};
+  __cpuid(info, 0);
+  const int maxLeaf = info[0];
+  if (maxLeaf < 1)
+  {
+    return features;
+  }
+  __cpuid(info, 1);
+  features.sse41 = (info[2] & (1 << 19)) != 0;
+  // AVX registers are only usable if the operating system saves them on a context switch.
+  const bool osSavesAvx = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+  // AVX-512 additionally needs the opmask registers and the upper halves of the ZMM registers saved.
+  const bool osSavesAvx512 = osSavesAvx && (_xgetbv(0) & 0xe0) == 0xe0;
+  features.avx             = osSavesAvx && (info[2] & (1 << 28)) != 0;
+  features.fma             = features.avx && (info[2] & (1 << 12)) != 0;
+  if (maxLeaf >= 7)
+  {
+    __cpuidex(info, 7, 0);
+    features.avx2    = features.avx && (info[1] & (1 << 5)) != 0;
+    features.avx512f = features.avx && osSavesAvx512 && (info[1] & (1 << 16)) != 0;
+  }
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+  __builtin_cpu_init();
+  features.sse41   = __builtin_cpu_supports("sse4.1");
+  features.avx     = __builtin_cpu_supports("avx");
+  features.avx2    = __builtin_cpu_supports("avx2");
+  features.fma     = __builtin_cpu_supports("fma");
+  features.avx512f = __builtin_cpu_supports("avx512f");
+#endif
+  return features;
+}
+} // namespace
+
+namespace gims
+{
+const CpuFeatures& getCpuFeatures()
+{
+  static const CpuFeatures features = detectCpuFeatures();
+  return features;
+}
+} // namespace gims
@@ -0,0 +1,123 @@
+#include <cstring>
+#include <gimslib/sys/Hash.hpp>
+
+namespace
+{
+using gims::ui32;
+using gims::ui64;
+using gims::ui8;
+
+constexpr ui64 PRIME1 = 0x9E3779B185EBCA87ULL;
+constexpr ui64 PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr ui64 PRIME3 = 0x165667B19E3779F9ULL;
+constexpr ui64 PRIME4 = 0x85EBCA77C2B2AE63ULL;
+constexpr ui64 PRIME5 = 0x27D4EB2F165667C5ULL;
+
+inline ui64 rotateLeft(ui64 x, int r)
+{
+  return (x << r) | (x >> (64 - r));
+}
+
+inline ui64 load64(const ui8* p)
+{
+  ui64 v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline ui32 load32(const ui8* p)
+{
+  ui32 v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline ui64 round(ui64 accumulator, ui64 input)
+{
+  accumulator += input * PRIME2;
+  accumulator = rotateLeft(accumulator, 31);
+  return accumulator * PRIME1;
+}
+
+inline ui64 mergeRound(ui64 accumulator, ui64 value)
+{
+  accumulator ^= round(0, value);
+  return accumulator * PRIME1 + PRIME4;
+}
+} // namespace
+
+namespace gims
+{
+ui64 hash64(const void* data, size_t size, ui64 seed)
+{
+  const ui8*       p   = static_cast<const ui8*>(data);
+  const ui8* const end = p + size;
+  ui64             h;
+
+  if (size >= 32)
+  {
+    ui64             v1    = seed + PRIME1 + PRIME2;
+    ui64             v2    = seed + PRIME2;
+    ui64             v3    = seed;
+    ui64             v4    = seed - PRIME1;
+    const ui8* const limit = end - 32;
+    do
+    {
+      v1 = round(v1, load64(p));
+      v2 = round(v2, load64(p + 8));
+      v3 = round(v3, load64(p + 16));
+      v4 = round(v4, load64(p + 24));
+      p += 32;
+    } while (p <= limit);
+
+    h = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+    h = mergeRound(h, v1);
+    h = mergeRound(h, v2);
+    h = mergeRound(h, v3);
+    h = mergeRound(h, v4);
+  }
+  else
+  {
+    h = seed + PRIME5;
+  }
+
+  h += static_cast<ui64>(size);
+
+  while (p + 8 <= end)
+  {
+    h ^= round(0, load64(p));
+    h = rotateLeft(h, 27) * PRIME1 + PRIME4;
+    p += 8;
+  }
+  if (p + 4 <= end)
+  {
+    h ^= static_cast<ui64>(load32(p)) * PRIME1;
+    h = rotateLeft(h, 23) * PRIME2 + PRIME3;
+    p += 4;
+  }
+  while (p < end)
+  {
+    h ^= (*p) * PRIME5;
+    h = rotateLeft(h, 11) * PRIME1;
+    p++;
+  }
+
+  h ^= h >> 33;
+  h *= PRIME2;
+  h ^= h >> 29;
+  h *= PRIME3;
+  h ^= h >> 32;
+  return h;
+}
+
+ui32 hash32(ui32 value, ui32 seed)
+{
+  ui32 h = value ^ (seed * 0x9E3779B9u + 0x7F4A7C15u);
+  h ^= h >> 16;
+  h *= 0x7FEB352Du;
+  h ^= h >> 15;
+  h *= 0x846CA68Bu;
+  h ^= h >> 16;
+  return h;
+}
+} // namespace gims
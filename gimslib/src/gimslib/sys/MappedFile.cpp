@@ -0,0 +1,124 @@
+#include <gimslib/sys/MappedFile.hpp>
+#include <stdexcept>
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace gims
+{
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string& fileName)
+{
+  m_fileHandle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (m_fileHandle == INVALID_HANDLE_VALUE)
+  {
+    m_fileHandle = nullptr;
+    throw std::runtime_error("Error opening file " + fileName + ".");
+  }
+
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(m_fileHandle, &fileSize))
+  {
+    CloseHandle(m_fileHandle);
+    throw std::runtime_error("Error querying the size of " + fileName + ".");
+  }
+  m_size = static_cast<size_t>(fileSize.QuadPart);
+  if (m_size == 0)
+  {
+    return;
+  }
+
+  m_mappingHandle = CreateFileMappingA(m_fileHandle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+  if (m_mappingHandle == nullptr)
+  {
+    CloseHandle(m_fileHandle);
+    throw std::runtime_error("Error mapping file " + fileName + ".");
+  }
+
+  m_data = static_cast<ui8*>(MapViewOfFile(m_mappingHandle, FILE_MAP_COPY, 0, 0, 0));
+  if (m_data == nullptr)
+  {
+    CloseHandle(m_mappingHandle);
+    CloseHandle(m_fileHandle);
+    throw std::runtime_error("Error mapping file " + fileName + ".");
+  }
+}
+
+MappedFile::~MappedFile()
+{
+  if (m_data)
+  {
+    UnmapViewOfFile(m_data);
+  }
+  if (m_mappingHandle)
+  {
+    CloseHandle(m_mappingHandle);
+  }
+  if (m_fileHandle)
+  {
+    CloseHandle(m_fileHandle);
+  }
+}
+#else
+MappedFile::MappedFile(const std::string& fileName)
+{
+  m_fileDescriptor = open(fileName.c_str(), O_RDONLY);
+  if (m_fileDescriptor == -1)
+  {
+    throw std::runtime_error("Error opening file " + fileName + ".");
+  }
+
+  struct stat fileStatus;
+  if (fstat(m_fileDescriptor, &fileStatus) != 0)
+  {
+    close(m_fileDescriptor);
+    throw std::runtime_error("Error querying the size of " + fileName + ".");
+  }
+  m_size = static_cast<size_t>(fileStatus.st_size);
+  if (m_size == 0)
+  {
+    return;
+  }
+
+  void* mapping = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, m_fileDescriptor, 0);
+  if (mapping == MAP_FAILED)
+  {
+    close(m_fileDescriptor);
+    throw std::runtime_error("Error mapping file " + fileName + ".");
+  }
+  m_data = static_cast<ui8*>(mapping);
+  madvise(mapping, m_size, MADV_SEQUENTIAL);
+}
+
+MappedFile::~MappedFile()
+{
+  if (m_data)
+  {
+    munmap(m_data, m_size);
+  }
+  if (m_fileDescriptor != -1)
+  {
+    close(m_fileDescriptor);
+  }
+}
+#endif
+
+ui8* MappedFile::data() const
+{
+  return m_data;
+}
+
+size_t MappedFile::size() const
+{
+  return m_size;
+}
+} // namespace gims
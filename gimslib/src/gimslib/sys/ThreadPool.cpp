@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <exception>
+#include <gimslib/sys/ThreadPool.hpp>
+
+namespace
+{
+//! Pool and index of the worker running on this thread, if any.
+thread_local const gims::ThreadPool* t_pool      = nullptr;
+thread_local gims::ui32              t_workerIdx = 0;
+
+//! State of one ThreadPool::parallelFor() call, shared by the caller and the helper tasks.
+struct ParallelLoop
+{
+  const std::function<void(size_t, size_t)>* body;
+  size_t                                     count;
+  size_t                                     grainSize;
+  size_t                                     nRanges;
+  std::atomic<size_t>                        nextRange = 0;
+  std::atomic<size_t>                        nFinished = 0;
+  std::mutex                                 errorMutex;
+  std::exception_ptr                         error;
+
+  //! Processes ranges until none is left. A helper that starts after the loop completed returns immediately and
+  //! never touches body, which may no longer exist.
+  void run()
+  {
+    for (size_t rangeIdx = nextRange.fetch_add(1); rangeIdx < nRanges; rangeIdx = nextRange.fetch_add(1))
+    {
+      try
+      {
+        (*body)(rangeIdx * grainSize, std::min(count, (rangeIdx + 1) * grainSize));
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error)
+        {
+          error = std::current_exception();
+        }
+      }
+      if (nFinished.fetch_add(1, std::memory_order_acq_rel) + 1 == nRanges)
+      {
+        nFinished.notify_all();
+      }
+    }
+  }
+};
+} // namespace
+
+namespace gims
+{
+ThreadPool::ThreadPool(ui32 nThreads)
+{
+  if (nThreads == 0)
+  {
+    nThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (ui32 i = 0; i < nThreads; i++)
+  {
+    m_queues.push_back(std::make_unique<Queue>());
+  }
+  for (ui32 i = 0; i < nThreads; i++)
+  {
+    m_threads.emplace_back(&ThreadPool::workerMain, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_sleepMutex);
+    m_stop = true;
+  }
+  m_wakeUp.notify_all();
+  for (auto& thread : m_threads)
+  {
+    thread.join();
+  }
+}
+
+void ThreadPool::enqueue(Task task)
+{
+  // The task is counted before it becomes visible, so a worker that acquires it never sees a count of zero.
+  {
+    std::lock_guard<std::mutex> lock(m_sleepMutex);
+    m_nPending++;
+  }
+  const ui32 queueIdx =
+      t_pool == this ? t_workerIdx : m_nextQueue.fetch_add(1, std::memory_order_relaxed) % getNumThreads();
+  {
+    std::lock_guard<std::mutex> lock(m_queues[queueIdx]->mutex);
+    m_queues[queueIdx]->tasks.push_back(std::move(task));
+  }
+  m_wakeUp.notify_one();
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body)
+{
+  grainSize            = std::max<size_t>(grainSize, 1);
+  const size_t nRanges = (count + grainSize - 1) / grainSize;
+  if (nRanges == 0)
+  {
+    return;
+  }
+
+  auto loop       = std::make_shared<ParallelLoop>();
+  loop->body      = &body;
+  loop->count     = count;
+  loop->grainSize = grainSize;
+  loop->nRanges   = nRanges;
+
+  const size_t nHelpers = std::min<size_t>(getNumThreads(), nRanges - 1);
+  for (size_t i = 0; i < nHelpers; i++)
+  {
+    enqueue([loop]() { loop->run(); });
+  }
+  loop->run();
+  for (size_t nFinished = loop->nFinished.load(std::memory_order_acquire); nFinished != nRanges;
+       nFinished        = loop->nFinished.load(std::memory_order_acquire))
+  {
+    loop->nFinished.wait(nFinished, std::memory_order_acquire);
+  }
+  if (loop->error)
+  {
+    std::rethrow_exception(loop->error);
+  }
+}
+
+ui32 ThreadPool::getNumThreads() const
+{
+  return static_cast<ui32>(m_queues.size());
+}
+
+bool ThreadPool::tryAcquire(ui32 workerIdx, Task& task)
+{
+  {
+    auto&                       own = *m_queues[workerIdx];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty())
+    {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      return true;
+    }
+  }
+  for (ui32 i = 1; i < getNumThreads(); i++)
+  {
+    auto&                       victim = *m_queues[(workerIdx + i) % getNumThreads()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty())
+    {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::workerMain(ui32 workerIdx)
+{
+  t_pool      = this;
+  t_workerIdx = workerIdx;
+  for (;;)
+  {
+    Task task;
+    if (tryAcquire(workerIdx, task))
+    {
+      {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_nPending--;
+      }
+      task();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(m_sleepMutex);
+    m_wakeUp.wait(lock, [this]() { return m_stop || m_nPending > 0; });
+    if (m_stop && m_nPending == 0)
+    {
+      return;
+    }
+  }
+}
+} // namespace gims
@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <gimslib/sys/TileScheduler.hpp>
+#include <stdexcept>
+
+namespace
+{
+using namespace gims;
+
+//! Tiles [begin, end) that a worker has left, packed into one word with begin in the upper 32 bits. Owner and thieves
+//! change it with a compare-exchange. As ranges only shrink or move to an empty worker, a stale word never reappears.
+struct alignas(64) WorkerRange
+{
+  std::atomic<ui64> range = 0;
+};
+
+ui64 packRange(ui32 begin, ui32 end)
+{
+  return (ui64(begin) << 32) | end;
+}
+
+ui32 getBegin(ui64 range)
+{
+  return static_cast<ui32>(range >> 32);
+}
+
+ui32 getEnd(ui64 range)
+{
+  return static_cast<ui32>(range);
+}
+
+ui32 getSize(ui64 range)
+{
+  return getEnd(range) - getBegin(range);
+}
+
+//! Moves the back half of the largest range of the other workers to the empty range of thief.
+//! \return False if all ranges are empty.
+bool steal(std::vector<WorkerRange>& ranges, ui32 thiefIdx)
+{
+  for (;;)
+  {
+    ui32 victimIdx = thiefIdx;
+    ui64 victim    = 0;
+    for (ui32 wIdx = 0; wIdx < ranges.size(); wIdx++)
+    {
+      const ui64 range = ranges[wIdx].range.load(std::memory_order_acquire);
+      if (wIdx != thiefIdx && getSize(range) > getSize(victim))
+      {
+        victimIdx = wIdx;
+        victim    = range;
+      }
+    }
+    if (victimIdx == thiefIdx)
+    {
+      return false;
+    }
+    const ui32 split = getEnd(victim) - (getSize(victim) + 1) / 2;
+    if (ranges[victimIdx].range.compare_exchange_strong(victim, packRange(getBegin(victim), split),
+                                                         std::memory_order_acq_rel))
+    {
+      ranges[thiefIdx].range.store(packRange(split, getEnd(victim)), std::memory_order_release);
+      return true;
+    }
+  }
+}
+} // namespace
+
+namespace gims
+{
+f64 TileSchedulerStatistics::getTilesPerSecondPerCore() const
+{
+  return seconds > 0.0 && nWorkers > 0 ? f64(nTiles) / seconds / f64(nWorkers) : 0.0;
+}
+
+TileScheduler::TileScheduler(ui32 width, ui32 height, ui32 tileSize)
+    : m_width(width)
+    , m_height(height)
+    , m_tileSize(tileSize)
+    , m_nTilesX(0)
+    , m_nTilesY(0)
+{
+  if (tileSize == 0)
+  {
+    throw std::runtime_error("Tiles must be at least one pixel wide.");
+  }
+  m_nTilesX = (width + tileSize - 1) / tileSize;
+  m_nTilesY = (height + tileSize - 1) / tileSize;
+}
+
+TileSchedulerStatistics TileScheduler::run(const std::function<void(const Tile& tile, ui32 workerIdx)>& renderTile,
+                                           ThreadPool* threadPool) const
+{
+  TileSchedulerStatistics result;
+  result.nWorkers = getNumWorkers(threadPool);
+  result.nTiles   = getNumTiles();
+  result.tilesPerWorker.resize(result.nWorkers, 0);
+
+  std::vector<WorkerRange> ranges(result.nWorkers);
+  for (ui32 wIdx = 0; wIdx < result.nWorkers; wIdx++)
+  {
+    ranges[wIdx].range = packRange(static_cast<ui32>(ui64(result.nTiles) * wIdx / result.nWorkers),
+                                   static_cast<ui32>(ui64(result.nTiles) * (wIdx + 1) / result.nWorkers));
+  }
+  std::atomic<ui64> nSteals = 0;
+  std::atomic<bool> failed  = false;
+
+  const auto work = [&](ui32 workerIdx)
+  {
+    auto& own = ranges[workerIdx].range;
+    for (;;)
+    {
+      ui64 range = own.load(std::memory_order_acquire);
+      while (getSize(range) > 0 && !failed.load(std::memory_order_relaxed))
+      {
+        if (!own.compare_exchange_weak(range, packRange(getBegin(range) + 1, getEnd(range)),
+                                       std::memory_order_acq_rel))
+        {
+          continue;
+        }
+        try
+        {
+          renderTile(getTile(getBegin(range)), workerIdx);
+        }
+        catch (...)
+        {
+          failed.store(true, std::memory_order_relaxed);
+          throw;
+        }
+        result.tilesPerWorker[workerIdx]++;
+        range = own.load(std::memory_order_acquire);
+      }
+      if (failed.load(std::memory_order_relaxed) || !steal(ranges, workerIdx))
+      {
+        return;
+      }
+      nSteals.fetch_add(1, std::memory_order_relaxed);
+    }
+  };
+
+  const auto start = std::chrono::steady_clock::now();
+  if (threadPool != nullptr)
+  {
+    threadPool->parallelFor(result.nWorkers, 1,
+                            [&](size_t begin, size_t end)
+                            {
+                              for (size_t wIdx = begin; wIdx < end; wIdx++)
+                              {
+                                work(static_cast<ui32>(wIdx));
+                              }
+                            });
+  }
+  else
+  {
+    work(0);
+  }
+  result.seconds = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+  result.nSteals = nSteals.load();
+  return result;
+}
+
+ui32 TileScheduler::getNumWorkers(const ThreadPool* threadPool)
+{
+  // The calling thread takes part in ThreadPool::parallelFor(). Hence, one worker of the pool stays idle, and the
+  // number of threads that render equals the number of workers of the pool.
+  return threadPool != nullptr ? threadPool->getNumThreads() : 1;
+}
+
+ui32 TileScheduler::getNumTiles() const
+{
+  return m_nTilesX * m_nTilesY;
+}
+
+Tile TileScheduler::getTile(ui32 tileIdx) const
+{
+  Tile result;
+  result.index  = tileIdx;
+  result.x      = tileIdx % m_nTilesX * m_tileSize;
+  result.y      = tileIdx / m_nTilesX * m_tileSize;
+  result.width  = std::min(m_tileSize, m_width - result.x);
+  result.height = std::min(m_tileSize, m_height - result.y);
+  return result;
+}
+} // namespace gims